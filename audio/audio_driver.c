@@ -54,6 +54,7 @@
 #include "../retroarch.h"
 #include "../list_special.h"
 #include "../file_path_special.h"
+#include "../frame_trace.h"
 #include "../record/record_driver.h"
 #include "../tasks/task_content.h"
 #include "../verbosity.h"
@@ -228,9 +229,11 @@ static bool audio_driver_free_devices_list(void)
          || !audio_st->current_audio->device_list_free
          || !audio_st->context_audio_data)
       return false;
+   AUDIO_DRIVER_WRITE_LOCK(audio_st);
    audio_st->current_audio->device_list_free(
          audio_st->context_audio_data,
          audio_st->devices_list);
+   AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
    audio_st->devices_list = NULL;
    return true;
 }
@@ -270,10 +273,77 @@ static void audio_driver_deinit_resampler(void)
    audio_st->resampler_quality  = RESAMPLER_QUALITY_DONTCARE;
 }
 
+#ifdef HAVE_DSP_FILTER
+/* Reports where the time goes in a DSP filter chain that went
+ * over the budget its config sets, and drops it rather than let
+ * it starve the driver.
+ * Runs wherever audio_driver_process() does, which owns the chain. */
+static void audio_driver_dsp_filter_drop(audio_driver_state_t *audio_st)
+{
+   unsigned i, count;
+   struct retro_dsp_stage_stats stats[32];
+
+   count = retro_dsp_filter_get_stats(audio_st->dsp,
+         stats, ARRAY_SIZE(stats));
+
+   RARCH_ERR("[DSP]: Filter chain takes longer than the audio it "
+         "processes, disabling it.\n");
+   for (i = 0; i < count && i < ARRAY_SIZE(stats); i++)
+      RARCH_ERR("[DSP]: #%u %s: %.1f%% of real time%s.\n",
+            i, stats[i].ident, stats[i].load * 100.0f,
+            stats[i].threaded ? ", worker thread" : "");
+
+   retro_dsp_filter_free(audio_st->dsp);
+   audio_st->dsp = NULL;
+}
+#endif
+
+#ifdef HAVE_THREADS
+static void audio_driver_process_deinit(audio_driver_state_t *audio_st)
+{
+   if (audio_st->process_thread)
+   {
+      slock_lock(audio_st->ring_lock);
+      audio_st->process_quit = true;
+      scond_signal(audio_st->ring_cond);
+      slock_unlock(audio_st->ring_lock);
+
+      sthread_join(audio_st->process_thread);
+   }
+
+   if (audio_st->process_lock)
+      slock_free(audio_st->process_lock);
+   if (audio_st->write_lock)
+      slock_free(audio_st->write_lock);
+   if (audio_st->ring_lock)
+      slock_free(audio_st->ring_lock);
+   if (audio_st->ring_cond)
+      scond_free(audio_st->ring_cond);
+   if (audio_st->ring)
+      fifo_free(audio_st->ring);
+   if (audio_st->process_buf)
+      memalign_free(audio_st->process_buf);
+   if (audio_st->process_conv_buf)
+      memalign_free(audio_st->process_conv_buf);
+
+   audio_st->process_thread   = NULL;
+   audio_st->process_lock     = NULL;
+   audio_st->write_lock       = NULL;
+   audio_st->ring_lock        = NULL;
+   audio_st->ring_cond        = NULL;
+   audio_st->ring             = NULL;
+   audio_st->process_buf      = NULL;
+   audio_st->process_conv_buf = NULL;
+   audio_st->process_quit     = false;
+}
+#endif
 
 static bool audio_driver_deinit_internal(bool audio_enable)
 {
    audio_driver_state_t *audio_st = &audio_driver_st;
+#ifdef HAVE_THREADS
+   audio_driver_process_deinit(audio_st);
+#endif
    if (     audio_st->current_audio
          && audio_st->current_audio->free)
    {
@@ -326,7 +396,9 @@ static void audio_driver_mixer_deinit(void)
 {
    unsigned i;
 
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.flags &= ~AUDIO_FLAG_MIXER_ACTIVE;
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 
    for (i = 0; i < AUDIO_MIXER_MAX_SYSTEM_STREAMS; i++)
    {
@@ -334,7 +406,9 @@ static void audio_driver_mixer_deinit(void)
       audio_driver_mixer_remove_stream(i);
    }
 
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_mixer_done();
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 #endif
 
@@ -389,29 +463,49 @@ bool audio_driver_find_driver(
    return true;
 }
 
+/**
+ * Describes a chunk of samples from the core,
+ * along with the state it has to be processed in.
+ * When the audio processing thread is running,
+ * each chunk in its ring starts with one of these.
+ **/
+struct audio_chunk
+{
+   /** When the chunk was flushed, for fast-forward timing. */
+   retro_time_t time;
+   /** Size of the chunk, in samples. */
+   size_t samples;
+   /** Samples still queued behind this chunk,
+    * which are about to reach the driver's buffer too. */
+   size_t queued;
+   float slowmotion_ratio;
+   bool fastforward_mute;
+   bool is_slowmotion;
+   bool is_fastforward;
+};
+
 /**
  * Writes audio samples to audio driver's output.
  * Will first perform DSP processing (if enabled) and resampling.
  *
  * @param audio_st The overall state of the audio driver.
- * @param slowmotion_ratio The factor by which slow motion extends the core's runtime
- * (e.g. a value of 2 means the core is running at half speed).
- * @param audio_fastforward_mute True if no audio should be output while the game is in fast-forward.
- * @param data Audio output data that was most recently provided by the core.
- * @param samples The size of \c data, in samples.
- * @param is_slowmotion True if the player is currently running the game in slow motion.
- * @param is_fastmotion True if the player is currently running the game in fast-forward.
+ * @param chunk The chunk to process, see \c audio_chunk.
+ * @param data Audio output data that was provided by the core.
+ * @param conv_buf Scratch buffer for converting the output to 16-bit.
+ * @param output Receives the output to write to the driver.
+ * @return The size of \c output, in bytes.
  **/
-static void audio_driver_flush(
+static size_t audio_driver_process(
       audio_driver_state_t *audio_st,
-      float slowmotion_ratio,
-      bool audio_fastforward_mute,
-      const int16_t *data, size_t samples,
-      bool is_slowmotion, bool is_fastforward)
+      const struct audio_chunk *chunk,
+      const int16_t *data,
+      int16_t *conv_buf,
+      const void **output)
 {
    struct resampler_data src_data;
+   size_t samples                    = chunk->samples;
    float audio_volume_gain           = (audio_st->mute_enable ||
-         (audio_fastforward_mute && is_fastforward))
+         (chunk->fastforward_mute && chunk->is_fastforward))
                ? 0.0f
                : audio_st->volume_gain;
 
@@ -430,6 +524,9 @@ static void audio_driver_flush(
     * (see audio_driver_init) */
 
 #ifdef HAVE_DSP_FILTER
+   if (audio_st->dsp && retro_dsp_filter_over_budget(audio_st->dsp))
+      audio_driver_dsp_filter_drop(audio_st);
+
    if (audio_st->dsp)
    { /* If we want to process our audio for reasons besides resampling... */
       struct retro_dsp_data dsp_data;
@@ -466,12 +563,30 @@ static void audio_driver_flush(
       if (audio_st->flags & AUDIO_FLAG_CONTROL)
       {
          /* Readjust the audio input rate. */
-         int avail                   = (int)audio_st->current_audio->write_avail(
-               audio_st->context_audio_data);
+         int delta_mid;
+         double direction, adjust;
+         int avail;
          int half_size               = (int)(audio_st->buffer_size / 2);
-         int delta_mid               = avail - half_size;
-         double direction            = (double)delta_mid / half_size;
-         double adjust               = 1.0 + audio_st->rate_control_delta * direction;
+
+         AUDIO_DRIVER_WRITE_LOCK(audio_st);
+         avail                       = (int)audio_st->current_audio->write_avail(
+               audio_st->context_audio_data);
+         AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+
+         /* Count what's still queued for the processing
+          * thread, in driver bytes, as already buffered */
+         if (chunk->queued)
+         {
+            avail                   -= (int)(chunk->queued
+                  * audio_st->source_ratio_current
+                  * audio_driver_get_sample_size());
+            if (avail < 0)
+               avail                 = 0;
+         }
+
+         delta_mid                   = avail - half_size;
+         direction                   = (double)delta_mid / half_size;
+         adjust                      = 1.0 + audio_st->rate_control_delta * direction;
 
          audio_st->free_samples_buf[write_idx]
                                      = avail;
@@ -494,11 +609,11 @@ static void audio_driver_flush(
 
    src_data.ratio           = audio_st->source_ratio_current;
 
-   if (is_slowmotion)
-      src_data.ratio       *= slowmotion_ratio;
+   if (chunk->is_slowmotion)
+      src_data.ratio       *= chunk->slowmotion_ratio;
 
-   if (is_fastforward && config_get_ptr()->bools.audio_fastforward_speedup) {
-      const retro_time_t flush_time = cpu_features_get_time_usec();
+   if (chunk->is_fastforward && config_get_ptr()->bools.audio_fastforward_speedup) {
+      const retro_time_t flush_time = chunk->time;
 
       if (audio_st->last_flush_time > 0) {
          /* What we should see if the speed was 1.0x, converted to microsecs */
@@ -550,8 +665,9 @@ static void audio_driver_flush(
    }
 #endif
 
-   /* Now we write our processed audio output to the driver.
-    * It may not be played immediately, depending on the driver implementation. */
+   /* Now we hand our processed audio output back, for the caller to
+    * write to the driver. It may not be played immediately, depending
+    * on the driver implementation. */
    {
       const void *output_data = audio_st->output_samples_buf;
       unsigned output_frames  = (unsigned)src_data.output_frames; /* Unit: frames */
@@ -560,16 +676,217 @@ static void audio_driver_flush(
          output_frames       *= sizeof(float); /* Unit: bytes */
       else
       {
-         convert_float_to_s16(audio_st->output_samples_conv_buf,
+         convert_float_to_s16(conv_buf,
                (const float*)output_data, output_frames * 2);
 
-         output_data          = audio_st->output_samples_conv_buf;
+         output_data          = conv_buf;
          output_frames       *= sizeof(int16_t);  /* Unit: bytes */
       }
 
+      *output                 = output_data;
+      return output_frames * 2;
+   }
+}
+
+#ifdef HAVE_THREADS
+static void audio_driver_process_thread(void *data)
+{
+   audio_driver_state_t *audio_st = (audio_driver_state_t*)data;
+
+   for (;;)
+   {
+      struct audio_chunk chunk;
+      const void *output = NULL;
+      size_t size        = 0;
+      size_t avail       = 0;
+
+      slock_lock(audio_st->ring_lock);
+      while (     !audio_st->process_quit
+            && FIFO_READ_AVAIL(audio_st->ring) < sizeof(chunk))
+         scond_wait(audio_st->ring_cond, audio_st->ring_lock);
+
+      if (audio_st->process_quit)
+      {
+         slock_unlock(audio_st->ring_lock);
+         break;
+      }
+
+      fifo_read(audio_st->ring, &chunk, sizeof(chunk));
+      fifo_read(audio_st->ring, audio_st->process_buf,
+            chunk.samples * sizeof(int16_t));
+      chunk.queued = FIFO_READ_AVAIL(audio_st->ring) / sizeof(int16_t);
+      scond_signal(audio_st->ring_cond);
+      slock_unlock(audio_st->ring_lock);
+
+      slock_lock(audio_st->process_lock);
+      size = audio_driver_process(audio_st, &chunk,
+            audio_st->process_buf, audio_st->process_conv_buf, &output);
+      slock_unlock(audio_st->process_lock);
+
+      /* The write can block until the driver has room. Whatever
+       * room it leaves is recorded for the main thread, which
+       * shouldn't wait here just to ask the driver for it.
+       * The output buffers are only touched from here. */
+      slock_lock(audio_st->write_lock);
       audio_st->current_audio->write(audio_st->context_audio_data,
-            output_data, output_frames * 2);
+            output, size);
+      if (audio_st->current_audio->write_avail)
+         avail = audio_st->current_audio->write_avail(
+               audio_st->context_audio_data);
+      slock_unlock(audio_st->write_lock);
+
+      slock_lock(audio_st->ring_lock);
+      audio_st->process_avail = avail;
+      slock_unlock(audio_st->ring_lock);
+   }
+}
+
+/* Queues a chunk for the processing thread. Like a blocking
+ * driver write, this waits when the thread falls behind. */
+static void audio_driver_process_queue(audio_driver_state_t *audio_st,
+      const struct audio_chunk *chunk, const int16_t *data)
+{
+   size_t size = sizeof(*chunk) + chunk->samples * sizeof(int16_t);
+
+   slock_lock(audio_st->ring_lock);
+   while (     !audio_st->process_quit
+         && FIFO_WRITE_AVAIL(audio_st->ring) < size)
+      scond_wait(audio_st->ring_cond, audio_st->ring_lock);
+
+   if (!audio_st->process_quit)
+   {
+      fifo_write(audio_st->ring, chunk, sizeof(*chunk));
+      fifo_write(audio_st->ring, data, chunk->samples * sizeof(int16_t));
+      scond_signal(audio_st->ring_cond);
+   }
+   slock_unlock(audio_st->ring_lock);
+}
+
+/* Drops chunks the processing thread hasn't picked up yet */
+static void audio_driver_process_clear(audio_driver_state_t *audio_st)
+{
+   if (!audio_st->process_thread)
+      return;
+
+   slock_lock(audio_st->ring_lock);
+   fifo_clear(audio_st->ring);
+   scond_signal(audio_st->ring_cond);
+   slock_unlock(audio_st->ring_lock);
+}
+
+static bool audio_driver_process_init(audio_driver_state_t *audio_st,
+      size_t conv_buf_length)
+{
+   /* Room for the largest chunk (a rewind buffer), or two regular
+    * ones. Latency from the ring is offset by rate control, which
+    * counts what's queued in it. */
+   size_t max_samples         = AUDIO_CHUNK_SIZE_NONBLOCKING * 2;
+   size_t ring_size           = 2 * sizeof(struct audio_chunk)
+      + max_samples * sizeof(int16_t) + 1;
+
+   audio_st->process_quit     = false;
+   audio_st->process_avail    = 0;
+   audio_st->process_lock     = slock_new();
+   audio_st->write_lock       = slock_new();
+   audio_st->ring_lock        = slock_new();
+   audio_st->ring_cond        = scond_new();
+   audio_st->ring             = fifo_new(ring_size);
+   audio_st->process_buf      = (int16_t*)memalign_alloc(64,
+         max_samples * sizeof(int16_t));
+   audio_st->process_conv_buf = (int16_t*)memalign_alloc(64,
+         conv_buf_length);
+
+   if (     !audio_st->process_lock
+         || !audio_st->write_lock
+         || !audio_st->ring_lock
+         || !audio_st->ring_cond
+         || !audio_st->ring
+         || !audio_st->process_buf
+         || !audio_st->process_conv_buf
+         || !(audio_st->process_thread = sthread_create(
+               audio_driver_process_thread, audio_st)))
+   {
+      audio_driver_process_deinit(audio_st);
+      return false;
    }
+
+   return true;
+}
+#endif
+
+size_t audio_driver_write_avail(void)
+{
+   audio_driver_state_t *audio_st = &audio_driver_st;
+
+#ifdef HAVE_THREADS
+   if (audio_st->process_thread)
+   {
+      size_t queued, avail;
+
+      slock_lock(audio_st->ring_lock);
+      queued = FIFO_READ_AVAIL(audio_st->ring) / sizeof(int16_t);
+      avail  = audio_st->process_avail;
+      slock_unlock(audio_st->ring_lock);
+
+      /* Audio still queued for the thread counts as buffered
+       * too. The original ratio, as the thread owns the current one. */
+      queued = (size_t)(queued * audio_st->source_ratio_original
+            * audio_driver_get_sample_size());
+
+      return (avail > queued) ? avail - queued : 0;
+   }
+#endif
+
+   return audio_st->current_audio->write_avail(
+         audio_st->context_audio_data);
+}
+
+/**
+ * Processes audio samples and writes them to the driver, or hands
+ * them to the audio processing thread if it's running.
+ *
+ * @param audio_st The overall state of the audio driver.
+ * @param slowmotion_ratio The factor by which slow motion extends the core's runtime
+ * (e.g. a value of 2 means the core is running at half speed).
+ * @param audio_fastforward_mute True if no audio should be output while the game is in fast-forward.
+ * @param data Audio output data that was most recently provided by the core.
+ * @param samples The size of \c data, in samples.
+ * @param is_slowmotion True if the player is currently running the game in slow motion.
+ * @param is_fastmotion True if the player is currently running the game in fast-forward.
+ **/
+static void audio_driver_flush(
+      audio_driver_state_t *audio_st,
+      float slowmotion_ratio,
+      bool audio_fastforward_mute,
+      const int16_t *data, size_t samples,
+      bool is_slowmotion, bool is_fastforward)
+{
+   struct audio_chunk chunk;
+   retro_time_t trace_start = cpu_features_get_time_usec();
+
+   chunk.time               = trace_start;
+   chunk.samples            = samples;
+   chunk.queued             = 0;
+   chunk.slowmotion_ratio   = slowmotion_ratio;
+   chunk.fastforward_mute   = audio_fastforward_mute;
+   chunk.is_slowmotion      = is_slowmotion;
+   chunk.is_fastforward     = is_fastforward;
+
+#ifdef HAVE_THREADS
+   if (audio_st->process_thread)
+      audio_driver_process_queue(audio_st, &chunk, data);
+   else
+#endif
+   {
+      const void *output = NULL;
+      size_t size        = audio_driver_process(audio_st, &chunk, data,
+            audio_st->output_samples_conv_buf, &output);
+
+      audio_st->current_audio->write(audio_st->context_audio_data,
+            output, size);
+   }
+
+   frame_trace_add(FRAME_TRACE_AUDIO_FLUSH, trace_start);
 }
 
 #ifdef HAVE_AUDIOMIXER
@@ -580,13 +897,21 @@ audio_mixer_stream_t *audio_driver_mixer_get_stream(unsigned i)
    return &audio_driver_st.mixer_streams[i];
 }
 
-const char *audio_driver_mixer_get_stream_name(unsigned i)
+size_t audio_driver_mixer_get_stream_name(unsigned i, char *s, size_t len)
 {
+   size_t _len;
    if (i > (AUDIO_MIXER_MAX_SYSTEM_STREAMS-1))
-      return msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NOT_AVAILABLE);
+      return strlcpy(s,
+            msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NOT_AVAILABLE), len);
+   /* The processing thread frees the name once the stream ends */
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    if (!string_is_empty(audio_driver_st.mixer_streams[i].name))
-      return audio_driver_st.mixer_streams[i].name;
-   return msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NOT_AVAILABLE);
+      _len = strlcpy(s, audio_driver_st.mixer_streams[i].name, len);
+   else
+      _len = strlcpy(s,
+            msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NOT_AVAILABLE), len);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
+   return _len;
 }
 
 #endif
@@ -797,6 +1122,20 @@ bool audio_driver_init_internal(
    audio_mixer_init(settings->uints.audio_output_sample_rate);
 #endif
 
+#ifdef HAVE_THREADS
+   /* A callback driver already runs all of this on its own thread */
+   if (     settings->bools.audio_threaded_processing
+         && !audio_cb_inited
+         && (audio_driver_st.flags & AUDIO_FLAG_ACTIVE))
+   {
+      if (audio_driver_process_init(&audio_driver_st,
+               outsamples_max * sizeof(int16_t)))
+         RARCH_LOG("[Audio]: Processing audio on its own thread.\n");
+      else
+         RARCH_WARN("[Audio]: Failed to start audio processing thread.\n");
+   }
+#endif
+
    /* Threaded driver is initially stopped. */
    if (     (audio_driver_st.flags & AUDIO_FLAG_ACTIVE)
          &&  audio_cb_inited)
@@ -939,9 +1278,38 @@ size_t audio_driver_sample_batch_rewind(
 void audio_driver_dsp_filter_free(void)
 {
    audio_driver_state_t *audio_st  = &audio_driver_st;
-   if (audio_st->dsp)
-      retro_dsp_filter_free(audio_st->dsp);
+   retro_dsp_filter_t *dsp         = NULL;
+
+   AUDIO_DRIVER_LOCK(audio_st);
+   dsp           = audio_st->dsp;
    audio_st->dsp = NULL;
+   AUDIO_DRIVER_UNLOCK(audio_st);
+
+   if (dsp)
+      retro_dsp_filter_free(dsp);
+}
+
+size_t audio_driver_dsp_filter_stats(char *s, size_t len)
+{
+   unsigned i, count;
+   struct retro_dsp_stage_stats stats[32];
+   size_t _len                    = 0;
+   audio_driver_state_t *audio_st = &audio_driver_st;
+
+   if (!len)
+      return 0;
+   s[0] = '\0';
+
+   AUDIO_DRIVER_LOCK(audio_st);
+   count = audio_st->dsp ? retro_dsp_filter_get_stats(audio_st->dsp,
+         stats, ARRAY_SIZE(stats)) : 0;
+   for (i = 0; i < count && i < ARRAY_SIZE(stats) && _len < len; i++)
+      _len += snprintf(s + _len, len - _len, " %-12s %5.2f %%%s\n",
+            stats[i].ident, stats[i].load * 100.0f,
+            stats[i].threaded ? " (worker)" : "");
+   AUDIO_DRIVER_UNLOCK(audio_st);
+
+   return MIN(_len, len - 1);
 }
 
 bool audio_driver_dsp_filter_init(const char *device)
@@ -962,7 +1330,9 @@ bool audio_driver_dsp_filter_init(const char *device)
    if (!audio_driver_dsp)
       return false;
 
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.dsp = audio_driver_dsp;
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 
    return true;
 }
@@ -1063,6 +1433,92 @@ static int audio_mixer_find_index(
    return -1;
 }
 
+/* The helpers below and the stop callbacks, which the processing
+ * thread may run while mixing, expect AUDIO_DRIVER_LOCK to be held */
+static void audio_driver_mixer_play_stream_internal(
+      unsigned i, unsigned type)
+{
+   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
+      return;
+
+   switch (audio_driver_st.mixer_streams[i].state)
+   {
+      case AUDIO_STREAM_STATE_STOPPED:
+         audio_driver_st.mixer_streams[i].voice =
+            audio_mixer_play(audio_driver_st.mixer_streams[i].handle,
+               (type == AUDIO_STREAM_STATE_PLAYING_LOOPED) ? true : false,
+               1.0f, audio_driver_st.resampler_ident,
+               audio_driver_st.resampler_quality,
+               audio_driver_st.mixer_streams[i].stop_cb);
+         audio_driver_st.mixer_streams[i].state = (enum audio_mixer_state)type;
+         break;
+      case AUDIO_STREAM_STATE_PLAYING:
+      case AUDIO_STREAM_STATE_PLAYING_LOOPED:
+      case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
+      case AUDIO_STREAM_STATE_NONE:
+         break;
+   }
+}
+
+static void audio_driver_mixer_stop_stream_internal(unsigned i)
+{
+   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
+      return;
+
+   switch (audio_driver_st.mixer_streams[i].state)
+   {
+      case AUDIO_STREAM_STATE_PLAYING:
+      case AUDIO_STREAM_STATE_PLAYING_LOOPED:
+      case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
+         {
+            audio_mixer_voice_t *voice     = audio_driver_st.mixer_streams[i].voice;
+
+            if (voice)
+               audio_mixer_stop(voice);
+            audio_driver_st.mixer_streams[i].state   = AUDIO_STREAM_STATE_STOPPED;
+            audio_driver_st.mixer_streams[i].volume  = 1.0f;
+         }
+         break;
+      case AUDIO_STREAM_STATE_STOPPED:
+      case AUDIO_STREAM_STATE_NONE:
+         break;
+   }
+}
+
+static void audio_driver_mixer_remove_stream_internal(unsigned i)
+{
+   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
+      return;
+
+   switch (audio_driver_st.mixer_streams[i].state)
+   {
+      case AUDIO_STREAM_STATE_PLAYING:
+      case AUDIO_STREAM_STATE_PLAYING_LOOPED:
+      case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
+         audio_driver_mixer_stop_stream_internal(i);
+         /* fall-through */
+      case AUDIO_STREAM_STATE_STOPPED:
+         {
+            audio_mixer_sound_t *handle = audio_driver_st.mixer_streams[i].handle;
+            if (handle)
+               audio_mixer_destroy(handle);
+
+            if (!string_is_empty(audio_driver_st.mixer_streams[i].name))
+               free(audio_driver_st.mixer_streams[i].name);
+
+            audio_driver_st.mixer_streams[i].state   = AUDIO_STREAM_STATE_NONE;
+            audio_driver_st.mixer_streams[i].stop_cb = NULL;
+            audio_driver_st.mixer_streams[i].volume  = 0.0f;
+            audio_driver_st.mixer_streams[i].handle  = NULL;
+            audio_driver_st.mixer_streams[i].voice   = NULL;
+            audio_driver_st.mixer_streams[i].name    = NULL;
+         }
+         break;
+      case AUDIO_STREAM_STATE_NONE:
+         break;
+   }
+}
+
 static void audio_mixer_play_stop_cb(
       audio_mixer_sound_t *sound, unsigned reason)
 {
@@ -1154,7 +1610,10 @@ static void audio_mixer_play_stop_sequential_cb(
                if (audio_driver_st.mixer_streams[i].state
                      == AUDIO_STREAM_STATE_STOPPED)
                {
-                  audio_driver_mixer_play_stream_sequential(i);
+                  audio_driver_st.mixer_streams[i].stop_cb =
+                     audio_mixer_play_stop_sequential_cb;
+                  audio_driver_mixer_play_stream_internal(i,
+                        AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL);
                   break;
                }
             }
@@ -1202,29 +1661,8 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
    if (params->stream_type == AUDIO_STREAM_TYPE_NONE)
       return false;
 
-   switch (params->slot_selection_type)
-   {
-      case AUDIO_MIXER_SLOT_SELECTION_MANUAL:
-         free_slot = params->slot_selection_idx;
-
-         /* If we are using a manually specified
-          * slot, must free any existing stream
-          * before assigning the new one */
-         audio_driver_mixer_stop_stream(free_slot);
-         audio_driver_mixer_remove_stream(free_slot);
-
-         break;
-      case AUDIO_MIXER_SLOT_SELECTION_AUTOMATIC:
-      default:
-         if (!audio_driver_mixer_get_free_stream_slot(
-                  &free_slot, params->stream_type))
-            return false;
-         break;
-   }
-
-   if (params->state == AUDIO_STREAM_STATE_NONE)
-      return false;
-
+   /* Decoding can take a while, so it's done before
+    * holding up the processing thread */
    if (!(buf = malloc(params->bufsize)))
       return false;
 
@@ -1269,6 +1707,31 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
       return false;
    }
 
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
+
+   switch (params->slot_selection_type)
+   {
+      case AUDIO_MIXER_SLOT_SELECTION_MANUAL:
+         free_slot = params->slot_selection_idx;
+
+         /* If we are using a manually specified
+          * slot, must free any existing stream
+          * before assigning the new one */
+         audio_driver_mixer_stop_stream_internal(free_slot);
+         audio_driver_mixer_remove_stream_internal(free_slot);
+
+         break;
+      case AUDIO_MIXER_SLOT_SELECTION_AUTOMATIC:
+      default:
+         if (!audio_driver_mixer_get_free_stream_slot(
+                  &free_slot, params->stream_type))
+            goto error;
+         break;
+   }
+
+   if (params->state == AUDIO_STREAM_STATE_NONE)
+      goto error;
+
    switch (params->state)
    {
       case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
@@ -1297,40 +1760,29 @@ bool audio_driver_mixer_add_stream(audio_mixer_stream_params_t *params)
    audio_driver_st.mixer_streams[free_slot].volume      = params->volume;
    audio_driver_st.mixer_streams[free_slot].stop_cb     = stop_cb;
 
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
+
    return true;
+
+error:
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
+   /* Frees @buf along with the decoded sound */
+   audio_mixer_destroy(handle);
+   return false;
 }
 
 enum audio_mixer_state audio_driver_mixer_get_stream_state(unsigned i)
 {
+   enum audio_mixer_state state;
+
    if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return AUDIO_STREAM_STATE_NONE;
 
-   return audio_driver_st.mixer_streams[i].state;
-}
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
+   state = audio_driver_st.mixer_streams[i].state;
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 
-static void audio_driver_mixer_play_stream_internal(
-      unsigned i, unsigned type)
-{
-   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
-      return;
-
-   switch (audio_driver_st.mixer_streams[i].state)
-   {
-      case AUDIO_STREAM_STATE_STOPPED:
-         audio_driver_st.mixer_streams[i].voice =
-            audio_mixer_play(audio_driver_st.mixer_streams[i].handle,
-               (type == AUDIO_STREAM_STATE_PLAYING_LOOPED) ? true : false,
-               1.0f, audio_driver_st.resampler_ident,
-               audio_driver_st.resampler_quality,
-               audio_driver_st.mixer_streams[i].stop_cb);
-         audio_driver_st.mixer_streams[i].state = (enum audio_mixer_state)type;
-         break;
-      case AUDIO_STREAM_STATE_PLAYING:
-      case AUDIO_STREAM_STATE_PLAYING_LOOPED:
-      case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
-      case AUDIO_STREAM_STATE_NONE:
-         break;
-   }
+   return state;
 }
 
 static void audio_driver_load_menu_bgm_callback(retro_task_t *task,
@@ -1470,21 +1922,27 @@ end:
 
 void audio_driver_mixer_play_stream(unsigned i)
 {
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_streams[i].stop_cb = audio_mixer_play_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 void audio_driver_mixer_play_menu_sound_looped(unsigned i)
 {
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_streams[i].stop_cb = audio_mixer_menu_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING_LOOPED);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 void audio_driver_mixer_play_menu_sound(unsigned i)
 {
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_streams[i].stop_cb = audio_mixer_menu_stop_cb;
-   audio_driver_mixer_stop_stream(i);
+   audio_driver_mixer_stop_stream_internal(i);
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 void audio_driver_mixer_play_scroll_sound(bool direction_up)
@@ -1498,22 +1956,32 @@ void audio_driver_mixer_play_scroll_sound(bool direction_up)
 
 void audio_driver_mixer_play_stream_looped(unsigned i)
 {
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_streams[i].stop_cb = audio_mixer_play_stop_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING_LOOPED);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 void audio_driver_mixer_play_stream_sequential(unsigned i)
 {
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_streams[i].stop_cb = audio_mixer_play_stop_sequential_cb;
    audio_driver_mixer_play_stream_internal(i, AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 float audio_driver_mixer_get_stream_volume(unsigned i)
 {
+   float volume;
+
    if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return 0.0f;
 
-   return audio_driver_st.mixer_streams[i].volume;
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
+   volume = audio_driver_st.mixer_streams[i].volume;
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
+
+   return volume;
 }
 
 void audio_driver_mixer_set_stream_volume(unsigned i, float vol)
@@ -1523,6 +1991,7 @@ void audio_driver_mixer_set_stream_volume(unsigned i, float vol)
    if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return;
 
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_streams[i].volume = vol;
 
    voice                                  =
@@ -1530,72 +1999,29 @@ void audio_driver_mixer_set_stream_volume(unsigned i, float vol)
 
    if (voice)
       audio_mixer_voice_set_volume(voice, DB_TO_GAIN(vol));
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 void audio_driver_mixer_stop_stream(unsigned i)
 {
-   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
-      return;
-
-   switch (audio_driver_st.mixer_streams[i].state)
-   {
-      case AUDIO_STREAM_STATE_PLAYING:
-      case AUDIO_STREAM_STATE_PLAYING_LOOPED:
-      case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
-         {
-            audio_mixer_voice_t *voice     = audio_driver_st.mixer_streams[i].voice;
-
-            if (voice)
-               audio_mixer_stop(voice);
-            audio_driver_st.mixer_streams[i].state   = AUDIO_STREAM_STATE_STOPPED;
-            audio_driver_st.mixer_streams[i].volume  = 1.0f;
-         }
-         break;
-      case AUDIO_STREAM_STATE_STOPPED:
-      case AUDIO_STREAM_STATE_NONE:
-         break;
-   }
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
+   audio_driver_mixer_stop_stream_internal(i);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 void audio_driver_mixer_remove_stream(unsigned i)
 {
-   if (i >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
-      return;
-
-   switch (audio_driver_st.mixer_streams[i].state)
-   {
-      case AUDIO_STREAM_STATE_PLAYING:
-      case AUDIO_STREAM_STATE_PLAYING_LOOPED:
-      case AUDIO_STREAM_STATE_PLAYING_SEQUENTIAL:
-         audio_driver_mixer_stop_stream(i);
-         /* fall-through */
-      case AUDIO_STREAM_STATE_STOPPED:
-         {
-            audio_mixer_sound_t *handle = audio_driver_st.mixer_streams[i].handle;
-            if (handle)
-               audio_mixer_destroy(handle);
-
-            if (!string_is_empty(audio_driver_st.mixer_streams[i].name))
-               free(audio_driver_st.mixer_streams[i].name);
-
-            audio_driver_st.mixer_streams[i].state   = AUDIO_STREAM_STATE_NONE;
-            audio_driver_st.mixer_streams[i].stop_cb = NULL;
-            audio_driver_st.mixer_streams[i].volume  = 0.0f;
-            audio_driver_st.mixer_streams[i].handle  = NULL;
-            audio_driver_st.mixer_streams[i].voice   = NULL;
-            audio_driver_st.mixer_streams[i].name    = NULL;
-         }
-         break;
-      case AUDIO_STREAM_STATE_NONE:
-         break;
-   }
-
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
+   audio_driver_mixer_remove_stream_internal(i);
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
 }
 
 bool audio_driver_mixer_toggle_mute(void)
 {
+   AUDIO_DRIVER_LOCK(&audio_driver_st);
    audio_driver_st.mixer_mute_enable  =
       !audio_driver_st.mixer_mute_enable;
+   AUDIO_DRIVER_UNLOCK(&audio_driver_st);
    return true;
 }
 #endif
@@ -1655,24 +2081,35 @@ bool audio_driver_has_callback(void)
 
 static INLINE bool audio_driver_alive(void)
 {
+   bool alive                     = false;
    audio_driver_state_t *audio_st = &audio_driver_st;
    if (     audio_st->current_audio
          && audio_st->current_audio->alive
          && audio_st->context_audio_data)
-      return audio_st->current_audio->alive(audio_st->context_audio_data);
-   return false;
+   {
+      AUDIO_DRIVER_WRITE_LOCK(audio_st);
+      alive = audio_st->current_audio->alive(audio_st->context_audio_data);
+      AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+   }
+   return alive;
 }
 
 bool audio_driver_start(bool is_shutdown)
 {
+   bool started;
    audio_driver_state_t *audio_st = &audio_driver_st;
    if (
             !audio_st->current_audio
          || !audio_st->current_audio->start
          || !audio_st->context_audio_data)
       goto error;
-   if (!audio_st->current_audio->start(
-            audio_st->context_audio_data, is_shutdown))
+
+   AUDIO_DRIVER_WRITE_LOCK(audio_st);
+   started = audio_st->current_audio->start(
+         audio_st->context_audio_data, is_shutdown);
+   AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+
+   if (!started)
       goto error;
 
    RARCH_DBG("[Audio]: Started audio driver \"%s\" (is_shutdown=%s)\n",
@@ -1697,8 +2134,15 @@ bool audio_driver_stop(void)
          || !audio_driver_alive()
       )
       return false;
+
+#ifdef HAVE_THREADS
+   /* Don't let queued audio restart the driver */
+   audio_driver_process_clear(&audio_driver_st);
+#endif
+   AUDIO_DRIVER_WRITE_LOCK(&audio_driver_st);
    stopped = audio_driver_st.current_audio->stop(
          audio_driver_st.context_audio_data);
+   AUDIO_DRIVER_WRITE_UNLOCK(&audio_driver_st);
 
    if (stopped)
       RARCH_DBG("[Audio]: Stopped audio driver \"%s\"\n", audio_driver_st.current_audio->ident);
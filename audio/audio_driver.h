@@ -39,11 +39,43 @@
 #include <audio/audio_mixer.h>
 #endif
 #include <audio/audio_resampler.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <queues/fifo_queue.h>
+#endif
 
 #include "audio_defines.h"
 
 #define AUDIO_BUFFER_FREE_SAMPLES_COUNT (8 * 1024)
 
+#ifdef HAVE_THREADS
+/* Serializes changes to the DSP filter and the mixer with
+ * the audio processing thread, if it's running */
+#define AUDIO_DRIVER_LOCK(audio_st) \
+   if ((audio_st)->process_lock) \
+      slock_lock((audio_st)->process_lock)
+
+#define AUDIO_DRIVER_UNLOCK(audio_st) \
+   if ((audio_st)->process_lock) \
+      slock_unlock((audio_st)->process_lock)
+
+/* Serializes every call into the audio driver with the
+ * processing thread's write. Taken after AUDIO_DRIVER_LOCK
+ * when both are needed. */
+#define AUDIO_DRIVER_WRITE_LOCK(audio_st) \
+   if ((audio_st)->write_lock) \
+      slock_lock((audio_st)->write_lock)
+
+#define AUDIO_DRIVER_WRITE_UNLOCK(audio_st) \
+   if ((audio_st)->write_lock) \
+      slock_unlock((audio_st)->write_lock)
+#else
+#define AUDIO_DRIVER_LOCK(audio_st)         ((void)0)
+#define AUDIO_DRIVER_UNLOCK(audio_st)       ((void)0)
+#define AUDIO_DRIVER_WRITE_LOCK(audio_st)   ((void)0)
+#define AUDIO_DRIVER_WRITE_UNLOCK(audio_st) ((void)0)
+#endif
+
 RETRO_BEGIN_DECLS
 
 #ifdef HAVE_AUDIOMIXER
@@ -253,6 +285,32 @@ typedef struct
    retro_time_t last_flush_time;
    /* Exponential moving average */
    retro_time_t avg_flush_delta;
+
+#ifdef HAVE_THREADS
+   /**
+    * Optional thread doing everything audio_driver_flush() would,
+    * from conversion to the driver write, off the main thread.
+    * Chunks reach it through a ring of raw samples.
+    */
+   sthread_t *process_thread;
+   /* Held by the thread while it processes a chunk */
+   slock_t *process_lock;
+   /* Held by the thread during the driver write, which may
+    * block, and by anything else calling into the driver */
+   slock_t *write_lock;
+   slock_t *ring_lock;
+   /* Signalled when the ring gets data, room, or on shutdown */
+   scond_t *ring_cond;
+   fifo_buffer_t *ring;
+   /* The thread's own copy of the chunk being processed,
+    * and its own buffer for converting the output to 16-bit */
+   int16_t *process_buf;
+   int16_t *process_conv_buf;
+   /* The driver's write_avail() after the thread's last write,
+    * guarded by ring_lock */
+   size_t process_avail;
+   bool process_quit;
+#endif
 } audio_driver_state_t;
 
 bool audio_driver_enable_callback(void);
@@ -263,6 +321,18 @@ bool audio_driver_mixer_extension_supported(const char *ext);
 
 void audio_driver_dsp_filter_free(void);
 
+/**
+ * audio_driver_dsp_filter_stats:
+ * @s   : buffer for one line per filter of the chain.
+ * @len : size of @s.
+ *
+ * Writes the share of real time each filter of the active
+ * DSP chain took over the last second of audio.
+ *
+ * Returns: length of the text, 0 without a chain.
+ **/
+size_t audio_driver_dsp_filter_stats(char *s, size_t len);
+
 bool audio_driver_dsp_filter_init(const char *device);
 
 void audio_driver_set_buffer_size(size_t bufsize);
@@ -271,6 +341,16 @@ bool audio_driver_get_devices_list(void **ptr);
 
 void audio_driver_setup_rewind(void);
 
+/**
+ * audio_driver_write_avail:
+ *
+ * Returns: how many bytes the driver could take without
+ * blocking. With the audio processing thread running, this is
+ * estimated from what the thread last saw, less what it has
+ * yet to write, rather than waiting on the driver.
+ **/
+size_t audio_driver_write_avail(void);
+
 bool audio_driver_callback(void);
 
 bool audio_driver_has_callback(void);
@@ -310,7 +390,7 @@ void audio_driver_mixer_remove_stream(unsigned i);
 
 enum audio_mixer_state audio_driver_mixer_get_stream_state(unsigned i);
 
-const char *audio_driver_mixer_get_stream_name(unsigned i);
+size_t audio_driver_mixer_get_stream_name(unsigned i, char *s, size_t len);
 
 void audio_driver_load_system_sounds(void);
 
@@ -1420,6 +1420,8 @@ void cheat_manager_apply_retro_cheats(void)
       if (!cheat_st->memory_initialized)
          return;
 
+      core_state_invalidate();
+
       if (!run_cheat)
       {
          run_cheat = true;
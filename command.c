@@ -59,6 +59,7 @@
 #include "cheat_manager.h"
 #include "content.h"
 #include "dynamic.h"
+#include "frame_trace.h"
 #include "list_special.h"
 #include "paths.h"
 #include "retroarch.h"
@@ -755,6 +756,73 @@ bool command_play_replay_slot(command_t *cmd, const char *arg)
 #endif
 }
 
+bool command_seek_rewind(command_t *cmd, const char *arg)
+{
+#ifdef HAVE_REWIND
+   char reply[128]              = "";
+   runloop_state_t *runloop_st  = runloop_state_get_ptr();
+   settings_t *settings         = config_get_ptr();
+   unsigned granularity         = settings->uints.rewind_granularity;
+   unsigned frames              = (unsigned)strtoul(arg, NULL, 10);
+   /* The buffer holds one entry every 'granularity' frames */
+   unsigned entries             = granularity
+      ? (frames + granularity - 1) / granularity
+      : frames;
+   bool ret                     = state_manager_seek(
+         &runloop_st->rewind_st, entries);
+
+   if (ret)
+      command_post_state_loaded();
+
+   snprintf(reply, sizeof(reply) - 1, "SEEK_REWIND %u %s",
+         frames, ret ? "OK" : "FAILED");
+   cmd->replier(cmd, reply, strlen(reply));
+   return ret;
+#else
+   return false;
+#endif
+}
+
+/* Only letters, digits, '-', '_' and '.', not starting with a dot.
+ * Network commands can come from anywhere, so no paths. */
+static bool command_is_plain_file_name(const char *name)
+{
+   const char *c;
+
+   if (string_is_empty(name) || *name == '.')
+      return false;
+
+   for (c = name; *c; c++)
+   {
+      if (     !ISALNUM((unsigned char)*c)
+            && *c != '-' && *c != '_' && *c != '.')
+         return false;
+   }
+
+   return (c - name) < 128;
+}
+
+bool command_dump_frame_trace(command_t *cmd, const char *arg)
+{
+   char path[PATH_MAX_LENGTH];
+   char reply[128]              = "";
+   settings_t *settings         = config_get_ptr();
+   const char *log_dir          = settings->paths.log_dir;
+   bool ret                     = false;
+
+   /* The trace always goes to the log directory */
+   if (     !string_is_empty(log_dir)
+         && command_is_plain_file_name(arg))
+   {
+      fill_pathname_join_special(path, log_dir, arg, sizeof(path));
+      ret = frame_trace_write(path);
+   }
+
+   snprintf(reply, sizeof(reply) - 1, "DUMP_FRAME_TRACE %s",
+         ret ? "OK" : "FAILED");
+   cmd->replier(cmd, reply, strlen(reply));
+   return ret;
+}
 
 #if defined(HAVE_CHEEVOS)
 bool command_read_ram(command_t *cmd, const char *arg)
@@ -808,6 +876,8 @@ bool command_write_ram(command_t *cmd, const char *arg)
       rcheevos_pause_hardcore();
    }
 
+   core_state_invalidate();
+
    while (*arg)
    {
       *data = strtoul(arg, (char**)&arg, 16);
@@ -1004,6 +1074,7 @@ bool command_write_memory(command_t *cmd, const char *arg)
    if (data)
    {
       uint8_t* start = data;
+      core_state_invalidate();
       while (*arg && max_bytes > 0)
       {
          --max_bytes;
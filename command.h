@@ -417,6 +417,8 @@ bool command_get_config_param(command_t *cmd, const char* arg);
 bool command_show_osd_msg(command_t *cmd, const char* arg);
 bool command_load_state_slot(command_t *cmd, const char* arg);
 bool command_play_replay_slot(command_t *cmd, const char* arg);
+bool command_seek_rewind(command_t *cmd, const char* arg);
+bool command_dump_frame_trace(command_t *cmd, const char* arg);
 #ifdef HAVE_CHEEVOS
 bool command_read_ram(command_t *cmd, const char *arg);
 bool command_write_ram(command_t *cmd, const char *arg);
@@ -443,6 +445,10 @@ static const struct cmd_action_map action_map[] = {
 
    { "LOAD_STATE_SLOT",command_load_state_slot, "<slot number>"},
    { "PLAY_REPLAY_SLOT",command_play_replay_slot, "<slot number>"},
+#ifdef HAVE_REWIND
+   { "SEEK_REWIND",     command_seek_rewind,      "<number of frames>"},
+#endif
+   { "DUMP_FRAME_TRACE",command_dump_frame_trace, "<file name in the log directory, .json for Chrome trace format>"},
 };
 
 static const struct cmd_map map[] = {
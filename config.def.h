@@ -465,6 +465,10 @@
 /* Graphics context specific scaling */
 #define DEFAULT_VIDEO_CTX_SCALING false
 
+/* Network video driver sends only what changed
+ * in each frame, see gfx/drivers/network_gfx.c */
+#define DEFAULT_VIDEO_NETWORK_DELTA false
+
 /* On resize and fullscreen, rendering area will stay 4:3 */
 #define DEFAULT_FORCE_ASPECT true
 
@@ -1140,6 +1144,10 @@
 /* Will sync audio. (recommended) */
 #define DEFAULT_AUDIO_SYNC true
 
+/* Resample, filter and write audio on a separate thread,
+ * so a blocking audio driver doesn't stall the core. */
+#define DEFAULT_AUDIO_THREADED_PROCESSING false
+
 /* Audio rate control. */
 #if !defined(RARCH_CONSOLE)
 #define DEFAULT_RATE_CONTROL true
@@ -1218,6 +1226,10 @@
  * depending on the save state buffer. */
 #define DEFAULT_REWIND_ENABLE false
 
+/* Compresses rewind states on a worker thread while
+ * the core runs the next frame. */
+#define DEFAULT_REWIND_ASYNC false
+
 /* When set, any time a cheat is toggled it is immediately applied. */
 #define DEFAULT_APPLY_CHEATS_AFTER_TOGGLE false
 
@@ -1242,6 +1254,14 @@
 #define DEFAULT_REWIND_GRANULARITY 1
 #endif
 
+/* Store a full savestate every N rewind steps so seeking
+ * back doesn't need to replay every patch. 0 disables. */
+#define DEFAULT_REWIND_KEYFRAME_INTERVAL 0
+
+/* Deflate level applied to rewind states on top of
+ * the delta encoding. 0 disables. */
+#define DEFAULT_REWIND_COMPRESSION_LEVEL 0
+
 /* Pause gameplay when window loses focus. */
 #if defined(EMSCRIPTEN)
 #define DEFAULT_PAUSE_NONACTIVE false
@@ -1389,6 +1409,10 @@
 /* When using the Run Ahead feature, use a secondary instance of the core. */
 #define DEFAULT_RUN_AHEAD_SECONDARY_INSTANCE true
 
+/* When using a secondary instance for Run Ahead, number of extra
+ * instances that run ahead on worker threads with guessed input. */
+#define DEFAULT_RUN_AHEAD_SPECULATIVE_INSTANCES 0
+
 /* Hide warning messages when using the Run Ahead feature. */
 #define DEFAULT_RUN_AHEAD_HIDE_WARNINGS false
 /* Hide warning messages when using Preemptive Frames. */
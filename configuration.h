@@ -217,6 +217,8 @@ typedef struct settings
       unsigned libretro_log_level;
       unsigned rewind_granularity;
       unsigned rewind_buffer_size_step;
+      unsigned rewind_keyframe_interval;
+      unsigned rewind_compression_level;
       unsigned autosave_interval;
       unsigned replay_checkpoint_interval;
       unsigned replay_max_keep;
@@ -322,6 +324,7 @@ typedef struct settings
 #endif
 
       unsigned run_ahead_frames;
+      unsigned run_ahead_speculative_instances;
 
       unsigned midi_volume;
       unsigned streaming_mode;
@@ -616,6 +619,9 @@ typedef struct settings
 #endif
       bool video_wiiu_prefer_drc;
       bool video_notch_write_over_enable;
+#ifdef HAVE_NETWORK_VIDEO
+      bool video_network_delta;
+#endif
       bool video_hdr_enable;
       bool video_hdr_expand_gamut;
 
@@ -631,6 +637,7 @@ typedef struct settings
       bool audio_enable_menu_bgm;
       bool audio_enable_menu_scroll;
       bool audio_sync;
+      bool audio_threaded_processing;
       bool audio_rate_control;
       bool audio_fastforward_mute;
       bool audio_fastforward_speedup;
@@ -941,6 +948,7 @@ typedef struct settings
       bool history_list_enable;
       bool playlist_entry_rename;
       bool rewind_enable;
+      bool rewind_async;
       bool fastforward_frameskip;
       bool vrr_runloop_enable;
       bool menu_throttle_framerate;
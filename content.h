@@ -72,6 +72,9 @@ bool content_serialize_state_rewind(void* buffer, size_t buffer_size);
 /* Deserializes the current state. */
 bool content_deserialize_state(const void* serialized_data, size_t serialized_size);
 
+/* Deserializes a state taken by content_serialize_state_rewind. */
+bool content_deserialize_state_rewind(const void* serialized_data, size_t serialized_size);
+
 /* Waits for any in-progress save state tasks to finish */
 void content_wait_for_save_state_task(void);
 /* Waits for any in-progress load state tasks to finish */
@@ -103,6 +106,10 @@ bool content_init(void);
 /* Resets the state and savefile backup buffers */
 void content_reset_savestate_backups(void);
 
+/* Frees the savestate buffer pool; no save
+ * or load task may be running. */
+void content_state_pool_deinit(void);
+
 /* Checks if the buffers are empty */
 bool content_undo_load_buf_is_empty(void);
 bool content_undo_save_buf_is_empty(void);
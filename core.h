@@ -51,6 +51,19 @@ bool core_serialize_special(retro_ctx_serialize_info_t *info);
 bool core_unserialize(retro_ctx_serialize_info_t *info);
 bool core_unserialize_special(retro_ctx_serialize_info_t *info);
 
+/* Rewind, run-ahead, preemptive frames and netplay each
+ * register as a user of the state cache. Once two or more are
+ * active, the last special savestate taken from or loaded into
+ * the core is kept, and serializing the same core state again
+ * copies it from there instead of calling into the core. */
+void core_state_cache_acquire(void);
+void core_state_cache_release(void);
+bool core_state_cache_shared(void);
+
+/* Marks the core state as changed. Call whenever the core
+ * runs or its memory is modified behind its back. */
+void core_state_invalidate(void);
+
 bool core_set_cheat(retro_ctx_cheat_info_t *info);
 
 bool core_reset_cheat(void);
@@ -345,6 +345,7 @@ bool disk_control_set_eject_state(
       return false;
 
    /* Set eject state */
+   core_state_invalidate();
    if (disk_control->cb.set_eject_state(eject))
       strlcpy(
             msg,
@@ -429,6 +430,7 @@ bool disk_control_set_index(
    num_images = disk_control->cb.get_num_images();
 
    /* Perform 'set index' action */
+   core_state_invalidate();
    error = !disk_control->cb.set_image_index(index);
 
    /* Get log/notification message */
@@ -608,6 +610,7 @@ bool disk_control_append_image(
       goto error;
 
    /* Append image */
+   core_state_invalidate();
    if (!disk_control->cb.add_image_index())
       goto error;
 
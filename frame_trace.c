@@ -0,0 +1,170 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <retro_endianness.h>
+#include <features/features_cpu.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#include "frame_trace.h"
+
+#define FRAME_TRACE_MAGIC   0x52544652 /* "RFTR" */
+#define FRAME_TRACE_VERSION 1
+
+struct frame_trace_event
+{
+   retro_time_t start;
+   uint32_t duration;
+   uint32_t frame;
+   uint32_t stage;
+};
+
+typedef struct frame_trace
+{
+   struct frame_trace_event events[FRAME_TRACE_SIZE];
+   size_t pos;
+   size_t count;
+   uint32_t frame;
+} frame_trace_t;
+
+static frame_trace_t frame_trace_st;
+
+static const char *frame_trace_stage_names[FRAME_TRACE_STAGE_LAST] = {
+   "frame",
+   "input_poll",
+   "core_run",
+   "run_ahead",
+   "audio_flush",
+   "video_frame",
+   "frame_delay"
+};
+
+retro_time_t frame_trace_begin_frame(void)
+{
+   frame_trace_st.frame++;
+   return cpu_features_get_time_usec();
+}
+
+void frame_trace_add(enum frame_trace_stage stage, retro_time_t start)
+{
+   frame_trace_t *trace            = &frame_trace_st;
+   struct frame_trace_event *event = &trace->events[trace->pos];
+
+   event->start    = start;
+   event->duration = (uint32_t)(cpu_features_get_time_usec() - start);
+   event->frame    = trace->frame;
+   event->stage    = (uint32_t)stage;
+
+   if (++trace->pos == FRAME_TRACE_SIZE)
+      trace->pos   = 0;
+   if (trace->count < FRAME_TRACE_SIZE)
+      trace->count++;
+}
+
+void frame_trace_clear(void)
+{
+   frame_trace_st.pos   = 0;
+   frame_trace_st.count = 0;
+}
+
+static const struct frame_trace_event *frame_trace_get(
+      const frame_trace_t *trace, size_t i)
+{
+   /* Oldest event first */
+   size_t first = (trace->count < FRAME_TRACE_SIZE) ? 0 : trace->pos;
+   return &trace->events[(first + i) % FRAME_TRACE_SIZE];
+}
+
+static bool frame_trace_write_json(const frame_trace_t *trace,
+      RFILE *file)
+{
+   size_t i;
+
+   filestream_printf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+   for (i = 0; i < trace->count; i++)
+   {
+      const struct frame_trace_event *event = frame_trace_get(trace, i);
+
+      /* Complete events on a single track nest by time */
+      filestream_printf(file,
+            "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%lld,\"dur\":%u,\"args\":{\"frame\":%u}}\n",
+            i ? "," : "",
+            frame_trace_stage_names[event->stage],
+            (long long)event->start,
+            (unsigned)event->duration,
+            (unsigned)event->frame);
+   }
+
+   filestream_printf(file, "]}\n");
+   return filestream_error(file) == 0;
+}
+
+static bool frame_trace_write_binary(const frame_trace_t *trace,
+      RFILE *file)
+{
+   size_t i;
+   uint32_t header[3];
+
+   header[0] = retro_cpu_to_le32(FRAME_TRACE_MAGIC);
+   header[1] = retro_cpu_to_le32(FRAME_TRACE_VERSION);
+   header[2] = retro_cpu_to_le32((uint32_t)trace->count);
+
+   if (filestream_write(file, header, sizeof(header)) != sizeof(header))
+      return false;
+
+   for (i = 0; i < trace->count; i++)
+   {
+      uint32_t record[5];
+      const struct frame_trace_event *event = frame_trace_get(trace, i);
+      uint64_t start = retro_cpu_to_le64((uint64_t)event->start);
+
+      memcpy(record, &start, sizeof(start));
+      record[2] = retro_cpu_to_le32(event->duration);
+      record[3] = retro_cpu_to_le32(event->frame);
+      record[4] = retro_cpu_to_le32(event->stage);
+
+      if (filestream_write(file, record, sizeof(record)) != sizeof(record))
+         return false;
+   }
+
+   return true;
+}
+
+bool frame_trace_write(const char *path)
+{
+   bool ret;
+   RFILE *file;
+
+   if (string_is_empty(path))
+      return false;
+
+   if (!(file = filestream_open(path,
+               RETRO_VFS_FILE_ACCESS_WRITE,
+               RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return false;
+
+   if (string_is_equal_noncase(path_get_extension(path), "json"))
+      ret = frame_trace_write_json(&frame_trace_st, file);
+   else
+      ret = frame_trace_write_binary(&frame_trace_st, file);
+
+   filestream_close(file);
+   return ret;
+}
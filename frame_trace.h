@@ -0,0 +1,91 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FRAME_TRACE_H
+#define _FRAME_TRACE_H
+
+#include <stdint.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <libretro.h>
+
+RETRO_BEGIN_DECLS
+
+/* Per-frame timeline of the main loop stages between input
+ * polling and presentation, unlike the performance counters
+ * which only keep totals.
+ *
+ * Each stage records its start and duration into a fixed ring
+ * buffer holding the last FRAME_TRACE_SIZE events, so it stays
+ * enabled at all times. Only to be used from the main thread. */
+
+#ifndef FRAME_TRACE_SIZE
+#define FRAME_TRACE_SIZE 4096
+#endif
+
+enum frame_trace_stage
+{
+   FRAME_TRACE_FRAME = 0,
+   FRAME_TRACE_INPUT_POLL,
+   FRAME_TRACE_CORE_RUN,
+   FRAME_TRACE_RUN_AHEAD,
+   FRAME_TRACE_AUDIO_FLUSH,
+   FRAME_TRACE_VIDEO_FRAME,
+   FRAME_TRACE_FRAME_DELAY,
+   FRAME_TRACE_STAGE_LAST
+};
+
+/**
+ * frame_trace_begin_frame:
+ *
+ * Starts a new frame; events added from now on are tagged with it.
+ *
+ * Returns: start time to pass to frame_trace_add(FRAME_TRACE_FRAME)
+ * once the frame is done.
+ **/
+retro_time_t frame_trace_begin_frame(void);
+
+/**
+ * frame_trace_add:
+ * @stage                : stage that just finished.
+ * @start                : time it started, from
+ *                         cpu_features_get_time_usec().
+ *
+ * Records @stage as running from @start until now.
+ **/
+void frame_trace_add(enum frame_trace_stage stage, retro_time_t start);
+
+void frame_trace_clear(void);
+
+/**
+ * frame_trace_write:
+ * @path                 : file to write.
+ *
+ * Writes the events currently in the ring buffer, oldest first.
+ * Paths ending in '.json' get the Chrome trace event format, which
+ * chrome://tracing and Perfetto can open. Anything else gets the
+ * compact binary format:
+ *
+ *   "RFTR", uint32 version (1), uint32 event count, then per event
+ *   uint64 start (usec), uint32 duration (usec), uint32 frame,
+ *   uint32 stage (enum frame_trace_stage). All little endian.
+ *
+ * Returns: true on success.
+ **/
+bool frame_trace_write(const char *path);
+
+RETRO_END_DECLS
+
+#endif
@@ -22,6 +22,7 @@
 #include "SDL.h"
 
 #include "../video_defines.h"
+#include "../video_dirty.h"
 #include "../font_driver.h"
 #include "../../retroarch.h"
 
@@ -53,6 +54,8 @@ typedef struct _sdl2_video
    sdl2_tex_t menu;  /* ptr alignment */
    sdl2_tex_t font;  /* ptr alignment */
 
+   video_dirty_t dirty; /* ptr alignment */
+
    SDL_Window *window;
    SDL_Renderer *renderer;
 
@@ -20,10 +20,13 @@
 
 #include <sixel.h>
 
+#include "../video_dirty.h"
+
 #define SIXEL_COLORS 256
 
 typedef struct sixel
 {
+   video_dirty_t dirty;
    SIXELSTATUS sixel_status;
    unsigned video_width;
    unsigned video_height;
@@ -18,7 +18,11 @@
 #include <retro_miscellaneous.h>
 #include <retro_timers.h>
 #include <stdlib.h>
+#include <string.h>
 #include <compat/strl.h>
+#ifdef HAVE_ZLIB
+#include <streams/trans_stream.h>
+#endif
 
 #ifdef HAVE_NETWORKING
 #include <net/net_compat.h>
@@ -50,6 +54,42 @@ enum
    NETWORK_VIDEO_PIXELFORMAT_RGB565
 } network_video_pixelformat;
 
+/* By default every frame is sent as screen_width * screen_height
+ * 32-bit pixels, with nothing else on the wire.
+ *
+ * With video_network_delta enabled, only the parts of the frame that
+ * changed are sent instead. The stream starts with
+ *
+ *   char magic[4] "RNVD", uint32 version (1)
+ *
+ * followed by one packet per frame:
+ *
+ *   uint32 width, height   frame size in pixels
+ *   uint32 format          NETWORK_VIDEO_PIXELFORMAT_*; 4 bytes per pixel
+ *   uint32 tile_size       edge of a tile in pixels
+ *   uint32 tiles           number of tiles in the payload
+ *   uint32 flags           NETWORK_VIDEO_FLAG_*
+ *   uint32 size            payload size in bytes
+ *   uint8  payload[size]
+ *
+ * With NETWORK_VIDEO_FLAG_ZLIB set the payload is a zlib stream,
+ * otherwise it is stored as is. Once inflated, it holds for each tile
+ * that differs from the previous frame:
+ *
+ *   uint16 x, y            tile column and row
+ *   uint32 pixels[]        the tile's pixels, row by row, clipped
+ *                          to the frame, XORed with the previous frame
+ *
+ * The previous frame is all zeroes at the start of the stream and
+ * whenever width or height change. Header fields are big endian,
+ * pixels are in host order as in the raw stream.
+ *
+ * tools/netvideorecv decodes this stream. */
+#define NETWORK_VIDEO_DELTA_MAGIC   0x524E5644 /* "RNVD" */
+#define NETWORK_VIDEO_DELTA_VERSION 1
+#define NETWORK_VIDEO_TILE_SIZE     16
+#define NETWORK_VIDEO_FLAG_ZLIB     (1 << 0)
+
 typedef struct network
 {
    int fd;
@@ -57,8 +97,19 @@ typedef struct network
    unsigned video_height;
    unsigned screen_width;
    unsigned screen_height;
+   uint32_t *delta_prev;
+   uint8_t *delta_buf;
+   uint8_t *delta_zbuf;
+#ifdef HAVE_ZLIB
+   void *delta_stream;
+#endif
+   size_t delta_buf_size;
+   size_t delta_zbuf_size;
+   unsigned delta_width;
+   unsigned delta_height;
    uint16_t port;
    char address[256];
+   bool delta;
 } network_video_t;
 
 static unsigned char *network_menu_frame = NULL;
@@ -90,6 +141,175 @@ static void gfx_ctx_network_input_driver(
    *input_data = NULL;
 }
 
+static void network_gfx_delta_free(network_video_t *network)
+{
+   free(network->delta_prev);
+   free(network->delta_buf);
+   free(network->delta_zbuf);
+#ifdef HAVE_ZLIB
+   if (network->delta_stream)
+      zlib_deflate_backend.stream_free(network->delta_stream);
+   network->delta_stream    = NULL;
+#endif
+   network->delta_prev      = NULL;
+   network->delta_buf       = NULL;
+   network->delta_zbuf      = NULL;
+   network->delta_buf_size  = 0;
+   network->delta_zbuf_size = 0;
+   network->delta_width     = 0;
+   network->delta_height    = 0;
+}
+
+static bool network_gfx_delta_resize(network_video_t *network,
+      unsigned width, unsigned height)
+{
+   size_t pixels = (size_t)width * height;
+   size_t tiles  =
+        ((width  + NETWORK_VIDEO_TILE_SIZE - 1) / NETWORK_VIDEO_TILE_SIZE)
+      * ((height + NETWORK_VIDEO_TILE_SIZE - 1) / NETWORK_VIDEO_TILE_SIZE);
+
+   network_gfx_delta_free(network);
+
+   network->delta_buf_size  = tiles * 2 * sizeof(uint16_t)
+      + pixels * sizeof(uint32_t);
+   /* Larger than deflate can ever grow the payload,
+    * so a frame always compresses in one go. */
+   network->delta_zbuf_size = network->delta_buf_size
+      + network->delta_buf_size / 8 + 64;
+
+   network->delta_prev      = (uint32_t*)calloc(pixels, sizeof(uint32_t));
+   network->delta_buf       = (uint8_t*)malloc(network->delta_buf_size);
+   network->delta_zbuf      = (uint8_t*)malloc(network->delta_zbuf_size);
+
+   if (     !network->delta_prev
+         || !network->delta_buf
+         || !network->delta_zbuf)
+   {
+      network_gfx_delta_free(network);
+      return false;
+   }
+
+#ifdef HAVE_ZLIB
+   if ((network->delta_stream = zlib_deflate_backend.stream_new()))
+      zlib_deflate_backend.define(network->delta_stream, "level", 1);
+#endif
+
+   network->delta_width     = width;
+   network->delta_height    = height;
+   return true;
+}
+
+/* Appends every tile which differs from the previous frame to
+ * delta_buf, XORed with it, and makes @frame the previous frame.
+ * Returns the payload size. */
+static size_t network_gfx_delta_encode(network_video_t *network,
+      const uint32_t *frame, unsigned *tiles)
+{
+   unsigned tx, ty;
+   unsigned width  = network->delta_width;
+   unsigned height = network->delta_height;
+   uint8_t *out    = network->delta_buf;
+
+   *tiles          = 0;
+
+   for (ty = 0; ty * NETWORK_VIDEO_TILE_SIZE < height; ty++)
+   {
+      unsigned y0 = ty * NETWORK_VIDEO_TILE_SIZE;
+      unsigned th = MIN(NETWORK_VIDEO_TILE_SIZE, height - y0);
+
+      for (tx = 0; tx * NETWORK_VIDEO_TILE_SIZE < width; tx++)
+      {
+         unsigned x, y;
+         unsigned x0          = tx * NETWORK_VIDEO_TILE_SIZE;
+         unsigned tw          = MIN(NETWORK_VIDEO_TILE_SIZE, width - x0);
+         size_t   offset      = (size_t)y0 * width + x0;
+         const uint32_t *src  = frame + offset;
+         uint32_t       *prev = network->delta_prev + offset;
+         uint16_t pos[2];
+
+         for (y = 0; y < th; y++)
+            if (memcmp(src + y * width, prev + y * width,
+                     tw * sizeof(uint32_t)))
+               break;
+
+         if (y == th)
+            continue;
+
+         pos[0] = htons((uint16_t)tx);
+         pos[1] = htons((uint16_t)ty);
+         memcpy(out, pos, sizeof(pos));
+         out   += sizeof(pos);
+
+         for (y = 0; y < th; y++, src += width, prev += width)
+         {
+            for (x = 0; x < tw; x++)
+            {
+               uint32_t delta = src[x] ^ prev[x];
+               memcpy(out, &delta, sizeof(delta));
+               out           += sizeof(delta);
+            }
+            memcpy(prev, src, tw * sizeof(uint32_t));
+         }
+
+         (*tiles)++;
+      }
+   }
+
+   return out - network->delta_buf;
+}
+
+static void network_gfx_delta_send(network_video_t *network,
+      const uint32_t *frame, unsigned width, unsigned height,
+      unsigned pixfmt)
+{
+   uint32_t header[7];
+   unsigned tiles        = 0;
+   uint32_t flags        = 0;
+   const uint8_t *packet = NULL;
+   size_t size           = 0;
+
+   if (     (network->delta_width  != width)
+         || (network->delta_height != height))
+      if (!network_gfx_delta_resize(network, width, height))
+         return;
+
+   size   = network_gfx_delta_encode(network, frame, &tiles);
+   packet = network->delta_buf;
+
+#ifdef HAVE_ZLIB
+   if (size && network->delta_stream)
+   {
+      uint32_t rd, wn;
+
+      zlib_deflate_backend.set_in(network->delta_stream,
+            network->delta_buf, (uint32_t)size);
+      zlib_deflate_backend.set_out(network->delta_stream,
+            network->delta_zbuf, (uint32_t)network->delta_zbuf_size);
+
+      if (     zlib_deflate_backend.trans(network->delta_stream, true,
+               &rd, &wn, NULL)
+            && wn < size)
+      {
+         packet = network->delta_zbuf;
+         size   = wn;
+         flags |= NETWORK_VIDEO_FLAG_ZLIB;
+      }
+   }
+#endif
+
+   header[0] = htonl(width);
+   header[1] = htonl(height);
+   header[2] = htonl(pixfmt);
+   header[3] = htonl(NETWORK_VIDEO_TILE_SIZE);
+   header[4] = htonl(tiles);
+   header[5] = htonl(flags);
+   header[6] = htonl((uint32_t)size);
+
+   if (socket_send_all_blocking(network->fd, header, sizeof(header), true)
+         && size)
+      socket_send_all_blocking(network->fd, packet, size, true);
+}
+
 static void *network_gfx_init(const video_info_t *video,
       input_driver_t **input, void **input_data)
 {
@@ -100,6 +320,11 @@ static void *network_gfx_init(const video_info_t *video,
    bool video_font_enable               = settings->bools.video_font_enable;
    const char *joypad_driver            = settings->arrays.input_joypad_driver;
 
+   if (!network)
+      return NULL;
+
+   network->delta                       = settings->bools.video_network_delta;
+
    *input                               = NULL;
    *input_data                          = NULL;
 
@@ -146,7 +371,16 @@ try_connect:
    network->fd = fd;
 
    if (network->fd >= 0)
+   {
+      if (network->delta)
+      {
+         uint32_t header[2];
+         header[0] = htonl(NETWORK_VIDEO_DELTA_MAGIC);
+         header[1] = htonl(NETWORK_VIDEO_DELTA_VERSION);
+         socket_send_all_blocking(network->fd, header, sizeof(header), true);
+      }
       RARCH_LOG("[Network]: Connected to host.\n");
+   }
    else
    {
       RARCH_LOG("[Network]: Could not connect to host, retrying...\n");
@@ -328,7 +562,14 @@ static bool network_gfx_frame(void *data, const void *frame,
 
    if (draw && network->screen_width > 0 && network->screen_height > 0)
    {
-      if (network->fd > 0)
+      if (network->delta)
+      {
+         if (network->fd > 0 && frame_to_copy == network_video_temp_buf)
+            network_gfx_delta_send(network,
+                  (const uint32_t*)network_video_temp_buf,
+                  network->screen_width, network->screen_height, pixfmt);
+      }
+      else if (network->fd > 0)
          socket_send_all_blocking(network->fd, frame_to_copy, network->screen_width * network->screen_height * 4, true);
    }
 
@@ -375,6 +616,8 @@ static void network_gfx_free(void *data)
 
    font_driver_free_osd();
 
+   network_gfx_delta_free(network);
+
    if (network->fd >= 0)
       socket_close(network->fd);
 
@@ -326,7 +326,10 @@ static void sdl_refresh_input_size(sdl2_video_t *vid, bool menu, bool rgb32,
        * state (this should only be set by
        * sdl2_poke_texture_enable()) */
       if (!menu)
+      {
          target->active = true;
+         video_dirty_invalidate(&vid->dirty);
+      }
    }
 }
 
@@ -486,9 +489,30 @@ static bool sdl2_gfx_frame(void *data, const void *frame, unsigned width,
 
    if (frame)
    {
+      unsigned i, num_rects;
+      unsigned bpp = vid->video.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
+
       SDL_RenderClear(vid->renderer);
       sdl_refresh_input_size(vid, false, vid->video.rgb32, width, height, pitch);
-      SDL_UpdateTexture(vid->frame.tex, NULL, frame, pitch);
+
+      /* The texture keeps its contents, so only upload what changed */
+      num_rects = video_dirty_update(&vid->dirty, frame,
+            width, height, pitch, bpp);
+
+      for (i = 0; i < num_rects; i++)
+      {
+         SDL_Rect r;
+         const struct video_dirty_rect *rect = &vid->dirty.rects[i];
+
+         r.x = (int)rect->x;
+         r.y = (int)rect->y;
+         r.w = (int)rect->width;
+         r.h = (int)rect->height;
+
+         SDL_UpdateTexture(vid->frame.tex, &r,
+               (const uint8_t*)frame + rect->y * pitch + rect->x * bpp,
+               pitch);
+      }
    }
 
    SDL_RenderCopyEx(vid->renderer, vid->frame.tex, NULL, NULL, vid->rotation, NULL, SDL_FLIP_NONE);
@@ -561,6 +585,8 @@ static void sdl2_gfx_free(void *data)
    if (vid->font_data)
       vid->font_driver->free(vid->font_data);
 
+   video_dirty_free(&vid->dirty);
+
    free(vid);
 }
 
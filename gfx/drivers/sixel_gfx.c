@@ -380,6 +380,9 @@ static bool sixel_gfx_frame(void *data, const void *frame,
       sixel->video_width = width;
       sixel->video_height = height;
 
+      /* Scrolling moved the old picture */
+      video_dirty_invalidate(&sixel->dirty);
+
       if (sixel_temp_buf)
       {
          free(sixel_temp_buf);
@@ -472,6 +475,15 @@ static bool sixel_gfx_frame(void *data, const void *frame,
       frame_to_copy = sixel_temp_buf;
    }
 
+   /* Sixel output can't be positioned, so a partial update is not
+    * possible; skip encoding frames identical to the last one. */
+   if (     draw
+         && frame_to_copy == sixel_temp_buf
+         && !video_dirty_update(&sixel->dirty, sixel_temp_buf,
+            sixel->screen_width, sixel->screen_height,
+            sixel->screen_width * sizeof(unsigned), sizeof(unsigned)))
+      draw = false;
+
    if (draw && sixel->screen_width > 0 && sixel->screen_height > 0)
    {
       printf("\0338");
@@ -536,7 +548,10 @@ static void sixel_gfx_free(void *data)
    font_driver_free_osd();
 
    if (sixel)
+   {
+      video_dirty_free(&sixel->dirty);
       free(sixel);
+   }
 }
 
 static bool sixel_gfx_set_shader(void *data,
@@ -33,6 +33,7 @@
 #endif
 
 #include "../common/x11_common.h"
+#include "../video_dirty.h"
 #include "../../configuration.h"
 #include "../../verbosity.h"
 
@@ -42,15 +43,21 @@ typedef struct xshm
    XImage* image;
    uint8_t *fbptr;
    GC gc;
+   video_dirty_t dirty;
    int width;
    int height;
+   unsigned refresh;
    bool use_shm;
 } xshm_t;
 
+/* Unchanged areas are still redrawn every so often,
+ * in case the window was overdrawn without us noticing. */
+#define XSHM_FULL_REFRESH_FRAMES 60
+
 static void *xshm_init(const video_info_t *video,
       input_driver_t **input, void **input_data)
 {
-   xshm_t* xshm = (xshm_t*)malloc(sizeof(xshm_t));
+   xshm_t* xshm = (xshm_t*)calloc(1, sizeof(xshm_t));
    Window parent;
    XSetWindowAttributes attributes;
 
@@ -138,27 +145,61 @@ static bool xshm_frame(void *data, const void *frame, unsigned width,
       unsigned height, uint64_t frame_count,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
-   unsigned y;
+   unsigned i, y;
+   unsigned num_rects = 0;
    xshm_t      *xshm  = (xshm_t*)data;
 #ifdef HAVE_MENU
    bool menu_is_alive = (video_info->menu_st_flags & MENU_ST_FLAG_ALIVE) ? true : false;
 #endif
 
-   for (y = 0; y < height; y++)
-      memcpy(xshm->fbptr + sizeof(uint32_t)*xshm->width*y,
-            (uint8_t*)frame + pitch*y, pitch);
+   if (width > (unsigned)xshm->width)
+      width  = xshm->width;
+   if (height > (unsigned)xshm->height)
+      height = xshm->height;
+
+   if (frame)
+   {
+      if (++xshm->refresh >= XSHM_FULL_REFRESH_FRAMES)
+      {
+         xshm->refresh = 0;
+         video_dirty_invalidate(&xshm->dirty);
+      }
+
+      num_rects = video_dirty_update(&xshm->dirty, frame,
+            width, height, pitch, sizeof(uint32_t));
+   }
+
+   for (i = 0; i < num_rects; i++)
+   {
+      const struct video_dirty_rect *rect = &xshm->dirty.rects[i];
+      size_t offset = rect->x * sizeof(uint32_t);
+      size_t len    = rect->width * sizeof(uint32_t);
+
+      for (y = rect->y; y < rect->y + rect->height; y++)
+         memcpy(xshm->fbptr + sizeof(uint32_t)*xshm->width*y + offset,
+               (const uint8_t*)frame + pitch*y + offset, len);
+   }
 
 #ifdef HAVE_MENU
    menu_driver_frame(menu_is_alive, video_info);
 #endif
 
-   if (xshm->use_shm)
-      XShmPutImage(g_x11_dpy, g_x11_win, xshm->gc, xshm->image,
-		   0, 0, 0, 0, xshm->width, xshm->height, False);
-   else
-      XPutImage(g_x11_dpy, g_x11_win, xshm->gc, xshm->image,
-		0, 0, 0, 0, xshm->width, xshm->height);
-   XFlush(g_x11_dpy);
+   for (i = 0; i < num_rects; i++)
+   {
+      const struct video_dirty_rect *rect = &xshm->dirty.rects[i];
+
+      if (xshm->use_shm)
+         XShmPutImage(g_x11_dpy, g_x11_win, xshm->gc, xshm->image,
+               rect->x, rect->y, rect->x, rect->y,
+               rect->width, rect->height, False);
+      else
+         XPutImage(g_x11_dpy, g_x11_win, xshm->gc, xshm->image,
+               rect->x, rect->y, rect->x, rect->y,
+               rect->width, rect->height);
+   }
+
+   if (num_rects)
+      XFlush(g_x11_dpy);
 
    return true;
 }
@@ -167,7 +208,15 @@ static void xshm_set_nonblock_state(void *a, bool b, bool c, unsigned d) { }
 static bool xshm_alive(void *data) { return true; }
 static bool xshm_focus(void *data) { return true; }
 static bool xshm_suppress_screensaver(void *data, bool enable) { return false; }
-static void xshm_free(void *data) { }
+static void xshm_free(void *data)
+{
+   xshm_t *xshm = (xshm_t*)data;
+
+   if (!xshm)
+      return;
+
+   video_dirty_free(&xshm->dirty);
+}
 static void xshm_poke_set_filtering(void *data, unsigned index, bool smooth, bool ctx_scaling) { }
 static void xshm_poke_set_aspect_ratio(void *data, unsigned aspect_ratio_idx) { }
 static void xshm_poke_apply_state_changes(void *data) { }
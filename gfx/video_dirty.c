@@ -0,0 +1,340 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+#include <retro_miscellaneous.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "video_dirty.h"
+
+/* Tile hash, in the style of the XXH3 accumulator: every 16 byte block
+ * is XORed with a key that depends on its position in the tile, and
+ * the product of the 32-bit halves of each 64-bit lane, plus the other
+ * lane, is added to two 64-bit accumulators. All versions below give
+ * the same hash as the C one. */
+#define VIDEO_DIRTY_KEY0 0xbe4ba423396cfeb8ULL
+#define VIDEO_DIRTY_KEY1 0x1cad21f72c81017cULL
+#define VIDEO_DIRTY_STEP 0x9e3779b97f4a7c15ULL
+
+#if defined(__SSE2__)
+static INLINE __m128i video_dirty_block(__m128i acc,
+      const uint8_t *src, uint64_t key)
+{
+   __m128i v    = _mm_loadu_si128((const __m128i*)src);
+   __m128i d    = _mm_xor_si128(v, _mm_set_epi64x(
+            (int64_t)(VIDEO_DIRTY_KEY1 + key),
+            (int64_t)(VIDEO_DIRTY_KEY0 + key)));
+   __m128i prod = _mm_mul_epu32(d, _mm_srli_epi64(d, 32));
+
+   return _mm_add_epi64(acc, _mm_add_epi64(prod,
+            _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+static INLINE uint64x2_t video_dirty_block(uint64x2_t acc,
+      const uint8_t *src, uint64_t key)
+{
+   uint64x2_t v    = vreinterpretq_u64_u8(vld1q_u8(src));
+   uint64x2_t d    = veorq_u64(v, vcombine_u64(
+            vcreate_u64(VIDEO_DIRTY_KEY0 + key),
+            vcreate_u64(VIDEO_DIRTY_KEY1 + key)));
+   uint64x2_t prod = vmull_u32(vmovn_u64(d), vshrn_n_u64(d, 32));
+
+   return vaddq_u64(acc, vaddq_u64(prod, vextq_u64(v, v, 1)));
+}
+#else
+static INLINE void video_dirty_block(uint64_t *acc,
+      const uint8_t *src, uint64_t key)
+{
+   uint64_t v0, v1, d0, d1;
+
+   memcpy(&v0, src,     sizeof(v0));
+   memcpy(&v1, src + 8, sizeof(v1));
+
+   d0      = v0 ^ (VIDEO_DIRTY_KEY0 + key);
+   d1      = v1 ^ (VIDEO_DIRTY_KEY1 + key);
+
+   acc[0] += (d0 & 0xffffffff) * (d0 >> 32) + v1;
+   acc[1] += (d1 & 0xffffffff) * (d1 >> 32) + v0;
+}
+#endif
+
+static uint64_t video_dirty_hash_tile(const uint8_t *src, size_t pitch,
+      unsigned row_bytes, unsigned rows)
+{
+   unsigned y;
+   uint64_t h;
+   uint64_t key = 0;
+   uint64_t acc[2];
+#if defined(__AVX2__)
+   __m256i acc2 = _mm256_setzero_si256();
+#endif
+#if defined(__SSE2__)
+   __m128i acc1 = _mm_setzero_si128();
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   uint64x2_t acc1 = vdupq_n_u64(0);
+#else
+   uint64_t *acc1 = acc;
+   acc[0]         = 0;
+   acc[1]         = 0;
+#endif
+
+   for (y = 0; y < rows; y++, src += pitch)
+   {
+      unsigned x = 0;
+
+#if defined(__AVX2__)
+      for (; x + 32 <= row_bytes; x += 32, key += 2 * VIDEO_DIRTY_STEP)
+      {
+         __m256i v    = _mm256_loadu_si256((const __m256i*)(src + x));
+         __m256i d    = _mm256_xor_si256(v, _mm256_set_epi64x(
+                  (int64_t)(VIDEO_DIRTY_KEY1 + key + VIDEO_DIRTY_STEP),
+                  (int64_t)(VIDEO_DIRTY_KEY0 + key + VIDEO_DIRTY_STEP),
+                  (int64_t)(VIDEO_DIRTY_KEY1 + key),
+                  (int64_t)(VIDEO_DIRTY_KEY0 + key)));
+         __m256i prod = _mm256_mul_epu32(d, _mm256_srli_epi64(d, 32));
+
+         acc2         = _mm256_add_epi64(acc2, _mm256_add_epi64(prod,
+                  _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))));
+      }
+#endif
+      for (; x + 16 <= row_bytes; x += 16, key += VIDEO_DIRTY_STEP)
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+         acc1 = video_dirty_block(acc1, src + x, key);
+#else
+         video_dirty_block(acc1, src + x, key);
+#endif
+
+      if (x < row_bytes)
+      {
+         uint8_t tail[16] = {0};
+         memcpy(tail, src + x, row_bytes - x);
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+         acc1 = video_dirty_block(acc1, tail, key);
+#else
+         video_dirty_block(acc1, tail, key);
+#endif
+         key += VIDEO_DIRTY_STEP;
+      }
+   }
+
+#if defined(__AVX2__)
+   acc1 = _mm_add_epi64(acc1, _mm_add_epi64(
+            _mm256_castsi256_si128(acc2),
+            _mm256_extracti128_si256(acc2, 1)));
+#endif
+#if defined(__SSE2__)
+   _mm_storeu_si128((__m128i*)acc, acc1);
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   vst1q_u64(acc, acc1);
+#endif
+
+   /* Fold the lanes and avalanche */
+   h  = acc[0] ^ (acc[1] * VIDEO_DIRTY_STEP);
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   h *= 0xc4ceb9fe1a85ec53ULL;
+   h ^= h >> 33;
+   return h;
+}
+
+void video_dirty_free(video_dirty_t *dirty)
+{
+   free(dirty->hashes);
+   free(dirty->changed);
+   free(dirty->open_rects);
+   if (dirty->rects != &dirty->whole)
+      free(dirty->rects);
+   memset(dirty, 0, sizeof(*dirty));
+}
+
+void video_dirty_invalidate(video_dirty_t *dirty)
+{
+   dirty->valid = false;
+}
+
+static bool video_dirty_resize(video_dirty_t *dirty,
+      unsigned width, unsigned height, unsigned bpp)
+{
+   size_t tiles;
+   unsigned tiles_x = (width  + VIDEO_DIRTY_TILE_SIZE - 1)
+      / VIDEO_DIRTY_TILE_SIZE;
+   unsigned tiles_y = (height + VIDEO_DIRTY_TILE_SIZE - 1)
+      / VIDEO_DIRTY_TILE_SIZE;
+
+   video_dirty_free(dirty);
+
+   tiles              = (size_t)tiles_x * tiles_y;
+   dirty->hashes      = (uint64_t*)malloc(tiles * sizeof(*dirty->hashes));
+   dirty->changed     = (uint8_t*)malloc(tiles);
+   dirty->open_rects  = (int*)malloc(2 * tiles_x * sizeof(int));
+   dirty->rects       = (struct video_dirty_rect*)
+      malloc(tiles * sizeof(*dirty->rects));
+
+   if (     !dirty->hashes
+         || !dirty->changed
+         || !dirty->open_rects
+         || !dirty->rects)
+   {
+      video_dirty_free(dirty);
+      return false;
+   }
+
+   dirty->width       = width;
+   dirty->height      = height;
+   dirty->bpp         = bpp;
+   dirty->tiles_x     = tiles_x;
+   dirty->tiles_y     = tiles_y;
+   return true;
+}
+
+/* Merges changed tiles into rectangles, in tile units. A run of tiles
+ * on one row extends the rectangle above it if that spans exactly the
+ * same columns; 'open_rects' holds, per starting column, the rectangle
+ * which ended on the previous row. */
+static void video_dirty_build_rects(video_dirty_t *dirty)
+{
+   unsigned tx, ty;
+   int *open_prev = dirty->open_rects;
+   int *open_cur  = dirty->open_rects + dirty->tiles_x;
+
+   dirty->num_rects = 0;
+
+   for (tx = 0; tx < dirty->tiles_x; tx++)
+      open_prev[tx] = -1;
+
+   for (ty = 0; ty < dirty->tiles_y; ty++)
+   {
+      int *tmp;
+      const uint8_t *changed = dirty->changed + ty * dirty->tiles_x;
+
+      for (tx = 0; tx < dirty->tiles_x; tx++)
+         open_cur[tx] = -1;
+
+      for (tx = 0; tx < dirty->tiles_x; )
+      {
+         unsigned start = tx;
+         int idx;
+
+         if (!changed[tx])
+         {
+            tx++;
+            continue;
+         }
+
+         while (tx < dirty->tiles_x && changed[tx])
+            tx++;
+
+         idx = open_prev[start];
+
+         if (idx >= 0 && dirty->rects[idx].width == tx - start)
+            dirty->rects[idx].height++;
+         else
+         {
+            struct video_dirty_rect *rect = &dirty->rects[dirty->num_rects];
+            rect->x      = start;
+            rect->y      = ty;
+            rect->width  = tx - start;
+            rect->height = 1;
+            idx          = (int)dirty->num_rects++;
+         }
+
+         open_cur[start] = idx;
+      }
+
+      tmp       = open_prev;
+      open_prev = open_cur;
+      open_cur  = tmp;
+   }
+}
+
+unsigned video_dirty_update(video_dirty_t *dirty, const void *frame,
+      unsigned width, unsigned height, size_t pitch, unsigned bpp)
+{
+   unsigned i, tx, ty;
+   unsigned changed = 0;
+   const uint8_t *src = (const uint8_t*)frame;
+
+   if (     !dirty->hashes
+         || (dirty->width  != width)
+         || (dirty->height != height)
+         || (dirty->bpp    != bpp))
+   {
+      if (!video_dirty_resize(dirty, width, height, bpp))
+      {
+         /* Without the tiles, everything is always dirty */
+         dirty->whole.x      = 0;
+         dirty->whole.y      = 0;
+         dirty->whole.width  = width;
+         dirty->whole.height = height;
+         dirty->rects        = &dirty->whole;
+         dirty->num_rects    = 1;
+         return 1;
+      }
+   }
+
+   for (ty = 0, i = 0; ty < dirty->tiles_y; ty++)
+   {
+      unsigned y    = ty * VIDEO_DIRTY_TILE_SIZE;
+      unsigned rows = MIN(VIDEO_DIRTY_TILE_SIZE, height - y);
+
+      for (tx = 0; tx < dirty->tiles_x; tx++, i++)
+      {
+         unsigned x    = tx * VIDEO_DIRTY_TILE_SIZE;
+         unsigned cols = MIN(VIDEO_DIRTY_TILE_SIZE, width - x);
+         uint64_t hash = video_dirty_hash_tile(
+               src + y * pitch + x * bpp, pitch, cols * bpp, rows);
+
+         dirty->changed[i] = !dirty->valid || hash != dirty->hashes[i];
+         dirty->hashes[i]  = hash;
+         changed          |= dirty->changed[i];
+      }
+   }
+
+   dirty->valid = true;
+
+   if (!changed)
+   {
+      dirty->num_rects = 0;
+      return 0;
+   }
+
+   video_dirty_build_rects(dirty);
+
+   /* Tiles to pixels, clipped to the frame */
+   for (i = 0; i < dirty->num_rects; i++)
+   {
+      struct video_dirty_rect *rect = &dirty->rects[i];
+      unsigned x                    = rect->x * VIDEO_DIRTY_TILE_SIZE;
+      unsigned y                    = rect->y * VIDEO_DIRTY_TILE_SIZE;
+
+      rect->width  = MIN(rect->width  * VIDEO_DIRTY_TILE_SIZE, width  - x);
+      rect->height = MIN(rect->height * VIDEO_DIRTY_TILE_SIZE, height - y);
+      rect->x      = x;
+      rect->y      = y;
+   }
+
+   return dirty->num_rects;
+}
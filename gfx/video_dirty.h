@@ -0,0 +1,88 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __VIDEO_DIRTY_H
+#define __VIDEO_DIRTY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Finds the parts of a frame that changed since the previous one,
+ * so software video drivers can upload only those.
+ *
+ * Frames are split into VIDEO_DIRTY_TILE_SIZE square tiles, and only
+ * a 64-bit hash of each tile is kept rather than a copy of the frame.
+ * Changed tiles are merged into rectangles: runs of tiles along a row,
+ * then runs spanning the same columns on consecutive rows. */
+
+#define VIDEO_DIRTY_TILE_SIZE 32
+
+struct video_dirty_rect
+{
+   unsigned x;
+   unsigned y;
+   unsigned width;
+   unsigned height;
+};
+
+typedef struct video_dirty
+{
+   uint64_t *hashes;
+   uint8_t *changed;
+   int *open_rects;
+   struct video_dirty_rect *rects;
+   struct video_dirty_rect whole;
+   unsigned num_rects;
+   unsigned width;
+   unsigned height;
+   unsigned bpp;
+   unsigned tiles_x;
+   unsigned tiles_y;
+   bool valid;
+} video_dirty_t;
+
+/**
+ * video_dirty_update:
+ * @dirty                : tracker, zero-initialized before first use.
+ * @frame                : frame to compare with the previous one.
+ * @width                : width of @frame in pixels.
+ * @height               : height of @frame in pixels.
+ * @pitch                : bytes between rows of @frame.
+ * @bpp                  : bytes per pixel.
+ *
+ * Hashes @frame and fills @dirty->rects with the areas that differ
+ * from the frame passed last time. The whole frame is reported after
+ * video_dirty_invalidate(), when the size or format changes, or when
+ * memory runs out.
+ *
+ * Returns: number of rectangles in @dirty->rects, 0 if the frame
+ * didn't change.
+ **/
+unsigned video_dirty_update(video_dirty_t *dirty, const void *frame,
+      unsigned width, unsigned height, size_t pitch, unsigned bpp);
+
+/* Makes the next update report the whole frame, e.g. when
+ * the output was lost or overdrawn. */
+void video_dirty_invalidate(video_dirty_t *dirty);
+
+void video_dirty_free(video_dirty_t *dirty);
+
+RETRO_END_DECLS
+
+#endif
@@ -61,6 +61,7 @@
 #include "../ui/ui_companion_driver.h"
 #include "../driver.h"
 #include "../file_path_special.h"
+#include "../frame_trace.h"
 #include "../list_special.h"
 #include "../retroarch.h"
 #include "../verbosity.h"
@@ -3764,6 +3765,7 @@ void video_driver_frame(const void *data, unsigned width,
    if (render_frame && video_info.statistics_show)
    {
       audio_statistics_t audio_stats;
+      char dsp_stats[256];
       char throttle_stats[128];
       char latency_stats[128];
       char tmp[128];
@@ -3812,11 +3814,22 @@ void video_driver_frame(const void *data, unsigned width,
 
       audio_compute_buffer_statistics(&audio_stats);
 
+      dsp_stats[0]      = '\0';
       throttle_stats[0] = '\0';
       latency_stats[0]  = '\0';
       tmp[0]            = '\0';
       len               = 0;
 
+#ifdef HAVE_DSP_FILTER
+      /* TODO/FIXME - localize */
+      {
+         size_t _len = strlcpy(dsp_stats, "DSP\n", sizeof(dsp_stats));
+         if (!audio_driver_dsp_filter_stats(dsp_stats + _len,
+                  sizeof(dsp_stats) - _len))
+            dsp_stats[0] = '\0';
+      }
+#endif
+
       if (video_info.frame_rest)
          len = snprintf(tmp + len, sizeof(throttle_stats),
                " Frame Rest:  %2u.00 ms\n"
@@ -3888,6 +3901,7 @@ void video_driver_frame(const void *data, unsigned width,
             " Blocking:    %5.2f %%\n"
             " Samples:     %5d\n"
             "%s"
+            "%s"
             "%s",
             av_info->geometry.base_width,
             av_info->geometry.base_height,
@@ -3910,6 +3924,7 @@ void video_driver_frame(const void *data, unsigned width,
             audio_stats.close_to_underrun,
             audio_stats.close_to_blocking,
             audio_stats.samples,
+            dsp_stats,
             throttle_stats,
             latency_stats);
 
@@ -3998,6 +4013,8 @@ void video_driver_frame(const void *data, unsigned width,
    else if (!video_info.crt_switch_resolution)
 #endif
       video_st->flags          &= ~VIDEO_FLAG_CRT_SWITCHING_ACTIVE;
+
+   frame_trace_add(FRAME_TRACE_VIDEO_FRAME, new_time);
 }
 
 static void video_driver_reinit_context(settings_t *settings, int flags)
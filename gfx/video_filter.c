@@ -14,7 +14,9 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <compat/strl.h>
 #include <file/file_path.h>
@@ -36,6 +38,25 @@
 #include "video_filter.h"
 #include "video_filters/softfilter.h"
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+/* Frames are split into more tiles than there are threads, so
+ * that a thread which gets descheduled or lands on a slow core
+ * only holds up the tile it's working on, not a whole share of
+ * the frame. Tiles are kept tall enough that the rows a filter
+ * reads from the neighbouring tiles stay a small part of the
+ * work. */
+#define SOFTFILTER_TILES_PER_THREAD 4
+#define SOFTFILTER_TILE_MIN_ROWS    16
+
+/* Input rows per thread in each band when chained filters are run
+ * band by band. Small enough for the bands passed between them to
+ * stay in cache, large enough to keep the rows recomputed around
+ * each band for context cheap. */
+#define SOFTFILTER_BAND_ROWS        32
+
 struct rarch_soft_plug
 {
 #ifdef HAVE_DYLIB
@@ -44,65 +65,105 @@ struct rarch_soft_plug
    const struct softfilter_implementation *impl;
 };
 
+struct rarch_softfilter_pass
+{
+   const struct softfilter_implementation *impl;
+   void *impl_data;
+
+   struct softfilter_work_packet *packets;
+   unsigned num_packets;
+
+   enum retro_pixel_format out_pix_fmt;
+   unsigned bpp;
+   unsigned max_width, max_height;
+
+   /* Set if the pass supports SOFTFILTER_FLAG_BANDS, along with
+    * the output rows it makes per input row. */
+   bool bands;
+   unsigned scale;
+   unsigned context_rows;
+
+   /* Run band by band together with the next pass. */
+   bool fuse_next;
+
+   /* Output for the next pass. Passes run band by band write into
+    * a band sized buffer instead of a whole frame. */
+   uint8_t *frame;
+   uint8_t *band;
+   size_t stride;
+
+   /* Input and output size of the frame being processed */
+   unsigned width, height;
+   unsigned out_width, out_height;
+
+   /* Input rows the pass is run on for the current band, and the
+    * output rows wanted from it. */
+   unsigned band_lo, band_hi;
+   unsigned out_lo, out_hi;
+};
+
 struct rarch_softfilter
 {
    config_file_t *conf;
 
-   const struct softfilter_implementation *impl;
-   void *impl_data;
+   struct rarch_softfilter_pass *passes;
+   unsigned num_passes;
 
    struct rarch_soft_plug *plugs;
    unsigned num_plugs;
 
    unsigned max_width, max_height;
+   unsigned band_rows;
    enum retro_pixel_format pix_fmt, out_pix_fmt;
 
-   struct softfilter_work_packet *packets;
-   unsigned threads;
-
 #ifdef HAVE_THREADS
-   struct filter_thread_data *thread_data;
-#endif
-};
-
-#ifdef HAVE_THREADS
-#include <rthreads/rthreads.h>
-
-struct filter_thread_data
-{
-   sthread_t *thread;
-   const struct softfilter_work_packet *packet;
-   scond_t *cond;
+   /* Packets of the pass being run are handed out from a single
+    * queue shared by the workers and the thread calling
+    * rarch_softfilter_process(), each taking the next unclaimed
+    * one until none are left. */
+   const struct rarch_softfilter_pass *pass;
+   sthread_t **workers;
    slock_t *lock;
-   void *userdata;
+   scond_t *work_cond;
+   scond_t *done_cond;
+   unsigned num_workers;
+   unsigned next_packet;
+   unsigned pending_packets;
    bool die;
-   bool done;
+#endif
 };
 
+#ifdef HAVE_THREADS
 static void filter_thread_loop(void *data)
 {
-   struct filter_thread_data *thr = (struct filter_thread_data*)data;
+   rarch_softfilter_t *filt = (rarch_softfilter_t*)data;
+
+   slock_lock(filt->lock);
 
    for (;;)
    {
-      bool die;
-      slock_lock(thr->lock);
-      while (thr->done && !thr->die)
-         scond_wait(thr->cond, thr->lock);
-      die = thr->die;
-      slock_unlock(thr->lock);
+      unsigned i;
+      const struct rarch_softfilter_pass *pass;
 
-      if (die)
+      while (!filt->die && (!filt->pass
+               || filt->next_packet >= filt->pass->num_packets))
+         scond_wait(filt->work_cond, filt->lock);
+
+      if (filt->die)
          break;
 
-      if (thr->packet && thr->packet->work)
-         thr->packet->work(thr->userdata, thr->packet->thread_data);
+      pass = filt->pass;
+      i    = filt->next_packet++;
+      slock_unlock(filt->lock);
+
+      pass->packets[i].work(pass->impl_data, pass->packets[i].thread_data);
 
-      slock_lock(thr->lock);
-      thr->done = true;
-      scond_signal(thr->cond);
-      slock_unlock(thr->lock);
+      slock_lock(filt->lock);
+      if (--filt->pending_packets == 0)
+         scond_signal(filt->done_cond);
    }
+
+   slock_unlock(filt->lock);
 }
 #endif
 
@@ -130,31 +191,40 @@ static const struct softfilter_config softfilter_config = {
    config_userdata_free,
 };
 
-static bool create_softfilter_graph(rarch_softfilter_t *filt,
+static void softfilter_pass_output_size(
+      const struct rarch_softfilter_pass *pass,
+      unsigned *out_width, unsigned *out_height,
+      unsigned width, unsigned height)
+{
+   if (pass->impl->query_output_size)
+      pass->impl->query_output_size(pass->impl_data, out_width,
+            out_height, width, height);
+   else
+   {
+      *out_width  = width;
+      *out_height = height;
+   }
+}
+
+static bool create_softfilter_pass(rarch_softfilter_t *filt,
+      struct rarch_softfilter_pass *pass, const char *key,
       enum retro_pixel_format in_pixel_format,
       unsigned max_width, unsigned max_height,
       softfilter_simd_mask_t cpu_features,
       unsigned threads)
 {
-   unsigned input_fmts, input_fmt, output_fmts;
+   unsigned input_fmts, input_fmt, output_fmts, tiles, width, height;
    struct config_file_userdata userdata;
-   char key[64], name[64];
+   char name[64];
    name[0] = '\0';
-   strlcpy(key, "filter", sizeof(key));
 
    if (!config_get_array(filt->conf, key, name, sizeof(name)))
    {
-      RARCH_ERR("Could not find 'filter' array in config.\n");
+      RARCH_ERR("Could not find '%s' array in config.\n", key);
       return false;
    }
 
-   if (filt->num_plugs == 0)
-   {
-      RARCH_ERR("No filter plugs found. Exiting...\n");
-      return false;
-   }
-
-   if (!(filt->impl = softfilter_find_implementation(filt, name)))
+   if (!(pass->impl = softfilter_find_implementation(filt, name)))
    {
       RARCH_ERR("Could not find implementation.\n");
       return false;
@@ -163,11 +233,10 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
    userdata.conf      = filt->conf;
    /* Index-specific configs take priority over ident-specific. */
    userdata.prefix[0] = key;
-   userdata.prefix[1] = filt->impl->short_ident;
+   userdata.prefix[1] = pass->impl->short_ident;
 
    /* Simple assumptions. */
-   filt->pix_fmt      = in_pixel_format;
-   input_fmts         = filt->impl->query_input_formats();
+   input_fmts         = pass->impl->query_input_formats();
 
    switch (in_pixel_format)
    {
@@ -187,79 +256,278 @@ static bool create_softfilter_graph(rarch_softfilter_t *filt,
       return false;
    }
 
-   output_fmts = filt->impl->query_output_formats(input_fmt);
+   output_fmts = pass->impl->query_output_formats(input_fmt);
    /* If we have a match of input/output formats, use that. */
    if (output_fmts & input_fmt)
-      filt->out_pix_fmt = in_pixel_format;
+      pass->out_pix_fmt = in_pixel_format;
    else if (output_fmts & SOFTFILTER_FMT_XRGB8888)
-      filt->out_pix_fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+      pass->out_pix_fmt = RETRO_PIXEL_FORMAT_XRGB8888;
    else if (output_fmts & SOFTFILTER_FMT_RGB565)
-      filt->out_pix_fmt = RETRO_PIXEL_FORMAT_RGB565;
+      pass->out_pix_fmt = RETRO_PIXEL_FORMAT_RGB565;
    else
    {
       RARCH_ERR("Did not find suitable output format for softfilter.\n");
       return false;
    }
 
-   filt->max_width = max_width;
-   filt->max_height = max_height;
+   pass->bpp = (pass->out_pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888)
+      ? SOFTFILTER_BPP_XRGB8888 : SOFTFILTER_BPP_RGB565;
+
+#ifdef HAVE_THREADS
+   /* The filter is asked for one work packet per tile; it may
+    * hand back fewer if it can't be split that finely. */
+   tiles = (threads > 1) ? threads * SOFTFILTER_TILES_PER_THREAD : 1;
+   if (tiles > max_height / SOFTFILTER_TILE_MIN_ROWS)
+      tiles = MAX(max_height / SOFTFILTER_TILE_MIN_ROWS, threads);
+#else
+   tiles = threads;
+#endif
 
-   filt->impl_data = filt->impl->create(
+   pass->impl_data = pass->impl->create(
          &softfilter_config, input_fmt, input_fmt, max_width, max_height,
-         threads != RARCH_SOFTFILTER_THREADS_AUTO ? threads :
-         cpu_features_get_core_amount(), cpu_features,
-         &userdata);
-   if (!filt->impl_data)
+         tiles, cpu_features, &userdata);
+   if (!pass->impl_data)
    {
       RARCH_ERR("Failed to create softfilter state.\n");
       return false;
    }
 
-   threads = filt->impl->query_num_threads(filt->impl_data);
-   if (!threads)
+   tiles = pass->impl->query_num_threads(pass->impl_data);
+   if (!tiles)
    {
       RARCH_ERR("Invalid number of threads.\n");
       return false;
    }
 
-   filt->threads = threads;
-   RARCH_LOG("Using %u threads for softfilter.\n", threads);
+   pass->num_packets = tiles;
 
-   filt->packets = (struct softfilter_work_packet*)
-      calloc(threads, sizeof(*filt->packets));
-   if (!filt->packets)
+   pass->packets = (struct softfilter_work_packet*)
+      calloc(tiles, sizeof(*pass->packets));
+   if (!pass->packets)
    {
       RARCH_ERR("Failed to allocate softfilter packets.\n");
       return false;
    }
 
-#ifdef HAVE_THREADS
-   if (filt->threads > 1)
-   {
-      unsigned i;
-      if (!(filt->thread_data = (struct filter_thread_data*)
-         calloc(threads, sizeof(*filt->thread_data))))
-         return false;
+   pass->width  = max_width;
+   pass->height = max_height;
+   softfilter_pass_output_size(pass, &pass->max_width, &pass->max_height,
+         max_width, max_height);
+   pass->stride = pass->max_width * pass->bpp;
 
-      for (i = 0; i < threads; i++)
+   /* Running in bands needs a whole number of output rows
+    * per input row, whatever the height. */
+   if (     pass->impl->api_version >= 3
+         && (pass->impl->flags & SOFTFILTER_FLAG_BANDS))
+   {
+      softfilter_pass_output_size(pass, &width, &height, max_width, 1);
+      if (height && pass->max_height == height * max_height)
       {
-         filt->thread_data[i].userdata = filt->impl_data;
-         filt->thread_data[i].done     = true;
+         pass->bands        = true;
+         pass->scale        = height;
+         pass->context_rows = pass->impl->band_context_rows;
+      }
+   }
+
+   return true;
+}
+
+/* Works out which rows each pass from first to last has to be
+ * run on, for the next pass to have its rows and their context
+ * and for the last one to make rows lo to hi of the first one's
+ * input, scaled up. */
+static void softfilter_plan_band(struct rarch_softfilter_pass *passes,
+      unsigned first, unsigned last, unsigned lo, unsigned hi)
+{
+   unsigned k;
+
+   for (k = first; k <= last; k++)
+   {
+      lo *= passes[k].scale;
+      hi *= passes[k].scale;
+   }
+
+   for (k = last + 1; k-- > first; )
+   {
+      struct rarch_softfilter_pass *pass = &passes[k];
+      unsigned in_lo = lo / pass->scale;
+      unsigned in_hi = (hi + pass->scale - 1) / pass->scale;
+
+      pass->out_lo  = lo;
+      pass->out_hi  = hi;
+      pass->band_lo = (in_lo > pass->context_rows)
+         ? in_lo - pass->context_rows : 0;
+      pass->band_hi = MIN(in_hi + pass->context_rows, pass->height);
+
+      lo            = pass->band_lo;
+      hi            = pass->band_hi;
+   }
+}
+
+static bool create_softfilter_buffers(rarch_softfilter_t *filt)
+{
+   unsigned i, first, k, y;
+
+   for (first = 0; first < filt->num_passes; first = i + 1)
+   {
+      struct rarch_softfilter_pass *passes = filt->passes;
+
+      for (i = first; passes[i].fuse_next; i++);
 
-         filt->thread_data[i].lock     = slock_new();
-         if (!filt->thread_data[i].lock)
+      /* Whole frames are passed between runs of passes */
+      if (i + 1 < filt->num_passes)
+      {
+         if (!(passes[i].frame = (uint8_t*)
+                  malloc(passes[i].stride * passes[i].max_height)))
             return false;
-         filt->thread_data[i].cond     = scond_new();
-         if (!filt->thread_data[i].cond)
+      }
+
+      if (i == first)
+         continue;
+
+      /* Size the band buffers for the largest band of the
+       * largest frame; smaller frames only clip bands. */
+      for (k = first; k <= i; k++)
+      {
+         unsigned rows = 0;
+
+         /* The last pass only needs one if it makes rows for
+          * context, which mustn't end up in the output. */
+         if (k == i && !passes[k].context_rows)
+            break;
+
+         for (y = 0; y < passes[first].height; y += filt->band_rows)
+         {
+            softfilter_plan_band(passes, first, i, y,
+                  MIN(y + filt->band_rows, passes[first].height));
+            rows = MAX(rows,
+                  (passes[k].band_hi - passes[k].band_lo) * passes[k].scale);
+         }
+
+         if (!(passes[k].band = (uint8_t*)malloc(passes[k].stride * rows)))
             return false;
-         filt->thread_data[i].thread   = sthread_create(
-               filter_thread_loop, &filt->thread_data[i]);
-         if (!filt->thread_data[i].thread)
+      }
+   }
+
+   return true;
+}
+
+static bool create_softfilter_graph(rarch_softfilter_t *filt,
+      enum retro_pixel_format in_pixel_format,
+      unsigned max_width, unsigned max_height,
+      softfilter_simd_mask_t cpu_features,
+      unsigned threads)
+{
+   unsigned i;
+   unsigned num_passes             = 0;
+   unsigned max_packets            = 0;
+   unsigned width                  = max_width;
+   unsigned height                 = max_height;
+   enum retro_pixel_format pix_fmt = in_pixel_format;
+   bool chain                      = config_get_uint(filt->conf,
+         "filters", &num_passes);
+
+   if (filt->num_plugs == 0)
+   {
+      RARCH_ERR("No filter plugs found. Exiting...\n");
+      return false;
+   }
+
+   /* Chains list their passes as filter0, filter1 etc. like audio
+    * DSP configs; a single 'filter' is a chain of one. */
+   if (!chain)
+      num_passes = 1;
+   else if (!num_passes)
+   {
+      RARCH_ERR("No filters in config.\n");
+      return false;
+   }
+
+   if (!(filt->passes = (struct rarch_softfilter_pass*)
+            calloc(num_passes, sizeof(*filt->passes))))
+      return false;
+   filt->num_passes = num_passes;
+
+   filt->pix_fmt    = in_pixel_format;
+   filt->max_width  = max_width;
+   filt->max_height = max_height;
+
+   if (threads == RARCH_SOFTFILTER_THREADS_AUTO)
+      threads = cpu_features_get_core_amount();
+
+   for (i = 0; i < num_passes; i++)
+   {
+      struct rarch_softfilter_pass *pass = &filt->passes[i];
+      char key[64];
+
+      if (chain)
+         snprintf(key, sizeof(key), "filter%u", i);
+      else
+         strlcpy(key, "filter", sizeof(key));
+
+      if (!create_softfilter_pass(filt, pass, key, pix_fmt,
+               width, height, cpu_features, threads))
+         return false;
+
+      pix_fmt     = pass->out_pix_fmt;
+      width       = pass->max_width;
+      height      = pass->max_height;
+      max_packets = MAX(max_packets, pass->num_packets);
+
+      if (i > 0 && filt->passes[i - 1].bands && pass->bands)
+         filt->passes[i - 1].fuse_next = true;
+   }
+
+   filt->out_pix_fmt = pix_fmt;
+
+#ifdef HAVE_THREADS
+   /* The calling thread works through the tiles as well,
+    * so one thread less is needed. */
+   filt->num_workers = MIN(threads, max_packets) - 1;
+
+   if (filt->num_workers)
+   {
+      if (!(filt->lock = slock_new()))
+         return false;
+      if (!(filt->work_cond = scond_new()))
+         return false;
+      if (!(filt->done_cond = scond_new()))
+         return false;
+      if (!(filt->workers = (sthread_t**)
+               calloc(filt->num_workers, sizeof(*filt->workers))))
+         return false;
+
+      for (i = 0; i < filt->num_workers; i++)
+      {
+         if (!(filt->workers[i] = sthread_create(filter_thread_loop, filt)))
             return false;
       }
    }
+
+   filt->band_rows = SOFTFILTER_BAND_ROWS * (filt->num_workers + 1);
+
+   RARCH_LOG("Using %u threads and %u tiles for softfilter.\n",
+         filt->num_workers + 1, max_packets);
+#else
+   filt->band_rows = SOFTFILTER_BAND_ROWS;
+
+   RARCH_LOG("Using %u tiles for softfilter.\n", max_packets);
 #endif
 
+   if (!create_softfilter_buffers(filt))
+   {
+      RARCH_ERR("Failed to allocate softfilter buffers.\n");
+      return false;
+   }
+
+   for (i = 0; i < num_passes; i++)
+   {
+      if (filt->passes[i].fuse_next)
+         RARCH_LOG("Running softfilters %s and %s in bands.\n",
+               filt->passes[i].impl->ident,
+               filt->passes[i + 1].impl->ident);
+   }
+
    return true;
 }
 
@@ -376,7 +644,8 @@ static bool append_softfilter_plugs(rarch_softfilter_t *filt,
          continue;
       }
 
-      if (impl->api_version != SOFTFILTER_API_VERSION)
+      if (     impl->api_version < 2
+            || impl->api_version > SOFTFILTER_API_VERSION)
       {
          dylib_close(lib);
          continue;
@@ -483,9 +752,40 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    if (!filt)
       return;
 
-   free(filt->packets);
-   if (filt->impl && filt->impl_data)
-      filt->impl->destroy(filt->impl_data);
+#ifdef HAVE_THREADS
+   if (filt->workers)
+   {
+      slock_lock(filt->lock);
+      filt->die = true;
+      scond_broadcast(filt->work_cond);
+      slock_unlock(filt->lock);
+
+      for (i = 0; i < filt->num_workers; i++)
+      {
+         if (filt->workers[i])
+            sthread_join(filt->workers[i]);
+      }
+      free(filt->workers);
+   }
+   if (filt->lock)
+      slock_free(filt->lock);
+   if (filt->work_cond)
+      scond_free(filt->work_cond);
+   if (filt->done_cond)
+      scond_free(filt->done_cond);
+#endif
+
+   for (i = 0; i < filt->num_passes; i++)
+   {
+      struct rarch_softfilter_pass *pass = &filt->passes[i];
+
+      free(pass->packets);
+      free(pass->frame);
+      free(pass->band);
+      if (pass->impl && pass->impl_data)
+         pass->impl->destroy(pass->impl_data);
+   }
+   free(filt->passes);
 
 #ifdef HAVE_DYLIB
    for (i = 0; i < filt->num_plugs; i++)
@@ -496,25 +796,6 @@ void rarch_softfilter_free(rarch_softfilter_t *filt)
    free(filt->plugs);
 #endif
 
-#ifdef HAVE_THREADS
-   if (filt->threads > 1)
-   {
-      for (i = 0; i < filt->threads; i++)
-      {
-         if (!filt->thread_data[i].thread)
-            continue;
-         slock_lock(filt->thread_data[i].lock);
-         filt->thread_data[i].die = true;
-         scond_signal(filt->thread_data[i].cond);
-         slock_unlock(filt->thread_data[i].lock);
-         sthread_join(filt->thread_data[i].thread);
-         slock_free(filt->thread_data[i].lock);
-         scond_free(filt->thread_data[i].cond);
-      }
-      free(filt->thread_data);
-   }
-#endif
-
    if (filt->conf)
       config_file_free(filt->conf);
 
@@ -532,9 +813,17 @@ void rarch_softfilter_get_output_size(rarch_softfilter_t *filt,
       unsigned *out_width, unsigned *out_height,
       unsigned width, unsigned height)
 {
-   if (filt && filt->impl && filt->impl->query_output_size)
-      filt->impl->query_output_size(filt->impl_data, out_width,
-            out_height, width, height);
+   unsigned i;
+
+   if (!filt || !filt->passes)
+      return;
+
+   for (i = 0; i < filt->num_passes; i++)
+      softfilter_pass_output_size(&filt->passes[i],
+            &width, &height, width, height);
+
+   *out_width  = width;
+   *out_height = height;
 }
 
 enum retro_pixel_format rarch_softfilter_get_output_format(
@@ -543,51 +832,153 @@ enum retro_pixel_format rarch_softfilter_get_output_format(
    return filt->out_pix_fmt;
 }
 
-void rarch_softfilter_process(rarch_softfilter_t *filt,
+static void softfilter_run_pass(rarch_softfilter_t *filt,
+      struct rarch_softfilter_pass *pass,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height,
       size_t input_stride)
 {
    unsigned i;
 
-   if (!filt)
-      return;
-
-   if (filt->impl && filt->impl->get_work_packets)
-      filt->impl->get_work_packets(filt->impl_data, filt->packets,
+   if (pass->impl->get_work_packets)
+      pass->impl->get_work_packets(pass->impl_data, pass->packets,
             output, output_stride, input, width, height, input_stride);
 
 #ifdef HAVE_THREADS
-   if (filt->threads > 1)
+   if (filt->num_workers)
    {
-      /* Fire off workers */
-      for (i = 0; i < filt->threads; i++)
+      slock_lock(filt->lock);
+      filt->pass            = pass;
+      filt->next_packet     = 0;
+      filt->pending_packets = pass->num_packets;
+      scond_broadcast(filt->work_cond);
+
+      /* Take tiles from the queue too instead of only waiting */
+      while (filt->next_packet < pass->num_packets)
       {
-#if 0
-         RARCH_LOG("Firing off filter thread %u ...\n", i);
+         i = filt->next_packet++;
+         slock_unlock(filt->lock);
+
+         pass->packets[i].work(pass->impl_data, pass->packets[i].thread_data);
+
+         slock_lock(filt->lock);
+         filt->pending_packets--;
+      }
+
+      while (filt->pending_packets)
+         scond_wait(filt->done_cond, filt->lock);
+      filt->pass = NULL;
+      slock_unlock(filt->lock);
+      return;
+   }
 #endif
-         filt->thread_data[i].packet = &filt->packets[i];
-         slock_lock(filt->thread_data[i].lock);
-         filt->thread_data[i].done = false;
-         scond_signal(filt->thread_data[i].cond);
-         slock_unlock(filt->thread_data[i].lock);
+
+   for (i = 0; i < pass->num_packets; i++)
+      pass->packets[i].work(pass->impl_data, pass->packets[i].thread_data);
+}
+
+/* Runs passes first to last one band of rows at a time, so that
+ * what they pass on to each other never leaves the cache. */
+static void softfilter_run_bands(rarch_softfilter_t *filt,
+      unsigned first, unsigned last,
+      uint8_t *output, size_t output_stride,
+      const uint8_t *input, size_t input_stride)
+{
+   unsigned y, k;
+   struct rarch_softfilter_pass *passes = filt->passes;
+   struct rarch_softfilter_pass *end    = &passes[last];
+   unsigned height                      = passes[first].height;
+
+   for (y = 0; y < height; y += filt->band_rows)
+   {
+      softfilter_plan_band(passes, first, last,
+            y, MIN(y + filt->band_rows, height));
+
+      for (k = first; k <= last; k++)
+      {
+         struct rarch_softfilter_pass *pass = &passes[k];
+         const uint8_t *src                 = input
+            + pass->band_lo * input_stride;
+         size_t src_stride                  = input_stride;
+         uint8_t *dst                       = output
+            + pass->out_lo * output_stride;
+         size_t dst_stride                  = output_stride;
+
+         if (k > first)
+         {
+            const struct rarch_softfilter_pass *prev = pass - 1;
+            src        = prev->band + (pass->band_lo
+                  - prev->band_lo * prev->scale) * prev->stride;
+            src_stride = prev->stride;
+         }
+
+         if (pass->band)
+         {
+            dst        = pass->band;
+            dst_stride = pass->stride;
+         }
+
+         softfilter_run_pass(filt, pass, dst, dst_stride, src,
+               pass->width, pass->band_hi - pass->band_lo, src_stride);
       }
 
-      /* Wait for workers */
-      for (i = 0; i < filt->threads; i++)
+      /* The last pass made extra rows around the band as context
+       * for itself, only copy out the band. */
+      if (end->band)
       {
-#if 0
-         RARCH_LOG("Waiting for filter thread %u ...\n", i);
-#endif
-         slock_lock(filt->thread_data[i].lock);
-         while (!filt->thread_data[i].done)
-            scond_wait(filt->thread_data[i].cond, filt->thread_data[i].lock);
-         slock_unlock(filt->thread_data[i].lock);
+         unsigned row;
+         size_t len = end->out_width * end->bpp;
+
+         for (row = end->out_lo; row < end->out_hi; row++)
+            memcpy(output + row * output_stride, end->band
+                  + (row - end->band_lo * end->scale) * end->stride, len);
       }
-      return;
    }
-#endif
+}
+
+void rarch_softfilter_process(rarch_softfilter_t *filt,
+      void *output, size_t output_stride,
+      const void *input, unsigned width, unsigned height,
+      size_t input_stride)
+{
+   unsigned i, first;
 
-   for (i = 0; i < filt->threads; i++)
-      filt->packets[i].work(filt->impl_data, filt->packets[i].thread_data);
+   if (!filt || !filt->passes)
+      return;
+
+   for (first = 0; first < filt->num_passes; first = i + 1)
+   {
+      struct rarch_softfilter_pass *pass;
+      void *out         = output;
+      size_t out_stride = output_stride;
+
+      for (i = first; ; i++)
+      {
+         pass         = &filt->passes[i];
+         pass->width  = width;
+         pass->height = height;
+         softfilter_pass_output_size(pass, &width, &height, width, height);
+         pass->out_width  = width;
+         pass->out_height = height;
+
+         if (!pass->fuse_next)
+            break;
+      }
+
+      if (i + 1 < filt->num_passes)
+      {
+         out        = pass->frame;
+         out_stride = pass->stride;
+      }
+
+      if (i == first)
+         softfilter_run_pass(filt, pass, out, out_stride, input,
+               pass->width, pass->height, input_stride);
+      else
+         softfilter_run_bands(filt, first, i, (uint8_t*)out, out_stride,
+               (const uint8_t*)input, input_stride);
+
+      input        = out;
+      input_stride = out_stride;
+   }
 }
@@ -170,6 +170,8 @@ static const struct softfilter_implementation darken = {
    SOFTFILTER_API_VERSION,
    "Darken",
    "darken",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
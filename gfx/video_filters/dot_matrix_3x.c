@@ -321,6 +321,8 @@ static const struct softfilter_implementation dot_matrix_3x_generic = {
    SOFTFILTER_API_VERSION,
    "Dot Matrix 3x",
    "dot_matrix_3x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
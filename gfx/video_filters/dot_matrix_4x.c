@@ -358,6 +358,8 @@ static const struct softfilter_implementation dot_matrix_4x_generic = {
    SOFTFILTER_API_VERSION,
    "Dot Matrix 4x",
    "dot_matrix_4x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
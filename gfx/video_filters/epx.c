@@ -19,6 +19,13 @@
 #include <stdlib.h>
 
 #include <retro_endianness.h>
+#include <retro_inline.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
 
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation epx_get_implementation
@@ -45,6 +52,7 @@ struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
+   softfilter_simd_mask_t simd;
    unsigned in_fmt;
 };
 
@@ -79,7 +87,8 @@ static void *epx_generic_create(const struct softfilter_config *config,
       free(filt);
       return NULL;
    }
-   filt->threads            = 1;
+   filt->threads            = threads;
+   filt->simd               = simd;
    filt->in_fmt             = in_fmt;
    return filt;
 }
@@ -189,6 +198,128 @@ static void epx_generic_rgb565 (unsigned width, unsigned height,
    }
 }
 
+/* The SIMD versions compute the same result written the way
+ * Scale2x does it, with the left/right neighbours of the line's
+ * first and last pixel taken to be the pixel itself. Vectors load
+ * one pixel to either side of them, so those pixels go through
+ * epx_pixel_rgb565() instead. */
+#if defined(__SSE2__) || (defined(__ARM_NEON__) || defined(__ARM_NEON))
+static INLINE void epx_pixel_rgb565(const uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride,
+      unsigned x, unsigned width)
+{
+   uint16_t colorX = src[x];
+   uint16_t colorA = (x > 0) ? src[x - 1] : colorX;
+   uint16_t colorC = (x < width - 1) ? src[x + 1] : colorX;
+   uint16_t colorD = (src - src_stride)[x];
+   uint16_t colorB = (src + src_stride)[x];
+   uint16_t *dP1   = dst + (x << 1);
+   uint16_t *dP2   = dP1 + dst_stride;
+
+   if ((colorA != colorC) && (colorB != colorD))
+   {
+      dP1[0] = (colorD == colorA) ? colorD : colorX;
+      dP1[1] = (colorC == colorD) ? colorC : colorX;
+      dP2[0] = (colorA == colorB) ? colorA : colorX;
+      dP2[1] = (colorB == colorC) ? colorB : colorX;
+   }
+   else
+      dP1[0] = dP1[1] = dP2[0] = dP2[1] = colorX;
+}
+#endif
+
+#if defined(__SSE2__)
+#define EPX_SELECT(mask, a, b) _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+
+static void epx_sse2_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned x;
+
+   for (; height; height--)
+   {
+      epx_pixel_rgb565(src, src_stride, dst, dst_stride, 0, width);
+
+      for (x = 1; x + 8 < width; x += 8)
+      {
+         __m128i colorA = _mm_loadu_si128((const __m128i*)(src + x - 1));
+         __m128i colorX = _mm_loadu_si128((const __m128i*)(src + x));
+         __m128i colorC = _mm_loadu_si128((const __m128i*)(src + x + 1));
+         __m128i colorD = _mm_loadu_si128((const __m128i*)(src + x - src_stride));
+         __m128i colorB = _mm_loadu_si128((const __m128i*)(src + x + src_stride));
+         __m128i skip   = _mm_or_si128(_mm_cmpeq_epi16(colorA, colorC),
+               _mm_cmpeq_epi16(colorB, colorD));
+         __m128i p00    = EPX_SELECT(_mm_andnot_si128(skip,
+                  _mm_cmpeq_epi16(colorD, colorA)), colorD, colorX);
+         __m128i p01    = EPX_SELECT(_mm_andnot_si128(skip,
+                  _mm_cmpeq_epi16(colorC, colorD)), colorC, colorX);
+         __m128i p10    = EPX_SELECT(_mm_andnot_si128(skip,
+                  _mm_cmpeq_epi16(colorA, colorB)), colorA, colorX);
+         __m128i p11    = EPX_SELECT(_mm_andnot_si128(skip,
+                  _mm_cmpeq_epi16(colorB, colorC)), colorB, colorX);
+         uint16_t *dP1  = dst + (x << 1);
+         uint16_t *dP2  = dP1 + dst_stride;
+
+         _mm_storeu_si128((__m128i*)(dP1),     _mm_unpacklo_epi16(p00, p01));
+         _mm_storeu_si128((__m128i*)(dP1 + 8), _mm_unpackhi_epi16(p00, p01));
+         _mm_storeu_si128((__m128i*)(dP2),     _mm_unpacklo_epi16(p10, p11));
+         _mm_storeu_si128((__m128i*)(dP2 + 8), _mm_unpackhi_epi16(p10, p11));
+      }
+
+      for (; x < width; x++)
+         epx_pixel_rgb565(src, src_stride, dst, dst_stride, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
+}
+
+#undef EPX_SELECT
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+static void epx_neon_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned x;
+
+   for (; height; height--)
+   {
+      epx_pixel_rgb565(src, src_stride, dst, dst_stride, 0, width);
+
+      for (x = 1; x + 8 < width; x += 8)
+      {
+         uint16x8x2_t row0, row1;
+         uint16x8_t colorA = vld1q_u16(src + x - 1);
+         uint16x8_t colorX = vld1q_u16(src + x);
+         uint16x8_t colorC = vld1q_u16(src + x + 1);
+         uint16x8_t colorD = vld1q_u16(src + x - src_stride);
+         uint16x8_t colorB = vld1q_u16(src + x + src_stride);
+         uint16x8_t skip   = vorrq_u16(vceqq_u16(colorA, colorC),
+               vceqq_u16(colorB, colorD));
+
+         row0.val[0] = vbslq_u16(vbicq_u16(vceqq_u16(colorD, colorA), skip),
+               colorD, colorX);
+         row0.val[1] = vbslq_u16(vbicq_u16(vceqq_u16(colorC, colorD), skip),
+               colorC, colorX);
+         row1.val[0] = vbslq_u16(vbicq_u16(vceqq_u16(colorA, colorB), skip),
+               colorA, colorX);
+         row1.val[1] = vbslq_u16(vbicq_u16(vceqq_u16(colorB, colorC), skip),
+               colorB, colorX);
+
+         vst2q_u16(dst + (x << 1), row0);
+         vst2q_u16(dst + (x << 1) + dst_stride, row1);
+      }
+
+      for (; x < width; x++)
+         epx_pixel_rgb565(src, src_stride, dst, dst_stride, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
+}
+#endif
+
 static void epx_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr =
@@ -197,8 +328,18 @@ static void epx_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output = (uint16_t*)thr->out_data;
    unsigned width   = thr->width;
    unsigned height  = thr->height;
+   void (*filter)(unsigned, unsigned, int, int, uint16_t*,
+         unsigned, uint16_t*, unsigned) = epx_generic_rgb565;
+
+#if defined(__SSE2__)
+   if (((struct filter_data*)data)->simd & SOFTFILTER_SIMD_SSE2)
+      filter = epx_sse2_rgb565;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   if (((struct filter_data*)data)->simd & SOFTFILTER_SIMD_NEON)
+      filter = epx_neon_rgb565;
+#endif
 
-   epx_generic_rgb565(width, height,
+   filter(width, height,
          thr->first, thr->last, input,
          (unsigned)(thr->in_pitch / SOFTFILTER_BPP_RGB565),
          output,
@@ -382,6 +382,8 @@ static const struct softfilter_implementation gameboy3x_generic = {
    SOFTFILTER_API_VERSION,
    "Gameboy3x",
    "gameboy3x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
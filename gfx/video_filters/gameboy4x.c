@@ -440,6 +440,8 @@ static const struct softfilter_implementation gameboy4x_generic = {
    SOFTFILTER_API_VERSION,
    "Gameboy4x",
    "gameboy4x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -228,6 +228,8 @@ static const struct softfilter_implementation grid2x_generic = {
    SOFTFILTER_API_VERSION,
    "Grid2x",
    "grid2x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -244,6 +244,8 @@ static const struct softfilter_implementation grid3x_generic = {
    SOFTFILTER_API_VERSION,
    "Grid3x",
    "grid3x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -17,6 +17,14 @@
 #include "softfilter.h"
 #include <stdlib.h>
 
+#include <retro_inline.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation lq2x_get_implementation
 #define softfilter_thread_data lq2x_softfilter_thread_data
@@ -42,6 +50,7 @@ struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
+   softfilter_simd_mask_t simd;
    unsigned in_fmt;
 };
 
@@ -78,6 +87,7 @@ static void *lq2x_generic_create(const struct softfilter_config *config,
    /* Apparently the code is not thread-safe,
     * so force single threaded operation... */
    filt->threads = 1;
+   filt->simd    = simd;
    filt->in_fmt  = in_fmt;
    return filt;
 }
@@ -101,13 +111,67 @@ static void lq2x_generic_destroy(void *data)
    free(filt);
 }
 
+/* Expands pixel @x of the line @src, with @src_prev and
+ * @src_next being the lines above and below it. */
+static INLINE void lq2x_pixel_rgb565(const uint16_t *src_prev,
+      const uint16_t *src, const uint16_t *src_next,
+      uint16_t *out0, uint16_t *out1, unsigned x, unsigned width)
+{
+   uint16_t A = src_prev[x];
+   uint16_t B = (x > 0) ? src[x - 1] : src[x];
+   uint16_t C = src[x];
+   uint16_t D = (x < width - 1) ? src[x + 1] : src[x];
+   uint16_t E = src_next[x];
+   uint16_t c = C;
+
+   if (A != E && B != D)
+   {
+      out0[(x << 1)    ] = (A == B ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
+      out0[(x << 1) + 1] = (A == D ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
+      out1[(x << 1)    ] = (E == B ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
+      out1[(x << 1) + 1] = (E == D ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
+   }
+   else
+   {
+      out0[(x << 1)    ] = c;
+      out0[(x << 1) + 1] = c;
+      out1[(x << 1)    ] = c;
+      out1[(x << 1) + 1] = c;
+   }
+}
+
+static INLINE void lq2x_pixel_xrgb8888(const uint32_t *src_prev,
+      const uint32_t *src, const uint32_t *src_next,
+      uint32_t *out0, uint32_t *out1, unsigned x, unsigned width)
+{
+   uint32_t A = src_prev[x];
+   uint32_t B = (x > 0) ? src[x - 1] : src[x];
+   uint32_t C = src[x];
+   uint32_t D = (x < width - 1) ? src[x + 1] : src[x];
+   uint32_t E = src_next[x];
+   uint32_t c = C;
+
+   if (A != E && B != D)
+   {
+      out0[(x << 1)    ] = (A == B ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
+      out0[(x << 1) + 1] = (A == D ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
+      out1[(x << 1)    ] = (E == B ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
+      out1[(x << 1) + 1] = (E == D ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
+   }
+   else
+   {
+      out0[(x << 1)    ] = c;
+      out0[(x << 1) + 1] = c;
+      out1[(x << 1)    ] = c;
+      out1[(x << 1) + 1] = c;
+   }
+}
+
 static void lq2x_generic_rgb565(unsigned width, unsigned height,
       int first, int last, uint16_t *src,
       unsigned src_stride, uint16_t *dst, unsigned dst_stride)
 {
    unsigned x, y;
-   uint16_t *out0 = (uint16_t*)dst;
-   uint16_t *out1 = (uint16_t*)(dst + dst_stride);
 
    for (y = 0; y < height; y++)
    {
@@ -115,33 +179,11 @@ static void lq2x_generic_rgb565(unsigned width, unsigned height,
       int nextline = (y == height - 1 || last) ? 0 : src_stride;
 
       for (x = 0; x < width; x++)
-      {
-         uint16_t A = *(src - prevline);
-         uint16_t B = (x > 0) ? *(src - 1) : *src;
-         uint16_t C = *src;
-         uint16_t D = (x < width - 1) ? *(src + 1) : *src;
-         uint16_t E = *(src++ + nextline);
-         uint16_t c = C;
-
-         if (A != E && B != D)
-         {
-            *out0++ = (A == B ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
-            *out0++ = (A == D ? ((C + A - ((C ^ A) & 0x0821)) >> 1) : c);
-            *out1++ = (E == B ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
-            *out1++ = (E == D ? ((C + E - ((C ^ E) & 0x0821)) >> 1) : c);
-         }
-         else
-         {
-            *out0++ = c;
-            *out0++ = c;
-            *out1++ = c;
-            *out1++ = c;
-         }
-      }
+         lq2x_pixel_rgb565(src - prevline, src, src + nextline,
+               dst, dst + dst_stride, x, width);
 
-      src  += src_stride - width;
-      out0 += dst_stride + dst_stride - (width << 1);
-      out1 += dst_stride + dst_stride - (width << 1);
+      src += src_stride;
+      dst += dst_stride << 1;
    }
 }
 
@@ -150,8 +192,6 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
       unsigned src_stride, uint32_t *dst, unsigned dst_stride)
 {
    unsigned x, y;
-   uint32_t *out0 = (uint32_t*)dst;
-   uint32_t *out1 = (uint32_t*)(dst + dst_stride);
 
    for (y = 0; y < height; y++)
    {
@@ -159,36 +199,231 @@ static void lq2x_generic_xrgb8888(unsigned width, unsigned height,
       int nextline = (y == height - 1 || last) ? 0 : src_stride;
 
       for (x = 0; x < width; x++)
+         lq2x_pixel_xrgb8888(src - prevline, src, src + nextline,
+               dst, dst + dst_stride, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
+}
+
+/* The SIMD versions are the same as Scale2x's, blending the
+ * selected neighbour with the centre pixel. The blend is
+ * rewritten as (C & A) + (((C ^ A) & ~mask) >> 1), which gives
+ * the same result without needing a wider type for the sum.
+ * Vectors load one pixel to either side of them, so the first
+ * pixel of each line and the ones too close to its end go
+ * through the scalar path instead. */
+#if defined(__SSE2__)
+#define LQ2X_SELECT(mask, a, b) _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+
+static void lq2x_sse2_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+   const __m128i lsb = _mm_set1_epi16((short)(0xffff & ~0x0821));
+
+   for (y = 0; y < height; y++)
+   {
+      int prevline         = (y == 0 ? 0 : src_stride);
+      int nextline         = (y == height - 1 || last) ? 0 : src_stride;
+      const uint16_t *prev = src - prevline;
+      const uint16_t *next = src + nextline;
+      uint16_t *out0       = dst;
+      uint16_t *out1       = dst + dst_stride;
+
+      if (width)
+         lq2x_pixel_rgb565(prev, src, next, out0, out1, 0, width);
+
+      for (x = 1; x + 8 < width; x += 8)
+      {
+         __m128i A    = _mm_loadu_si128((const __m128i*)(prev + x));
+         __m128i B    = _mm_loadu_si128((const __m128i*)(src  + x - 1));
+         __m128i C    = _mm_loadu_si128((const __m128i*)(src  + x));
+         __m128i D    = _mm_loadu_si128((const __m128i*)(src  + x + 1));
+         __m128i E    = _mm_loadu_si128((const __m128i*)(next + x));
+         __m128i CA   = _mm_add_epi16(_mm_and_si128(C, A),
+               _mm_srli_epi16(_mm_and_si128(_mm_xor_si128(C, A), lsb), 1));
+         __m128i CE   = _mm_add_epi16(_mm_and_si128(C, E),
+               _mm_srli_epi16(_mm_and_si128(_mm_xor_si128(C, E), lsb), 1));
+         __m128i skip = _mm_or_si128(_mm_cmpeq_epi16(A, E), _mm_cmpeq_epi16(B, D));
+         __m128i p00  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(A, B)), CA, C);
+         __m128i p01  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(A, D)), CA, C);
+         __m128i p10  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(E, B)), CE, C);
+         __m128i p11  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(E, D)), CE, C);
+
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1)),     _mm_unpacklo_epi16(p00, p01));
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1) + 8), _mm_unpackhi_epi16(p00, p01));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1)),     _mm_unpacklo_epi16(p10, p11));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1) + 8), _mm_unpackhi_epi16(p10, p11));
+      }
+
+      for (; x < width; x++)
+         lq2x_pixel_rgb565(prev, src, next, out0, out1, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
+}
+
+static void lq2x_sse2_xrgb8888(unsigned width, unsigned height,
+      int first, int last, uint32_t *src,
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+   const __m128i lsb = _mm_set1_epi32((int)~0x0421);
+   /* The scalar sum wraps around at 32 bits */
+   const __m128i top = _mm_set1_epi32(0x7fffffff);
+
+   for (y = 0; y < height; y++)
+   {
+      int prevline         = (y == 0 ? 0 : src_stride);
+      int nextline         = (y == height - 1 || last) ? 0 : src_stride;
+      const uint32_t *prev = src - prevline;
+      const uint32_t *next = src + nextline;
+      uint32_t *out0       = dst;
+      uint32_t *out1       = dst + dst_stride;
+
+      if (width)
+         lq2x_pixel_xrgb8888(prev, src, next, out0, out1, 0, width);
+
+      for (x = 1; x + 4 < width; x += 4)
+      {
+         __m128i A    = _mm_loadu_si128((const __m128i*)(prev + x));
+         __m128i B    = _mm_loadu_si128((const __m128i*)(src  + x - 1));
+         __m128i C    = _mm_loadu_si128((const __m128i*)(src  + x));
+         __m128i D    = _mm_loadu_si128((const __m128i*)(src  + x + 1));
+         __m128i E    = _mm_loadu_si128((const __m128i*)(next + x));
+         __m128i CA   = _mm_and_si128(top, _mm_add_epi32(_mm_and_si128(C, A),
+               _mm_srli_epi32(_mm_and_si128(_mm_xor_si128(C, A), lsb), 1)));
+         __m128i CE   = _mm_and_si128(top, _mm_add_epi32(_mm_and_si128(C, E),
+               _mm_srli_epi32(_mm_and_si128(_mm_xor_si128(C, E), lsb), 1)));
+         __m128i skip = _mm_or_si128(_mm_cmpeq_epi32(A, E), _mm_cmpeq_epi32(B, D));
+         __m128i p00  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(A, B)), CA, C);
+         __m128i p01  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(A, D)), CA, C);
+         __m128i p10  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(E, B)), CE, C);
+         __m128i p11  = LQ2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(E, D)), CE, C);
+
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1)),     _mm_unpacklo_epi32(p00, p01));
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1) + 4), _mm_unpackhi_epi32(p00, p01));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1)),     _mm_unpacklo_epi32(p10, p11));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1) + 4), _mm_unpackhi_epi32(p10, p11));
+      }
+
+      for (; x < width; x++)
+         lq2x_pixel_xrgb8888(prev, src, next, out0, out1, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
+}
+
+#undef LQ2X_SELECT
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+static void lq2x_neon_rgb565(unsigned width, unsigned height,
+      int first, int last, uint16_t *src,
+      unsigned src_stride, uint16_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+   const uint16x8_t lsb = vdupq_n_u16(0xffff & ~0x0821);
+
+   for (y = 0; y < height; y++)
+   {
+      int prevline         = (y == 0 ? 0 : src_stride);
+      int nextline         = (y == height - 1 || last) ? 0 : src_stride;
+      const uint16_t *prev = src - prevline;
+      const uint16_t *next = src + nextline;
+      uint16_t *out0       = dst;
+      uint16_t *out1       = dst + dst_stride;
+
+      if (width)
+         lq2x_pixel_rgb565(prev, src, next, out0, out1, 0, width);
+
+      for (x = 1; x + 8 < width; x += 8)
       {
-         uint32_t A = *(src - prevline);
-         uint32_t B = (x > 0) ? *(src - 1) : *src;
-         uint32_t C = *src;
-         uint32_t D = (x < width - 1) ? *(src + 1) : *src;
-         uint32_t E = *(src++ + nextline);
-         uint32_t c = C;
-
-         if (A != E && B != D)
-         {
-            *out0++ = (A == B ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
-            *out0++ = (A == D ? (C + A - ((C ^ A) & 0x0421)) >> 1 : c);
-            *out1++ = (E == B ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
-            *out1++ = (E == D ? (C + E - ((C ^ E) & 0x0421)) >> 1 : c);
-         }
-         else
-         {
-            *out0++ = c;
-            *out0++ = c;
-            *out1++ = c;
-            *out1++ = c;
-         }
+         uint16x8x2_t row0, row1;
+         uint16x8_t A    = vld1q_u16(prev + x);
+         uint16x8_t B    = vld1q_u16(src  + x - 1);
+         uint16x8_t C    = vld1q_u16(src  + x);
+         uint16x8_t D    = vld1q_u16(src  + x + 1);
+         uint16x8_t E    = vld1q_u16(next + x);
+         uint16x8_t CA   = vaddq_u16(vandq_u16(C, A),
+               vshrq_n_u16(vandq_u16(veorq_u16(C, A), lsb), 1));
+         uint16x8_t CE   = vaddq_u16(vandq_u16(C, E),
+               vshrq_n_u16(vandq_u16(veorq_u16(C, E), lsb), 1));
+         uint16x8_t skip = vorrq_u16(vceqq_u16(A, E), vceqq_u16(B, D));
+
+         row0.val[0]     = vbslq_u16(vbicq_u16(vceqq_u16(A, B), skip), CA, C);
+         row0.val[1]     = vbslq_u16(vbicq_u16(vceqq_u16(A, D), skip), CA, C);
+         row1.val[0]     = vbslq_u16(vbicq_u16(vceqq_u16(E, B), skip), CE, C);
+         row1.val[1]     = vbslq_u16(vbicq_u16(vceqq_u16(E, D), skip), CE, C);
+
+         vst2q_u16(out0 + (x << 1), row0);
+         vst2q_u16(out1 + (x << 1), row1);
       }
 
-      src += src_stride - width;
-      out0 += dst_stride + dst_stride - (width << 1);
-      out1 += dst_stride + dst_stride - (width << 1);
+      for (; x < width; x++)
+         lq2x_pixel_rgb565(prev, src, next, out0, out1, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
    }
 }
 
+static void lq2x_neon_xrgb8888(unsigned width, unsigned height,
+      int first, int last, uint32_t *src,
+      unsigned src_stride, uint32_t *dst, unsigned dst_stride)
+{
+   unsigned x, y;
+   const uint32x4_t lsb = vdupq_n_u32(~0x0421u);
+   /* The scalar sum wraps around at 32 bits */
+   const uint32x4_t top = vdupq_n_u32(0x7fffffff);
+
+   for (y = 0; y < height; y++)
+   {
+      int prevline         = (y == 0 ? 0 : src_stride);
+      int nextline         = (y == height - 1 || last) ? 0 : src_stride;
+      const uint32_t *prev = src - prevline;
+      const uint32_t *next = src + nextline;
+      uint32_t *out0       = dst;
+      uint32_t *out1       = dst + dst_stride;
+
+      if (width)
+         lq2x_pixel_xrgb8888(prev, src, next, out0, out1, 0, width);
+
+      for (x = 1; x + 4 < width; x += 4)
+      {
+         uint32x4x2_t row0, row1;
+         uint32x4_t A    = vld1q_u32(prev + x);
+         uint32x4_t B    = vld1q_u32(src  + x - 1);
+         uint32x4_t C    = vld1q_u32(src  + x);
+         uint32x4_t D    = vld1q_u32(src  + x + 1);
+         uint32x4_t E    = vld1q_u32(next + x);
+         uint32x4_t CA   = vandq_u32(top, vaddq_u32(vandq_u32(C, A),
+               vshrq_n_u32(vandq_u32(veorq_u32(C, A), lsb), 1)));
+         uint32x4_t CE   = vandq_u32(top, vaddq_u32(vandq_u32(C, E),
+               vshrq_n_u32(vandq_u32(veorq_u32(C, E), lsb), 1)));
+         uint32x4_t skip = vorrq_u32(vceqq_u32(A, E), vceqq_u32(B, D));
+
+         row0.val[0]     = vbslq_u32(vbicq_u32(vceqq_u32(A, B), skip), CA, C);
+         row0.val[1]     = vbslq_u32(vbicq_u32(vceqq_u32(A, D), skip), CA, C);
+         row1.val[0]     = vbslq_u32(vbicq_u32(vceqq_u32(E, B), skip), CE, C);
+         row1.val[1]     = vbslq_u32(vbicq_u32(vceqq_u32(E, D), skip), CE, C);
+
+         vst2q_u32(out0 + (x << 1), row0);
+         vst2q_u32(out1 + (x << 1), row1);
+      }
+
+      for (; x < width; x++)
+         lq2x_pixel_xrgb8888(prev, src, next, out0, out1, x, width);
+
+      src += src_stride;
+      dst += dst_stride << 1;
+   }
+}
+#endif
+
 static void lq2x_work_cb_rgb565(void *data, void *thread_data)
 {
    struct softfilter_thread_data *thr =
@@ -197,7 +432,18 @@ static void lq2x_work_cb_rgb565(void *data, void *thread_data)
    uint16_t *output                   = (uint16_t*)thr->out_data;
    unsigned width                     = thr->width;
    unsigned height                    = thr->height;
-   lq2x_generic_rgb565(width, height,
+   void (*filter)(unsigned, unsigned, int, int, uint16_t*,
+         unsigned, uint16_t*, unsigned) = lq2x_generic_rgb565;
+
+#if defined(__SSE2__)
+   if (((struct filter_data*)data)->simd & SOFTFILTER_SIMD_SSE2)
+      filter = lq2x_sse2_rgb565;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   if (((struct filter_data*)data)->simd & SOFTFILTER_SIMD_NEON)
+      filter = lq2x_neon_rgb565;
+#endif
+
+   filter(width, height,
          thr->first, thr->last, input,
          (unsigned)(thr->in_pitch / SOFTFILTER_BPP_RGB565),
          output,
@@ -212,7 +458,18 @@ static void lq2x_work_cb_xrgb8888(void *data, void *thread_data)
    uint32_t *output                   = (uint32_t*)thr->out_data;
    unsigned width                     = thr->width;
    unsigned height                    = thr->height;
-   lq2x_generic_xrgb8888(width, height,
+   void (*filter)(unsigned, unsigned, int, int, uint32_t*,
+         unsigned, uint32_t*, unsigned) = lq2x_generic_xrgb8888;
+
+#if defined(__SSE2__)
+   if (((struct filter_data*)data)->simd & SOFTFILTER_SIMD_SSE2)
+      filter = lq2x_sse2_xrgb8888;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   if (((struct filter_data*)data)->simd & SOFTFILTER_SIMD_NEON)
+      filter = lq2x_neon_xrgb8888;
+#endif
+
+   filter(width, height,
          thr->first, thr->last, input,
          (unsigned)(thr->in_pitch / SOFTFILTER_BPP_XRGB8888),
          output,
@@ -271,6 +528,8 @@ static const struct softfilter_implementation lq2x_generic = {
    SOFTFILTER_API_VERSION,
    "LQ2x",
    "lq2x",
+   SOFTFILTER_FLAG_BANDS,
+   1,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -20,6 +20,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation normal2x_get_implementation
 #define softfilter_thread_data normal2x_softfilter_thread_data
@@ -43,6 +49,7 @@ struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
+   softfilter_simd_mask_t simd;
    unsigned in_fmt;
 };
 
@@ -70,14 +77,13 @@ static void *normal2x_generic_create(const struct softfilter_config *config,
    struct filter_data *filt = (struct filter_data*)calloc(1, sizeof(*filt));
    if (!filt)
       return NULL;
-   if (!(filt->workers = (struct softfilter_thread_data*)calloc(1, sizeof(struct softfilter_thread_data))))
+   if (!(filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data))))
    {
       free(filt);
       return NULL;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
-   filt->threads = 1;
+   filt->threads = threads;
+   filt->simd    = simd;
    filt->in_fmt  = in_fmt;
    return filt;
 }
@@ -171,31 +177,215 @@ static void normal2x_work_cb_rgb565(void *data, void *thread_data)
    }
 }
 
+/* The SIMD versions double a whole vector of pixels at once
+ * by interleaving it with itself. */
+#if defined(__SSE2__)
+static void normal2x_work_cb_xrgb8888_sse2(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   const uint32_t *input              = (const uint32_t*)thr->in_data;
+   uint32_t *output                   = (uint32_t*)thr->out_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 2);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 2);
+   uint32_t x, y;
+
+   for (y = 0; y < thr->height; ++y)
+   {
+      uint32_t *out0 = output;
+      uint32_t *out1 = output + out_stride;
+
+      for (x = 0; x + 4 <= thr->width; x += 4)
+      {
+         __m128i color = _mm_loadu_si128((const __m128i*)(input + x));
+         __m128i lo    = _mm_unpacklo_epi32(color, color);
+         __m128i hi    = _mm_unpackhi_epi32(color, color);
+
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1)),     lo);
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1) + 4), hi);
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1)),     lo);
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1) + 4), hi);
+      }
+
+      for (; x < thr->width; ++x)
+      {
+         uint32_t color          = input[x];
+         out0[(x << 1)    ]      = color;
+         out0[(x << 1) + 1]      = color;
+         out1[(x << 1)    ]      = color;
+         out1[(x << 1) + 1]      = color;
+      }
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+
+static void normal2x_work_cb_rgb565_sse2(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   const uint16_t *input              = (const uint16_t*)thr->in_data;
+   uint16_t *output                   = (uint16_t*)thr->out_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 1);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 1);
+   uint32_t x, y;
+
+   for (y = 0; y < thr->height; ++y)
+   {
+      uint16_t *out0 = output;
+      uint16_t *out1 = output + out_stride;
+
+      for (x = 0; x + 8 <= thr->width; x += 8)
+      {
+         __m128i color = _mm_loadu_si128((const __m128i*)(input + x));
+         __m128i lo    = _mm_unpacklo_epi16(color, color);
+         __m128i hi    = _mm_unpackhi_epi16(color, color);
+
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1)),     lo);
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1) + 8), hi);
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1)),     lo);
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1) + 8), hi);
+      }
+
+      for (; x < thr->width; ++x)
+      {
+         uint16_t color          = input[x];
+         out0[(x << 1)    ]      = color;
+         out0[(x << 1) + 1]      = color;
+         out1[(x << 1)    ]      = color;
+         out1[(x << 1) + 1]      = color;
+      }
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+static void normal2x_work_cb_xrgb8888_neon(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   const uint32_t *input              = (const uint32_t*)thr->in_data;
+   uint32_t *output                   = (uint32_t*)thr->out_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 2);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 2);
+   uint32_t x, y;
+
+   for (y = 0; y < thr->height; ++y)
+   {
+      uint32_t *out0 = output;
+      uint32_t *out1 = output + out_stride;
+
+      for (x = 0; x + 4 <= thr->width; x += 4)
+      {
+         uint32x4x2_t color;
+         color.val[0] = vld1q_u32(input + x);
+         color.val[1] = color.val[0];
+
+         vst2q_u32(out0 + (x << 1), color);
+         vst2q_u32(out1 + (x << 1), color);
+      }
+
+      for (; x < thr->width; ++x)
+      {
+         uint32_t color          = input[x];
+         out0[(x << 1)    ]      = color;
+         out0[(x << 1) + 1]      = color;
+         out1[(x << 1)    ]      = color;
+         out1[(x << 1) + 1]      = color;
+      }
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+
+static void normal2x_work_cb_rgb565_neon(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   const uint16_t *input              = (const uint16_t*)thr->in_data;
+   uint16_t *output                   = (uint16_t*)thr->out_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 1);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 1);
+   uint32_t x, y;
+
+   for (y = 0; y < thr->height; ++y)
+   {
+      uint16_t *out0 = output;
+      uint16_t *out1 = output + out_stride;
+
+      for (x = 0; x + 8 <= thr->width; x += 8)
+      {
+         uint16x8x2_t color;
+         color.val[0] = vld1q_u16(input + x);
+         color.val[1] = color.val[0];
+
+         vst2q_u16(out0 + (x << 1), color);
+         vst2q_u16(out1 + (x << 1), color);
+      }
+
+      for (; x < thr->width; ++x)
+      {
+         uint16_t color          = input[x];
+         out0[(x << 1)    ]      = color;
+         out0[(x << 1) + 1]      = color;
+         out1[(x << 1)    ]      = color;
+         out1[(x << 1) + 1]      = color;
+      }
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+#endif
+
 static void normal2x_generic_packets(void *data,
       struct softfilter_work_packet *packets,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height, size_t input_stride)
 {
-   /* We are guaranteed single threaded operation
-    * (filt->threads = 1) so we don't need to loop
-    * over threads and can cull some code. This only
-    * makes the tiniest performance difference, but
-    * every little helps when running on an o3DS... */
-   struct filter_data *filt           = (struct filter_data*)data;
-   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[0];
-
-   thr->out_data                      = (uint8_t*)output;
-   thr->in_data                       = (const uint8_t*)input;
-   thr->out_pitch                     = output_stride;
-   thr->in_pitch                      = input_stride;
-   thr->width                         = width;
-   thr->height                        = height;
+   unsigned i;
+   struct filter_data *filt = (struct filter_data*)data;
+   softfilter_work_t work   = NULL;
 
    if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
-      packets[0].work                 = normal2x_work_cb_xrgb8888;
+   {
+      work = normal2x_work_cb_xrgb8888;
+#if defined(__SSE2__)
+      if (filt->simd & SOFTFILTER_SIMD_SSE2)
+         work = normal2x_work_cb_xrgb8888_sse2;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      if (filt->simd & SOFTFILTER_SIMD_NEON)
+         work = normal2x_work_cb_xrgb8888_neon;
+#endif
+   }
    else if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
-      packets[0].work                 = normal2x_work_cb_rgb565;
-   packets[0].thread_data             = thr;
+   {
+      work = normal2x_work_cb_rgb565;
+#if defined(__SSE2__)
+      if (filt->simd & SOFTFILTER_SIMD_SSE2)
+         work = normal2x_work_cb_rgb565_sse2;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      if (filt->simd & SOFTFILTER_SIMD_NEON)
+         work = normal2x_work_cb_rgb565_neon;
+#endif
+   }
+
+   for (i = 0; i < filt->threads; i++)
+   {
+      struct softfilter_thread_data *thr =
+         (struct softfilter_thread_data*)&filt->workers[i];
+      unsigned y_start       = (height * i) / filt->threads;
+      unsigned y_end         = (height * (i + 1)) / filt->threads;
+
+      thr->out_data          = (uint8_t*)output + y_start * 2 * output_stride;
+      thr->in_data           = (const uint8_t*)input + y_start * input_stride;
+      thr->out_pitch         = output_stride;
+      thr->in_pitch          = input_stride;
+      thr->width             = width;
+      thr->height            = y_end - y_start;
+
+      packets[i].work        = work;
+      packets[i].thread_data = thr;
+   }
 }
 
 static const struct softfilter_implementation normal2x_generic = {
@@ -212,6 +402,8 @@ static const struct softfilter_implementation normal2x_generic = {
    SOFTFILTER_API_VERSION,
    "Normal2x",
    "normal2x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
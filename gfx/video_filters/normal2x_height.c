@@ -196,6 +196,8 @@ static const struct softfilter_implementation normal2x_height_generic = {
    SOFTFILTER_API_VERSION,
    "Normal2x Height",
    "normal2x_height",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -198,6 +198,8 @@ static const struct softfilter_implementation normal2x_width_generic = {
    SOFTFILTER_API_VERSION,
    "Normal2x Width",
    "normal2x_width",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -232,6 +232,8 @@ static const struct softfilter_implementation normal4x_generic = {
    SOFTFILTER_API_VERSION,
    "Normal4x",
    "normal4x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
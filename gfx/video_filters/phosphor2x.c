@@ -469,6 +469,8 @@ static const struct softfilter_implementation phosphor2x_generic = {
    SOFTFILTER_API_VERSION,
    "Phosphor2x",
    "phosphor2x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
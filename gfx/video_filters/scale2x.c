@@ -20,6 +20,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <retro_inline.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#include <arm_neon.h>
+#endif
+
 #ifdef RARCH_INTERNAL
 #define softfilter_get_implementation scale2x_get_implementation
 #define softfilter_thread_data scale2x_softfilter_thread_data
@@ -43,6 +51,7 @@ struct filter_data
 {
    unsigned threads;
    struct softfilter_thread_data *workers;
+   softfilter_work_t work;
    unsigned in_fmt;
 };
 
@@ -62,41 +71,62 @@ static unsigned scale2x_generic_threads(void *data)
    return filt->threads;
 }
 
-static void *scale2x_generic_create(const struct softfilter_config *config,
-      unsigned in_fmt, unsigned out_fmt,
-      unsigned max_width, unsigned max_height,
-      unsigned threads, softfilter_simd_mask_t simd, void *userdata)
+/* Expands pixel @x of the line @src, with @src_prev and
+ * @src_next being the lines above and below it. */
+static INLINE void scale2x_pixel_xrgb8888(const uint32_t *src_prev,
+      const uint32_t *src, const uint32_t *src_next,
+      uint32_t *out0, uint32_t *out1, unsigned x, unsigned width)
 {
-   struct filter_data *filt = (struct filter_data*)calloc(1, sizeof(*filt));
-   if (!filt)
-      return NULL;
-   if (!(filt->workers = (struct softfilter_thread_data*)calloc(1, sizeof(struct softfilter_thread_data))))
+   /* Get sample points */
+   uint32_t A = src_prev[x];
+   uint32_t B = (x > 0) ? src[x - 1] : src[x];
+   uint32_t C = src[x];
+   uint32_t D = (x < width - 1) ? src[x + 1] : src[x];
+   uint32_t E = src_next[x];
+
+   /* Apply pixel expansion algorithm */
+   if (A != E && B != D)
    {
-      free(filt);
-      return NULL;
+      out0[(x << 1)    ] = (A == B ? A : C);
+      out0[(x << 1) + 1] = (A == D ? A : C);
+      out1[(x << 1)    ] = (E == B ? E : C);
+      out1[(x << 1) + 1] = (E == D ? E : C);
+   }
+   else
+   {
+      out0[(x << 1)    ] = C;
+      out0[(x << 1) + 1] = C;
+      out1[(x << 1)    ] = C;
+      out1[(x << 1) + 1] = C;
    }
-   /* Apparently the code is not thread-safe,
-    * so force single threaded operation... */
-   filt->threads = 1;
-   filt->in_fmt  = in_fmt;
-   return filt;
 }
 
-static void scale2x_generic_output(void *data,
-      unsigned *out_width, unsigned *out_height,
-      unsigned width, unsigned height)
+static INLINE void scale2x_pixel_rgb565(const uint16_t *src_prev,
+      const uint16_t *src, const uint16_t *src_next,
+      uint16_t *out0, uint16_t *out1, unsigned x, unsigned width)
 {
-   *out_width  = width << 1;
-   *out_height = height << 1;
-}
+   /* Get sample points */
+   uint16_t A = src_prev[x];
+   uint16_t B = (x > 0) ? src[x - 1] : src[x];
+   uint16_t C = src[x];
+   uint16_t D = (x < width - 1) ? src[x + 1] : src[x];
+   uint16_t E = src_next[x];
 
-static void scale2x_generic_destroy(void *data)
-{
-   struct filter_data *filt = (struct filter_data*)data;
-   if (!filt)
-      return;
-   free(filt->workers);
-   free(filt);
+   /* Apply pixel expansion algorithm */
+   if (A != E && B != D)
+   {
+      out0[(x << 1)    ] = (A == B ? A : C);
+      out0[(x << 1) + 1] = (A == D ? A : C);
+      out1[(x << 1)    ] = (E == B ? E : C);
+      out1[(x << 1) + 1] = (E == D ? E : C);
+   }
+   else
+   {
+      out0[(x << 1)    ] = C;
+      out0[(x << 1) + 1] = C;
+      out1[(x << 1)    ] = C;
+      out1[(x << 1) + 1] = C;
+   }
 }
 
 static void scale2x_work_cb_xrgb8888(void *data, void *thread_data)
@@ -105,45 +135,21 @@ static void scale2x_work_cb_xrgb8888(void *data, void *thread_data)
    uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 2);
    uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 2);
    const uint32_t *input              = (const uint32_t*)thr->in_data;
-   uint32_t *output0                  = (uint32_t*)thr->out_data;
-   uint32_t *output1                  = (uint32_t*)thr->out_data + out_stride;
-   uint16_t x, y;
+   uint32_t *output                   = (uint32_t*)thr->out_data;
+   unsigned x, y;
 
    for (y = 0; y < thr->height; y++)
    {
       /* Determine offsets of previous/next source lines */
-      uint32_t line_prev = (y == 0)               ? 0 : in_stride;
-      uint32_t line_next = (y == thr->height - 1) ? 0 : in_stride;
+      uint32_t line_prev = (y == 0 && !thr->first)             ? 0 : in_stride;
+      uint32_t line_next = (y == thr->height - 1 && thr->last) ? 0 : in_stride;
 
       for (x = 0; x < thr->width; x++)
-      {
-         /* Get sample points */
-         uint32_t A = *(input - line_prev);
-         uint32_t B = (x > 0) ? *(input - 1) : *input;
-         uint32_t C = *input;
-         uint32_t D = (x < thr->width - 1) ? *(input + 1) : *input;
-         uint32_t E = *(input++ + line_next);
-
-         /* Apply pixel expansion algorithm */
-         if (A != E && B != D)
-         {
-            *output0++ = (A == B ? A : C);
-            *output0++ = (A == D ? A : C);
-            *output1++ = (E == B ? E : C);
-            *output1++ = (E == D ? E : C);
-         }
-         else
-         {
-            *output0++ = C;
-            *output0++ = C;
-            *output1++ = C;
-            *output1++ = C;
-         }
-      }
+         scale2x_pixel_xrgb8888(input - line_prev, input, input + line_next,
+               output, output + out_stride, x, thr->width);
 
-      input   += in_stride - thr->width;
-      output0 += (out_stride << 1) - (thr->width << 1);
-      output1 += (out_stride << 1) - (thr->width << 1);
+      input  += in_stride;
+      output += out_stride << 1;
    }
 }
 
@@ -153,46 +159,288 @@ static void scale2x_work_cb_rgb565(void *data, void *thread_data)
    uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 1);
    uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 1);
    const uint16_t *input              = (const uint16_t*)thr->in_data;
-   uint16_t *output0                  = (uint16_t*)thr->out_data;
-   uint16_t *output1                  = (uint16_t*)thr->out_data + out_stride;
-   uint16_t x, y;
+   uint16_t *output                   = (uint16_t*)thr->out_data;
+   unsigned x, y;
 
    for (y = 0; y < thr->height; y++)
    {
       /* Determine offsets of previous/next source lines */
-      uint32_t line_prev = (y == 0)               ? 0 : in_stride;
-      uint32_t line_next = (y == thr->height - 1) ? 0 : in_stride;
+      uint32_t line_prev = (y == 0 && !thr->first)             ? 0 : in_stride;
+      uint32_t line_next = (y == thr->height - 1 && thr->last) ? 0 : in_stride;
 
       for (x = 0; x < thr->width; x++)
+         scale2x_pixel_rgb565(input - line_prev, input, input + line_next,
+               output, output + out_stride, x, thr->width);
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+
+/* The SIMD versions expand a whole vector of pixels at once,
+ * turning the branches into compare masks. Vectors load one
+ * pixel to either side of them, so the first pixel of each
+ * line and the ones too close to its end go through the
+ * scalar path instead. */
+#if defined(__SSE2__)
+#define SCALE2X_SELECT(mask, a, b) _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+
+static void scale2x_work_cb_xrgb8888_sse2(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 2);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 2);
+   const uint32_t *input              = (const uint32_t*)thr->in_data;
+   uint32_t *output                   = (uint32_t*)thr->out_data;
+   unsigned width                     = thr->width;
+   unsigned x, y;
+
+   for (y = 0; y < thr->height; y++)
+   {
+      uint32_t line_prev     = (y == 0 && !thr->first)             ? 0 : in_stride;
+      uint32_t line_next     = (y == thr->height - 1 && thr->last) ? 0 : in_stride;
+      const uint32_t *prev   = input - line_prev;
+      const uint32_t *next   = input + line_next;
+      uint32_t *out0         = output;
+      uint32_t *out1         = output + out_stride;
+
+      if (width)
+         scale2x_pixel_xrgb8888(prev, input, next, out0, out1, 0, width);
+
+      for (x = 1; x + 4 < width; x += 4)
+      {
+         __m128i A    = _mm_loadu_si128((const __m128i*)(prev  + x));
+         __m128i B    = _mm_loadu_si128((const __m128i*)(input + x - 1));
+         __m128i C    = _mm_loadu_si128((const __m128i*)(input + x));
+         __m128i D    = _mm_loadu_si128((const __m128i*)(input + x + 1));
+         __m128i E    = _mm_loadu_si128((const __m128i*)(next  + x));
+         __m128i skip = _mm_or_si128(_mm_cmpeq_epi32(A, E), _mm_cmpeq_epi32(B, D));
+         __m128i p00  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(A, B)), A, C);
+         __m128i p01  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(A, D)), A, C);
+         __m128i p10  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(E, B)), E, C);
+         __m128i p11  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi32(E, D)), E, C);
+
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1)),     _mm_unpacklo_epi32(p00, p01));
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1) + 4), _mm_unpackhi_epi32(p00, p01));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1)),     _mm_unpacklo_epi32(p10, p11));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1) + 4), _mm_unpackhi_epi32(p10, p11));
+      }
+
+      for (; x < width; x++)
+         scale2x_pixel_xrgb8888(prev, input, next, out0, out1, x, width);
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+
+static void scale2x_work_cb_rgb565_sse2(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 1);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 1);
+   const uint16_t *input              = (const uint16_t*)thr->in_data;
+   uint16_t *output                   = (uint16_t*)thr->out_data;
+   unsigned width                     = thr->width;
+   unsigned x, y;
+
+   for (y = 0; y < thr->height; y++)
+   {
+      uint32_t line_prev     = (y == 0 && !thr->first)             ? 0 : in_stride;
+      uint32_t line_next     = (y == thr->height - 1 && thr->last) ? 0 : in_stride;
+      const uint16_t *prev   = input - line_prev;
+      const uint16_t *next   = input + line_next;
+      uint16_t *out0         = output;
+      uint16_t *out1         = output + out_stride;
+
+      if (width)
+         scale2x_pixel_rgb565(prev, input, next, out0, out1, 0, width);
+
+      for (x = 1; x + 8 < width; x += 8)
+      {
+         __m128i A    = _mm_loadu_si128((const __m128i*)(prev  + x));
+         __m128i B    = _mm_loadu_si128((const __m128i*)(input + x - 1));
+         __m128i C    = _mm_loadu_si128((const __m128i*)(input + x));
+         __m128i D    = _mm_loadu_si128((const __m128i*)(input + x + 1));
+         __m128i E    = _mm_loadu_si128((const __m128i*)(next  + x));
+         __m128i skip = _mm_or_si128(_mm_cmpeq_epi16(A, E), _mm_cmpeq_epi16(B, D));
+         __m128i p00  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(A, B)), A, C);
+         __m128i p01  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(A, D)), A, C);
+         __m128i p10  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(E, B)), E, C);
+         __m128i p11  = SCALE2X_SELECT(_mm_andnot_si128(skip, _mm_cmpeq_epi16(E, D)), E, C);
+
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1)),     _mm_unpacklo_epi16(p00, p01));
+         _mm_storeu_si128((__m128i*)(out0 + (x << 1) + 8), _mm_unpackhi_epi16(p00, p01));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1)),     _mm_unpacklo_epi16(p10, p11));
+         _mm_storeu_si128((__m128i*)(out1 + (x << 1) + 8), _mm_unpackhi_epi16(p10, p11));
+      }
+
+      for (; x < width; x++)
+         scale2x_pixel_rgb565(prev, input, next, out0, out1, x, width);
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+
+#undef SCALE2X_SELECT
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+static void scale2x_work_cb_xrgb8888_neon(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 2);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 2);
+   const uint32_t *input              = (const uint32_t*)thr->in_data;
+   uint32_t *output                   = (uint32_t*)thr->out_data;
+   unsigned width                     = thr->width;
+   unsigned x, y;
+
+   for (y = 0; y < thr->height; y++)
+   {
+      uint32_t line_prev     = (y == 0 && !thr->first)             ? 0 : in_stride;
+      uint32_t line_next     = (y == thr->height - 1 && thr->last) ? 0 : in_stride;
+      const uint32_t *prev   = input - line_prev;
+      const uint32_t *next   = input + line_next;
+      uint32_t *out0         = output;
+      uint32_t *out1         = output + out_stride;
+
+      if (width)
+         scale2x_pixel_xrgb8888(prev, input, next, out0, out1, 0, width);
+
+      for (x = 1; x + 4 < width; x += 4)
       {
-         /* Get sample points */
-         uint16_t A = *(input - line_prev);
-         uint16_t B = (x > 0) ? *(input - 1) : *input;
-         uint16_t C = *input;
-         uint16_t D = (x < thr->width - 1) ? *(input + 1) : *input;
-         uint16_t E = *(input++ + line_next);
-
-         /* Apply pixel expansion algorithm */
-         if (A != E && B != D)
-         {
-            *output0++ = (A == B ? A : C);
-            *output0++ = (A == D ? A : C);
-            *output1++ = (E == B ? E : C);
-            *output1++ = (E == D ? E : C);
-         }
-         else
-         {
-            *output0++ = C;
-            *output0++ = C;
-            *output1++ = C;
-            *output1++ = C;
-         }
+         uint32x4x2_t row0, row1;
+         uint32x4_t A    = vld1q_u32(prev  + x);
+         uint32x4_t B    = vld1q_u32(input + x - 1);
+         uint32x4_t C    = vld1q_u32(input + x);
+         uint32x4_t D    = vld1q_u32(input + x + 1);
+         uint32x4_t E    = vld1q_u32(next  + x);
+         uint32x4_t skip = vorrq_u32(vceqq_u32(A, E), vceqq_u32(B, D));
+
+         row0.val[0]     = vbslq_u32(vbicq_u32(vceqq_u32(A, B), skip), A, C);
+         row0.val[1]     = vbslq_u32(vbicq_u32(vceqq_u32(A, D), skip), A, C);
+         row1.val[0]     = vbslq_u32(vbicq_u32(vceqq_u32(E, B), skip), E, C);
+         row1.val[1]     = vbslq_u32(vbicq_u32(vceqq_u32(E, D), skip), E, C);
+
+         vst2q_u32(out0 + (x << 1), row0);
+         vst2q_u32(out1 + (x << 1), row1);
       }
 
-      input   += in_stride - thr->width;
-      output0 += (out_stride << 1) - (thr->width << 1);
-      output1 += (out_stride << 1) - (thr->width << 1);
+      for (; x < width; x++)
+         scale2x_pixel_xrgb8888(prev, input, next, out0, out1, x, width);
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+
+static void scale2x_work_cb_rgb565_neon(void *data, void *thread_data)
+{
+   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)thread_data;
+   uint32_t in_stride                 = (uint32_t)(thr->in_pitch >> 1);
+   uint32_t out_stride                = (uint32_t)(thr->out_pitch >> 1);
+   const uint16_t *input              = (const uint16_t*)thr->in_data;
+   uint16_t *output                   = (uint16_t*)thr->out_data;
+   unsigned width                     = thr->width;
+   unsigned x, y;
+
+   for (y = 0; y < thr->height; y++)
+   {
+      uint32_t line_prev     = (y == 0 && !thr->first)             ? 0 : in_stride;
+      uint32_t line_next     = (y == thr->height - 1 && thr->last) ? 0 : in_stride;
+      const uint16_t *prev   = input - line_prev;
+      const uint16_t *next   = input + line_next;
+      uint16_t *out0         = output;
+      uint16_t *out1         = output + out_stride;
+
+      if (width)
+         scale2x_pixel_rgb565(prev, input, next, out0, out1, 0, width);
+
+      for (x = 1; x + 8 < width; x += 8)
+      {
+         uint16x8x2_t row0, row1;
+         uint16x8_t A    = vld1q_u16(prev  + x);
+         uint16x8_t B    = vld1q_u16(input + x - 1);
+         uint16x8_t C    = vld1q_u16(input + x);
+         uint16x8_t D    = vld1q_u16(input + x + 1);
+         uint16x8_t E    = vld1q_u16(next  + x);
+         uint16x8_t skip = vorrq_u16(vceqq_u16(A, E), vceqq_u16(B, D));
+
+         row0.val[0]     = vbslq_u16(vbicq_u16(vceqq_u16(A, B), skip), A, C);
+         row0.val[1]     = vbslq_u16(vbicq_u16(vceqq_u16(A, D), skip), A, C);
+         row1.val[0]     = vbslq_u16(vbicq_u16(vceqq_u16(E, B), skip), E, C);
+         row1.val[1]     = vbslq_u16(vbicq_u16(vceqq_u16(E, D), skip), E, C);
+
+         vst2q_u16(out0 + (x << 1), row0);
+         vst2q_u16(out1 + (x << 1), row1);
+      }
+
+      for (; x < width; x++)
+         scale2x_pixel_rgb565(prev, input, next, out0, out1, x, width);
+
+      input  += in_stride;
+      output += out_stride << 1;
+   }
+}
+#endif
+
+static void *scale2x_generic_create(const struct softfilter_config *config,
+      unsigned in_fmt, unsigned out_fmt,
+      unsigned max_width, unsigned max_height,
+      unsigned threads, softfilter_simd_mask_t simd, void *userdata)
+{
+   struct filter_data *filt = (struct filter_data*)calloc(1, sizeof(*filt));
+   if (!filt)
+      return NULL;
+   if (!(filt->workers = (struct softfilter_thread_data*)calloc(threads, sizeof(struct softfilter_thread_data))))
+   {
+      free(filt);
+      return NULL;
+   }
+   filt->threads = threads;
+   filt->in_fmt  = in_fmt;
+
+   if (in_fmt == SOFTFILTER_FMT_XRGB8888)
+   {
+      filt->work = scale2x_work_cb_xrgb8888;
+#if defined(__SSE2__)
+      if (simd & SOFTFILTER_SIMD_SSE2)
+         filt->work = scale2x_work_cb_xrgb8888_sse2;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      if (simd & SOFTFILTER_SIMD_NEON)
+         filt->work = scale2x_work_cb_xrgb8888_neon;
+#endif
+   }
+   else if (in_fmt == SOFTFILTER_FMT_RGB565)
+   {
+      filt->work = scale2x_work_cb_rgb565;
+#if defined(__SSE2__)
+      if (simd & SOFTFILTER_SIMD_SSE2)
+         filt->work = scale2x_work_cb_rgb565_sse2;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      if (simd & SOFTFILTER_SIMD_NEON)
+         filt->work = scale2x_work_cb_rgb565_neon;
+#endif
    }
+
+   return filt;
+}
+
+static void scale2x_generic_output(void *data,
+      unsigned *out_width, unsigned *out_height,
+      unsigned width, unsigned height)
+{
+   *out_width  = width << 1;
+   *out_height = height << 1;
+}
+
+static void scale2x_generic_destroy(void *data)
+{
+   struct filter_data *filt = (struct filter_data*)data;
+   if (!filt)
+      return;
+   free(filt->workers);
+   free(filt);
 }
 
 static void scale2x_generic_packets(void *data,
@@ -200,26 +448,31 @@ static void scale2x_generic_packets(void *data,
       void *output, size_t output_stride,
       const void *input, unsigned width, unsigned height, size_t input_stride)
 {
-   /* We are guaranteed single threaded operation
-    * (filt->threads = 1) so we don't need to loop
-    * over threads and can cull some code. This only
-    * makes the tiniest performance difference, but
-    * every little helps when running on an o3DS... */
-   struct filter_data *filt           = (struct filter_data*)data;
-   struct softfilter_thread_data *thr = (struct softfilter_thread_data*)&filt->workers[0];
+   unsigned i;
+   struct filter_data *filt = (struct filter_data*)data;
 
-   thr->out_data                      = (uint8_t*)output;
-   thr->in_data                       = (const uint8_t*)input;
-   thr->out_pitch                     = output_stride;
-   thr->in_pitch                      = input_stride;
-   thr->width                         = width;
-   thr->height                        = height;
+   for (i = 0; i < filt->threads; i++)
+   {
+      struct softfilter_thread_data *thr =
+         (struct softfilter_thread_data*)&filt->workers[i];
+      unsigned y_start       = (height * i) / filt->threads;
+      unsigned y_end         = (height * (i + 1)) / filt->threads;
+
+      thr->out_data          = (uint8_t*)output + y_start * 2 * output_stride;
+      thr->in_data           = (const uint8_t*)input + y_start * input_stride;
+      thr->out_pitch         = output_stride;
+      thr->in_pitch          = input_stride;
+      thr->width             = width;
+      thr->height            = y_end - y_start;
 
-   if (filt->in_fmt == SOFTFILTER_FMT_XRGB8888)
-      packets[0].work                 = scale2x_work_cb_xrgb8888;
-   else if (filt->in_fmt == SOFTFILTER_FMT_RGB565)
-      packets[0].work                 = scale2x_work_cb_rgb565;
-   packets[0].thread_data             = thr;
+      /* Workers need to know if they can access pixels
+       * outside their given buffer. */
+      thr->first             = y_start;
+      thr->last              = y_end == height;
+
+      packets[i].work        = filt->work;
+      packets[i].thread_data = thr;
+   }
 }
 
 static const struct softfilter_implementation scale2x_generic = {
@@ -236,6 +489,8 @@ static const struct softfilter_implementation scale2x_generic = {
    SOFTFILTER_API_VERSION,
    "Scale2x",
    "scale2x",
+   SOFTFILTER_FLAG_BANDS,
+   1,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
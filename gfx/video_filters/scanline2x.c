@@ -228,6 +228,8 @@ static const struct softfilter_implementation scanline2x_generic = {
    SOFTFILTER_API_VERSION,
    "Scanline2x",
    "scanline2x",
+   SOFTFILTER_FLAG_BANDS,
+   0,
 };
 
 const struct softfilter_implementation *softfilter_get_implementation(
@@ -97,7 +97,7 @@ typedef const struct softfilter_implementation
 const struct softfilter_implementation *softfilter_get_implementation(
       softfilter_simd_mask_t simd);
 
-#define SOFTFILTER_API_VERSION  2
+#define SOFTFILTER_API_VERSION  3
 
 /* Required base color formats */
 
@@ -111,6 +111,15 @@ const struct softfilter_implementation *softfilter_get_implementation(
 #define SOFTFILTER_BPP_RGB565   2
 #define SOFTFILTER_BPP_XRGB8888 4
 
+/* The filter can also be run on a band of rows of the frame,
+ * as if it were a whole frame. This requires each input row to
+ * become a fixed number of output rows, which only depend on it
+ * and the band_context_rows next to it; not on where the band is
+ * in the frame or on earlier calls. The frontend uses this to
+ * run chains of filters band by band, keeping the frames passed
+ * between them in cache. */
+#define SOFTFILTER_FLAG_BANDS   (1 << 0)
+
 /* Softfilter implementation.
  * Returns a bitmask of supported input formats. */
 typedef unsigned (*softfilter_query_input_formats_t)(void);
@@ -161,7 +170,11 @@ typedef void (*softfilter_get_work_packets_t)(void *data,
 /* Returns the number of worker threads the filter will use.
  * This can differ from the value passed to create() instead the filter
  * cannot be parallelized, etc. The number of threads must be less-or-equal
- * compared to the value passed to create(). */
+ * compared to the value passed to create().
+ *
+ * The frontend may pass create() more threads than it actually runs,
+ * to have frames split into smaller tiles of rows; packets are then
+ * run in any order and on any of its threads. */
 typedef unsigned (*softfilter_query_num_threads_t)(void *data);
 
 struct softfilter_implementation
@@ -176,13 +189,21 @@ struct softfilter_implementation
    softfilter_query_output_size_t query_output_size;
    softfilter_get_work_packets_t get_work_packets;
 
-   /* Must be SOFTFILTER_API_VERSION. */
+   /* Must be SOFTFILTER_API_VERSION. Implementations from version 2
+    * are still accepted, they end after short_ident. */
    unsigned api_version;
    /* Human readable identifier of implementation. */
    const char *ident;
    /* Computer-friendly short version of ident.
     * Lower case, no spaces and special characters, etc. */
    const char *short_ident;
+
+   /* Since API version 3. Bitmask of SOFTFILTER_FLAG_*. */
+   unsigned flags;
+   /* Since API version 3. With SOFTFILTER_FLAG_BANDS, how many
+    * input rows above and below a row the filter reads to produce
+    * the output rows for it. */
+   unsigned band_context_rows;
 };
 
 #ifdef __cplusplus
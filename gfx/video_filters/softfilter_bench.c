@@ -0,0 +1,544 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmarks the softfilter plugins in this directory.
+ *
+ * Build the plugins and the benchmark with 'make build=release bench',
+ * then run e.g.
+ *
+ *    ./softfilter_bench -w 320 -h 240 -n 500 *.filt
+ *
+ * Each .filt is run on a fixed test frame in every input format its
+ * filter supports, once with SIMD disabled and once with the SIMD mask
+ * of this build. The throughput of both is reported in megapixels of
+ * input per second, along with whether they produced the same output.
+ * All work packets run on the calling thread, so the figures are for
+ * a single core. */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <dirent.h>
+#include <dlfcn.h>
+
+#include "softfilter.h"
+
+#if defined(__APPLE__)
+#define BENCH_DYLIB_EXT ".dylib"
+#else
+#define BENCH_DYLIB_EXT ".so"
+#endif
+
+#define BENCH_MAX_PLUGS 64
+#define BENCH_MAX_KEYS  128
+
+struct bench_key
+{
+   char *key;
+   char *value;
+};
+
+struct bench_conf
+{
+   struct bench_key keys[BENCH_MAX_KEYS];
+   unsigned num_keys;
+   const char *prefix[2];
+};
+
+static void *bench_plugs[BENCH_MAX_PLUGS];
+static unsigned bench_num_plugs;
+
+static softfilter_simd_mask_t bench_simd_mask(void)
+{
+   softfilter_simd_mask_t mask = 0;
+#if defined(__SSE__)
+   mask |= SOFTFILTER_SIMD_SSE;
+#endif
+#if defined(__SSE2__)
+   mask |= SOFTFILTER_SIMD_SSE2;
+#endif
+#if defined(__AVX2__)
+   mask |= SOFTFILTER_SIMD_AVX2;
+#endif
+#if (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   mask |= SOFTFILTER_SIMD_NEON;
+#endif
+   return mask;
+}
+
+static double bench_time(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *bench_strdup(const char *s, size_t len)
+{
+   char *ret = (char*)malloc(len + 1);
+   if (ret)
+   {
+      memcpy(ret, s, len);
+      ret[len] = '\0';
+   }
+   return ret;
+}
+
+/* Reads the 'key = value' lines of a .filt file. Values can be
+ * quoted, and '#' starts a comment. */
+static int bench_conf_load(struct bench_conf *conf, const char *path)
+{
+   char line[1024];
+   FILE *file = fopen(path, "r");
+
+   if (!file)
+      return 0;
+
+   while (fgets(line, sizeof(line), file)
+         && conf->num_keys < BENCH_MAX_KEYS)
+   {
+      char *key = line, *value, *end;
+
+      while (isspace((unsigned char)*key))
+         key++;
+      if (!*key || *key == '#' || !(value = strchr(key, '=')))
+         continue;
+
+      for (end = value; end > key && isspace((unsigned char)end[-1]); end--);
+      conf->keys[conf->num_keys].key = bench_strdup(key, end - key);
+
+      value++;
+      while (isspace((unsigned char)*value))
+         value++;
+      if (*value == '"')
+         end = strchr(++value, '"');
+      else
+         end = strchr(value, '#');
+      if (!end)
+         end = value + strlen(value);
+      while (end > value && isspace((unsigned char)end[-1]))
+         end--;
+      conf->keys[conf->num_keys++].value = bench_strdup(value, end - value);
+   }
+
+   fclose(file);
+   return 1;
+}
+
+static void bench_conf_free(struct bench_conf *conf)
+{
+   unsigned i;
+   for (i = 0; i < conf->num_keys; i++)
+   {
+      free(conf->keys[i].key);
+      free(conf->keys[i].value);
+   }
+   conf->num_keys = 0;
+}
+
+static const char *bench_conf_find(const struct bench_conf *conf,
+      const char *key)
+{
+   unsigned i;
+   for (i = 0; i < conf->num_keys; i++)
+      if (!strcmp(conf->keys[i].key, key))
+         return conf->keys[i].value;
+   return NULL;
+}
+
+/* Same lookup order as config_file_userdata: index-specific
+ * keys, then ident-specific ones. */
+static const char *bench_conf_get(void *userdata, const char *key)
+{
+   unsigned i;
+   struct bench_conf *conf = (struct bench_conf*)userdata;
+
+   for (i = 0; i < 2; i++)
+   {
+      char name[256];
+      const char *value;
+      snprintf(name, sizeof(name), "%s_%s", conf->prefix[i], key);
+      if ((value = bench_conf_find(conf, name)))
+         return value;
+   }
+   return NULL;
+}
+
+static int bench_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   const char *str = bench_conf_get(userdata, key);
+   *value          = str ? (float)strtod(str, NULL) : default_value;
+   return str != NULL;
+}
+
+static int bench_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   const char *str = bench_conf_get(userdata, key);
+   *value          = str ? (int)strtol(str, NULL, 0) : default_value;
+   return str != NULL;
+}
+
+static int bench_get_hex(void *userdata, const char *key,
+      unsigned *value, unsigned default_value)
+{
+   const char *str = bench_conf_get(userdata, key);
+   *value          = str ? (unsigned)strtoul(str, NULL, 16) : default_value;
+   return str != NULL;
+}
+
+static unsigned bench_split(const char *str, double *values, unsigned max)
+{
+   unsigned num = 0;
+   char *end;
+
+   while (num < max)
+   {
+      double value = strtod(str, &end);
+      if (end == str)
+         break;
+      values[num++] = value;
+      str           = end;
+   }
+   return num;
+}
+
+static int bench_get_float_array(void *userdata, const char *key,
+      float **values, unsigned *out_num_values,
+      const float *default_values, unsigned num_default_values)
+{
+   unsigned i;
+   double parsed[64];
+   const char *str = bench_conf_get(userdata, key);
+
+   if (!str)
+   {
+      *values = (float*)calloc(num_default_values + 1, sizeof(float));
+      memcpy(*values, default_values, num_default_values * sizeof(float));
+      *out_num_values = num_default_values;
+      return 0;
+   }
+
+   *out_num_values = bench_split(str, parsed, 64);
+   *values         = (float*)calloc(*out_num_values + 1, sizeof(float));
+   for (i = 0; i < *out_num_values; i++)
+      (*values)[i] = (float)parsed[i];
+   return 1;
+}
+
+static int bench_get_int_array(void *userdata, const char *key,
+      int **values, unsigned *out_num_values,
+      const int *default_values, unsigned num_default_values)
+{
+   unsigned i;
+   double parsed[64];
+   const char *str = bench_conf_get(userdata, key);
+
+   if (!str)
+   {
+      *values = (int*)calloc(num_default_values + 1, sizeof(int));
+      memcpy(*values, default_values, num_default_values * sizeof(int));
+      *out_num_values = num_default_values;
+      return 0;
+   }
+
+   *out_num_values = bench_split(str, parsed, 64);
+   *values         = (int*)calloc(*out_num_values + 1, sizeof(int));
+   for (i = 0; i < *out_num_values; i++)
+      (*values)[i] = (int)parsed[i];
+   return 1;
+}
+
+static int bench_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   const char *str = bench_conf_get(userdata, key);
+   const char *ret = str ? str : default_output;
+   *output         = bench_strdup(ret, strlen(ret));
+   return str != NULL;
+}
+
+static const struct softfilter_config bench_config = {
+   bench_get_float,
+   bench_get_int,
+   bench_get_hex,
+   bench_get_float_array,
+   bench_get_int_array,
+   bench_get_string,
+   free,
+};
+
+static void bench_load_plugs(const char *dir)
+{
+   struct dirent *entry;
+   DIR *dirp = opendir(dir);
+   size_t ext_len = strlen(BENCH_DYLIB_EXT);
+
+   if (!dirp)
+      return;
+
+   while ((entry = readdir(dirp)) && bench_num_plugs < BENCH_MAX_PLUGS)
+   {
+      char path[1024];
+      void *lib;
+      size_t len = strlen(entry->d_name);
+
+      if (len <= ext_len
+            || strcmp(entry->d_name + len - ext_len, BENCH_DYLIB_EXT))
+         continue;
+
+      snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+      if (!(lib = dlopen(path, RTLD_NOW | RTLD_LOCAL)))
+         continue;
+      if (!dlsym(lib, "softfilter_get_implementation"))
+      {
+         dlclose(lib);
+         continue;
+      }
+      bench_plugs[bench_num_plugs++] = lib;
+   }
+
+   closedir(dirp);
+}
+
+static const struct softfilter_implementation *bench_find_impl(
+      const char *ident, softfilter_simd_mask_t simd)
+{
+   unsigned i;
+   for (i = 0; i < bench_num_plugs; i++)
+   {
+      const struct softfilter_implementation *impl;
+      softfilter_get_implementation_t get_impl =
+         (softfilter_get_implementation_t)
+         dlsym(bench_plugs[i], "softfilter_get_implementation");
+
+      if ((impl = get_impl(simd)) && !strcmp(impl->short_ident, ident))
+         return impl;
+   }
+   return NULL;
+}
+
+/* Tiles of a 16 colour palette with some single pixel diagonals
+ * on top, so edge detecting filters see both flat areas and edges. */
+static void bench_fill_frame(void *frame, unsigned fmt,
+      unsigned width, unsigned height, size_t pitch)
+{
+   unsigned x, y, i;
+   uint32_t palette[16];
+   uint32_t seed = 0x12345678;
+
+   for (i = 0; i < 16; i++)
+   {
+      seed       = seed * 1103515245 + 12345;
+      palette[i] = (seed >> 8) & 0xffffff;
+   }
+
+   for (y = 0; y < height; y++)
+   {
+      for (x = 0; x < width; x++)
+      {
+         uint32_t tile  = ((x >> 3) * 7 + (y >> 3) * 13) ^ (y >> 4);
+         uint32_t color = palette[tile & 15];
+
+         if ((x + y) % 23 == 0 || (x * 3 + y) % 37 == 0)
+            color = palette[(x ^ y) & 15];
+
+         if (fmt == SOFTFILTER_FMT_XRGB8888)
+            ((uint32_t*)((uint8_t*)frame + y * pitch))[x] = color;
+         else
+            ((uint16_t*)((uint8_t*)frame + y * pitch))[x] = (uint16_t)
+               (((color >> 8) & 0xf800) | ((color >> 5) & 0x07e0)
+                | ((color >> 3) & 0x001f));
+      }
+   }
+}
+
+struct bench_result
+{
+   double mpix;
+   void *output;
+   size_t output_size;
+};
+
+static int bench_run(const char *ident, struct bench_conf *conf,
+      softfilter_simd_mask_t simd, unsigned fmt,
+      unsigned width, unsigned height, unsigned frames,
+      struct bench_result *result)
+{
+   unsigned i, threads, out_width, out_height, out_fmts, out_fmt;
+   size_t in_pitch, out_pitch;
+   double start;
+   void *input, *output, *filt;
+   struct softfilter_work_packet *packets;
+   const struct softfilter_implementation *impl =
+      bench_find_impl(ident, simd);
+
+   if (!impl)
+      return 0;
+
+   /* Output format picked the same way as the frontend does */
+   out_fmts = impl->query_output_formats(fmt);
+   if (out_fmts & fmt)
+      out_fmt = fmt;
+   else if (out_fmts & SOFTFILTER_FMT_XRGB8888)
+      out_fmt = SOFTFILTER_FMT_XRGB8888;
+   else
+      out_fmt = SOFTFILTER_FMT_RGB565;
+
+   conf->prefix[0] = "filter";
+   conf->prefix[1] = impl->short_ident;
+
+   if (!(filt = impl->create(&bench_config, fmt, out_fmt,
+               width, height, 1, simd, conf)))
+      return 0;
+
+   threads = impl->query_num_threads(filt);
+   impl->query_output_size(filt, &out_width, &out_height, width, height);
+
+   in_pitch  = width * 4;
+   out_pitch = out_width * 4;
+   /* Filters may look one line past either end of the frame */
+   input     = calloc(in_pitch, height + 2);
+   output    = calloc(out_pitch, out_height);
+   packets   = (struct softfilter_work_packet*)
+      calloc(threads, sizeof(*packets));
+
+   bench_fill_frame((uint8_t*)input + in_pitch, fmt, width, height, in_pitch);
+
+   start = bench_time();
+   for (i = 0; i < frames; i++)
+   {
+      unsigned j;
+      impl->get_work_packets(filt, packets, output, out_pitch,
+            (uint8_t*)input + in_pitch, width, height, in_pitch);
+      for (j = 0; j < threads; j++)
+         packets[j].work(filt, packets[j].thread_data);
+   }
+   result->mpix        = (double)width * height * frames
+      / (bench_time() - start) / 1e6;
+   result->output      = output;
+   result->output_size = out_pitch * out_height;
+
+   impl->destroy(filt);
+   free(packets);
+   free(input);
+   return 1;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   unsigned width              = 320;
+   unsigned height             = 240;
+   unsigned frames             = 200;
+   const char *dir             = ".";
+   softfilter_simd_mask_t simd = bench_simd_mask();
+   static const unsigned fmts[] = {
+      SOFTFILTER_FMT_RGB565, SOFTFILTER_FMT_XRGB8888 };
+
+   for (i = 1; i < argc && argv[i][0] == '-'; i += 2)
+   {
+      if (i + 1 >= argc)
+         break;
+      if (!strcmp(argv[i], "-w"))
+         width  = (unsigned)strtoul(argv[i + 1], NULL, 0);
+      else if (!strcmp(argv[i], "-h"))
+         height = (unsigned)strtoul(argv[i + 1], NULL, 0);
+      else if (!strcmp(argv[i], "-n"))
+         frames = (unsigned)strtoul(argv[i + 1], NULL, 0);
+      else if (!strcmp(argv[i], "-d"))
+         dir    = argv[i + 1];
+   }
+
+   if (i >= argc || !width || !height || !frames)
+   {
+      fprintf(stderr, "Usage: %s [-w width] [-h height] [-n frames] "
+            "[-d plugin dir] file.filt...\n", argv[0]);
+      return 1;
+   }
+
+   bench_load_plugs(dir);
+   if (!bench_num_plugs)
+   {
+      fprintf(stderr, "No softfilter plugins found in %s.\n", dir);
+      return 1;
+   }
+
+   printf("%ux%u, %u frames, SIMD mask 0x%x\n", width, height, frames, simd);
+   printf("%-44s %-9s %12s %12s %8s\n",
+         "filter", "format", "scalar Mpx/s", "SIMD Mpx/s", "output");
+
+   for (; i < argc; i++)
+   {
+      unsigned j;
+      const char *ident;
+      const char *name = strrchr(argv[i], '/');
+      struct bench_conf conf;
+
+      memset(&conf, 0, sizeof(conf));
+      name = name ? name + 1 : argv[i];
+
+      if (!bench_conf_load(&conf, argv[i]))
+      {
+         printf("%-44s could not be read\n", name);
+         continue;
+      }
+      if (!(ident = bench_conf_find(&conf, "filter"))
+            || !bench_find_impl(ident, simd))
+      {
+         printf("%-44s no plugin found\n", name);
+         bench_conf_free(&conf);
+         continue;
+      }
+
+      for (j = 0; j < sizeof(fmts) / sizeof(fmts[0]); j++)
+      {
+         struct bench_result scalar, vector;
+
+         if (!(bench_find_impl(ident, simd)->query_input_formats() & fmts[j]))
+            continue;
+
+         if (     !bench_run(ident, &conf, 0, fmts[j],
+                     width, height, frames, &scalar))
+            continue;
+         if (     !bench_run(ident, &conf, simd, fmts[j],
+                     width, height, frames, &vector))
+         {
+            free(scalar.output);
+            continue;
+         }
+
+         printf("%-44s %-9s %12.1f %12.1f %8s\n", name,
+               fmts[j] == SOFTFILTER_FMT_RGB565 ? "RGB565" : "XRGB8888",
+               scalar.mpix, vector.mpix,
+               memcmp(scalar.output, vector.output, scalar.output_size)
+               ? "DIFFERS" : "same");
+
+         free(scalar.output);
+         free(vector.output);
+      }
+
+      bench_conf_free(&conf);
+   }
+
+   for (i = 0; i < (int)bench_num_plugs; i++)
+      dlclose(bench_plugs[i]);
+
+   return 0;
+}
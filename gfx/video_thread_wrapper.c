@@ -423,6 +423,18 @@ static void video_thread_loop(void *data)
 
       updated = thr->frame.updated;
 
+      if (updated)
+      {
+         /* Take the newest frame. The main thread can
+          * start on the next one while this one is shown. */
+         unsigned front     = thr->frame.front;
+         thr->frame.front   = thr->frame.ready;
+         thr->frame.ready   = front;
+         thr->frame.updated = false;
+         thr->frame.busy    = true;
+         scond_signal(thr->cond_cmd);
+      }
+
       /* To avoid race condition where send_cmd is updated
        * right after the switch is checked. */
       pkt     = thr->cmd_data;
@@ -438,6 +450,8 @@ static void video_thread_loop(void *data)
          bool               alive = false;
          bool               focus = false;
          bool        has_windowed = false;
+         const struct thread_video_slot
+            *front                = &thr->frame.slots[thr->frame.front];
 
          vp.x                     = 0;
          vp.y                     = 0;
@@ -462,9 +476,10 @@ static void video_thread_loop(void *data)
                video_driver_build_info(&video_info);
 
                ret = thr->driver->frame(thr->driver_data,
-                  thr->frame.buffer, thr->frame.width, thr->frame.height,
-                  thr->frame.count, thr->frame.pitch,
-                  *thr->frame.msg ? thr->frame.msg : NULL,
+                  front->dupe ? NULL : front->buffer,
+                  front->width, front->height,
+                  front->count, front->pitch,
+                  *front->msg ? front->msg : NULL,
                   &video_info);
 
                slock_unlock(thr->frame.lock);
@@ -493,7 +508,7 @@ static void video_thread_loop(void *data)
          thr->focus         = focus;
          thr->has_windowed  = has_windowed;
          thr->vp            = vp;
-         thr->frame.updated = false;
+         thr->frame.busy    = false;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -577,7 +592,8 @@ static bool video_thread_frame(void *data, const void *frame_,
       unsigned width, unsigned height, uint64_t frame_count,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
-   thread_video_t *thr = (thread_video_t*)data;
+   struct thread_video_slot *back = NULL;
+   thread_video_t *thr            = (thread_video_t*)data;
 
    if (!thr)
       return false;
@@ -595,6 +611,37 @@ static bool video_thread_frame(void *data, const void *frame_,
       return false;
    }
 
+   /* The back slot belongs to this thread, so it can be
+    * filled in without holding the lock. */
+   back = &thr->frame.slots[thr->frame.back];
+
+   if (frame_ && frame_ != back->buffer)
+   {
+      int i;
+      const uint8_t *src   = (const uint8_t*)frame_;
+      uint8_t       *dst   = back->buffer;
+      unsigned copy_stride = width *
+         (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+
+      for (i = 0; i < (int)height; i++, src += pitch, dst += copy_stride)
+         memcpy(dst, src, copy_stride);
+
+      pitch = copy_stride;
+   }
+
+   /* A NULL frame, or one the core rendered straight
+    * into the back slot, needs no copy. */
+   back->dupe   = !frame_;
+   back->width  = width;
+   back->height = height;
+   back->count  = frame_count;
+   back->pitch  = pitch;
+
+   if (msg)
+      strlcpy(back->msg, msg, sizeof(back->msg));
+   else
+      *back->msg = '\0';
+
    slock_lock(thr->lock);
 
    if (!thr->nonblock)
@@ -617,32 +664,23 @@ static bool video_thread_frame(void *data, const void *frame_,
       }
    }
 
-   /* Drop frame if updated flag is still set, as thread is
-    * still working on last frame. */
-   if (!thr->frame.updated)
+   /* If the thread hasn't picked up the last frame yet,
+    * replace it, so the newest frame is always shown next.
+    * A duplicate frame doesn't replace a new one. */
+   if (thr->frame.updated && back->dupe)
+      thr->hit_count++;
+   else
    {
-      const uint8_t *src   = (const uint8_t*)frame_;
-      uint8_t       *dst   = thr->frame.buffer;
-      unsigned copy_stride = width *
-         (thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t));
+      unsigned ready     = thr->frame.ready;
 
-      if (src)
-      {
-         int i; /* TODO/FIXME - increment counter never meaningfully used */
-         for (i = 0; i < (int)height; i++, src += pitch, dst += copy_stride)
-            memcpy(dst, src, copy_stride);
-      }
+      if (thr->frame.updated)
+         thr->miss_count++;
+      else
+         thr->hit_count++;
 
+      thr->frame.ready   = thr->frame.back;
+      thr->frame.back    = ready;
       thr->frame.updated = true;
-      thr->frame.width   = width;
-      thr->frame.height  = height;
-      thr->frame.count   = frame_count;
-      thr->frame.pitch   = copy_stride;
-
-      if (msg)
-         strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
-      else
-         *thr->frame.msg = '\0';
 
       scond_signal(thr->cond_thread);
 
@@ -652,13 +690,10 @@ static bool video_thread_frame(void *data, const void *frame_,
          do
          {
             scond_wait(thr->cond_cmd, thr->lock);
-         } while (thr->frame.updated);
+         } while (thr->frame.updated || thr->frame.busy);
       }
 #endif
-      thr->hit_count++;
    }
-   else
-      thr->miss_count++;
 
    slock_unlock(thr->lock);
 
@@ -695,20 +730,29 @@ static bool video_thread_init(thread_video_t *thr,
       return false;
 
    {
+      unsigned i;
       size_t max_size        = info.input_scale * RARCH_SCALE_BASE;
       max_size              *= max_size;
       max_size              *= info.rgb32 ?
          sizeof(uint32_t) : sizeof(uint16_t);
 
+      for (i = 0; i < ARRAY_SIZE(thr->frame.slots); i++)
+      {
 #ifdef _3DS
-      thr->frame.buffer      = linearMemAlign(max_size, 0x80);
+         thr->frame.slots[i].buffer = linearMemAlign(max_size, 0x80);
 #else
-      thr->frame.buffer      = (uint8_t*)malloc(max_size);
+         thr->frame.slots[i].buffer = (uint8_t*)malloc(max_size);
 #endif
-      if (!thr->frame.buffer)
-         return false;
+         if (!thr->frame.slots[i].buffer)
+            return false;
+
+         memset(thr->frame.slots[i].buffer, 0x80, max_size);
+      }
 
-      memset(thr->frame.buffer, 0x80, max_size);
+      thr->frame.size        = max_size;
+      thr->frame.back        = 0;
+      thr->frame.ready       = 1;
+      thr->frame.front       = 2;
    }
 
    thr->input                = input;
@@ -818,6 +862,7 @@ static bool video_thread_read_viewport(void *data,
 
 static void video_thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
 
    if (thr)
@@ -840,11 +885,14 @@ static void video_thread_free(void *data)
       }
 
       free(thr->texture.frame);
+      for (i = 0; i < ARRAY_SIZE(thr->frame.slots); i++)
+      {
 #ifdef _3DS
-      linearFree(thr->frame.buffer);
+         linearFree(thr->frame.slots[i].buffer);
 #else
-      free(thr->frame.buffer);
+         free(thr->frame.slots[i].buffer);
 #endif
+      }
       free(thr->alpha_mod);
 
       slock_free(thr->frame.lock);
@@ -1258,6 +1306,42 @@ static uint32_t thread_get_flags(void *data)
    return 0;
 }
 
+static bool thread_get_current_software_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   unsigned bpp;
+   thread_video_t *thr            = (thread_video_t*)data;
+   video_driver_state_t *video_st = video_state_get_ptr();
+
+   if (!thr)
+      return false;
+
+   /* The core has to render in the format the driver gets,
+    * since nothing converts the frame on the way. */
+   if (video_st->pix_fmt == RETRO_PIXEL_FORMAT_0RGB1555)
+      return false;
+#ifdef HAVE_VIDEO_FILTER
+   if (video_st->state_filter)
+      return false;
+#endif
+
+   bpp = thr->info.rgb32 ? sizeof(uint32_t) : sizeof(uint16_t);
+
+   if ((size_t)framebuffer->width * framebuffer->height * bpp
+         > thr->frame.size)
+      return false;
+
+   /* The back slot stays put until this frame is
+    * handed to the video thread. */
+   framebuffer->data         = thr->frame.slots[thr->frame.back].buffer;
+   framebuffer->pitch        = framebuffer->width * bpp;
+   framebuffer->format       = thr->info.rgb32
+      ? RETRO_PIXEL_FORMAT_XRGB8888 : RETRO_PIXEL_FORMAT_RGB565;
+   framebuffer->memory_flags = RETRO_MEMORY_TYPE_CACHED;
+
+   return true;
+}
+
 static const video_poke_interface_t thread_poke = {
    thread_get_flags,
    thread_load_texture,
@@ -1278,7 +1362,7 @@ static const video_poke_interface_t thread_poke = {
    thread_show_mouse,
    thread_grab_mouse_toggle,
    thread_get_current_shader,
-   NULL, /* get_current_software_framebuffer */
+   thread_get_current_software_framebuffer,
    NULL, /* get_hw_render_interface */
    thread_set_hdr_max_nits,
    thread_set_hdr_paper_white_nits,
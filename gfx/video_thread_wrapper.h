@@ -166,6 +166,17 @@ typedef struct thread_packet
    enum thread_cmd type;
 } thread_packet_t;
 
+struct thread_video_slot
+{
+   uint64_t count;
+   uint8_t *buffer;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   char msg[NAME_MAX_LENGTH];
+   bool dupe; /* Present the previous frame again */
+};
+
 typedef struct thread_video
 {
    retro_time_t last_time;
@@ -218,16 +229,21 @@ typedef struct thread_video
 
    bool alpha_update;
 
+   /* Triple buffered frames. The main thread fills slot 'back'
+    * (or the core renders straight into it, see
+    * GET_CURRENT_SOFTWARE_FRAMEBUFFER), then swaps it with 'ready'
+    * under 'lock'. The video thread swaps 'ready' with 'front'
+    * and presents 'front'. Only indices are swapped, never pixels. */
    struct
    {
-      uint64_t count;
       slock_t *lock;
-      uint8_t *buffer;
-      unsigned width;
-      unsigned height;
-      unsigned pitch;
-      char msg[NAME_MAX_LENGTH];
-      bool updated;
+      struct thread_video_slot slots[3];
+      size_t size;
+      unsigned back;
+      unsigned ready;
+      unsigned front;
+      bool updated; /* 'ready' holds a frame not yet picked up */
+      bool busy;    /* 'front' is being presented */
       bool within_thread;
    } frame;
 
@@ -92,6 +92,7 @@ COMPATIBILITY
 #include "../libretro-common/compat/compat_strldup.c"
 #include "../libretro-common/compat/fopen_utf8.c"
 #include "../libretro-common/memmap/memalign.c"
+#include "../libretro-common/memmap/buffer_pool.c"
 
 /*============================================================
 CONSOLE EXTENSIONS
@@ -243,6 +244,7 @@ CHEATS
 #include "../libretro-common/hash/lrc_hash.c"
 
 #include "../gfx/video_driver.c"
+#include "../gfx/video_dirty.c"
 /*============================================================
 UI COMMON CONTEXT
 ============================================================ */
@@ -1086,6 +1088,7 @@ STATE MANAGER
 ============================================================ */
 #ifdef HAVE_REWIND
 #include "../state_manager.c"
+#include "../state_manager_raw.c"
 #endif
 
 /*============================================================
@@ -1167,6 +1170,7 @@ RETROARCH
 ============================================================ */
 #include "../retroarch.c"
 #include "../runloop.c"
+#include "../frame_trace.c"
 #ifdef HAVE_RUNAHEAD
 #include "../runahead.c"
 #endif
@@ -1220,6 +1224,7 @@ THREAD
 #endif
 
 #include "../libretro-common/rthreads/rthreads.c"
+#include "../libretro-common/rthreads/tpool.c"
 #include "../gfx/video_thread_wrapper.c"
 #include "../audio/audio_thread_wrapper.c"
 #endif
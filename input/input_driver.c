@@ -52,6 +52,7 @@
 #include "../verbosity.h"
 #include "../configuration.h"
 #include "../list_special.h"
+#include "../frame_trace.h"
 #include "../performance_counters.h"
 #ifdef HAVE_BSV_MOVIE
 #include "../tasks/task_content.h"
@@ -5466,6 +5467,7 @@ void input_driver_poll(void)
 #endif
    bool input_remap_binds_enable  = settings->bools.input_remap_binds_enable;
    uint8_t max_users              = (uint8_t)settings->uints.input_max_users;
+   retro_time_t trace_start       = cpu_features_get_time_usec();
 
    if (     joypad && joypad->poll)
       joypad->poll();
@@ -5481,6 +5483,7 @@ void input_driver_poll(void)
    {
       for (i = 0; i < max_users; i++)
          input_st->turbo_btns.frame_enable[i] = 0;
+      frame_trace_add(FRAME_TRACE_INPUT_POLL, trace_start);
       return;
    }
 
@@ -5877,7 +5880,10 @@ void input_driver_poll(void)
             struct remote_message msg;
 
             if (input_st->remote->net_fd[user] < 0)
+            {
+               frame_trace_add(FRAME_TRACE_INPUT_POLL, trace_start);
                return;
+            }
 
             FD_ZERO(&fds);
             FD_SET(input_st->remote->net_fd[user], &fds);
@@ -5925,6 +5931,8 @@ void input_driver_poll(void)
       }
    }
 #endif
+
+   frame_trace_add(FRAME_TRACE_INPUT_POLL, trace_start);
 }
 
 int16_t input_driver_state_wrapper(unsigned port, unsigned device,
@@ -319,6 +319,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_AUDIO_SYNC,
    "audio_sync"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_AUDIO_THREADED_PROCESSING,
+   "audio_threaded_processing"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_AUDIO_VOLUME,
    "audio_volume"
@@ -3349,6 +3353,18 @@ MSG_HASH(
    MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP,
    "rewind_buffer_size_step"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_ASYNC,
+   "rewind_async"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL,
+   "rewind_keyframe_interval"
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_REWIND_COMPRESSION_LEVEL,
+   "rewind_compression_level"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_REWIND_SETTINGS,
    "rewind_settings"
@@ -3655,6 +3671,10 @@ MSG_HASH(
    MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE,
    "run_ahead_secondary_instance"
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_RUN_AHEAD_SPECULATIVE_INSTANCES,
+   "run_ahead_speculative_instances"
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS,
    "run_ahead_hide_warnings"
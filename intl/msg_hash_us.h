@@ -3059,6 +3059,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_AUDIO_SYNC,
    "Synchronize audio. Recommended."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_AUDIO_THREADED_PROCESSING,
+   "Threaded Audio Processing"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_AUDIO_THREADED_PROCESSING,
+   "Resample, filter and output audio on a separate thread. Can reduce stuttering when the audio driver blocks, at the cost of a little extra latency."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_AUDIO_MAX_TIMING_SKEW,
    "Maximum Timing Skew"
@@ -4332,6 +4340,14 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_RUN_AHEAD_SECONDARY_INSTANCE,
    "Use a second instance of the RetroArch core to run-ahead. Prevents audio problems due to loading state."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_RUN_AHEAD_SPECULATIVE_INSTANCES,
+   "Speculative Run-Ahead Instances"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_RUN_AHEAD_SPECULATIVE_INSTANCES,
+   "Extra core instances that run ahead on other CPU cores, each guessing a different next input. When a guess is right, the frames don't have to be emulated again after an input change. Requires the second instance and a software rendered core."
+   )
 MSG_HASH(
    MENU_ENUM_LABEL_VALUE_RUN_AHEAD_HIDE_WARNINGS,
    "Hide Run-Ahead Warnings"
@@ -4971,6 +4987,30 @@ MSG_HASH(
    MENU_ENUM_SUBLABEL_REWIND_BUFFER_SIZE_STEP,
    "Each time the rewind buffer size value is increased or decreased, it will change by this amount."
    )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_ASYNC,
+   "Threaded Rewind Compression"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_REWIND_ASYNC,
+   "Compress rewind states on a separate thread while the core runs the next frame. Reduces frame time spikes with large save states."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_KEYFRAME_INTERVAL,
+   "Rewind Keyframe Interval"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_REWIND_KEYFRAME_INTERVAL,
+   "Store a full save state every this many rewind steps, so jumping far back does not need to replay every step in between. Uses more of the rewind buffer. 0 disables keyframes."
+   )
+MSG_HASH(
+   MENU_ENUM_LABEL_VALUE_REWIND_COMPRESSION_LEVEL,
+   "Rewind Compression Level"
+   )
+MSG_HASH(
+   MENU_ENUM_SUBLABEL_REWIND_COMPRESSION_LEVEL,
+   "Compress rewind states further before storing them, fitting more rewind history in the same buffer at some CPU cost. Higher levels compress better but are slower. 0 disables."
+   )
 
 /* Settings > Frame Throttle > Frame Time Counter */
 
@@ -21,6 +21,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <retro_miscellaneous.h>
 
@@ -33,9 +34,16 @@
 #include <lists/string_list.h>
 #include <string/stdstring.h>
 #include <libretro_dspfilter.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include <audio/dsp_filter.h>
 
+/* Seconds in a row a chain may go over its budget
+ * before it's reported, so a hiccup doesn't count */
+#define DSP_BUDGET_WINDOWS 3
+
 struct retro_dsp_plug
 {
 #ifdef HAVE_DYLIB
@@ -48,6 +56,11 @@ struct retro_dsp_instance
 {
    const struct dspfilter_implementation *impl;
    void *impl_data;
+
+   /* Time spent in process() so far this window */
+   retro_time_t time_usec;
+   /* Share of real time, over the last window */
+   float load;
 };
 
 struct retro_dsp_filter
@@ -59,6 +72,36 @@ struct retro_dsp_filter
 
    struct retro_dsp_instance *instances;
    unsigned num_instances;
+
+   float sample_rate;
+   /* Share of real time the chain may take, 0 when unchecked */
+   float budget;
+   /* Frames processed this window, a window is a second of audio */
+   unsigned window_frames;
+   /* Windows in a row over budget */
+   unsigned over_windows;
+   /* Instances from here on run on the worker thread,
+    * all of them run here when not pipelined */
+   unsigned split;
+
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+
+   /* [0] is the chunk waiting on the tail of the chain,
+    * [1] takes the next one */
+   float *pipe_buf[2];
+   size_t pipe_buf_frames[2];
+   unsigned pipe_frames;
+   /* Instances the waiting chunk has been through */
+   unsigned pipe_split;
+   /* Set by the worker */
+   struct dspfilter_output pipe_out;
+   bool pipe_primed;
+   bool pipe_busy;
+   bool pipe_quit;
+#endif
 };
 
 static const struct dspfilter_implementation *find_implementation(
@@ -232,6 +275,253 @@ static bool append_plugs(retro_dsp_filter_t *dsp, struct string_list *list)
 }
 #endif
 
+/* Runs instances @first up to @last over @output, timing each */
+static void retro_dsp_filter_run(retro_dsp_filter_t *dsp,
+      unsigned first, unsigned last, struct dspfilter_output *output)
+{
+   unsigned i;
+   struct dspfilter_input input = {0};
+
+   for (i = first; i < last; i++)
+   {
+      retro_time_t start = cpu_features_get_time_usec();
+
+      input.samples = output->samples;
+      input.frames  = output->frames;
+      dsp->instances[i].impl->process(
+            dsp->instances[i].impl_data, output, &input);
+
+      dsp->instances[i].time_usec += cpu_features_get_time_usec() - start;
+   }
+}
+
+/* Turns the times of a window into loads, checks them against
+ * the budget, and moves the pipeline split to balance both ends */
+static void retro_dsp_filter_update_stats(retro_dsp_filter_t *dsp,
+      unsigned frames)
+{
+   unsigned i;
+   double window_usec;
+   float head      = 0.0f;
+   float tail      = 0.0f;
+   float critical  = 0.0f;
+
+   dsp->window_frames += frames;
+   if (dsp->window_frames < dsp->sample_rate)
+      return;
+
+   window_usec = dsp->window_frames * 1000000.0 / dsp->sample_rate;
+
+   for (i = 0; i < dsp->num_instances; i++)
+   {
+      struct retro_dsp_instance *inst = &dsp->instances[i];
+
+      inst->load      = (float)(inst->time_usec / window_usec);
+      inst->time_usec = 0;
+
+      if (i < dsp->split)
+         head        += inst->load;
+      else
+         tail        += inst->load;
+   }
+
+   dsp->window_frames = 0;
+
+   /* Both ends of a pipeline run at once */
+   critical           = MAX(head, tail);
+   if (dsp->budget > 0.0f && critical > dsp->budget)
+      dsp->over_windows++;
+   else
+      dsp->over_windows = 0;
+
+#ifdef HAVE_THREADS
+   if (dsp->thread)
+   {
+      unsigned best_split = dsp->split;
+      float best          = critical;
+      float total         = head + tail;
+
+      head                = 0.0f;
+      for (i = 1; i < dsp->num_instances; i++)
+      {
+         head += dsp->instances[i - 1].load;
+         if (MAX(head, total - head) < best)
+         {
+            best       = MAX(head, total - head);
+            best_split = i;
+         }
+      }
+
+      dsp->split = best_split;
+   }
+#endif
+}
+
+#ifdef HAVE_THREADS
+static void retro_dsp_filter_pipeline_thread(void *data)
+{
+   retro_dsp_filter_t *dsp = (retro_dsp_filter_t*)data;
+
+   slock_lock(dsp->lock);
+
+   for (;;)
+   {
+      while (!dsp->pipe_busy && !dsp->pipe_quit)
+         scond_wait(dsp->cond, dsp->lock);
+
+      if (dsp->pipe_quit)
+         break;
+
+      slock_unlock(dsp->lock);
+
+      dsp->pipe_out.samples = dsp->pipe_buf[0];
+      dsp->pipe_out.frames  = dsp->pipe_frames;
+      if (dsp->pipe_frames)
+         retro_dsp_filter_run(dsp, dsp->pipe_split,
+               dsp->num_instances, &dsp->pipe_out);
+
+      slock_lock(dsp->lock);
+      dsp->pipe_busy = false;
+      scond_signal(dsp->cond);
+   }
+
+   slock_unlock(dsp->lock);
+}
+
+static bool retro_dsp_filter_pipe_reserve(retro_dsp_filter_t *dsp,
+      unsigned idx, unsigned frames)
+{
+   float *buf;
+
+   if (frames <= dsp->pipe_buf_frames[idx])
+      return true;
+
+   if (!(buf = (float*)realloc(dsp->pipe_buf[idx],
+               frames * 2 * sizeof(float))))
+      return false;
+
+   dsp->pipe_buf[idx]        = buf;
+   dsp->pipe_buf_frames[idx] = frames;
+   return true;
+}
+
+static void retro_dsp_filter_pipeline_deinit(retro_dsp_filter_t *dsp)
+{
+   if (dsp->thread)
+   {
+      slock_lock(dsp->lock);
+      dsp->pipe_quit = true;
+      scond_signal(dsp->cond);
+      slock_unlock(dsp->lock);
+
+      sthread_join(dsp->thread);
+   }
+
+   if (dsp->lock)
+      slock_free(dsp->lock);
+   if (dsp->cond)
+      scond_free(dsp->cond);
+   free(dsp->pipe_buf[0]);
+   free(dsp->pipe_buf[1]);
+
+   dsp->thread      = NULL;
+   dsp->lock        = NULL;
+   dsp->cond        = NULL;
+   dsp->pipe_buf[0] = NULL;
+   dsp->pipe_buf[1] = NULL;
+   dsp->split       = dsp->num_instances;
+}
+
+/* Splits the chain in two, the tail running on a worker
+ * thread one chunk behind. Stays in series on failure. */
+static void retro_dsp_filter_pipeline_init(retro_dsp_filter_t *dsp)
+{
+   dsp->split       = dsp->num_instances / 2;
+   dsp->pipe_split  = dsp->split;
+   dsp->pipe_frames = 0;
+   dsp->pipe_primed = false;
+   dsp->pipe_busy   = false;
+   dsp->pipe_quit   = false;
+   dsp->lock        = slock_new();
+   dsp->cond        = scond_new();
+
+   if (     !dsp->lock
+         || !dsp->cond
+         || !(dsp->thread = sthread_create(
+               retro_dsp_filter_pipeline_thread, dsp)))
+      retro_dsp_filter_pipeline_deinit(dsp);
+}
+
+static void retro_dsp_filter_process_pipelined(retro_dsp_filter_t *dsp,
+      struct retro_dsp_data *data)
+{
+   float *buf;
+   size_t buf_frames;
+   struct dspfilter_output head = {0};
+   unsigned split               = dsp->split;
+   unsigned concurrent          = MIN(split, dsp->pipe_split);
+
+   /* Start out a chunk of silence behind, with nothing for
+    * the worker to do yet */
+   if (!dsp->pipe_primed)
+   {
+      dsp->pipe_out.samples = NULL;
+      dsp->pipe_out.frames  = 0;
+      if (retro_dsp_filter_pipe_reserve(dsp, 0, data->input_frames))
+      {
+         memset(dsp->pipe_buf[0], 0,
+               data->input_frames * 2 * sizeof(float));
+         dsp->pipe_out.samples = dsp->pipe_buf[0];
+         dsp->pipe_out.frames  = data->input_frames;
+      }
+      dsp->pipe_primed      = true;
+      concurrent            = split;
+   }
+   else
+   {
+      slock_lock(dsp->lock);
+      dsp->pipe_busy = true;
+      scond_signal(dsp->cond);
+      slock_unlock(dsp->lock);
+   }
+
+   head.samples = data->input;
+   head.frames  = data->input_frames;
+   retro_dsp_filter_run(dsp, 0, concurrent, &head);
+
+   slock_lock(dsp->lock);
+   while (dsp->pipe_busy)
+      scond_wait(dsp->cond, dsp->lock);
+   slock_unlock(dsp->lock);
+
+   /* Instances that just moved off the worker have to
+    * finish the previous chunk before they take this one */
+   retro_dsp_filter_run(dsp, concurrent, split, &head);
+
+   data->output        = dsp->pipe_out.samples;
+   data->output_frames = dsp->pipe_out.frames;
+
+   /* The head's output may be an instance's own buffer,
+    * copy it out before that instance runs again */
+   if (retro_dsp_filter_pipe_reserve(dsp, 1, head.frames))
+   {
+      memcpy(dsp->pipe_buf[1], head.samples,
+            head.frames * 2 * sizeof(float));
+      dsp->pipe_frames = head.frames;
+   }
+   else
+      dsp->pipe_frames = 0;
+
+   buf                     = dsp->pipe_buf[0];
+   buf_frames              = dsp->pipe_buf_frames[0];
+   dsp->pipe_buf[0]        = dsp->pipe_buf[1];
+   dsp->pipe_buf_frames[0] = dsp->pipe_buf_frames[1];
+   dsp->pipe_buf[1]        = buf;
+   dsp->pipe_buf_frames[1] = buf_frames;
+   dsp->pipe_split         = split;
+}
+#endif
+
 retro_dsp_filter_t *retro_dsp_filter_new(
       const char *filter_config,
       void *string_data,
@@ -264,6 +554,21 @@ retro_dsp_filter_t *retro_dsp_filter_new(
    if (!create_filter_graph(dsp, sample_rate))
       goto error;
 
+   dsp->sample_rate = sample_rate;
+   dsp->budget      = 0.0f;
+   dsp->split       = dsp->num_instances;
+   config_get_float(conf, "budget", &dsp->budget);
+
+#ifdef HAVE_THREADS
+   {
+      bool pipelined = false;
+      if (     config_get_bool(conf, "pipelined", &pipelined)
+            && pipelined
+            && dsp->num_instances > 1)
+         retro_dsp_filter_pipeline_init(dsp);
+   }
+#endif
+
    return dsp;
 
 error:
@@ -279,6 +584,10 @@ void retro_dsp_filter_free(retro_dsp_filter_t *dsp)
    if (!dsp)
       return;
 
+#ifdef HAVE_THREADS
+   retro_dsp_filter_pipeline_deinit(dsp);
+#endif
+
    for (i = 0; i < dsp->num_instances; i++)
    {
       if (dsp->instances[i].impl_data && dsp->instances[i].impl)
@@ -304,21 +613,44 @@ void retro_dsp_filter_free(retro_dsp_filter_t *dsp)
 void retro_dsp_filter_process(retro_dsp_filter_t *dsp,
       struct retro_dsp_data *data)
 {
-   unsigned i;
    struct dspfilter_output output = {0};
-   struct dspfilter_input input   = {0};
+
+#ifdef HAVE_THREADS
+   if (dsp->thread)
+   {
+      retro_dsp_filter_process_pipelined(dsp, data);
+      retro_dsp_filter_update_stats(dsp, data->input_frames);
+      return;
+   }
+#endif
 
    output.samples = data->input;
    output.frames  = data->input_frames;
 
-   for (i = 0; i < dsp->num_instances; i++)
-   {
-      input.samples = output.samples;
-      input.frames  = output.frames;
-      dsp->instances[i].impl->process(
-            dsp->instances[i].impl_data, &output, &input);
-   }
+   retro_dsp_filter_run(dsp, 0, dsp->num_instances, &output);
 
    data->output        = output.samples;
    data->output_frames = output.frames;
+
+   retro_dsp_filter_update_stats(dsp, data->input_frames);
+}
+
+unsigned retro_dsp_filter_get_stats(retro_dsp_filter_t *dsp,
+      struct retro_dsp_stage_stats *stats, unsigned max_stats)
+{
+   unsigned i;
+
+   for (i = 0; i < dsp->num_instances && i < max_stats; i++)
+   {
+      stats[i].ident    = dsp->instances[i].impl->short_ident;
+      stats[i].load     = dsp->instances[i].load;
+      stats[i].threaded = i >= dsp->split;
+   }
+
+   return dsp->num_instances;
+}
+
+bool retro_dsp_filter_over_budget(retro_dsp_filter_t *dsp)
+{
+   return dsp->budget > 0.0f && dsp->over_windows >= DSP_BUDGET_WINDOWS;
 }
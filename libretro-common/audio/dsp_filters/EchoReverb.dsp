@@ -2,6 +2,15 @@ filters = 2
 filter0 = echo
 filter1 = reverb
 
+# Runs the end of the chain on another thread, a chunk behind,
+# for chains too heavy for one core.
+# pipelined = true
+
+# Share of real time the chain may take. If set, the chain is
+# disabled when it goes over for a few seconds, rather than
+# starve the driver. Unchecked by default.
+# budget = 0.5
+
 echo_delay = "200"
 echo_feedback = "0.6"
 echo_amp = "0.25"
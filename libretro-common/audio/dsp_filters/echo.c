@@ -21,10 +21,17 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <retro_miscellaneous.h>
 #include <libretro_dspfilter.h>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
 struct echo_channel
 {
    float *buffer;
@@ -51,11 +58,66 @@ static void echo_free(void *data)
    free(echo);
 }
 
+/* Frames per pass, the echo of a block is summed on the stack */
+#define ECHO_BLOCK 256
+
+/* @dst += @src */
+static void echo_add(float *dst, const float *src, unsigned samples)
+{
+   unsigned i = 0;
+#if defined(__SSE__)
+   for (; i + 4 <= samples; i += 4)
+      _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i),
+               _mm_loadu_ps(src + i)));
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+   for (; i + 4 <= samples; i += 4)
+      vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+#endif
+   for (; i < samples; i++)
+      dst[i] += src[i];
+}
+
+/* @dst *= @scale */
+static void echo_scale(float *dst, float scale, unsigned samples)
+{
+   unsigned i = 0;
+#if defined(__SSE__)
+   __m128 vscale = _mm_set1_ps(scale);
+   for (; i + 4 <= samples; i += 4)
+      _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(dst + i), vscale));
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+   for (; i + 4 <= samples; i += 4)
+      vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(dst + i), scale));
+#endif
+   for (; i < samples; i++)
+      dst[i] *= scale;
+}
+
+/* @dst = @a + @b * @scale */
+static void echo_madd(float *dst, const float *a, const float *b,
+      float scale, unsigned samples)
+{
+   unsigned i = 0;
+#if defined(__SSE__)
+   __m128 vscale = _mm_set1_ps(scale);
+   for (; i + 4 <= samples; i += 4)
+      _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(a + i),
+               _mm_mul_ps(_mm_loadu_ps(b + i), vscale)));
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+   for (; i + 4 <= samples; i += 4)
+      vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(a + i),
+               vld1q_f32(b + i), scale));
+#endif
+   for (; i < samples; i++)
+      dst[i] = a[i] + b[i] * scale;
+}
+
 static void echo_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
-   unsigned i, c;
+   unsigned c;
    float *out             = NULL;
+   unsigned frames        = input->frames;
    struct echo_data *echo = (struct echo_data*)data;
 
    output->samples        = input->samples;
@@ -63,37 +125,40 @@ static void echo_process(void *data, struct dspfilter_output *output,
 
    out                    = output->samples;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   /* A delay line is read and rewritten at the same spot, so
+    * until one wraps no frame depends on another and each step
+    * can run over the whole block. */
+   while (frames)
    {
-      float left, right;
-      float echo_left  = 0.0f;
-      float echo_right = 0.0f;
+      float echo_buf[ECHO_BLOCK * 2];
+      unsigned run = MIN(frames, ECHO_BLOCK);
 
       for (c = 0; c < echo->num_channels; c++)
-      {
-         echo_left  += echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 0];
-         echo_right += echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 1];
-      }
+         run = MIN(run, echo->channels[c].frames - echo->channels[c].ptr);
 
-      echo_left     *= echo->amp;
-      echo_right    *= echo->amp;
+      memset(echo_buf, 0, run * 2 * sizeof(float));
+      for (c = 0; c < echo->num_channels; c++)
+         echo_add(echo_buf, echo->channels[c].buffer
+               + (echo->channels[c].ptr << 1), run * 2);
 
-      left           = out[0] + echo_left;
-      right          = out[1] + echo_right;
+      echo_scale(echo_buf, echo->amp, run * 2);
 
       for (c = 0; c < echo->num_channels; c++)
       {
-         float feedback_left  = out[0] + echo->channels[c].feedback * echo_left;
-         float feedback_right = out[1] + echo->channels[c].feedback * echo_right;
+         struct echo_channel *ch = &echo->channels[c];
 
-         echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 0] = feedback_left;
-         echo->channels[c].buffer[(echo->channels[c].ptr << 1) + 1] = feedback_right;
+         echo_madd(ch->buffer + (ch->ptr << 1), out, echo_buf,
+               ch->feedback, run * 2);
 
-         echo->channels[c].ptr = (echo->channels[c].ptr + 1) % echo->channels[c].frames;
+         ch->ptr += run;
+         if (ch->ptr >= ch->frames)
+            ch->ptr = 0;
       }
 
-      out[0] = left;
-      out[1] = right;
+      echo_add(out, echo_buf, run * 2);
+
+      out    += run * 2;
+      frames -= run;
    }
 }
 
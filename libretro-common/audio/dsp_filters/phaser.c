@@ -27,6 +27,12 @@
 #include <retro_miscellaneous.h>
 #include <libretro_dspfilter.h>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
 #define PHASER_LFO_SHAPE 4.0
 #define PHASER_LFO_SKIP_SAMPLES 20
 
@@ -37,7 +43,8 @@ struct phaser_data
    float fb;
    float depth;
    float drywet;
-   float old[2][24];
+   /* Per stage, left then right */
+   float old[24][2];
    float gain;
    float fbout[2];
    float lfoskip;
@@ -52,39 +59,79 @@ static void phaser_free(void *data)
    free(data);
 }
 
-static void phaser_process(void *data, struct dspfilter_output *output,
-      const struct dspfilter_input *input)
+/* Runs @frames frames at the current gain */
+static void phaser_run(struct phaser_data *ph, float *out, unsigned frames)
 {
-   unsigned i, c;
+   unsigned i;
    int s;
-   float m[2], tmp[2];
-   struct phaser_data *ph = (struct phaser_data*)data;
-   float *out             = output->samples;
+#if defined(__SSE__)
+   /* Left and right in the two low lanes */
+   __m128 gain   = _mm_set1_ps(ph->gain);
+   __m128 fb     = _mm_set1_ps(ph->fb);
+   __m128 scale  = _mm_set1_ps(0.01f);
+   __m128 wet    = _mm_set1_ps(ph->drywet);
+   __m128 dry    = _mm_set1_ps(1.0f - ph->drywet);
+   __m128 fbout  = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)ph->fbout);
+
+   for (i = 0; i < frames; i++, out += 2)
+   {
+      __m128 in = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)out);
+      __m128 m  = _mm_add_ps(in, _mm_mul_ps(_mm_mul_ps(fbout, fb), scale));
 
-   output->samples        = input->samples;
-   output->frames         = input->frames;
+      for (s = 0; s < ph->stages; s++)
+      {
+         __m128 tmp = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)ph->old[s]);
+         __m128 cur = _mm_add_ps(_mm_mul_ps(gain, tmp), m);
+         _mm_storel_pi((__m64*)ph->old[s], cur);
+         m          = _mm_sub_ps(tmp, _mm_mul_ps(gain, cur));
+      }
 
-   for (i = 0; i < input->frames; i++, out += 2)
+      fbout = m;
+      _mm_storel_pi((__m64*)out, _mm_add_ps(_mm_mul_ps(m, wet),
+               _mm_mul_ps(in, dry)));
+   }
+
+   _mm_storel_pi((__m64*)ph->fbout, fbout);
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+   float32x2_t fbout = vld1_f32(ph->fbout);
+
+   for (i = 0; i < frames; i++, out += 2)
+   {
+      float32x2_t in = vld1_f32(out);
+      float32x2_t m  = vadd_f32(in,
+            vmul_n_f32(vmul_n_f32(fbout, ph->fb), 0.01f));
+
+      for (s = 0; s < ph->stages; s++)
+      {
+         float32x2_t tmp = vld1_f32(ph->old[s]);
+         float32x2_t cur = vmla_n_f32(m, tmp, ph->gain);
+         vst1_f32(ph->old[s], cur);
+         m               = vmls_n_f32(tmp, cur, ph->gain);
+      }
+
+      fbout = m;
+      vst1_f32(out, vmla_n_f32(vmul_n_f32(m, ph->drywet),
+               in, 1.0f - ph->drywet));
+   }
+
+   vst1_f32(ph->fbout, fbout);
+#else
+   for (i = 0; i < frames; i++, out += 2)
    {
+      unsigned c;
+      float m[2], tmp[2];
       float in[2] = { out[0], out[1] };
 
       for (c = 0; c < 2; c++)
          m[c] = in[c] + ph->fbout[c] * ph->fb * 0.01f;
 
-      if ((ph->skipcount++ % PHASER_LFO_SKIP_SAMPLES) == 0)
-      {
-         ph->gain = 0.5 * (1.0 + cos(ph->skipcount * ph->lfoskip + ph->phase));
-         ph->gain = (exp(ph->gain * PHASER_LFO_SHAPE) - 1.0) / (exp(PHASER_LFO_SHAPE) - 1);
-         ph->gain = 1.0 - ph->gain * ph->depth;
-      }
-
       for (s = 0; s < ph->stages; s++)
       {
          for (c = 0; c < 2; c++)
          {
-            tmp[c] = ph->old[c][s];
-            ph->old[c][s] = ph->gain * tmp[c] + m[c];
-            m[c] = tmp[c] - ph->gain * ph->old[c][s];
+            tmp[c] = ph->old[s][c];
+            ph->old[s][c] = ph->gain * tmp[c] + m[c];
+            m[c] = tmp[c] - ph->gain * ph->old[s][c];
          }
       }
 
@@ -94,6 +141,42 @@ static void phaser_process(void *data, struct dspfilter_output *output,
          out[c] = m[c] * ph->drywet + in[c] * (1.0f - ph->drywet);
       }
    }
+#endif
+}
+
+static void phaser_process(void *data, struct dspfilter_output *output,
+      const struct dspfilter_input *input)
+{
+   struct phaser_data *ph = (struct phaser_data*)data;
+   float *out             = output->samples;
+   unsigned frames        = input->frames;
+
+   output->samples        = input->samples;
+   output->frames         = input->frames;
+
+   /* The gain only changes every PHASER_LFO_SKIP_SAMPLES frames,
+    * run the stages in between without looking at the LFO */
+   while (frames)
+   {
+      unsigned run;
+
+      if ((ph->skipcount % PHASER_LFO_SKIP_SAMPLES) == 0)
+      {
+         ph->gain = 0.5 * (1.0 + cos((ph->skipcount + 1) * ph->lfoskip + ph->phase));
+         ph->gain = (exp(ph->gain * PHASER_LFO_SHAPE) - 1.0) / (exp(PHASER_LFO_SHAPE) - 1);
+         ph->gain = 1.0 - ph->gain * ph->depth;
+      }
+
+      run             = PHASER_LFO_SKIP_SAMPLES
+         - (unsigned)(ph->skipcount % PHASER_LFO_SKIP_SAMPLES);
+      run             = MIN(run, frames);
+
+      phaser_run(ph, out, run);
+
+      ph->skipcount  += run;
+      out            += run * 2;
+      frames         -= run;
+   }
 }
 
 static void *phaser_init(const struct dspfilter_info *info,
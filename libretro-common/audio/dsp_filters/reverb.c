@@ -24,54 +24,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <boolean.h>
 #include <retro_inline.h>
 #include <libretro_dspfilter.h>
 
-struct comb
-{
-   float *buffer;
-   unsigned bufsize;
-   unsigned bufidx;
-
-   float feedback;
-   float filterstore;
-   float damp1, damp2;
-};
-
-struct allpass
-{
-   float *buffer;
-   float feedback;
-   unsigned bufsize;
-   unsigned bufidx;
-};
-
-static INLINE float comb_process(struct comb *c, float input)
-{
-   float output         = c->buffer[c->bufidx];
-   c->filterstore       = (output * c->damp2) + (c->filterstore * c->damp1);
-
-   c->buffer[c->bufidx] = input + (c->filterstore * c->feedback);
-
-   c->bufidx++;
-   if (c->bufidx >= c->bufsize)
-      c->bufidx = 0;
-
-   return output;
-}
-
-static INLINE float allpass_process(struct allpass *a, float input)
-{
-   float bufout         = a->buffer[a->bufidx];
-   float output         = -input + bufout;
-   a->buffer[a->bufidx] = input + bufout * a->feedback;
-
-   a->bufidx++;
-   if (a->bufidx >= a->bufsize)
-      a->bufidx = 0;
-
-   return output;
-}
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
 
 #define numcombs 8
 #define numallpasses 4
@@ -89,43 +50,239 @@ static const float initialdry = 0;
 static const float initialwidth = 1;
 static const float initialmode = 0;
 static const float freezemode = 0.5f;
+static const float allpassfeedback = 0.5f;
+
+/* Both channels use the same lengths and settings, so each delay
+ * line holds the left and right samples interleaved, and a stereo
+ * frame of every comb and allpass is one 64-bit load. */
+struct revline
+{
+   float *buffer;
+   unsigned bufsize;
+   unsigned bufidx;
+};
 
 struct revmodel
 {
-   struct comb combL[numcombs];
-   struct allpass allpassL[numallpasses];
+   struct revline comb[numcombs];
+   struct revline allpass[numallpasses];
 
-   float *bufcomb[numcombs];
-   float *bufallpass[numallpasses];
+   /* Left and right of comb 0, then comb 1, ... */
+   float filterstore[numcombs * 2];
 
    float gain;
    float roomsize, roomsize1;
-   float damp, damp1;
+   float damp, damp1, damp2;
    float wet, wet1, wet2;
    float dry;
    float width;
    float mode;
 };
 
-static float revmodel_process(struct revmodel *rev, float in)
+/* Runs @frames frames, none of which wrap a delay line.
+ * @comb and @allpass point at the current frame of each line. */
+static void revmodel_process_block(struct revmodel *rev, float *samples,
+      unsigned frames, float **comb, float **allpass)
 {
-   int i;
-   float mono_out = 0.0f;
-   float mono_in  = in;
-   float input    = mono_in * rev->gain;
+   unsigned i;
+   int c;
+   float gain     = rev->gain;
+   float feedback = rev->roomsize1;
+   float damp1    = rev->damp1;
+   float damp2    = rev->damp2;
+   float dry      = rev->dry;
+   float wet1     = rev->wet1;
+#if defined(__SSE__)
+   __m128 fs[numcombs / 2];
+   __m128 vgain     = _mm_set1_ps(gain);
+   __m128 vfeedback = _mm_set1_ps(feedback);
+   __m128 vdamp1    = _mm_set1_ps(damp1);
+   __m128 vdamp2    = _mm_set1_ps(damp2);
+   __m128 vdry      = _mm_set1_ps(dry);
+   __m128 vwet1     = _mm_set1_ps(wet1);
+   __m128 vapfb     = _mm_set1_ps(allpassfeedback);
+
+   /* Lanes are left and right of comb 2k, then of comb 2k + 1 */
+   for (c = 0; c < numcombs / 2; c++)
+      fs[c] = _mm_loadu_ps(rev->filterstore + c * 4);
+
+   for (i = 0; i < frames; i++, samples += 2)
+   {
+      unsigned idx = i * 2;
+      __m128 dry_in = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)samples);
+      __m128 in     = _mm_mul_ps(_mm_movelh_ps(dry_in, dry_in), vgain);
+      __m128 sum    = _mm_setzero_ps();
+
+      for (c = 0; c < numcombs / 2; c++)
+      {
+         float *lo  = comb[c * 2 + 0] + idx;
+         float *hi  = comb[c * 2 + 1] + idx;
+         __m128 out = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(),
+                  (const __m64*)lo), (const __m64*)hi);
+         fs[c]      = _mm_add_ps(_mm_mul_ps(out, vdamp2),
+               _mm_mul_ps(fs[c], vdamp1));
+         sum        = _mm_add_ps(sum, out);
+         out        = _mm_add_ps(in, _mm_mul_ps(fs[c], vfeedback));
+         _mm_storel_pi((__m64*)lo, out);
+         _mm_storeh_pi((__m64*)hi, out);
+      }
+
+      sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+
+      for (c = 0; c < numallpasses; c++)
+      {
+         float *ap     = allpass[c] + idx;
+         __m128 bufout = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)ap);
+         _mm_storel_pi((__m64*)ap,
+               _mm_add_ps(sum, _mm_mul_ps(bufout, vapfb)));
+         sum           = _mm_sub_ps(bufout, sum);
+      }
+
+      _mm_storel_pi((__m64*)samples, _mm_add_ps(
+               _mm_mul_ps(dry_in, vdry), _mm_mul_ps(sum, vwet1)));
+   }
 
-   for (i = 0; i < numcombs; i++)
-      mono_out += comb_process(&rev->combL[i], input);
+   for (c = 0; c < numcombs / 2; c++)
+      _mm_storeu_ps(rev->filterstore + c * 4, fs[c]);
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+   float32x4_t fs[numcombs / 2];
 
-   for (i = 0; i < numallpasses; i++)
-      mono_out = allpass_process(&rev->allpassL[i], mono_out);
+   for (c = 0; c < numcombs / 2; c++)
+      fs[c] = vld1q_f32(rev->filterstore + c * 4);
+
+   for (i = 0; i < frames; i++, samples += 2)
+   {
+      unsigned idx       = i * 2;
+      float32x2_t dry_in = vld1_f32(samples);
+      float32x2_t gained = vmul_n_f32(dry_in, gain);
+      float32x4_t in     = vcombine_f32(gained, gained);
+      float32x4_t sum4   = vdupq_n_f32(0.0f);
+      float32x2_t sum;
+
+      for (c = 0; c < numcombs / 2; c++)
+      {
+         float *lo       = comb[c * 2 + 0] + idx;
+         float *hi       = comb[c * 2 + 1] + idx;
+         float32x4_t out = vcombine_f32(vld1_f32(lo), vld1_f32(hi));
+         fs[c]           = vmlaq_n_f32(vmulq_n_f32(fs[c], damp1),
+               out, damp2);
+         sum4            = vaddq_f32(sum4, out);
+         out             = vmlaq_n_f32(in, fs[c], feedback);
+         vst1_f32(lo, vget_low_f32(out));
+         vst1_f32(hi, vget_high_f32(out));
+      }
+
+      sum = vadd_f32(vget_low_f32(sum4), vget_high_f32(sum4));
+
+      for (c = 0; c < numallpasses; c++)
+      {
+         float *ap          = allpass[c] + idx;
+         float32x2_t bufout = vld1_f32(ap);
+         vst1_f32(ap, vmla_n_f32(sum, bufout, allpassfeedback));
+         sum                = vsub_f32(bufout, sum);
+      }
+
+      vst1_f32(samples, vmla_n_f32(vmul_n_f32(dry_in, dry), sum, wet1));
+   }
+
+   for (c = 0; c < numcombs / 2; c++)
+      vst1q_f32(rev->filterstore + c * 4, fs[c]);
+#else
+   for (i = 0; i < frames; i++, samples += 2)
+   {
+      unsigned idx = i * 2;
+      float in_l   = samples[0];
+      float in_r   = samples[1];
+      float gain_l = in_l * gain;
+      float gain_r = in_r * gain;
+      float out_l  = 0.0f;
+      float out_r  = 0.0f;
+
+      for (c = 0; c < numcombs; c++)
+      {
+         float *buf  = comb[c] + idx;
+         float *fs   = rev->filterstore + c * 2;
+         float buf_l = buf[0];
+         float buf_r = buf[1];
+
+         fs[0]       = (buf_l * damp2) + (fs[0] * damp1);
+         fs[1]       = (buf_r * damp2) + (fs[1] * damp1);
+         buf[0]      = gain_l + (fs[0] * feedback);
+         buf[1]      = gain_r + (fs[1] * feedback);
+         out_l      += buf_l;
+         out_r      += buf_r;
+      }
+
+      for (c = 0; c < numallpasses; c++)
+      {
+         float *buf  = allpass[c] + idx;
+         float buf_l = buf[0];
+         float buf_r = buf[1];
+
+         buf[0]      = out_l + buf_l * allpassfeedback;
+         buf[1]      = out_r + buf_r * allpassfeedback;
+         out_l       = -out_l + buf_l;
+         out_r       = -out_r + buf_r;
+      }
+
+      samples[0] = in_l * dry + out_l * wet1;
+      samples[1] = in_r * dry + out_r * wet1;
+   }
+#endif
+}
 
-   return mono_in * rev->dry + mono_out * rev->wet1;
+static void revmodel_process(struct revmodel *rev, float *samples,
+      unsigned frames)
+{
+   while (frames)
+   {
+      int c;
+      float *comb[numcombs];
+      float *allpass[numallpasses];
+      unsigned run = frames;
+
+      /* Stop at the first wrap, so the kernel needs no index checks */
+      for (c = 0; c < numcombs; c++)
+      {
+         struct revline *l = &rev->comb[c];
+         if (l->bufsize - l->bufidx < run)
+            run = l->bufsize - l->bufidx;
+         comb[c] = l->buffer + l->bufidx * 2;
+      }
+
+      for (c = 0; c < numallpasses; c++)
+      {
+         struct revline *l = &rev->allpass[c];
+         if (l->bufsize - l->bufidx < run)
+            run = l->bufsize - l->bufidx;
+         allpass[c] = l->buffer + l->bufidx * 2;
+      }
+
+      revmodel_process_block(rev, samples, run, comb, allpass);
+
+      for (c = 0; c < numcombs; c++)
+      {
+         struct revline *l = &rev->comb[c];
+         l->bufidx        += run;
+         if (l->bufidx >= l->bufsize)
+            l->bufidx      = 0;
+      }
+
+      for (c = 0; c < numallpasses; c++)
+      {
+         struct revline *l = &rev->allpass[c];
+         l->bufidx        += run;
+         if (l->bufidx >= l->bufsize)
+            l->bufidx      = 0;
+      }
+
+      samples += run * 2;
+      frames  -= run;
+   }
 }
 
 static void revmodel_update(struct revmodel *rev)
 {
-   int i;
    rev->wet1 = rev->wet * (rev->width / 2.0f + 0.5f);
 
    if (rev->mode >= freezemode)
@@ -141,12 +298,7 @@ static void revmodel_update(struct revmodel *rev)
       rev->gain = fixedgain;
    }
 
-   for (i = 0; i < numcombs; i++)
-   {
-      rev->combL[i].feedback = rev->roomsize1;
-      rev->combL[i].damp1 = rev->damp1;
-      rev->combL[i].damp2 = 1.0f - rev->damp1;
-   }
+   rev->damp2 = 1.0f - rev->damp1;
 }
 
 static void revmodel_setroomsize(struct revmodel *rev, float value)
@@ -185,30 +337,30 @@ static void revmodel_setmode(struct revmodel *rev, float value)
    revmodel_update(rev);
 }
 
-static void revmodel_init(struct revmodel *rev,int srate)
+static bool revline_init(struct revline *l, double r, int length)
 {
+   l->bufsize = (unsigned)(r * length);
+   if (!l->bufsize)
+      l->bufsize = 1;
+   l->bufidx  = 0;
+   l->buffer  = (float*)calloc(l->bufsize * 2, sizeof(float));
+   return l->buffer != NULL;
+}
 
-  static const int comb_lengths[8] = { 1116,1188,1277,1356,1422,1491,1557,1617 };
-  static const int allpass_lengths[4] = { 225,341,441,556 };
-  double r = srate * (1 / 44100.0);
-  unsigned c;
+static bool revmodel_init(struct revmodel *rev, int srate)
+{
+   static const int comb_lengths[8] = { 1116,1188,1277,1356,1422,1491,1557,1617 };
+   static const int allpass_lengths[4] = { 225,341,441,556 };
+   double r = srate * (1 / 44100.0);
+   unsigned c;
 
    for (c = 0; c < numcombs; ++c)
-   {
-	   rev->bufcomb[c] = malloc(r*comb_lengths[c]*sizeof(float));
-	   rev->combL[c].buffer  =  rev->bufcomb[c];
-         memset(rev->combL[c].buffer,0,r*comb_lengths[c]*sizeof(float));
-         rev->combL[c].bufsize=r*comb_lengths[c];
-  }
+      if (!revline_init(&rev->comb[c], r, comb_lengths[c]))
+         return false;
 
    for (c = 0; c < numallpasses; ++c)
-   {
-	   rev->bufallpass[c] = malloc(r*allpass_lengths[c]*sizeof(float));
-	   rev->allpassL[c].buffer  =  rev->bufallpass[c];
-         memset(rev->allpassL[c].buffer,0,r*allpass_lengths[c]*sizeof(float));
-         rev->allpassL[c].bufsize=r*allpass_lengths[c];
-         rev->allpassL[c].feedback = 0.5f;
-  }
+      if (!revline_init(&rev->allpass[c], r, allpass_lengths[c]))
+         return false;
 
    revmodel_setwet(rev, initialwet);
    revmodel_setroomsize(rev, initialroom);
@@ -216,11 +368,12 @@ static void revmodel_init(struct revmodel *rev,int srate)
    revmodel_setdamp(rev, initialdamp);
    revmodel_setwidth(rev, initialwidth);
    revmodel_setmode(rev, initialmode);
+   return true;
 }
 
 struct reverb_data
 {
-   struct revmodel left, right;
+   struct revmodel model;
 };
 
 static void reverb_free(void *data)
@@ -228,36 +381,23 @@ static void reverb_free(void *data)
    struct reverb_data *rev = (struct reverb_data*)data;
    unsigned i;
 
-   for (i = 0; i < numcombs; i++) {
-   free(rev->left.bufcomb[i]);
-   free(rev->right.bufcomb[i]);
-   }
+   for (i = 0; i < numcombs; i++)
+      free(rev->model.comb[i].buffer);
 
-   for (i = 0; i < numallpasses; i++) {
-   free(rev->left.bufallpass[i]);
-   free(rev->right.bufallpass[i]);
-   }
+   for (i = 0; i < numallpasses; i++)
+      free(rev->model.allpass[i].buffer);
    free(data);
 }
 
 static void reverb_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
-   unsigned i;
-   float *out;
    struct reverb_data *rev = (struct reverb_data*)data;
 
    output->samples         = input->samples;
    output->frames          = input->frames;
-   out                     = output->samples;
-
-   for (i = 0; i < input->frames; i++, out += 2)
-   {
-      float in[2] = { out[0], out[1] };
 
-      out[0] = revmodel_process(&rev->left, in[0]);
-      out[1] = revmodel_process(&rev->right, in[1]);
-   }
+   revmodel_process(&rev->model, output->samples, input->frames);
 }
 
 static void *reverb_init(const struct dspfilter_info *info,
@@ -275,20 +415,17 @@ static void *reverb_init(const struct dspfilter_info *info,
    config->get_float(userdata, "roomwidth", &roomwidth, 0.56f);
    config->get_float(userdata, "roomsize", &roomsize, 0.56f);
 
-   revmodel_init(&rev->left,info->input_rate);
-   revmodel_init(&rev->right,info->input_rate);
-
-   revmodel_setdamp(&rev->left, damping);
-   revmodel_setdry(&rev->left, drytime);
-   revmodel_setwet(&rev->left, wettime);
-   revmodel_setwidth(&rev->left, roomwidth);
-   revmodel_setroomsize(&rev->left, roomsize);
+   if (!revmodel_init(&rev->model, info->input_rate))
+   {
+      reverb_free(rev);
+      return NULL;
+   }
 
-   revmodel_setdamp(&rev->right, damping);
-   revmodel_setdry(&rev->right, drytime);
-   revmodel_setwet(&rev->right, wettime);
-   revmodel_setwidth(&rev->right, roomwidth);
-   revmodel_setroomsize(&rev->right, roomsize);
+   revmodel_setdamp(&rev->model, damping);
+   revmodel_setdry(&rev->model, drytime);
+   revmodel_setwet(&rev->model, wettime);
+   revmodel_setwidth(&rev->model, roomwidth);
+   revmodel_setroomsize(&rev->model, roomsize);
 
    return rev;
 }
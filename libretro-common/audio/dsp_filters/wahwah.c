@@ -27,21 +27,25 @@
 #include <retro_miscellaneous.h>
 #include <libretro_dspfilter.h>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
 #define WAHWAH_LFO_SKIP_SAMPLES 30
 
 struct wahwah_data
 {
    float phase;
    float lfoskip;
-   float b0, b1, b2, a0, a1, a2;
+   float b0, b1, b2, a1, a2;
    float freq, startphase;
    float depth, freqofs, res;
    unsigned long skipcount;
 
-   struct
-   {
-      float xn1, xn2, yn1, yn2;
-   } l, r;
+   /* Filter history, left then right */
+   float xn1[2], xn2[2], yn1[2], yn2[2];
 };
 
 static void wahwah_free(void *data)
@@ -50,25 +54,110 @@ static void wahwah_free(void *data)
       free(data);
 }
 
+/* Runs @frames frames through the filter as it is now */
+static void wahwah_run(struct wahwah_data *wah, float *out, unsigned frames)
+{
+   unsigned i;
+#if defined(__SSE__)
+   /* Left and right in the two low lanes */
+   __m128 b0  = _mm_set1_ps(wah->b0);
+   __m128 b1  = _mm_set1_ps(wah->b1);
+   __m128 b2  = _mm_set1_ps(wah->b2);
+   __m128 a1  = _mm_set1_ps(wah->a1);
+   __m128 a2  = _mm_set1_ps(wah->a2);
+   __m128 xn1 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)wah->xn1);
+   __m128 xn2 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)wah->xn2);
+   __m128 yn1 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)wah->yn1);
+   __m128 yn2 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)wah->yn2);
+
+   for (i = 0; i < frames; i++, out += 2)
+   {
+      __m128 in = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)out);
+      __m128 y  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b0, in),
+               _mm_mul_ps(b1, xn1)), _mm_mul_ps(b2, xn2));
+      /* The last output goes in last, the rest doesn't wait on it */
+      y         = _mm_sub_ps(_mm_sub_ps(y, _mm_mul_ps(a2, yn2)),
+            _mm_mul_ps(a1, yn1));
+
+      xn2       = xn1;
+      xn1       = in;
+      yn2       = yn1;
+      yn1       = y;
+
+      _mm_storel_pi((__m64*)out, y);
+   }
+
+   _mm_storel_pi((__m64*)wah->xn1, xn1);
+   _mm_storel_pi((__m64*)wah->xn2, xn2);
+   _mm_storel_pi((__m64*)wah->yn1, yn1);
+   _mm_storel_pi((__m64*)wah->yn2, yn2);
+#elif defined(__ARM_NEON__) || defined(HAVE_NEON)
+   float32x2_t xn1 = vld1_f32(wah->xn1);
+   float32x2_t xn2 = vld1_f32(wah->xn2);
+   float32x2_t yn1 = vld1_f32(wah->yn1);
+   float32x2_t yn2 = vld1_f32(wah->yn2);
+
+   for (i = 0; i < frames; i++, out += 2)
+   {
+      float32x2_t in = vld1_f32(out);
+      float32x2_t y  = vmla_n_f32(vmla_n_f32(vmul_n_f32(in, wah->b0),
+               xn1, wah->b1), xn2, wah->b2);
+      y              = vmls_n_f32(vmls_n_f32(y, yn2, wah->a2),
+            yn1, wah->a1);
+
+      xn2            = xn1;
+      xn1            = in;
+      yn2            = yn1;
+      yn1            = y;
+
+      vst1_f32(out, y);
+   }
+
+   vst1_f32(wah->xn1, xn1);
+   vst1_f32(wah->xn2, xn2);
+   vst1_f32(wah->yn1, yn1);
+   vst1_f32(wah->yn2, yn2);
+#else
+   for (i = 0; i < frames; i++, out += 2)
+   {
+      unsigned c;
+      for (c = 0; c < 2; c++)
+      {
+         float in = out[c];
+         float y  = wah->b0 * in + wah->b1 * wah->xn1[c] + wah->b2 * wah->xn2[c]
+            - wah->a2 * wah->yn2[c] - wah->a1 * wah->yn1[c];
+
+         wah->xn2[c] = wah->xn1[c];
+         wah->xn1[c] = in;
+         wah->yn2[c] = wah->yn1[c];
+         wah->yn1[c] = y;
+
+         out[c]      = y;
+      }
+   }
+#endif
+}
+
 static void wahwah_process(void *data, struct dspfilter_output *output,
       const struct dspfilter_input *input)
 {
-   unsigned i;
    struct wahwah_data *wah = (struct wahwah_data*)data;
    float *out              = output->samples;
+   unsigned frames         = input->frames;
 
    output->samples         = input->samples;
    output->frames          = input->frames;
 
-   for (i = 0; i < input->frames; i++, out += 2)
+   /* Coefficients only change every WAHWAH_LFO_SKIP_SAMPLES frames,
+    * run the filter in between without looking at the LFO */
+   while (frames)
    {
-      float out_l, out_r;
-      float in[2] = { out[0], out[1] };
+      unsigned run;
 
-      if ((wah->skipcount++ % WAHWAH_LFO_SKIP_SAMPLES) == 0)
+      if ((wah->skipcount % WAHWAH_LFO_SKIP_SAMPLES) == 0)
       {
-         float omega, sn, cs, alpha;
-         float frequency = (1.0f + cos(wah->skipcount * wah->lfoskip + wah->phase)) / 2.0f;
+         float omega, sn, cs, alpha, a0;
+         float frequency = (1.0f + cos((wah->skipcount + 1) * wah->lfoskip + wah->phase)) / 2.0f;
 
          frequency       = frequency * wah->depth * (1.0f - wah->freqofs) + wah->freqofs;
          frequency       = exp((frequency - 1.0f) * 6.0f);
@@ -78,29 +167,24 @@ static void wahwah_process(void *data, struct dspfilter_output *output,
          cs              = cos(omega);
          alpha           = sn / (2.0f * wah->res);
 
-         wah->b0         = (1.0f - cs) / 2.0f;
-         wah->b1         = 1.0f  - cs;
-         wah->b2         = (1.0f - cs) / 2.0f;
-         wah->a0         = 1.0f + alpha;
-         wah->a1         = -2.0f * cs;
-         wah->a2         = 1.0f - alpha;
+         /* Normalized by a0, so there's no divide per sample */
+         a0              = 1.0f / (1.0f + alpha);
+         wah->b0         = (1.0f - cs) / 2.0f * a0;
+         wah->b1         = (1.0f - cs) * a0;
+         wah->b2         = wah->b0;
+         wah->a1         = -2.0f * cs * a0;
+         wah->a2         = (1.0f - alpha) * a0;
       }
 
-      out_l              = (wah->b0 * in[0] + wah->b1 * wah->l.xn1 + wah->b2 * wah->l.xn2 - wah->a1 * wah->l.yn1 - wah->a2 * wah->l.yn2) / wah->a0;
-      out_r              = (wah->b0 * in[1] + wah->b1 * wah->r.xn1 + wah->b2 * wah->r.xn2 - wah->a1 * wah->r.yn1 - wah->a2 * wah->r.yn2) / wah->a0;
-
-      wah->l.xn2         = wah->l.xn1;
-      wah->l.xn1         = in[0];
-      wah->l.yn2         = wah->l.yn1;
-      wah->l.yn1         = out_l;
+      run             = WAHWAH_LFO_SKIP_SAMPLES
+         - (unsigned)(wah->skipcount % WAHWAH_LFO_SKIP_SAMPLES);
+      run             = MIN(run, frames);
 
-      wah->r.xn2         = wah->r.xn1;
-      wah->r.xn1         = in[1];
-      wah->r.yn2         = wah->r.yn1;
-      wah->r.yn1         = out_r;
+      wahwah_run(wah, out, run);
 
-      out[0]             = out_l;
-      out[1]             = out_r;
+      wah->skipcount += run;
+      out            += run * 2;
+      frames         -= run;
    }
 }
 
@@ -53,6 +53,25 @@
 
 /* TODO, make all this more configurable. */
 
+/* Fixed ratio mode: when the nominal ratio is a fraction
+ * out/in with a small enough numerator, the Kaiser qualities
+ * use a table of exact filter phases on a grid of
+ * SINC_FIXED_MIN_STEP or more phases per output frame, instead
+ * of interpolating between power-of-two phases for every sample.
+ * Rate control moves the ratio a little on each call; the step
+ * is then split into whole phases and a fraction that's summed
+ * up frame by frame, adding a phase whenever it wraps. Every frame
+ * is still filtered with exact coefficients, and is at most one
+ * phase, about 1 / SINC_FIXED_MIN_STEP of a frame, off time. */
+#define SINC_FIXED_MIN_STEP   2048
+#define SINC_FIXED_MAX_PHASES 4096
+/* The ratio a frontend asks for usually isn't the core's own:
+ * RetroArch skews the input rate by up to audio_max_timing_skew
+ * (5% by default) to match the display. A ratio that isn't an
+ * exact fraction is snapped to the simplest one within this,
+ * and the skew is stepped through like rate control is. */
+#define SINC_FIXED_MAX_SKEW   0.05
+
 enum sinc_window
 {
    SINC_WINDOW_NONE   = 0,
@@ -75,16 +94,48 @@ typedef struct rarch_sinc_resampler
    float *phase_table;
    float *buffer_l;
    float *buffer_r;
+   unsigned phases;
    unsigned phase_bits;
    unsigned subphase_bits;
    unsigned subphase_mask;
    unsigned taps;
    unsigned ptr;
    uint32_t time;
+   /* Fixed ratio only: the step's fraction of a phase,
+    * in 1/2^32, and the running sum of it */
+   uint32_t step_frac;
+   uint32_t step_acc;
    float subphase_mod;
    float kaiser_beta;
+   bool fixed_ratio;
 } rarch_sinc_resampler_t;
 
+/* Time to advance per output frame, in 1/phases of an input
+ * frame. The fixed ratio path adds resamp->step_frac on top. */
+static INLINE uint32_t resampler_sinc_step(
+      rarch_sinc_resampler_t *resamp, double ratio)
+{
+   double step;
+   uint32_t istep;
+
+   if (!resamp->fixed_ratio)
+      return resamp->phases / ratio;
+
+   step              = resamp->phases / ratio;
+   istep             = (uint32_t)step;
+   resamp->step_frac = (uint32_t)((step - istep) * 4294967296.0);
+   return istep;
+}
+
+/* Advances by one output frame, carrying the step's
+ * fraction into a whole phase whenever it wraps */
+#define SINC_ADVANCE(resamp, step) \
+   do { \
+      (resamp)->step_acc += (resamp)->step_frac; \
+      (resamp)->time     += (step) \
+         + ((resamp)->step_acc < (resamp)->step_frac); \
+   } while (0)
+
 #if (defined(__ARM_NEON__) || defined(HAVE_NEON))
 
 #ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
@@ -172,8 +223,8 @@ static void resampler_sinc_process_neon_kaiser(void *re_, struct resampler_data
 static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
-   uint32_t ratio                 = phases / data->ratio;
+   unsigned phases                = resamp->phases;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -211,8 +262,11 @@ static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 #else
             int i;
             float32x4_t p1 = {0, 0, 0, 0}, p2 = {0, 0, 0, 0};
+            float32x4_t q1 = {0, 0, 0, 0}, q2 = {0, 0, 0, 0};
             float32x2_t p3, p4;
 
+            /* Two sums per channel, so the multiply-adds
+             * don't wait on each other */
             for (i = 0; i < (int)taps; i += 8)
             {
                float32x4x2_t coeff8  = vld2q_f32(&phase_table[i]);
@@ -221,17 +275,19 @@ static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 
                p1 = vmlaq_f32(p1,  left8.val[0], coeff8.val[0]);
                p2 = vmlaq_f32(p2, right8.val[0], coeff8.val[0]);
-               p1 = vmlaq_f32(p1,  left8.val[1], coeff8.val[1]);
-               p2 = vmlaq_f32(p2, right8.val[1], coeff8.val[1]);
+               q1 = vmlaq_f32(q1,  left8.val[1], coeff8.val[1]);
+               q2 = vmlaq_f32(q2, right8.val[1], coeff8.val[1]);
             }
 
+            p1 = vaddq_f32(p1, q1);
+            p2 = vaddq_f32(p2, q2);
             p3 = vadd_f32(vget_low_f32(p1), vget_high_f32(p1));
             p4 = vadd_f32(vget_low_f32(p2), vget_high_f32(p2));
             vst1_f32(output, vpadd_f32(p3, p4));
 #endif
             output                 += 2;
             out_frames++;
-            resamp->time           += ratio;
+            SINC_ADVANCE(resamp, ratio);
          }
       }
    }
@@ -329,9 +385,9 @@ static void resampler_sinc_process_avx_kaiser(void *re_, struct resampler_data *
 static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   unsigned phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -364,23 +420,42 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
             while (resamp->time < phases)
             {
                int i;
-               __m256 delta;
                unsigned phase           = resamp->time >> resamp->subphase_bits;
                float *phase_table       = resamp->phase_table + phase * taps;
 
                __m256 sum_l             = _mm256_setzero_ps();
                __m256 sum_r             = _mm256_setzero_ps();
+               __m256 sum_l2            = _mm256_setzero_ps();
+               __m256 sum_r2            = _mm256_setzero_ps();
 
-               for (i = 0; i < (int)taps; i += 8)
+               for (i = 0; i + 16 <= (int)taps; i += 16)
+               {
+                  __m256 sinc   = _mm256_load_ps((const float*)phase_table + i);
+                  __m256 sinc2  = _mm256_load_ps((const float*)phase_table + i + 8);
+
+                  sum_l         = _mm256_add_ps(sum_l,
+                        _mm256_mul_ps(_mm256_loadu_ps(buffer_l + i), sinc));
+                  sum_r         = _mm256_add_ps(sum_r,
+                        _mm256_mul_ps(_mm256_loadu_ps(buffer_r + i), sinc));
+                  sum_l2        = _mm256_add_ps(sum_l2,
+                        _mm256_mul_ps(_mm256_loadu_ps(buffer_l + i + 8), sinc2));
+                  sum_r2        = _mm256_add_ps(sum_r2,
+                        _mm256_mul_ps(_mm256_loadu_ps(buffer_r + i + 8), sinc2));
+               }
+
+               if (i < (int)taps)
                {
-                  __m256 buf_l  = _mm256_loadu_ps(buffer_l + i);
-                  __m256 buf_r  = _mm256_loadu_ps(buffer_r + i);
                   __m256 sinc   = _mm256_load_ps((const float*)phase_table + i);
 
-                  sum_l         = _mm256_add_ps(sum_l, _mm256_mul_ps(buf_l, sinc));
-                  sum_r         = _mm256_add_ps(sum_r, _mm256_mul_ps(buf_r, sinc));
+                  sum_l         = _mm256_add_ps(sum_l,
+                        _mm256_mul_ps(_mm256_loadu_ps(buffer_l + i), sinc));
+                  sum_r         = _mm256_add_ps(sum_r,
+                        _mm256_mul_ps(_mm256_loadu_ps(buffer_r + i), sinc));
                }
 
+               sum_l = _mm256_add_ps(sum_l, sum_l2);
+               sum_r = _mm256_add_ps(sum_r, sum_r2);
+
                /* hadd on AVX is weird, and acts on low-lanes
                 * and high-lanes separately. */
                __m256 res_l = _mm256_hadd_ps(sum_l, sum_l);
@@ -397,7 +472,7 @@ static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 
                output += 2;
                out_frames++;
-               resamp->time += ratio;
+               SINC_ADVANCE(resamp, ratio);
             }
          }
       }
@@ -506,9 +581,9 @@ static void resampler_sinc_process_sse_kaiser(void *re_, struct resampler_data *
 static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   unsigned phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -547,16 +622,35 @@ static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
 
                __m128 sum_l             = _mm_setzero_ps();
                __m128 sum_r             = _mm_setzero_ps();
+               __m128 sum_l2            = _mm_setzero_ps();
+               __m128 sum_r2            = _mm_setzero_ps();
 
-               for (i = 0; i < (int)taps; i += 4)
+               for (i = 0; i + 8 <= (int)taps; i += 8)
                {
-                  __m128 buf_l = _mm_loadu_ps(buffer_l + i);
-                  __m128 buf_r = _mm_loadu_ps(buffer_r + i);
-                  __m128 _sinc = _mm_load_ps((const float*)phase_table + i);
-                  sum_l        = _mm_add_ps(sum_l, _mm_mul_ps(buf_l, _sinc));
-                  sum_r        = _mm_add_ps(sum_r, _mm_mul_ps(buf_r, _sinc));
+                  __m128 _sinc  = _mm_load_ps((const float*)phase_table + i);
+                  __m128 _sinc2 = _mm_load_ps((const float*)phase_table + i + 4);
+                  sum_l         = _mm_add_ps(sum_l,
+                        _mm_mul_ps(_mm_loadu_ps(buffer_l + i), _sinc));
+                  sum_r         = _mm_add_ps(sum_r,
+                        _mm_mul_ps(_mm_loadu_ps(buffer_r + i), _sinc));
+                  sum_l2        = _mm_add_ps(sum_l2,
+                        _mm_mul_ps(_mm_loadu_ps(buffer_l + i + 4), _sinc2));
+                  sum_r2        = _mm_add_ps(sum_r2,
+                        _mm_mul_ps(_mm_loadu_ps(buffer_r + i + 4), _sinc2));
+               }
+
+               if (i < (int)taps)
+               {
+                  __m128 _sinc  = _mm_load_ps((const float*)phase_table + i);
+                  sum_l         = _mm_add_ps(sum_l,
+                        _mm_mul_ps(_mm_loadu_ps(buffer_l + i), _sinc));
+                  sum_r         = _mm_add_ps(sum_r,
+                        _mm_mul_ps(_mm_loadu_ps(buffer_r + i), _sinc));
                }
 
+               sum_l = _mm_add_ps(sum_l, sum_l2);
+               sum_r = _mm_add_ps(sum_r, sum_r2);
+
                /* Them annoying shuffles.
                 * sum_l = { l3, l2, l1, l0 }
                 * sum_r = { r3, r2, r1, r0 }
@@ -584,7 +678,7 @@ static void resampler_sinc_process_sse(void *re_, struct resampler_data *data)
 
                output += 2;
                out_frames++;
-               resamp->time += ratio;
+               SINC_ADVANCE(resamp, ratio);
             }
          }
       }
@@ -666,9 +760,9 @@ static void resampler_sinc_process_c_kaiser(void *re_, struct resampler_data *da
 static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
 {
    rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
-   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   unsigned phases                = resamp->phases;
 
-   uint32_t ratio                 = phases / data->ratio;
+   uint32_t ratio                 = resampler_sinc_step(resamp, data->ratio);
    const float *input             = data->data_in;
    float *output                  = data->data_out;
    size_t frames                  = data->input_frames;
@@ -719,7 +813,7 @@ static void resampler_sinc_process_c(void *re_, struct resampler_data *data)
 
                output                  += 2;
                out_frames++;
-               resamp->time            += ratio;
+               SINC_ADVANCE(resamp, ratio);
             }
          }
 
@@ -858,15 +952,104 @@ static void sinc_init_table_lanczos(
    }
 }
 
-static void *resampler_sinc_new(const struct resampler_config *config,
-      double bandwidth_mod, enum resampler_quality quality,
-      resampler_simd_mask_t mask)
+/* Phases for a table of fraction h/k, with a step of
+ * at least SINC_FIXED_MIN_STEP; 0 if it gets too big */
+static unsigned sinc_fixed_fraction_phases(uint64_t h, uint64_t k)
+{
+   uint64_t phases = h * ((SINC_FIXED_MIN_STEP + k - 1) / k);
+   return (phases <= SINC_FIXED_MAX_PHASES) ? (unsigned)phases : 0;
+}
+
+/**
+ * sinc_fixed_ratio_phases:
+ * @ratio              : nominal ratio, output rate / input rate.
+ *
+ * Looks for @ratio as a fraction out/in through its continued
+ * fraction, and scales out so that in becomes at least
+ * SINC_FIXED_MIN_STEP. E.g. 32040 Hz -> 48000 Hz is 400/267,
+ * giving a table of 1600 phases stepped by 1068.
+ *
+ * Returns: number of phases for the fixed ratio table, or 0 if
+ * @ratio isn't such a fraction.
+ **/
+static unsigned sinc_fixed_ratio_phases(double ratio)
+{
+   unsigned i;
+   double x     = ratio;
+   uint64_t h0  = 0, h1 = 1; /* numerators   */
+   uint64_t k0  = 1, k1 = 0; /* denominators */
+
+   if (ratio <= 0.0)
+      return 0;
+
+   for (i = 0; i < 32; i++)
+   {
+      double a   = floor(x);
+      uint64_t h = (uint64_t)a * h1 + h0;
+      uint64_t k = (uint64_t)a * k1 + k0;
+
+      if (h > SINC_FIXED_MAX_PHASES)
+         break;
+
+      if (h && fabs((double)h / k - ratio) <= ratio * 1e-9)
+         return sinc_fixed_fraction_phases(h, k);
+
+      if (x - a < 1e-9)
+         break;
+
+      x          = 1.0 / (x - a);
+      h0         = h1;
+      h1         = h;
+      k0         = k1;
+      k1         = k;
+   }
+
+   return 0;
+}
+
+/**
+ * sinc_snapped_ratio_phases:
+ * @ratio              : requested ratio, output rate / input rate.
+ *
+ * Like sinc_fixed_ratio_phases(), but for the simplest fraction
+ * within SINC_FIXED_MAX_SKEW of @ratio. The step's fraction takes
+ * up the difference, e.g. SNES audio skewed from 32040 Hz to 31987 Hz
+ * for a 59.94 Hz display still gets a table.
+ *
+ * Returns: number of phases for the fixed ratio table, or 0 if
+ * @ratio is out of its range.
+ **/
+static unsigned sinc_snapped_ratio_phases(double ratio)
+{
+   uint64_t k;
+
+   if (ratio <= 0.0)
+      return 0;
+
+   for (k = 1; k <= SINC_FIXED_MIN_STEP; k++)
+   {
+      uint64_t h = (uint64_t)(ratio * k + 0.5);
+
+      if (h > SINC_FIXED_MAX_PHASES)
+         break;
+      if (h && fabs((double)h / k - ratio) <= ratio * SINC_FIXED_MAX_SKEW)
+         return sinc_fixed_fraction_phases(h, k);
+   }
+
+   return 0;
+}
+
+static void *resampler_sinc_init(double bandwidth_mod,
+      enum resampler_quality quality, resampler_simd_mask_t mask,
+      bool fixed_ratio)
 {
    double cutoff                  = 0.0;
    size_t phase_elems             = 0;
    size_t elems                   = 0;
    unsigned enable_avx            = 0;
    unsigned sidelobes             = 0;
+   unsigned fixed_phases          = 0;
+   bool interpolate               = false;
    enum sinc_window window_type   = SINC_WINDOW_NONE;
    rarch_sinc_resampler_t *re     = (rarch_sinc_resampler_t*)
       calloc(1, sizeof(*re));
@@ -945,9 +1128,29 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 #endif
    }
 
-   phase_elems     = ((1 << re->phase_bits) * re->taps);
-   if (window_type == SINC_WINDOW_KAISER)
-      phase_elems  = phase_elems * 2;
+   if (fixed_ratio && window_type == SINC_WINDOW_KAISER)
+   {
+      if (!(fixed_phases = sinc_fixed_ratio_phases(bandwidth_mod)))
+         fixed_phases    = sinc_snapped_ratio_phases(bandwidth_mod);
+   }
+
+   if (fixed_phases)
+   {
+      /* One table entry per phase, no deltas to interpolate with */
+      re->fixed_ratio   = true;
+      re->phases        = fixed_phases;
+      re->phase_bits    = 0;
+      re->subphase_bits = 0;
+      re->subphase_mask = 0;
+      phase_elems       = fixed_phases * re->taps;
+   }
+   else
+   {
+      re->phases        = 1 << (re->phase_bits + re->subphase_bits);
+      phase_elems       = ((1 << re->phase_bits) * re->taps);
+      if (window_type == SINC_WINDOW_KAISER)
+         phase_elems    = phase_elems * 2;
+   }
    elems           = phase_elems + 4 * re->taps;
 
    re->main_buffer = (float*)memalign_alloc(128, sizeof(float) * elems);
@@ -967,22 +1170,39 @@ static void *resampler_sinc_new(const struct resampler_config *config,
                1 << re->phase_bits, re->taps, false);
          break;
       case SINC_WINDOW_KAISER:
-         sinc_init_table_kaiser(re, cutoff, re->phase_table,
-               1 << re->phase_bits, re->taps, true);
+         if (re->fixed_ratio)
+            sinc_init_table_kaiser(re, cutoff, re->phase_table,
+                  re->phases, re->taps, false);
+         else
+            sinc_init_table_kaiser(re, cutoff, re->phase_table,
+                  1 << re->phase_bits, re->taps, true);
          break;
       case SINC_WINDOW_NONE:
          goto error;
    }
 
+   /* The fixed ratio table has no deltas, so it goes
+    * through the same loops as the Lanczos one */
+   interpolate = (window_type == SINC_WINDOW_KAISER) && !re->fixed_ratio;
+
    sinc_resampler.process = resampler_sinc_process_c;
-   if (window_type == SINC_WINDOW_KAISER)
+   if (interpolate)
       sinc_resampler.process    = resampler_sinc_process_c_kaiser;
 
+   /* Only consider the paths that were built, a CPU with AVX
+    * running a build without it must still get the SSE path */
+#if !defined(__AVX__)
+   mask &= ~RESAMPLER_SIMD_AVX;
+#endif
+#if !defined(__SSE__)
+   mask &= ~RESAMPLER_SIMD_SSE;
+#endif
+
    if (mask & RESAMPLER_SIMD_AVX && enable_avx)
    {
 #if defined(__AVX__)
       sinc_resampler.process    = resampler_sinc_process_avx;
-      if (window_type == SINC_WINDOW_KAISER)
+      if (interpolate)
          sinc_resampler.process = resampler_sinc_process_avx_kaiser;
 #endif
    }
@@ -990,7 +1210,7 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    {
 #if defined(__SSE__)
       sinc_resampler.process = resampler_sinc_process_sse;
-      if (window_type == SINC_WINDOW_KAISER)
+      if (interpolate)
          sinc_resampler.process = resampler_sinc_process_sse_kaiser;
 #endif
    }
@@ -998,11 +1218,11 @@ static void *resampler_sinc_new(const struct resampler_config *config,
    {
 #if (defined(__ARM_NEON__) || defined(HAVE_NEON))
 #ifdef HAVE_ARM_NEON_ASM_OPTIMIZATIONS
-      if (window_type != SINC_WINDOW_KAISER)
+      if (!interpolate)
          sinc_resampler.process = resampler_sinc_process_neon;
 #else
       sinc_resampler.process = resampler_sinc_process_neon;
-      if (window_type == SINC_WINDOW_KAISER)
+      if (interpolate)
          sinc_resampler.process = resampler_sinc_process_neon_kaiser;
 #endif
 #endif
@@ -1015,6 +1235,13 @@ error:
    return NULL;
 }
 
+static void *resampler_sinc_new(const struct resampler_config *config,
+      double bandwidth_mod, enum resampler_quality quality,
+      resampler_simd_mask_t mask)
+{
+   return resampler_sinc_init(bandwidth_mod, quality, mask, true);
+}
+
 retro_resampler_t sinc_resampler = {
    resampler_sinc_new,
    resampler_sinc_process_c,
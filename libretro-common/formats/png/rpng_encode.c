@@ -25,12 +25,36 @@
 #include <string.h>
 
 #include <libretro.h>
+#include <retro_miscellaneous.h>
 #include <encodings/crc32.h>
 #include <streams/interface_stream.h>
 #include <streams/trans_stream.h>
 
+#ifdef HAVE_THREADS
+#include <features/features_cpu.h>
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "rpng_internal.h"
 
+/* zlib compression level; higher levels cost a lot of time
+ * for a few percent on screenshot-like images */
+#define RPNG_ENCODE_LEVEL           6
+#define RPNG_ENCODE_WINDOW_BITS     15
+/* Images are split into up to one block of rows per core, each
+ * filtered and deflated by its own thread. Smaller blocks
+ * would cost compression ratio for little gain. */
+#define RPNG_ENCODE_MAX_THREADS     8
+#define RPNG_ENCODE_MIN_BLOCK_SIZE  (1 << 20)
+
+#define RPNG_ADLER32_BASE           65521
+
 #undef GOTO_END_ERROR
 #define GOTO_END_ERROR() do { \
    fprintf(stderr, "[RPNG]: Error in line %d.\n", __LINE__); \
@@ -94,12 +118,16 @@ static bool png_write_ihdr_string(intfstream_t *intf_s, const struct png_ihdr *i
          sizeof(ihdr_raw) - sizeof(uint32_t));
 }
 
-static bool png_write_idat_string(intfstream_t* intf_s, const uint8_t *data, size_t size)
+static bool png_write_idat_string(intfstream_t* intf_s, const uint8_t *data,
+      size_t size, uint32_t crc)
 {
+   uint8_t crc_raw[4] = {0};
+
    if (intfstream_write(intf_s, data, size) != (ssize_t)size)
       return false;
 
-   return png_write_crc_string(intf_s, data + sizeof(uint32_t), size - sizeof(uint32_t));
+   dword_write_be(crc_raw, crc);
+   return intfstream_write(intf_s, crc_raw, sizeof(crc_raw)) == sizeof(crc_raw);
 }
 
 static bool png_write_iend_string(intfstream_t* intf_s)
@@ -116,10 +144,83 @@ static bool png_write_iend_string(intfstream_t* intf_s)
          sizeof(data) - sizeof(uint32_t));
 }
 
+static uint32_t rpng_adler32(uint32_t adler, const uint8_t *data, size_t size)
+{
+   uint32_t a = adler & 0xffff;
+   uint32_t b = adler >> 16;
+
+   while (size)
+   {
+      /* Largest run that can't overflow b before the modulo */
+      size_t run = size < 5552 ? size : 5552;
+
+      size -= run;
+      while (run--)
+      {
+         a += *data++;
+         b += a;
+      }
+
+      a %= RPNG_ADLER32_BASE;
+      b %= RPNG_ADLER32_BASE;
+   }
+
+   return (b << 16) | a;
+}
+
+/* Checksum of A followed by B, from the checksums
+ * of A and B and the size of B */
+static uint32_t rpng_adler32_combine(uint32_t adler1, uint32_t adler2,
+      size_t size2)
+{
+   uint32_t rem  = (uint32_t)(size2 % RPNG_ADLER32_BASE);
+   uint32_t sum1 = adler1 & 0xffff;
+   uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % RPNG_ADLER32_BASE);
+
+   sum1 += (adler2 & 0xffff) + RPNG_ADLER32_BASE - 1;
+   sum2 += (adler1 >> 16) + (adler2 >> 16) + RPNG_ADLER32_BASE - rem;
+
+   if (sum1 >= RPNG_ADLER32_BASE)
+      sum1 -= RPNG_ADLER32_BASE;
+   if (sum1 >= RPNG_ADLER32_BASE)
+      sum1 -= RPNG_ADLER32_BASE;
+   if (sum2 >= (RPNG_ADLER32_BASE << 1))
+      sum2 -= (RPNG_ADLER32_BASE << 1);
+   if (sum2 >= RPNG_ADLER32_BASE)
+      sum2 -= RPNG_ADLER32_BASE;
+
+   return (sum2 << 16) | sum1;
+}
+
 static void copy_argb_line(uint8_t *dst, const uint32_t *src, unsigned width)
 {
-   unsigned i;
-   for (i = 0; i < width; i++)
+   unsigned i = 0;
+#if defined(__SSE2__)
+   const __m128i rb_mask = _mm_set1_epi32(0x00ff00ff);
+
+   for (; i + 4 <= width; i += 4, dst += 16)
+   {
+      __m128i col = _mm_loadu_si128((const __m128i*)(src + i));
+      __m128i rb  = _mm_and_si128(col, rb_mask);
+      __m128i ga  = _mm_andnot_si128(rb_mask, col);
+
+      rb          = _mm_or_si128(_mm_slli_epi32(rb, 16),
+            _mm_srli_epi32(rb, 16));
+      _mm_storeu_si128((__m128i*)dst, _mm_or_si128(ga, rb));
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= width; i += 16, dst += 64)
+   {
+      uint8x16x4_t col = vld4q_u8((const uint8_t*)(src + i));
+      uint8x16_t b     = col.val[0];
+
+      col.val[0]       = col.val[2];
+      col.val[2]       = b;
+      vst4q_u8(dst, col);
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t col = src[i];
       *dst++ = (uint8_t)(col >> 16);
@@ -131,8 +232,20 @@ static void copy_argb_line(uint8_t *dst, const uint32_t *src, unsigned width)
 
 static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
 {
-   unsigned i;
-   for (i = 0; i < width; i++, dst += 3, src += 3)
+   unsigned i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= width; i += 16, dst += 48, src += 48)
+   {
+      uint8x16x3_t col = vld3q_u8(src);
+      uint8x16_t b     = col.val[0];
+
+      col.val[0]       = col.val[2];
+      col.val[2]       = b;
+      vst3q_u8(dst, col);
+   }
+#endif
+
+   for (; i < width; i++, dst += 3, src += 3)
    {
       dst[2] = src[0];
       dst[1] = src[1];
@@ -140,11 +253,41 @@ static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
    }
 }
 
+/* Sum of the bytes taken as signed, the usual
+ * heuristic for how well a filtered line compresses */
 static unsigned count_sad(const uint8_t *data, size_t size)
 {
-   size_t i;
+   size_t i     = 0;
    unsigned cnt = 0;
-   for (i = 0; i < size; i++)
+#if defined(__SSE2__)
+   const __m128i zero = _mm_setzero_si128();
+   __m128i sum        = _mm_setzero_si128();
+
+   for (; i + 16 <= size; i += 16)
+   {
+      __m128i in = _mm_loadu_si128((const __m128i*)(data + i));
+      /* |x| of a signed byte is the smaller of x and -x, unsigned */
+      __m128i a  = _mm_min_epu8(in, _mm_sub_epi8(zero, in));
+      sum        = _mm_add_epi64(sum, _mm_sad_epu8(a, zero));
+   }
+
+   cnt = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   uint32x4_t sum = vdupq_n_u32(0);
+
+   for (; i + 16 <= size; i += 16)
+   {
+      /* |-128| wraps to -128, which is 128 unsigned */
+      uint8x16_t a = vreinterpretq_u8_s8(vabsq_s8(
+               vreinterpretq_s8_u8(vld1q_u8(data + i))));
+      sum          = vpadalq_u16(sum, vpaddlq_u8(a));
+   }
+
+   cnt = vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1)
+       + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+#endif
+
+   for (; i < size; i++)
    {
       if (data[i])
          cnt += abs((int8_t)data[i]);
@@ -155,9 +298,18 @@ static unsigned count_sad(const uint8_t *data, size_t size)
 static unsigned filter_up(uint8_t *target, const uint8_t *line,
       const uint8_t *prev, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
    width *= bpp;
-   for (i = 0; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= width; i += 16)
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i), vld1q_u8(prev + i)));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - prev[i];
 
    return count_sad(target, width);
@@ -170,7 +322,17 @@ static unsigned filter_sub(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i];
-   for (i = bpp; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(line + i - bpp))));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= width; i += 16)
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i),
+               vld1q_u8(line + i - bpp)));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - line[i - bpp];
 
    return count_sad(target, width);
@@ -180,10 +342,29 @@ static unsigned filter_avg(uint8_t *target, const uint8_t *line,
       const uint8_t *prev, unsigned width, unsigned bpp)
 {
    unsigned i;
+#if defined(__SSE2__)
+   const __m128i one = _mm_set1_epi8(1);
+#endif
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - (prev[i] >> 1);
-   for (i = bpp; i < width; i++)
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+   {
+      __m128i a   = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+      __m128i b   = _mm_loadu_si128((const __m128i*)(prev + i));
+      /* _mm_avg_epu8 rounds up, PNG rounds down */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)), avg));
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= width; i += 16)
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i),
+               vhaddq_u8(vld1q_u8(line + i - bpp), vld1q_u8(prev + i))));
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - ((line[i - bpp] + prev[i]) >> 1);
 
    return count_sad(target, width);
@@ -194,76 +375,150 @@ static unsigned filter_paeth(uint8_t *target,
       unsigned width, unsigned bpp)
 {
    unsigned i;
+#if defined(__SSE2__)
+   const __m128i zero = _mm_setzero_si128();
+#endif
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - paeth(0, prev[i], 0);
-   for (i = bpp; i < width; i++)
+
+   /* With a = left, b = up and c = up left, paeth() compares
+    * pa = |b - c|, pb = |a - c| and pc = |a + b - 2c|. Only pc
+    * needs more than 8 bits, and saturating it to 255 doesn't
+    * change how it compares with the other two. */
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+   {
+      __m128i a      = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+      __m128i b      = _mm_loadu_si128((const __m128i*)(prev + i));
+      __m128i c      = _mm_loadu_si128((const __m128i*)(prev + i - bpp));
+      __m128i pa     = _mm_or_si128(_mm_subs_epu8(b, c), _mm_subs_epu8(c, b));
+      __m128i pb     = _mm_or_si128(_mm_subs_epu8(a, c), _mm_subs_epu8(c, a));
+      __m128i pc_lo  = _mm_sub_epi16(
+            _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+            _mm_slli_epi16(_mm_unpacklo_epi8(c, zero), 1));
+      __m128i pc_hi  = _mm_sub_epi16(
+            _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+            _mm_slli_epi16(_mm_unpackhi_epi8(c, zero), 1));
+      __m128i pc, use_a, use_b, pred;
+
+      pc_lo          = _mm_max_epi16(pc_lo, _mm_sub_epi16(zero, pc_lo));
+      pc_hi          = _mm_max_epi16(pc_hi, _mm_sub_epi16(zero, pc_hi));
+      pc             = _mm_packus_epi16(pc_lo, pc_hi);
+
+      /* x <= y is min(x, y) == x */
+      use_a          = _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_min_epu8(pa, pb), pa),
+            _mm_cmpeq_epi8(_mm_min_epu8(pa, pc), pa));
+      use_b          = _mm_cmpeq_epi8(_mm_min_epu8(pb, pc), pb);
+      pred           = _mm_or_si128(_mm_and_si128(use_b, b),
+            _mm_andnot_si128(use_b, c));
+      pred           = _mm_or_si128(_mm_and_si128(use_a, a),
+            _mm_andnot_si128(use_a, pred));
+
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)), pred));
+   }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   for (; i + 16 <= width; i += 16)
+   {
+      uint8x16_t a     = vld1q_u8(line + i - bpp);
+      uint8x16_t b     = vld1q_u8(prev + i);
+      uint8x16_t c     = vld1q_u8(prev + i - bpp);
+      uint8x16_t pa    = vabdq_u8(b, c);
+      uint8x16_t pb    = vabdq_u8(a, c);
+      int16x8_t pc_lo  = vreinterpretq_s16_u16(vsubq_u16(
+               vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+               vshll_n_u8(vget_low_u8(c), 1)));
+      int16x8_t pc_hi  = vreinterpretq_s16_u16(vsubq_u16(
+               vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+               vshll_n_u8(vget_high_u8(c), 1)));
+      uint8x16_t pc    = vcombine_u8(
+            vqmovun_s16(vabsq_s16(pc_lo)),
+            vqmovun_s16(vabsq_s16(pc_hi)));
+      uint8x16_t use_a = vandq_u8(vcleq_u8(pa, pb), vcleq_u8(pa, pc));
+      uint8x16_t pred  = vbslq_u8(use_a, a,
+            vbslq_u8(vcleq_u8(pb, pc), b, c));
+
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i), pred));
+   }
+#endif
+   for (; i < width; i++)
       target[i] = line[i] - paeth(line[i - bpp], prev[i], prev[i - bpp]);
 
    return count_sad(target, width);
 }
 
-bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
-      unsigned width, unsigned height, signed pitch, unsigned bpp)
+/* A run of rows that one thread filters and deflates on its own.
+ *
+ * The output is an IDAT chunk whose data is a raw deflate stream.
+ * Every block but the last ends with a sync flush, on a byte
+ * boundary and without the final block bit, so the chunks in
+ * order still hold a single zlib stream. The first block adds the
+ * zlib header; the caller adds the checksum to the last one. */
+struct rpng_encode_block
+{
+   const uint8_t *data;    /* first row of the block */
+   const uint8_t *prev;    /* row above it, NULL at the top */
+   uint8_t *filtered;
+   uint8_t *chunk;
+   size_t filtered_size;
+   size_t chunk_size;      /* capacity, then the bytes used */
+   signed pitch;
+   unsigned width;
+   unsigned height;
+   unsigned bpp;
+   uint32_t adler;
+   uint32_t crc;
+   bool first;
+   bool last;
+   bool ok;
+};
+
+static void rpng_encode_rows(void *data)
 {
    unsigned h;
-   struct png_ihdr ihdr = {0};
-   bool ret = true;
-   const struct trans_stream_backend *stream_backend = NULL;
-   size_t encode_buf_size  = 0;
-   uint8_t *encode_buf     = NULL;
-   uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
+   struct rpng_encode_block *block = (struct rpng_encode_block*)data;
+   const struct trans_stream_backend *stream_backend =
+      trans_stream_get_zlib_deflate_backend();
+   size_t line_size        = block->width * block->bpp;
+   const uint8_t *src      = block->data;
+   uint8_t *encode_target  = block->filtered;
+   uint8_t *lines          = (uint8_t*)calloc(6, line_size);
+   uint8_t *rgba_line      = lines;
+   uint8_t *prev_encoded   = lines + line_size;
+   uint8_t *up_filtered    = lines + line_size * 2;
+   uint8_t *sub_filtered   = lines + line_size * 3;
+   uint8_t *avg_filtered   = lines + line_size * 4;
+   uint8_t *paeth_filtered = lines + line_size * 5;
+   uint8_t *deflated       = block->chunk + 8;
    void *stream            = NULL;
    uint32_t total_in       = 0;
    uint32_t total_out      = 0;
-   
-   if (!intf_s)
-      GOTO_END_ERROR();
 
-   stream_backend = trans_stream_get_zlib_deflate_backend();
+   block->ok               = false;
 
-   if (intfstream_write(intf_s, png_magic, sizeof(png_magic)) != sizeof(png_magic))
-      GOTO_END_ERROR();
-
-   ihdr.width = width;
-   ihdr.height = height;
-   ihdr.depth = 8;
-   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
-   if (!png_write_ihdr_string(intf_s, &ihdr))
-      GOTO_END_ERROR();
-
-   encode_buf_size = (width * bpp + 1) * height;
-   encode_buf      = (uint8_t*)malloc(encode_buf_size);
-   if (!encode_buf)
-      GOTO_END_ERROR();
+   if (!lines)
+      return;
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
-      GOTO_END_ERROR();
-
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
-      GOTO_END_ERROR();
+   /* Filters look at the row above, which may
+    * belong to the previous block */
+   if (block->prev)
+   {
+      if (block->bpp == sizeof(uint32_t))
+         copy_argb_line(prev_encoded, (const uint32_t*)block->prev,
+               block->width);
+      else
+         copy_bgr24_line(prev_encoded, block->prev, block->width);
+   }
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
+   for (h = 0; h < block->height;
+         h++, encode_target += line_size, src += block->pitch)
    {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
+      if (block->bpp == sizeof(uint32_t))
+         copy_argb_line(rgba_line, (const uint32_t*)src, block->width);
       else
-         copy_bgr24_line(rgba_line, data, width);
+         copy_bgr24_line(rgba_line, src, block->width);
 
       /* Try every filtering method, and choose the method
        * which has most entries as zero.
@@ -272,7 +527,9 @@ bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
        * simple to implement.
        */
       {
-         unsigned none_score  = count_sad(rgba_line, width * bpp);
+         unsigned width       = block->width;
+         unsigned bpp         = block->bpp;
+         unsigned none_score  = count_sad(rgba_line, line_size);
          unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
          unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
          unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
@@ -281,6 +538,7 @@ bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
          const uint8_t *chosen_filtered = rgba_line;
+         uint8_t *tmp         = NULL;
 
          if (sub_score < min_sad)
          {
@@ -310,58 +568,189 @@ bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
          }
 
          *encode_target++ = filter;
-         memcpy(encode_target, chosen_filtered, width * bpp);
+         memcpy(encode_target, chosen_filtered, line_size);
 
-         memcpy(prev_encoded, rgba_line, width * bpp);
+         /* This line is the previous one for the next */
+         tmp          = prev_encoded;
+         prev_encoded = rgba_line;
+         rgba_line    = tmp;
       }
    }
 
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
-   if (!deflate_buf)
-      GOTO_END_ERROR();
+   free(lines);
 
-   stream = stream_backend->stream_new();
+   block->adler = rpng_adler32(1, block->filtered, block->filtered_size);
 
-   if (!stream)
-      GOTO_END_ERROR();
+   if (block->first)
+   {
+      /* zlib header: deflate with a 32K window, no dictionary */
+      unsigned flevel = RPNG_ENCODE_LEVEL >= 7 ? 3
+         : RPNG_ENCODE_LEVEL == 6 ? 2 : RPNG_ENCODE_LEVEL >= 2 ? 1 : 0;
+      unsigned flg    = flevel << 6;
+
+      flg            += 31 - ((0x78 << 8) | flg) % 31;
+      *deflated++     = 0x78;
+      *deflated++     = (uint8_t)flg;
+   }
 
+   if (!(stream = stream_backend->stream_new()))
+      return;
+
+   stream_backend->define(stream, "level", RPNG_ENCODE_LEVEL);
+   stream_backend->define(stream, "window_bits", (uint32_t)-RPNG_ENCODE_WINDOW_BITS);
+   stream_backend->define(stream, "sync_flush", !block->last);
    stream_backend->set_in(
          stream,
-         encode_buf,
-         (unsigned)encode_buf_size);
+         block->filtered,
+         (uint32_t)block->filtered_size);
+   /* Leave room for the checksum after the last block */
    stream_backend->set_out(
          stream,
-         deflate_buf + 8,
-         (unsigned)(encode_buf_size * 2));
+         deflated,
+         (uint32_t)(block->chunk + block->chunk_size - deflated - 4));
+
+   /* The output is sized so it can't fill up, treat a full one
+    * as a failure rather than handling partial output */
+   if (     stream_backend->trans(stream, true, &total_in, &total_out, NULL)
+         && total_in  == block->filtered_size
+         && total_out <  (uint32_t)(block->chunk + block->chunk_size
+            - deflated - 4))
+   {
+      block->chunk_size = deflated + total_out - block->chunk;
+      block->ok         = true;
+
+      memcpy(block->chunk + 4, "IDAT", 4);
+      dword_write_be(block->chunk, (uint32_t)(block->chunk_size - 8));
+      /* The last CRC has to wait for the checksum */
+      if (!block->last)
+         block->crc     = encoding_crc32(0, block->chunk + 4,
+               block->chunk_size - 4);
+   }
+
+   stream_backend->stream_free(stream);
+}
+
+bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
+      unsigned width, unsigned height, signed pitch, unsigned bpp)
+{
+   unsigned i;
+   struct png_ihdr ihdr = {0};
+   bool ret = true;
+   struct rpng_encode_block blocks[RPNG_ENCODE_MAX_THREADS];
+#ifdef HAVE_THREADS
+   sthread_t *threads[RPNG_ENCODE_MAX_THREADS];
+#endif
+   unsigned num_blocks     = 1;
+   size_t line_size        = width * bpp + 1;
+   size_t encode_buf_size  = 0;
+   size_t chunk_buf_size   = 0;
+   uint8_t *encode_buf     = NULL;
+   uint8_t *chunk_buf      = NULL;
+   uint8_t *chunk_target   = NULL;
+   struct rpng_encode_block *last = NULL;
+
+   if (!intf_s)
+      GOTO_END_ERROR();
+
+   if (intfstream_write(intf_s, png_magic, sizeof(png_magic)) != sizeof(png_magic))
+      GOTO_END_ERROR();
 
-   if (!stream_backend->trans(stream, true, &total_in, &total_out, NULL))
+   ihdr.width = width;
+   ihdr.height = height;
+   ihdr.depth = 8;
+   ihdr.color_type = bpp == sizeof(uint32_t) ? 6 : 2; /* RGBA or RGB */
+   if (!png_write_ihdr_string(intf_s, &ihdr))
       GOTO_END_ERROR();
 
-   memcpy(deflate_buf + 4, "IDAT", 4);
-   dword_write_be(deflate_buf + 0,        ((uint32_t)total_out));
-   if (!png_write_idat_string(intf_s, deflate_buf, ((size_t)total_out + 8)))
+   encode_buf_size = line_size * height;
+
+#ifdef HAVE_THREADS
+   num_blocks = MIN(cpu_features_get_core_amount(), RPNG_ENCODE_MAX_THREADS);
+   num_blocks = MIN(num_blocks,
+         (unsigned)(encode_buf_size / RPNG_ENCODE_MIN_BLOCK_SIZE));
+   num_blocks = MAX(num_blocks, 1);
+#endif
+
+   /* Each block's deflate output is bounded by its input plus a
+    * little framing, chunk header and checksums included */
+   chunk_buf_size  = encode_buf_size + (encode_buf_size >> 10)
+      + num_blocks * 64;
+
+   encode_buf      = (uint8_t*)malloc(encode_buf_size);
+   chunk_buf       = (uint8_t*)malloc(chunk_buf_size);
+   if (!encode_buf || !chunk_buf)
       GOTO_END_ERROR();
 
+   chunk_target    = chunk_buf;
+   for (i = 0; i < num_blocks; i++)
+   {
+      struct rpng_encode_block *block = &blocks[i];
+      unsigned first_row              = height * i / num_blocks;
+      unsigned last_row               = height * (i + 1) / num_blocks;
+
+      block->data          = data + (ptrdiff_t)first_row * pitch;
+      block->prev          = first_row
+         ? data + (ptrdiff_t)(first_row - 1) * pitch : NULL;
+      block->filtered      = encode_buf + first_row * line_size;
+      block->filtered_size = (last_row - first_row) * line_size;
+      block->chunk         = chunk_target;
+      block->chunk_size    = block->filtered_size
+         + (block->filtered_size >> 10) + 64;
+      block->pitch         = pitch;
+      block->width         = width;
+      block->height        = last_row - first_row;
+      block->bpp           = bpp;
+      block->first         = (i == 0);
+      block->last          = (i == num_blocks - 1);
+      block->ok            = false;
+      chunk_target        += block->chunk_size;
+   }
+
+#ifdef HAVE_THREADS
+   /* Encode the first block here, and any block
+    * whose thread couldn't be started. */
+   for (i = 1; i < num_blocks; i++)
+      threads[i] = sthread_create(rpng_encode_rows, &blocks[i]);
+
+   rpng_encode_rows(&blocks[0]);
+
+   for (i = 1; i < num_blocks; i++)
+   {
+      if (threads[i])
+         sthread_join(threads[i]);
+      else
+         rpng_encode_rows(&blocks[i]);
+   }
+#else
+   rpng_encode_rows(&blocks[0]);
+#endif
+
+   for (i = 0; i < num_blocks; i++)
+      if (!blocks[i].ok)
+         GOTO_END_ERROR();
+
+   /* The zlib checksum covers the data of every block */
+   last = &blocks[num_blocks - 1];
+   for (i = 1; i < num_blocks; i++)
+      blocks[0].adler = rpng_adler32_combine(blocks[0].adler,
+            blocks[i].adler, blocks[i].filtered_size);
+
+   dword_write_be(last->chunk + last->chunk_size, blocks[0].adler);
+   last->chunk_size += 4;
+   dword_write_be(last->chunk, (uint32_t)(last->chunk_size - 8));
+   last->crc         = encoding_crc32(0, last->chunk + 4,
+         last->chunk_size - 4);
+
+   for (i = 0; i < num_blocks; i++)
+      if (!png_write_idat_string(intf_s, blocks[i].chunk,
+               blocks[i].chunk_size, blocks[i].crc))
+         GOTO_END_ERROR();
+
    if (!png_write_iend_string(intf_s))
       GOTO_END_ERROR();
 end:
    free(encode_buf);
-   free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
-
-   if (stream_backend)
-   {
-      if (stream)
-      {
-         if (stream_backend->stream_free)
-            stream_backend->stream_free(stream);
-      }
-   }
+   free(chunk_buf);
    return ret;
 }
 
@@ -21,20 +21,27 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <retro_inline.h>
+#include <retro_miscellaneous.h>
 
 #include <gfx/scaler/pixconv.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/tpool.h>
+#endif
+
 #if _MSC_VER && _MSC_VER <= 1800
 #define SCALER_NO_SIMD
 #endif
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef __AVX2__
 #endif
 
 #if defined(__SSE2__)
@@ -45,6 +52,14 @@
 #include <arm_neon.h>
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define CONV_MAX_THREADS        8
+/* Smallest number of rows worth giving to one thread */
+#define CONV_MIN_STRIP_ROWS     16
+
 void conv_rgb565_0rgb1555(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -53,6 +68,11 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint16_t *output = (uint16_t*)output_;
 
+#if defined(__AVX2__)
+   int max_width_avx2      = width - 15;
+   const __m256i hi_mask_256 = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask_256 = _mm256_set1_epi16(0x1f);
+#endif
 #if defined(__SSE2__)
    int max_width           = width - 7;
    const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
@@ -63,11 +83,20 @@ void conv_rgb565_0rgb1555(void *output_, const void *input_,
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       int w = 0;
+#if defined(__AVX2__)
+      for (; w < max_width_avx2; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask_256);
+         __m256i lo = _mm256_and_si256(in, lo_mask_256);
+         _mm256_storeu_si256((__m256i*)(output + w), _mm256_or_si256(hi, lo));
+      }
+#endif
 #if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
          const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+         __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
          __m128i lo = _mm_and_si128(in, lo_mask);
          _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
       }
@@ -91,6 +120,13 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
    const uint16_t *input   = (const uint16_t*)input_;
    uint16_t *output        = (uint16_t*)output_;
 
+#if defined(__AVX2__)
+   int max_width_avx2          = width - 15;
+   const __m256i hi_mask_256   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask_256   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask_256 = _mm256_set1_epi16(1 << 5);
+#endif
 #if defined(__SSE2__)
    int max_width           = width - 7;
 
@@ -104,6 +140,17 @@ void conv_0rgb1555_rgb565(void *output_, const void *input_,
          h++, output += out_stride >> 1, input += in_stride >> 1)
    {
       int w = 0;
+#if defined(__AVX2__)
+      for (; w < max_width_avx2; w += 16)
+      {
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i rg   = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask_256);
+         __m256i b    = _mm256_and_si256(in, lo_mask_256);
+         __m256i glow = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask_256);
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+      }
+#endif
 #if defined(__SSE2__)
       for (; w < max_width; w += 8)
       {
@@ -135,6 +182,15 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+#if defined(__AVX2__)
+   const __m256i pix_mask_r_256  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb_256 = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid_256   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi_256    = _mm256_set1_epi16(0x0210);
+   const __m256i a_256           = _mm256_set1_epi16(0x00ff);
+
+   int max_width_avx2 = width - 15;
+#endif
 #ifdef __SSE2__
    const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
    const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
@@ -142,6 +198,8 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
    const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
    const __m128i a           = _mm_set1_epi16(0x00ff);
 
+   int max_width = width - 7;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
    int max_width = width - 7;
 #endif
 
@@ -149,6 +207,39 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
          h++, output += out_stride >> 2, input += in_stride >> 1)
    {
       int w = 0;
+#if defined(__AVX2__)
+      for (; w < max_width_avx2; w += 16)
+      {
+         __m256i res_lo_bg, res_hi_bg;
+         __m256i res_lo_ra, res_hi_ra;
+         __m256i res_lo, res_hi;
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i r = _mm256_and_si256(in, pix_mask_r_256);
+         __m256i g = _mm256_and_si256(in, pix_mask_gb_256);
+         __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_gb_256);
+
+         r = _mm256_mulhi_epi16(r, mul15_hi_256);
+         g = _mm256_mulhi_epi16(g, mul15_mid_256);
+         b = _mm256_mulhi_epi16(b, mul15_mid_256);
+
+         res_lo_bg = _mm256_unpacklo_epi8(b, g);
+         res_hi_bg = _mm256_unpackhi_epi8(b, g);
+         res_lo_ra = _mm256_unpacklo_epi8(r, a_256);
+         res_hi_ra = _mm256_unpackhi_epi8(r, a_256);
+
+         /* Unpacking works within 128-bit lanes, so res_lo holds
+          * pixels 0-3 and 8-11, res_hi pixels 4-7 and 12-15. */
+         res_lo = _mm256_or_si256(res_lo_bg,
+               _mm256_slli_si256(res_lo_ra, 2));
+         res_hi = _mm256_or_si256(res_hi_bg,
+               _mm256_slli_si256(res_hi_ra, 2));
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+      }
+#endif
 #ifdef __SSE2__
       for (; w < max_width; w += 8)
       {
@@ -177,6 +268,24 @@ void conv_0rgb1555_argb8888(void *output_, const void *input_,
          _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
          _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
       }
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      for (; w < max_width; w += 8)
+      {
+         /* Move each component to the top and replicate
+          * its top bits below it, as in the C loop. */
+         uint16x8_t in = vld1q_u16(input + w);
+         uint16x8_t r  = vshlq_n_u16(in, 1);
+         uint16x8_t g  = vshlq_n_u16(in, 6);
+         uint16x8_t b  = vshlq_n_u16(in, 11);
+
+         uint8x8x4_t res;
+         res.val[3] = vdup_n_u8(0xffu);
+         res.val[2] = vshrn_n_u16(vsriq_n_u16(r, r, 5), 8);
+         res.val[1] = vshrn_n_u16(vsriq_n_u16(g, g, 5), 8);
+         res.val[0] = vshrn_n_u16(vsriq_n_u16(b, b, 5), 8);
+
+         vst4_u8((uint8_t*)(output + w), res);
+      }
 #endif
 
       for (; w < width; w++)
@@ -212,6 +321,17 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    const __m128i a          = _mm_set1_epi16(0x00ff);
 
    int max_width            = width - 7;
+#if defined(__AVX2__)
+   const __m256i pix_mask_r_256 = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g_256 = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b_256 = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r_256    = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g_256    = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b_256    = _mm256_set1_epi16(0x4200);
+   const __m256i a_256          = _mm256_set1_epi16(0x00ff);
+
+   int max_width_avx2           = width - 15;
+#endif
 #elif defined(__MMX__)
    const __m64 pix_mask_r = _mm_set1_pi16(0x1f << 10);
    const __m64 pix_mask_g = _mm_set1_pi16(0x3f << 5);
@@ -231,6 +351,37 @@ void conv_rgb565_argb8888(void *output_, const void *input_,
    {
       int w = 0;
 #if defined(__SSE2__)
+#if defined(__AVX2__)
+      for (; w < max_width_avx2; w += 16)
+      {
+         __m256i res_lo, res_hi;
+         __m256i res_lo_bg, res_hi_bg, res_lo_ra, res_hi_ra;
+         const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         __m256i        r = _mm256_and_si256(_mm256_srli_epi16(in, 1), pix_mask_r_256);
+         __m256i        g = _mm256_and_si256(in, pix_mask_g_256);
+         __m256i        b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_b_256);
+
+         r                = _mm256_mulhi_epi16(r, mul16_r_256);
+         g                = _mm256_mulhi_epi16(g, mul16_g_256);
+         b                = _mm256_mulhi_epi16(b, mul16_b_256);
+
+         res_lo_bg        = _mm256_unpacklo_epi8(b, g);
+         res_hi_bg        = _mm256_unpackhi_epi8(b, g);
+         res_lo_ra        = _mm256_unpacklo_epi8(r, a_256);
+         res_hi_ra        = _mm256_unpackhi_epi8(r, a_256);
+
+         /* Pixels 0-3 and 8-11 in res_lo, 4-7 and 12-15 in res_hi */
+         res_lo           = _mm256_or_si256(res_lo_bg,
+               _mm256_slli_si256(res_lo_ra, 2));
+         res_hi           = _mm256_or_si256(res_hi_bg,
+               _mm256_slli_si256(res_hi_ra, 2));
+
+         _mm256_storeu_si256((__m256i*)(output + w + 0),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+         _mm256_storeu_si256((__m256i*)(output + w + 8),
+               _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+      }
+#endif
       for (; w < max_width; w += 8)
       {
          __m128i res_lo, res_hi;
@@ -355,10 +506,10 @@ void conv_rgb565_abgr8888(void *output_, const void *input_,
          r                = _mm_mulhi_epi16(r, mul16_r);
          g                = _mm_mulhi_epi16(g, mul16_g);
          b                = _mm_mulhi_epi16(b, mul16_b);
-         res_lo_bg        = _mm_unpacklo_epi8(b, g);
-         res_hi_bg        = _mm_unpackhi_epi8(b, g);
-         res_lo_ra        = _mm_unpacklo_epi8(r, a);
-         res_hi_ra        = _mm_unpackhi_epi8(r, a);
+         res_lo_bg        = _mm_unpacklo_epi8(r, g);
+         res_hi_bg        = _mm_unpackhi_epi8(r, g);
+         res_lo_ra        = _mm_unpacklo_epi8(b, a);
+         res_hi_ra        = _mm_unpackhi_epi8(b, a);
          res_lo           = _mm_or_si128(res_lo_bg,
                _mm_slli_si128(res_lo_ra, 2));
          res_hi           = _mm_or_si128(res_hi_bg,
@@ -407,7 +558,7 @@ void conv_argb8888_rgba4444(void *output_, const void *input_,
    uint16_t *output      = (uint16_t*)output_;
 
    for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+         h++, output += out_stride >> 1, input += in_stride >> 2)
    {
       for (w = 0; w < width; w++)
       {
@@ -769,7 +920,7 @@ void conv_bgr24_rgb565(void *output_, const void *input_,
    const uint8_t *input = (const uint8_t*)input_;
    uint16_t *output     = (uint16_t*)output_;
    for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride)
+         h++, output += out_stride >> 1, input += in_stride)
    {
       const uint8_t *inp = input;
       for (w = 0; w < width; w++)
@@ -904,14 +1055,60 @@ void conv_argb8888_abgr8888(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
+   int h;
    const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
+#if defined(__AVX2__)
+   /* Swaps bytes 0 and 2 of every pixel */
+   const __m256i shuffle_rb = _mm256_setr_epi8(
+         2, 1, 0, 3,  6, 5, 4, 7,  10, 9, 8, 11,  14, 13, 12, 15,
+         2, 1, 0, 3,  6, 5, 4, 7,  10, 9, 8, 11,  14, 13, 12, 15);
+   int max_width_avx2       = width - 7;
+#endif
+#if defined(__SSE2__)
+   const __m128i ag_mask    = _mm_set1_epi32((int)0xff00ff00);
+   const __m128i b_mask     = _mm_set1_epi32(0x000000ff);
+   const __m128i r_mask     = _mm_set1_epi32(0x00ff0000);
+   int max_width            = width - 3;
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   int max_width            = width - 15;
+#endif
+
    for (h = 0; h < height;
          h++, output += out_stride >> 2, input += in_stride >> 2)
    {
-      for (w = 0; w < width; w++)
+      int w = 0;
+#if defined(__AVX2__)
+      for (; w < max_width_avx2; w += 8)
+      {
+         __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+         _mm256_storeu_si256((__m256i*)(output + w),
+               _mm256_shuffle_epi8(in, shuffle_rb));
+      }
+#endif
+#if defined(__SSE2__)
+      for (; w < max_width; w += 4)
+      {
+         __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+         __m128i r  = _mm_and_si128(_mm_slli_epi32(in, 16), r_mask);
+         __m128i b  = _mm_and_si128(_mm_srli_epi32(in, 16), b_mask);
+         __m128i ag = _mm_and_si128(in, ag_mask);
+         _mm_storeu_si128((__m128i*)(output + w),
+               _mm_or_si128(ag, _mm_or_si128(r, b)));
+      }
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      for (; w < max_width; w += 16)
+      {
+         uint8x16x4_t px = vld4q_u8((const uint8_t*)(input + w));
+         uint8x16_t tmp  = px.val[0];
+         px.val[0]       = px.val[2];
+         px.val[2]       = tmp;
+         vst4q_u8((uint8_t*)(output + w), px);
+      }
+#endif
+
+      for (; w < width; w++)
       {
          uint32_t col = input[w];
          output[w]    = ((col << 16) & 0xff0000) |
@@ -951,6 +1148,23 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const __m128i a             = _mm_cmpeq_epi16(
          _mm_setzero_si128(), _mm_setzero_si128());
 #endif
+#if defined(__AVX2__)
+   const __m256i mask_y_256        = _mm256_set1_epi16(0xffu);
+   const __m256i mask_u_256        = _mm256_set1_epi32(0xffu << 8);
+   const __m256i mask_v_256        = _mm256_set1_epi32(0xffu << 24);
+   const __m256i chroma_offset_256 = _mm256_set1_epi16(128);
+   const __m256i round_offset_256  = _mm256_set1_epi16(YUV_OFFSET);
+
+   const __m256i yuv_mul_256       = _mm256_set1_epi16(YUV_MAT_Y);
+   const __m256i u_g_mul_256       = _mm256_set1_epi16(YUV_MAT_U_G);
+   const __m256i u_b_mul_256       = _mm256_set1_epi16(YUV_MAT_U_B);
+   const __m256i v_r_mul_256       = _mm256_set1_epi16(YUV_MAT_V_R);
+   const __m256i v_g_mul_256       = _mm256_set1_epi16(YUV_MAT_V_G);
+   const __m256i a_256             = _mm256_set1_epi16(-1);
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+   const int16x8_t chroma_offset   = vdupq_n_s16(128);
+   const int16x8_t round_offset    = vdupq_n_s16(YUV_OFFSET);
+#endif
 
    for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
    {
@@ -958,6 +1172,90 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
       uint32_t      *dst = output;
       int              w = 0;
 
+#if defined(__AVX2__)
+      /* Same steps as the SSE2 loop below, on 32 pixels.
+       * Everything but the final stores works within 128-bit
+       * lanes, so lane 0 handles pixels 0-7 and 16-23 and
+       * lane 1 pixels 8-15 and 24-31. */
+      for (; w + 32 <= width; w += 32, src += 64, dst += 32)
+      {
+         __m256i u, v, u0_g, u1_g, u0_b, u1_b, v0_r, v1_r, v0_g, v1_g,
+                 r0, g0, b0, r1, g1, b1;
+         __m256i res_lo_bg, res_hi_bg, res_lo_ra, res_hi_ra;
+         __m256i res0, res1, res2, res3;
+         __m256i yuv0 = _mm256_loadu_si256((const __m256i*)(src +  0));
+         __m256i yuv1 = _mm256_loadu_si256((const __m256i*)(src + 32));
+
+         __m256i _y0  = _mm256_and_si256(yuv0, mask_y_256);
+         __m256i u0   = _mm256_and_si256(yuv0, mask_u_256);
+         __m256i v0   = _mm256_and_si256(yuv0, mask_v_256);
+         __m256i _y1  = _mm256_and_si256(yuv1, mask_y_256);
+         __m256i u1   = _mm256_and_si256(yuv1, mask_u_256);
+         __m256i v1   = _mm256_and_si256(yuv1, mask_v_256);
+
+         u0 = _mm256_srli_si256(u0, 1);
+         v0 = _mm256_srli_si256(v0, 3);
+         u1 = _mm256_srli_si256(u1, 1);
+         v1 = _mm256_srli_si256(v1, 3);
+         u  = _mm256_packs_epi32(u0, u1);
+         v  = _mm256_packs_epi32(v0, v1);
+
+         u  = _mm256_sub_epi16(u, chroma_offset_256);
+         v  = _mm256_sub_epi16(v, chroma_offset_256);
+
+         u0 = _mm256_unpacklo_epi16(u, u);
+         u1 = _mm256_unpackhi_epi16(u, u);
+         v0 = _mm256_unpacklo_epi16(v, v);
+         v1 = _mm256_unpackhi_epi16(v, v);
+
+         _y0  = _mm256_mullo_epi16(_y0, yuv_mul_256);
+         _y1  = _mm256_mullo_epi16(_y1, yuv_mul_256);
+         u0_g = _mm256_mullo_epi16(u0, u_g_mul_256);
+         u1_g = _mm256_mullo_epi16(u1, u_g_mul_256);
+         u0_b = _mm256_mullo_epi16(u0, u_b_mul_256);
+         u1_b = _mm256_mullo_epi16(u1, u_b_mul_256);
+         v0_r = _mm256_mullo_epi16(v0, v_r_mul_256);
+         v1_r = _mm256_mullo_epi16(v1, v_r_mul_256);
+         v0_g = _mm256_mullo_epi16(v0, v_g_mul_256);
+         v1_g = _mm256_mullo_epi16(v1, v_g_mul_256);
+
+         r0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y0, v0_r),
+                  round_offset_256), YUV_SHIFT);
+         g0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                  _mm256_adds_epi16(_y0, v0_g), u0_g), round_offset_256), YUV_SHIFT);
+         b0 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y0, u0_b),
+                  round_offset_256), YUV_SHIFT);
+
+         r1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y1, v1_r),
+                  round_offset_256), YUV_SHIFT);
+         g1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(
+                  _mm256_adds_epi16(_y1, v1_g), u1_g), round_offset_256), YUV_SHIFT);
+         b1 = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(_y1, u1_b),
+                  round_offset_256), YUV_SHIFT);
+
+         r0 = _mm256_packus_epi16(r0, r1);
+         g0 = _mm256_packus_epi16(g0, g1);
+         b0 = _mm256_packus_epi16(b0, b1);
+
+         res_lo_bg = _mm256_unpacklo_epi8(b0, g0);
+         res_hi_bg = _mm256_unpackhi_epi8(b0, g0);
+         res_lo_ra = _mm256_unpacklo_epi8(r0, a_256);
+         res_hi_ra = _mm256_unpackhi_epi8(r0, a_256);
+         res0      = _mm256_unpacklo_epi16(res_lo_bg, res_lo_ra);
+         res1      = _mm256_unpackhi_epi16(res_lo_bg, res_lo_ra);
+         res2      = _mm256_unpacklo_epi16(res_hi_bg, res_hi_ra);
+         res3      = _mm256_unpackhi_epi16(res_hi_bg, res_hi_ra);
+
+         _mm256_storeu_si256((__m256i*)(dst +  0),
+               _mm256_permute2x128_si256(res0, res1, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst +  8),
+               _mm256_permute2x128_si256(res0, res1, 0x31));
+         _mm256_storeu_si256((__m256i*)(dst + 16),
+               _mm256_permute2x128_si256(res2, res3, 0x20));
+         _mm256_storeu_si256((__m256i*)(dst + 24),
+               _mm256_permute2x128_si256(res2, res3, 0x31));
+      }
+#endif
 #if defined(__SSE2__)
       /* Each loop processes 16 pixels. */
       for (; w + 16 <= width; w += 16, src += 32, dst += 16)
@@ -1041,6 +1339,42 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
          _mm_storeu_si128((__m128i*)(dst +  8), res2);
          _mm_storeu_si128((__m128i*)(dst + 12), res3);
       }
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON))
+      /* Each loop processes 16 pixels, even and odd ones apart. */
+      for (; w + 16 <= width; w += 16, src += 32, dst += 16)
+      {
+         uint8x8x4_t res0, res1;
+         uint8x8x2_t r, g, b;
+         uint8x8x4_t yuv = vld4_u8(src); /* Y0, U, Y1, V */
+         int16x8_t _y0   = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(yuv.val[0]), 6));
+         int16x8_t _y1   = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(yuv.val[2]), 6));
+         int16x8_t u     = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yuv.val[1])), chroma_offset);
+         int16x8_t v     = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(yuv.val[3])), chroma_offset);
+
+         int16x8_t r_c   = vaddq_s16(vmulq_n_s16(v, YUV_MAT_V_R), round_offset);
+         int16x8_t g_c   = vaddq_s16(vmlaq_n_s16(vmulq_n_s16(u, YUV_MAT_U_G),
+                  v, YUV_MAT_V_G), round_offset);
+         int16x8_t b_c   = vaddq_s16(vmulq_n_s16(u, YUV_MAT_U_B), round_offset);
+
+         r = vzip_u8(vqmovun_s16(vshrq_n_s16(vaddq_s16(_y0, r_c), YUV_SHIFT)),
+                     vqmovun_s16(vshrq_n_s16(vaddq_s16(_y1, r_c), YUV_SHIFT)));
+         g = vzip_u8(vqmovun_s16(vshrq_n_s16(vaddq_s16(_y0, g_c), YUV_SHIFT)),
+                     vqmovun_s16(vshrq_n_s16(vaddq_s16(_y1, g_c), YUV_SHIFT)));
+         b = vzip_u8(vqmovun_s16(vshrq_n_s16(vaddq_s16(_y0, b_c), YUV_SHIFT)),
+                     vqmovun_s16(vshrq_n_s16(vaddq_s16(_y1, b_c), YUV_SHIFT)));
+
+         res0.val[0] = b.val[0];
+         res0.val[1] = g.val[0];
+         res0.val[2] = r.val[0];
+         res0.val[3] = vdup_n_u8(0xffu);
+         res1.val[0] = b.val[1];
+         res1.val[1] = g.val[1];
+         res1.val[2] = r.val[1];
+         res1.val[3] = res0.val[3];
+
+         vst4_u8((uint8_t*)(dst + 0), res0);
+         vst4_u8((uint8_t*)(dst + 8), res1);
+      }
 #endif
 
       /* Finish off the rest (if any) in C. */
@@ -1081,3 +1415,74 @@ void conv_copy(void *output_, const void *input_,
          h++, output += out_stride, input += in_stride)
       memcpy(output, input, copy_len);
 }
+
+#ifdef HAVE_THREADS
+struct conv_thread
+{
+   conv_func_t conv;
+   void *output;
+   const void *input;
+   int width;
+   int height;
+   int out_stride;
+   int in_stride;
+};
+
+static void conv_thread_entry(void *data)
+{
+   struct conv_thread *thr = (struct conv_thread*)data;
+
+   thr->conv(thr->output, thr->input,
+         thr->width, thr->height,
+         thr->out_stride, thr->in_stride);
+}
+#endif
+
+void conv_parallel(conv_func_t conv, void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride,
+      struct tpool *pool, unsigned threads)
+{
+#ifdef HAVE_THREADS
+   int i;
+   struct conv_thread thr[CONV_MAX_THREADS];
+
+   /* Smaller images convert about as fast on one thread
+    * as it takes to hand strips to the workers. */
+   if (width * height < CONV_THREADS_MIN_PIXELS)
+      threads = 1;
+
+   threads = MIN(threads, CONV_MAX_THREADS);
+   threads = MIN(threads, (unsigned)(height / CONV_MIN_STRIP_ROWS));
+
+   if (pool && threads > 1)
+   {
+      /* Each thread converts a strip of whole rows */
+      for (i = 0; i < (int)threads; i++)
+      {
+         int first          = height * i / (int)threads;
+         int last           = height * (i + 1) / (int)threads;
+
+         thr[i].conv        = conv;
+         thr[i].output      = (uint8_t*)output + (ptrdiff_t)first * out_stride;
+         thr[i].input       = (const uint8_t*)input + (ptrdiff_t)first * in_stride;
+         thr[i].width       = width;
+         thr[i].height      = last - first;
+         thr[i].out_stride  = out_stride;
+         thr[i].in_stride   = in_stride;
+      }
+
+      /* Convert the first strip here, and any strip
+       * the pool couldn't take. */
+      for (i = 1; i < (int)threads; i++)
+         if (!tpool_add_work(pool, conv_thread_entry, &thr[i]))
+            conv_thread_entry(&thr[i]);
+
+      conv_thread_entry(&thr[0]);
+      tpool_wait(pool);
+      return;
+   }
+#endif
+
+   conv(output, input, width, height, out_stride, in_stride);
+}
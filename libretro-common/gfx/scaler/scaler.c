@@ -25,25 +25,105 @@
 #include <string.h>
 #include <math.h>
 
+#include <retro_miscellaneous.h>
 #include <gfx/scaler/scaler.h>
 #include <gfx/scaler/scaler_int.h>
 #include <gfx/scaler/filter.h>
 #include <gfx/scaler/pixconv.h>
 
-static bool allocate_frames(struct scaler_ctx *ctx)
+#ifdef HAVE_THREADS
+#include <features/features_cpu.h>
+#include <rthreads/tpool.h>
+#endif
+
+/* The generic filter path scales strips of this many output rows
+ * at a time, horizontally and then vertically, so the rows the
+ * vertical pass reads are still in cache. */
+#define SCALER_STRIP_HEIGHT       16
+
+/* Outputs at least this large have their strips split between
+ * the calling thread and a pool of workers, which lives as long
+ * as the filter. */
+#define SCALER_THREADS_MIN_PIXELS (640 * 480)
+#define SCALER_MAX_THREADS        8
+
+static void scaler_strip_input_rows(const struct scaler_ctx *ctx,
+      int out_first, int out_last, int *in_first, int *in_last)
+{
+   int h;
+
+   *in_first = ctx->vert.filter_pos[out_first];
+   *in_last  = ctx->vert.filter_pos[out_first];
+
+   for (h = out_first + 1; h < out_last; h++)
+   {
+      if (ctx->vert.filter_pos[h] < *in_first)
+         *in_first = ctx->vert.filter_pos[h];
+      if (ctx->vert.filter_pos[h] > *in_last)
+         *in_last  = ctx->vert.filter_pos[h];
+   }
+
+   *in_last += ctx->vert.filter_len;
+}
+
+/* Starts the workers for outputs of at least @min_pixels, one fewer
+ * than the threads sharing @strips strips, since the calling thread
+ * takes a strip too. The pixel conversions use the same workers. */
+static void allocate_pool(struct scaler_ctx *ctx,
+      int min_pixels, int strips)
+{
+   ctx->scaled.threads      = 1;
+
+#ifdef HAVE_THREADS
+   if (ctx->out_width * ctx->out_height >= min_pixels)
+   {
+      ctx->scaled.threads = MAX(1, MIN(MIN(
+                  (int)cpu_features_get_core_amount(),
+                  SCALER_MAX_THREADS), strips));
+      /* Without workers, everything runs on the calling thread */
+      if (     ctx->scaled.threads > 1
+            && !(ctx->pool = tpool_create(ctx->scaled.threads - 1)))
+         ctx->scaled.threads = 1;
+   }
+#endif
+}
+
+static bool allocate_strips(struct scaler_ctx *ctx)
 {
-   uint64_t *scaled_frame = NULL;
-   ctx->scaled.stride     = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
-   ctx->scaled.width      = ctx->out_width;
-   ctx->scaled.height     = ctx->in_height;
-   scaled_frame           = (uint64_t*)calloc(sizeof(uint64_t),
-            (ctx->scaled.stride * ctx->scaled.height) >> 3);
+   int h;
+   uint64_t *scaled_frame   = NULL;
+
+   ctx->scaled.stride       = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
+   ctx->scaled.width        = ctx->out_width;
+   ctx->scaled.height       = 0;
+   ctx->scaled.strip_height = SCALER_STRIP_HEIGHT;
+
+   for (h = 0; h < ctx->out_height; h += SCALER_STRIP_HEIGHT)
+   {
+      int in_first, in_last;
+      scaler_strip_input_rows(ctx, h,
+            MIN(h + SCALER_STRIP_HEIGHT, ctx->out_height),
+            &in_first, &in_last);
+      ctx->scaled.height = MAX(ctx->scaled.height, in_last - in_first);
+   }
+
+   allocate_pool(ctx, SCALER_THREADS_MIN_PIXELS,
+         (ctx->out_height + SCALER_STRIP_HEIGHT - 1) / SCALER_STRIP_HEIGHT);
+
+   scaled_frame = (uint64_t*)calloc(sizeof(uint64_t),
+         (ctx->scaled.stride * ctx->scaled.height
+          * ctx->scaled.threads) >> 3);
 
    if (!scaled_frame)
       return false;
 
-   ctx->scaled.frame      = scaled_frame;
+   ctx->scaled.frame = scaled_frame;
 
+   return true;
+}
+
+static bool allocate_frames(struct scaler_ctx *ctx)
+{
    if (ctx->in_fmt != SCALER_FMT_ARGB8888)
    {
       uint32_t *input_frame = NULL;
@@ -201,6 +281,8 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
          if (!ctx->direct_pixconv)
             return false;
       }
+
+      allocate_pool(ctx, CONV_THREADS_MIN_PIXELS, ctx->out_height);
    }
    else
    {
@@ -261,6 +343,9 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 
       if (!scaler_gen_filter(ctx))
          return false;
+
+      if (!allocate_strips(ctx))
+         return false;
    }
 
    return true;
@@ -268,6 +353,12 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 {
+#ifdef HAVE_THREADS
+   if (ctx->pool)
+      tpool_destroy(ctx->pool);
+#endif
+   ctx->pool                = NULL;
+
    if (ctx->horiz.filter)
       free(ctx->horiz.filter);
    if (ctx->horiz.filter_pos)
@@ -297,6 +388,8 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
    ctx->scaled.width        = 0;
    ctx->scaled.height       = 0;
    ctx->scaled.stride       = 0;
+   ctx->scaled.strip_height = 0;
+   ctx->scaled.threads      = 0;
 
    ctx->input.frame         = NULL;
    ctx->input.stride        = 0;
@@ -305,6 +398,115 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
    ctx->output.stride       = 0;
 }
 
+static void scaler_ctx_scale_strips(const struct scaler_ctx *ctx,
+      void *output, const void *input_frame, void *output_frame,
+      int input_stride, int output_stride,
+      int out_first, int out_last, uint64_t *scaled)
+{
+   int h;
+   /* Input rows @scaled holds from the previous strip */
+   int have_first   = 0;
+   int have_last    = 0;
+   int scaled_pitch = ctx->scaled.stride >> 3;
+
+   for (h = out_first; h < out_last; h += ctx->scaled.strip_height)
+   {
+      int in_first, in_last;
+      int keep   = 0;
+      int h_last = MIN(h + ctx->scaled.strip_height, out_last);
+
+      scaler_strip_input_rows(ctx, h, h_last, &in_first, &in_last);
+
+      /* Strips overlap by about a filter's length of input rows,
+       * which a tall filter would otherwise scale several times.
+       * Move the rows already scaled to the top instead. */
+      if (in_first >= have_first && in_first < have_last)
+      {
+         keep = MIN(have_last, in_last) - in_first;
+         if (in_first > have_first)
+            memmove(scaled, scaled + (in_first - have_first) * scaled_pitch,
+                  keep * ctx->scaled.stride);
+      }
+
+      if (in_first + keep < in_last)
+         ctx->scaler_horiz(ctx, input_frame, input_stride,
+               scaled + keep * scaled_pitch, in_first + keep, in_last);
+      ctx->scaler_vert(ctx, output_frame, output_stride,
+            scaled, in_first, h, h_last);
+
+      have_first = in_first;
+      have_last  = in_last;
+
+      /* Convert the strip while it's still in cache */
+      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+         ctx->out_pixconv((uint8_t*)output + h * ctx->out_stride,
+               (const uint8_t*)output_frame + h * output_stride,
+               ctx->out_width, h_last - h,
+               ctx->out_stride, output_stride);
+   }
+}
+
+#ifdef HAVE_THREADS
+struct scaler_thread
+{
+   const struct scaler_ctx *ctx;
+   void *output;
+   const void *input_frame;
+   void *output_frame;
+   int input_stride;
+   int output_stride;
+   int out_first;
+   int out_last;
+   uint64_t *scaled;
+};
+
+static void scaler_thread_entry(void *data)
+{
+   struct scaler_thread *thr = (struct scaler_thread*)data;
+
+   scaler_ctx_scale_strips(thr->ctx, thr->output,
+         thr->input_frame, thr->output_frame,
+         thr->input_stride, thr->output_stride,
+         thr->out_first, thr->out_last, thr->scaled);
+}
+
+static void scaler_ctx_scale_threaded(const struct scaler_ctx *ctx,
+      void *output, const void *input_frame, void *output_frame,
+      int input_stride, int output_stride)
+{
+   int i;
+   struct scaler_thread thr[SCALER_MAX_THREADS];
+   int strip_height = ctx->scaled.strip_height;
+   int strips       = (ctx->out_height + strip_height - 1) / strip_height;
+
+   for (i = 0; i < ctx->scaled.threads; i++)
+   {
+      thr[i].ctx           = ctx;
+      thr[i].output        = output;
+      thr[i].input_frame   = input_frame;
+      thr[i].output_frame  = output_frame;
+      thr[i].input_stride  = input_stride;
+      thr[i].output_stride = output_stride;
+      thr[i].out_first     = MIN(ctx->out_height,
+            strips * i / ctx->scaled.threads * strip_height);
+      thr[i].out_last      = MIN(ctx->out_height,
+            strips * (i + 1) / ctx->scaled.threads * strip_height);
+      thr[i].scaled        = ctx->scaled.frame
+         + i * ctx->scaled.height * (ctx->scaled.stride >> 3);
+   }
+
+   /* Run the first share here, and any share
+    * the pool couldn't take. */
+   for (i = 1; i < ctx->scaled.threads; i++)
+      if (!tpool_add_work(ctx->pool, scaler_thread_entry, &thr[i]))
+         scaler_thread_entry(&thr[i]);
+
+   scaler_thread_entry(&thr[0]);
+
+   tpool_wait(ctx->pool);
+}
+#endif
+
 /**
  * scaler_ctx_scale:
  * @ctx          : pointer to scaler context object.
@@ -323,9 +525,10 @@ void scaler_ctx_scale(struct scaler_ctx *ctx,
 
    if (ctx->in_fmt != SCALER_FMT_ARGB8888)
    {
-      ctx->in_pixconv(ctx->input.frame, input,
+      conv_parallel(ctx->in_pixconv, ctx->input.frame, input,
             ctx->in_width, ctx->in_height,
-            ctx->input.stride, ctx->in_stride);
+            ctx->input.stride, ctx->in_stride,
+            ctx->pool, ctx->scaled.threads);
 
       input_frame       = ctx->input.frame;
       input_stride      = ctx->input.stride;
@@ -345,15 +548,23 @@ void scaler_ctx_scale(struct scaler_ctx *ctx,
             output_stride, input_stride);
    else
    {
-      /* Take generic filter path. */
-      if (ctx->scaler_horiz)
-         ctx->scaler_horiz(ctx, input_frame, input_stride);
-      if (ctx->scaler_vert)
-         ctx->scaler_vert (ctx, output, output_stride);
+      /* Take generic filter path, which converts
+       * the output as it goes. */
+#ifdef HAVE_THREADS
+      if (ctx->scaled.threads > 1)
+         scaler_ctx_scale_threaded(ctx, output, input_frame, output_frame,
+               input_stride, output_stride);
+      else
+#endif
+         scaler_ctx_scale_strips(ctx, output, input_frame, output_frame,
+               input_stride, output_stride,
+               0, ctx->out_height, ctx->scaled.frame);
+      return;
    }
 
    if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-      ctx->out_pixconv(output, ctx->output.frame,
+      conv_parallel(ctx->out_pixconv, output, ctx->output.frame,
             ctx->out_width, ctx->out_height,
-            ctx->out_stride, ctx->output.stride);
+            ctx->out_stride, ctx->output.stride,
+            ctx->pool, ctx->scaled.threads);
 }
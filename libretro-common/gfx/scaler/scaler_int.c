@@ -26,6 +26,9 @@
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef __AVX2__
+#undef __ARM_NEON__
+#undef __ARM_NEON
 #endif
 
 #if defined(__SSE2__)
@@ -35,6 +38,14 @@
 #endif
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /* ARGB8888 scaler is split in two:
  *
  * First, horizontal scaler is applied.
@@ -58,176 +69,308 @@
  * Scaling is now complete. Channels are shifted right by 3, and saturated
  * into 8-bit values.
  *
+ * Both work on a range of rows, so the caller can run them over strips
+ * of the image that stay in cache. As every tap of the vertical filter
+ * uses the same coefficient across a row, the SIMD versions of it do
+ * several pixels at once.
+ *
  * The C version of scalers perform the exact same operations as the
  * SIMD code for testing purposes.
  */
 
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+static INLINE uint32_t scaler_argb8888_vert_pixel(
+      const struct scaler_ctx *ctx, const uint64_t *input_base_y,
+      const int16_t *filter_vert)
 {
-   int h, w, y;
-   const uint64_t      *input = ctx->scaled.frame;
-   uint32_t           *output = (uint32_t*)output_;
+   int y;
+   int16_t res_a = 0;
+   int16_t res_r = 0;
+   int16_t res_g = 0;
+   int16_t res_b = 0;
+
+   for (y = 0; y < ctx->vert.filter_len; y++,
+         input_base_y += (ctx->scaled.stride >> 3))
+   {
+      uint64_t col   = *input_base_y;
 
-   const int16_t *filter_vert = ctx->vert.filter;
+      int16_t a      = (col >> 48) & 0xffff;
+      int16_t r      = (col >> 32) & 0xffff;
+      int16_t g      = (col >> 16) & 0xffff;
+      int16_t b      = (col >>  0) & 0xffff;
+
+      int16_t coeff  = filter_vert[y];
+
+      res_a         += (a * coeff) >> 16;
+      res_r         += (r * coeff) >> 16;
+      res_g         += (g * coeff) >> 16;
+      res_b         += (b * coeff) >> 16;
+   }
+
+   res_a           >>= (7 - 2 - 2);
+   res_r           >>= (7 - 2 - 2);
+   res_g           >>= (7 - 2 - 2);
+   res_b           >>= (7 - 2 - 2);
+
+   return
+      (clamp_8bit(res_a) << 24) |
+      (clamp_8bit(res_r) << 16) |
+      (clamp_8bit(res_g) << 8)  |
+      (clamp_8bit(res_b) << 0);
+}
 
-   for (h = 0; h < ctx->out_height; h++,
+void scaler_argb8888_vert(const struct scaler_ctx *ctx,
+      void *output_, int stride,
+      const uint64_t *input, int in_first, int out_first, int out_last)
+{
+   int h, w;
+   uint32_t           *output = (uint32_t*)output_
+      + out_first * (stride >> 2);
+   const int16_t *filter_vert = ctx->vert.filter
+      + out_first * ctx->vert.filter_stride;
+   int in_stride              = ctx->scaled.stride >> 3;
+
+   for (h = out_first; h < out_last; h++,
          filter_vert += ctx->vert.filter_stride, output += stride >> 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h]
-         * (ctx->scaled.stride >> 3);
+      const uint64_t *input_base = input
+         + (ctx->vert.filter_pos[h] - in_first) * in_stride;
 
-      for (w = 0; w < ctx->out_width; w++)
+      w = 0;
+
+#if defined(__AVX2__)
+      for (; w + 4 <= ctx->out_width; w += 4)
       {
+         int y;
          const uint64_t *input_base_y = input_base + w;
-#if defined(__SSE2__)
-         __m128i final;
-         __m128i res = _mm_setzero_si128();
+         __m256i res = _mm256_setzero_si256();
 
-         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2,
-               input_base_y += (ctx->scaled.stride >> 2))
+         for (y = 0; y < ctx->vert.filter_len; y++,
+               input_base_y += in_stride)
          {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
+            __m256i coeff = _mm256_set1_epi16(filter_vert[y]);
+            __m256i col   = _mm256_loadu_si256((const __m256i*)input_base_y);
 
-            res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+            res           = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
          }
 
-         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
+         res = _mm256_srai_epi16(res, (7 - 2 - 2));
+         /* Pack each lane, then gather the two lanes' pixels */
+         res = _mm256_permute4x64_epi64(_mm256_packus_epi16(res, res), 0x08);
+
+         _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(res));
+      }
+#endif
+#if defined(__SSE2__)
+      for (; w + 2 <= ctx->out_width; w += 2)
+      {
+         int y;
+         const uint64_t *input_base_y = input_base + w;
+         __m128i res = _mm_setzero_si128();
+
+         for (y = 0; y < ctx->vert.filter_len; y++,
+               input_base_y += in_stride)
          {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
+            __m128i coeff = _mm_set1_epi16(filter_vert[y]);
+            __m128i col   = _mm_loadu_si128((const __m128i*)input_base_y);
 
             res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
          }
 
-         res       = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
-         res       = _mm_srai_epi16(res, (7 - 2 - 2));
+         res = _mm_srai_epi16(res, (7 - 2 - 2));
 
-         final     = _mm_packus_epi16(res, res);
-
-         output[w] = _mm_cvtsi128_si32(final);
-#else
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+         _mm_storel_epi64((__m128i*)(output + w), _mm_packus_epi16(res, res));
+      }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+      for (; w + 2 <= ctx->out_width; w += 2)
+      {
+         int y;
+         const uint64_t *input_base_y = input_base + w;
+         int16x8_t res = vdupq_n_s16(0);
 
          for (y = 0; y < ctx->vert.filter_len; y++,
-               input_base_y += (ctx->scaled.stride >> 3))
+               input_base_y += in_stride)
          {
-            uint64_t col   = *input_base_y;
+            int16x4_t coeff = vdup_n_s16(filter_vert[y]);
+            int16x8_t col   = vld1q_s16((const int16_t*)input_base_y);
+            int16x8_t prod  = vcombine_s16(
+                  vshrn_n_s32(vmull_s16(vget_low_s16(col),  coeff), 16),
+                  vshrn_n_s32(vmull_s16(vget_high_s16(col), coeff), 16));
 
-            int16_t a      = (col >> 48) & 0xffff;
-            int16_t r      = (col >> 32) & 0xffff;
-            int16_t g      = (col >> 16) & 0xffff;
-            int16_t b      = (col >>  0) & 0xffff;
-
-            int16_t coeff  = filter_vert[y];
-
-            res_a         += (a * coeff) >> 16;
-            res_r         += (r * coeff) >> 16;
-            res_g         += (g * coeff) >> 16;
-            res_b         += (b * coeff) >> 16;
+            res             = vqaddq_s16(prod, res);
          }
 
-         res_a           >>= (7 - 2 - 2);
-         res_r           >>= (7 - 2 - 2);
-         res_g           >>= (7 - 2 - 2);
-         res_b           >>= (7 - 2 - 2);
-
-         output[w]         =
-            (clamp_8bit(res_a) << 24) |
-            (clamp_8bit(res_r) << 16) |
-            (clamp_8bit(res_g) << 8)  |
-            (clamp_8bit(res_b) << 0);
-#endif
+         vst1_u8((uint8_t*)(output + w),
+               vqmovun_s16(vshrq_n_s16(res, (7 - 2 - 2))));
       }
+#endif
+
+      for (; w < ctx->out_width; w++)
+         output[w] = scaler_argb8888_vert_pixel(ctx, input_base + w,
+               filter_vert);
    }
 }
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+static INLINE uint64_t scaler_argb8888_horiz_pixel(
+      const struct scaler_ctx *ctx, const uint32_t *input_base_x,
+      const int16_t *filter_horiz)
 {
-   int h, w, x;
-   const uint32_t *input = (uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
-
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2,
-         output += ctx->scaled.stride >> 3)
-   {
-      const int16_t *filter_horiz = ctx->horiz.filter;
-
-      for (w = 0; w < ctx->scaled.width; w++,
-            filter_horiz += ctx->horiz.filter_stride)
-      {
-         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+   int x;
 #if defined(__SSE2__)
-         __m128i res = _mm_setzero_si128();
+   __m128i res = _mm_setzero_si128();
 #ifndef __x86_64__
-         union
-         {
-            uint32_t *u32;
-            uint64_t *u64;
-         } u;
+   union
+   {
+      uint32_t u32[2];
+      uint64_t u64;
+   } u;
 #endif
-         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
-         {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+   for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+   {
+      __m128i coeff = _mm_set_epi64x((uint16_t)filter_horiz[x + 1] * 0x0001000100010001ull, (uint16_t)filter_horiz[x + 0] * 0x0001000100010001ull);
 
-            __m128i col   = _mm_unpacklo_epi8(_mm_set_epi64x(0,
-                     ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
+      __m128i col   = _mm_unpacklo_epi8(_mm_set_epi64x(0,
+               ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
 
-            col           = _mm_slli_epi16(col, 7);
-            res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+      col           = _mm_slli_epi16(col, 7);
+      res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
 
-         for (; x < ctx->horiz.filter_len; x++)
-         {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
-            __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
+   for (; x < ctx->horiz.filter_len; x++)
+   {
+      __m128i coeff = _mm_set_epi64x(0, (uint16_t)filter_horiz[x] * 0x0001000100010001ull);
+      __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
 
-            col           = _mm_slli_epi16(col, 7);
-            res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+      col           = _mm_slli_epi16(col, 7);
+      res           = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
 
-         res              = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+   res              = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
 
 #ifdef __x86_64__
-         output[w]        = _mm_cvtsi128_si64(res);
+   return _mm_cvtsi128_si64(res);
 #else /* 32-bit doesn't have si64. Do it in two steps. */
-         u.u64    = output + w;
-         u.u32[0] = _mm_cvtsi128_si32(res);
-         u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
+   u.u32[0] = _mm_cvtsi128_si32(res);
+   u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
+   return u.u64;
 #endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   int16x4_t sum;
+   int16x8_t res = vdupq_n_s16(0);
+
+   for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+   {
+      int16x8_t col   = vreinterpretq_s16_u16(vshlq_n_u16(vmovl_u8(
+                  vreinterpret_u8_u32(vld1_u32(input_base_x + x))), 7));
+      int16x8_t prod  = vcombine_s16(
+            vshrn_n_s32(vmull_s16(vget_low_s16(col),
+                  vdup_n_s16(filter_horiz[x + 0])), 16),
+            vshrn_n_s32(vmull_s16(vget_high_s16(col),
+                  vdup_n_s16(filter_horiz[x + 1])), 16));
+
+      res             = vqaddq_s16(prod, res);
+   }
+
+   sum = vqadd_s16(vget_low_s16(res), vget_high_s16(res));
+
+   for (; x < ctx->horiz.filter_len; x++)
+   {
+      int16x4_t col   = vreinterpret_s16_u16(vshl_n_u16(vget_low_u16(vmovl_u8(
+                  vreinterpret_u8_u32(vdup_n_u32(input_base_x[x])))), 7));
+
+      sum             = vqadd_s16(vshrn_n_s32(vmull_s16(col,
+                  vdup_n_s16(filter_horiz[x])), 16), sum);
+   }
+
+   return vget_lane_u64(vreinterpret_u64_s16(sum), 0);
 #else
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+   int16_t res_a = 0;
+   int16_t res_r = 0;
+   int16_t res_g = 0;
+   int16_t res_b = 0;
 
-         for (x = 0; x < ctx->horiz.filter_len; x++)
-         {
-            uint32_t col   = input_base_x[x];
+   for (x = 0; x < ctx->horiz.filter_len; x++)
+   {
+      uint32_t col   = input_base_x[x];
 
-            int16_t a      = (col >> (24 - 7)) & (0xff << 7);
-            int16_t r      = (col >> (16 - 7)) & (0xff << 7);
-            int16_t g      = (col >> ( 8 - 7)) & (0xff << 7);
-            int16_t b      = (col << ( 0 + 7)) & (0xff << 7);
+      int16_t a      = (col >> (24 - 7)) & (0xff << 7);
+      int16_t r      = (col >> (16 - 7)) & (0xff << 7);
+      int16_t g      = (col >> ( 8 - 7)) & (0xff << 7);
+      int16_t b      = (col << ( 0 + 7)) & (0xff << 7);
 
-            int16_t coeff  = filter_horiz[x];
+      int16_t coeff  = filter_horiz[x];
 
-            res_a         += (a * coeff) >> 16;
-            res_r         += (r * coeff) >> 16;
-            res_g         += (g * coeff) >> 16;
-            res_b         += (b * coeff) >> 16;
-         }
+      res_a         += (a * coeff) >> 16;
+      res_r         += (r * coeff) >> 16;
+      res_g         += (g * coeff) >> 16;
+      res_b         += (b * coeff) >> 16;
+   }
 
-         output[w]         = (
-               (uint64_t)res_a  << 48)  |
-               ((uint64_t)res_r << 32)  |
-               ((uint64_t)res_g << 16)  |
-               ((uint64_t)res_b << 0);
+   return
+         ((uint64_t)res_a << 48) |
+         ((uint64_t)res_r << 32) |
+         ((uint64_t)res_g << 16) |
+         ((uint64_t)res_b << 0);
 #endif
+}
+
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
+      const void *input_, int stride,
+      uint64_t *output, int in_first, int in_last)
+{
+   int h, w;
+   const uint32_t *input = (const uint32_t*)input_
+      + in_first * (stride >> 2);
+
+   for (h = in_first; h < in_last; h++, input += stride >> 2,
+         output += ctx->scaled.stride >> 3)
+   {
+      const int16_t *filter_horiz = ctx->horiz.filter;
+
+      w = 0;
+
+#if defined(__AVX2__)
+      /* Two pixels at a time, one per 128-bit lane */
+      if (!(ctx->horiz.filter_len & 1))
+      {
+         for (; w + 2 <= ctx->scaled.width; w += 2,
+               filter_horiz += ctx->horiz.filter_stride * 2)
+         {
+            const uint32_t *input_base_a = input + ctx->horiz.filter_pos[w + 0];
+            const uint32_t *input_base_b = input + ctx->horiz.filter_pos[w + 1];
+            const int16_t *filter_b      = filter_horiz + ctx->horiz.filter_stride;
+            __m256i res                  = _mm256_setzero_si256();
+            int x;
+
+            for (x = 0; x < ctx->horiz.filter_len; x += 2)
+            {
+               __m256i coeff = _mm256_set_epi64x(
+                     (uint16_t)filter_b[x + 1]     * 0x0001000100010001ull,
+                     (uint16_t)filter_b[x + 0]     * 0x0001000100010001ull,
+                     (uint16_t)filter_horiz[x + 1] * 0x0001000100010001ull,
+                     (uint16_t)filter_horiz[x + 0] * 0x0001000100010001ull);
+               __m256i col   = _mm256_unpacklo_epi8(_mm256_set_epi64x(0,
+                        ((uint64_t)input_base_b[x + 1] << 32) | input_base_b[x + 0], 0,
+                        ((uint64_t)input_base_a[x + 1] << 32) | input_base_a[x + 0]),
+                     _mm256_setzero_si256());
+
+               col           = _mm256_slli_epi16(col, 7);
+               res           = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
+            }
+
+            res           = _mm256_adds_epi16(_mm256_srli_si256(res, 8), res);
+
+            _mm_storel_epi64((__m128i*)(output + w + 0),
+                  _mm256_castsi256_si128(res));
+            _mm_storel_epi64((__m128i*)(output + w + 1),
+                  _mm256_extracti128_si256(res, 1));
+         }
       }
+#endif
+
+      for (; w < ctx->scaled.width; w++,
+            filter_horiz += ctx->horiz.filter_stride)
+         output[w] = scaler_argb8888_horiz_pixel(ctx,
+               input + ctx->horiz.filter_pos[w], filter_horiz);
    }
 }
 
@@ -25,6 +25,8 @@
 
 #include <retro_common_api.h>
 
+#include <boolean.h>
+
 RETRO_BEGIN_DECLS
 
 typedef struct retro_dsp_filter retro_dsp_filter_t;
@@ -47,9 +49,47 @@ struct retro_dsp_data
    unsigned output_frames;
 };
 
+/**
+ * Runs the filter chain over @data.
+ *
+ * If the config sets "pipelined", the tail of the chain runs on a
+ * worker thread, one chunk behind the head. The output is then the
+ * previous call's input, and the first call outputs silence.
+ */
 void retro_dsp_filter_process(retro_dsp_filter_t *dsp,
       struct retro_dsp_data *data);
 
+/**
+ * How long one filter of the chain takes.
+ */
+struct retro_dsp_stage_stats
+{
+   const char *ident;
+   /* Share of real time spent in this filter,
+    * over the last second of audio. */
+   float load;
+   /* Runs on the pipeline's worker thread. */
+   bool threaded;
+};
+
+/**
+ * Fills @stats with up to @max_stats filters, in chain order.
+ *
+ * Returns: the number of filters in the chain.
+ */
+unsigned retro_dsp_filter_get_stats(retro_dsp_filter_t *dsp,
+      struct retro_dsp_stage_stats *stats, unsigned max_stats);
+
+/**
+ * Whether the chain has taken more real time than the "budget"
+ * its config sets for several seconds in a row, and can't keep
+ * up with the audio on this machine. Always false without one.
+ *
+ * Loads are wall-clock time, so they include any time the
+ * thread spent preempted.
+ */
+bool retro_dsp_filter_over_budget(retro_dsp_filter_t *dsp);
+
 RETRO_END_DECLS
 
 #endif
@@ -0,0 +1,121 @@
+/* Copyright  (C) 2010-2026 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (buffer_pool.h).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIBRETRO_BUFFER_POOL_H
+#define _LIBRETRO_BUFFER_POOL_H
+
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+#define BUFFER_POOL_MAX_BUFS 4
+
+struct slock;
+
+struct buffer_pool_buf
+{
+   void *data;
+   size_t capacity;
+   bool in_use;
+};
+
+/* A handful of reusable heap buffers. Buffers may be
+ * handed back from any thread; everything else must
+ * happen on the thread that owns the pool. */
+typedef struct buffer_pool
+{
+   struct buffer_pool_buf bufs[BUFFER_POOL_MAX_BUFS];
+   struct slock *lock;
+   unsigned count;
+} buffer_pool_t;
+
+/**
+ * buffer_pool_init:
+ * @pool  : zero-initialised or previously deinitialised pool.
+ * @count : number of buffers to keep, at most BUFFER_POOL_MAX_BUFS.
+ *
+ * Does nothing if @pool is already initialised.
+ **/
+void buffer_pool_init(buffer_pool_t *pool, unsigned count);
+
+/**
+ * buffer_pool_deinit:
+ * @pool : pool to tear down.
+ *
+ * Frees the idle buffers and the lock. Buffers still handed
+ * out are forgotten, so buffer_pool_put() won't take them
+ * back. No other thread may use @pool while this runs.
+ **/
+void buffer_pool_deinit(buffer_pool_t *pool);
+
+/**
+ * buffer_pool_get:
+ * @pool : pool to take the buffer from.
+ * @len  : size the buffer must hold.
+ *
+ * Takes a buffer of at least @len bytes from @pool, or
+ * allocates one if every pooled buffer is busy. Contents
+ * are undefined.
+ *
+ * Returns: the buffer, NULL on allocation failure.
+ **/
+void *buffer_pool_get(buffer_pool_t *pool, size_t len);
+
+/**
+ * buffer_pool_put:
+ * @pool      : pool @data may have come from.
+ * @data      : buffer to hand back.
+ * @swap      : if non-NULL, stored in place of @data.
+ * @swap_size : size of @swap.
+ *
+ * Returns @data to @pool. With @swap, @pool takes over
+ * @swap instead and the caller keeps @data.
+ *
+ * Returns: true if @data belonged to @pool. Otherwise
+ * nothing was taken over and the caller still owns
+ * both @data and @swap.
+ **/
+bool buffer_pool_put(buffer_pool_t *pool, void *data,
+      void *swap, size_t swap_size);
+
+/**
+ * buffer_pool_take:
+ * @pool : pool @data may have come from.
+ * @data : buffer from buffer_pool_get().
+ *
+ * Detaches @data from @pool, which forgets it and allocates
+ * a new buffer the next time that one would be reused. The
+ * caller then owns @data and frees it itself.
+ *
+ * Returns: true if @data belonged to @pool.
+ **/
+bool buffer_pool_take(buffer_pool_t *pool, void *data);
+
+/* Frees the pooled buffers nobody is holding on to */
+void buffer_pool_trim(buffer_pool_t *pool);
+
+RETRO_END_DECLS
+
+#endif
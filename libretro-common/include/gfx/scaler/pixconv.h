@@ -29,6 +29,10 @@
 
 RETRO_BEGIN_DECLS
 
+typedef void (*conv_func_t)(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride);
+
 void conv_0rgb1555_argb8888(void *output, const void *input,
       int width, int height,
       int out_stride, int in_stride);
@@ -105,6 +109,29 @@ void conv_copy(void *output, const void *input,
       int width, int height,
       int out_stride, int in_stride);
 
+/* Images smaller than this are always converted
+ * on the calling thread by conv_parallel(). */
+#define CONV_THREADS_MIN_PIXELS (1280 * 720)
+
+struct tpool;
+
+/**
+ * conv_parallel:
+ * @conv         : one of the converters above.
+ * @pool         : workers to share the rows with, or NULL.
+ * @threads      : number of strips to split the rows into,
+ *                 the calling thread converting one of them.
+ *
+ * Runs @conv on strips of whole rows, in parallel when built
+ * with HAVE_THREADS and the image has at least
+ * CONV_THREADS_MIN_PIXELS pixels. Strides are in bytes and
+ * may be negative.
+ **/
+void conv_parallel(conv_func_t conv, void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride,
+      struct tpool *pool, unsigned threads);
+
 RETRO_END_DECLS
 
 #endif
@@ -51,6 +51,8 @@ enum scaler_type
    SCALER_TYPE_SINC
 };
 
+struct tpool;
+
 struct scaler_filter
 {
    int16_t *filter;
@@ -62,9 +64,9 @@ struct scaler_filter
 struct scaler_ctx
 {
    void (*scaler_horiz)(const struct scaler_ctx*,
-         const void*, int);
+         const void*, int, uint64_t*, int, int);
    void (*scaler_vert)(const struct scaler_ctx*,
-         void*, int);
+         void*, int, const uint64_t*, int, int, int);
    void (*scaler_special)(const struct scaler_ctx*,
          void*, const void*, int, int, int, int, int, int);
 
@@ -79,14 +81,23 @@ struct scaler_ctx
       int stride;
    } input;
 
+   /* Horizontally scaled rows for one strip of output rows,
+    * for each thread. */
    struct
    {
       uint64_t *frame;
       int width;
       int height;
       int stride;
+      int strip_height;
+      int threads;
    } scaled;
 
+   /* Workers sharing the strips and the pixel conversions with
+    * the calling thread, when built with HAVE_THREADS and the
+    * output is large. 'scaled.threads' counts the calling thread. */
+   struct tpool *pool;
+
    struct
    {
       uint32_t *frame;
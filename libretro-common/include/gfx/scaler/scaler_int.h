@@ -29,11 +29,16 @@
 
 RETRO_BEGIN_DECLS
 
+/* Scales output rows out_first to out_last (exclusive), reading
+ * horizontally scaled rows which start at input row in_first. */
 void scaler_argb8888_vert(const struct scaler_ctx *ctx,
-      void *output, int stride);
+      void *output, int stride,
+      const uint64_t *input, int in_first, int out_first, int out_last);
 
+/* Scales input rows in_first to in_last (exclusive) horizontally. */
 void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
-      const void *input, int stride);
+      const void *input, int stride,
+      uint64_t *output, int in_first, int in_last);
 
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
       void *output, const void *input,
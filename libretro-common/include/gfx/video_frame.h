@@ -28,6 +28,7 @@
 #include <retro_inline.h>
 
 #include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
 
 #include <libretro.h>
 
@@ -37,9 +38,10 @@ RETRO_BEGIN_DECLS
 { \
    if (ctx && ctx->unscaled && ctx->direct_pixconv) \
       /* Just perform straight pixel conversion. */ \
-      ctx->direct_pixconv(output, input, \
+      conv_parallel(ctx->direct_pixconv, output, input, \
             ctx->out_width,  ctx->out_height, \
-            ctx->out_stride, ctx->in_stride); \
+            ctx->out_stride, ctx->in_stride, \
+            ctx->pool, ctx->scaled.threads); \
    else \
       scaler_ctx_scale(ctx, output, input); \
 }
@@ -67,6 +67,12 @@ RETRO_BEGIN_DECLS
  * <size of next compressed chunk> : repeated until end of file
  * <next compressed chunk>         :
  * 
+ * Each chunk is an independent zlib stream. When built
+ * with HAVE_THREADS, files of more than one chunk are
+ * compressed and decompressed several chunks at a time,
+ * on as many threads as there are CPU cores (the file
+ * format is unaffected).
+ * 
  */
 
 /* Prevent direct access to rzipstream_t members */
@@ -154,6 +160,16 @@ bool rzipstream_write_file(const char *path, const void *data, int64_t len);
  * at the end (harmless, but a waste of space). */
 void rzipstream_rewind(rzipstream_t *stream);
 
+/* Sets the position of the *uncompressed* data
+ * in an RZIP file open for reading. 'whence' is
+ * one of SEEK_SET, SEEK_CUR or SEEK_END.
+ * On first use, the offset of every chunk in the
+ * file is recorded, so that later seeks only need
+ * to inflate the chunk holding the target.
+ * Returns 0 on success, or -1 in the event
+ * of an error (or if file is open for writing) */
+int64_t rzipstream_seek(rzipstream_t *stream, int64_t offset, int whence);
+
 /* File Status */
 
 /* Returns total size (in bytes) of the *uncompressed*
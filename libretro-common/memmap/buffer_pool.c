@@ -0,0 +1,186 @@
+/* Copyright  (C) 2010-2026 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (buffer_pool.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include <buffer_pool.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+
+#define BUFFER_POOL_LOCK(pool) \
+   if ((pool)->lock) \
+      slock_lock((pool)->lock)
+#define BUFFER_POOL_UNLOCK(pool) \
+   if ((pool)->lock) \
+      slock_unlock((pool)->lock)
+#else
+#define BUFFER_POOL_LOCK(pool)
+#define BUFFER_POOL_UNLOCK(pool)
+#endif
+
+void buffer_pool_init(buffer_pool_t *pool, unsigned count)
+{
+   if (pool->count)
+      return;
+   if (count > BUFFER_POOL_MAX_BUFS)
+      count   = BUFFER_POOL_MAX_BUFS;
+#ifdef HAVE_THREADS
+   pool->lock = slock_new();
+#endif
+   pool->count = count;
+}
+
+void buffer_pool_deinit(buffer_pool_t *pool)
+{
+   unsigned i;
+
+   for (i = 0; i < BUFFER_POOL_MAX_BUFS; i++)
+   {
+      struct buffer_pool_buf *buf = &pool->bufs[i];
+      if (!buf->in_use)
+         free(buf->data);
+      buf->data     = NULL;
+      buf->capacity = 0;
+      buf->in_use   = false;
+   }
+
+#ifdef HAVE_THREADS
+   if (pool->lock)
+      slock_free(pool->lock);
+#endif
+   pool->lock  = NULL;
+   pool->count = 0;
+}
+
+void *buffer_pool_get(buffer_pool_t *pool, size_t len)
+{
+   unsigned i;
+   struct buffer_pool_buf *buf = NULL;
+
+   BUFFER_POOL_LOCK(pool);
+   /* Prefer a buffer that is already big enough */
+   for (i = 0; i < pool->count; i++)
+   {
+      if (pool->bufs[i].in_use)
+         continue;
+      if (!buf || pool->bufs[i].capacity >= len)
+         buf = &pool->bufs[i];
+      if (buf->capacity >= len)
+         break;
+   }
+   if (buf)
+      buf->in_use = true;
+   BUFFER_POOL_UNLOCK(pool);
+
+   if (!buf)
+      return malloc(len);
+
+   /* Only the owner of an in-use buffer touches it,
+    * so this can grow it without holding the lock */
+   if (buf->capacity < len)
+   {
+      free(buf->data);
+      buf->capacity = 0;
+      if (!(buf->data = malloc(len)))
+      {
+         BUFFER_POOL_LOCK(pool);
+         buf->in_use = false;
+         BUFFER_POOL_UNLOCK(pool);
+         return NULL;
+      }
+      buf->capacity = len;
+   }
+
+   return buf->data;
+}
+
+bool buffer_pool_put(buffer_pool_t *pool, void *data,
+      void *swap, size_t swap_size)
+{
+   unsigned i;
+   bool pooled = false;
+
+   if (!data)
+      return false;
+
+   BUFFER_POOL_LOCK(pool);
+   for (i = 0; i < pool->count; i++)
+   {
+      struct buffer_pool_buf *buf = &pool->bufs[i];
+      if (!buf->in_use || buf->data != data)
+         continue;
+      if (swap)
+      {
+         buf->data     = swap;
+         buf->capacity = swap_size;
+      }
+      buf->in_use = false;
+      pooled      = true;
+      break;
+   }
+   BUFFER_POOL_UNLOCK(pool);
+
+   return pooled;
+}
+
+bool buffer_pool_take(buffer_pool_t *pool, void *data)
+{
+   unsigned i;
+   bool pooled = false;
+
+   if (!data)
+      return false;
+
+   BUFFER_POOL_LOCK(pool);
+   for (i = 0; i < pool->count; i++)
+   {
+      struct buffer_pool_buf *buf = &pool->bufs[i];
+      if (!buf->in_use || buf->data != data)
+         continue;
+      buf->data     = NULL;
+      buf->capacity = 0;
+      buf->in_use   = false;
+      pooled        = true;
+      break;
+   }
+   BUFFER_POOL_UNLOCK(pool);
+
+   return pooled;
+}
+
+void buffer_pool_trim(buffer_pool_t *pool)
+{
+   unsigned i;
+
+   BUFFER_POOL_LOCK(pool);
+   for (i = 0; i < pool->count; i++)
+   {
+      struct buffer_pool_buf *buf = &pool->bufs[i];
+      if (buf->in_use)
+         continue;
+      free(buf->data);
+      buf->data     = NULL;
+      buf->capacity = 0;
+   }
+   BUFFER_POOL_UNLOCK(pool);
+}
@@ -63,7 +63,8 @@ static tpool_work_t *tpool_work_create(thread_func_t func, void *arg)
    if (!func)
       return NULL;
 
-   work       = (tpool_work_t*)calloc(1, sizeof(*work));
+   if (!(work = (tpool_work_t*)calloc(1, sizeof(*work))))
+      return NULL;
    work->func = func;
    work->arg  = arg;
    work->next = NULL;
@@ -164,8 +165,8 @@ tpool_t *tpool_create(size_t num)
    if (num == 0)
       num = 2;
 
-   tp               = (tpool_t*)calloc(1, sizeof(*tp));
-   tp->thread_cnt   = num;
+   if (!(tp = (tpool_t*)calloc(1, sizeof(*tp))))
+      return NULL;
 
    tp->work_mutex   = slock_new();
    tp->work_cond    = scond_new();
@@ -174,14 +175,35 @@ tpool_t *tpool_create(size_t num)
    tp->work_first   = NULL;
    tp->work_last    = NULL;
 
+   if (!tp->work_mutex || !tp->work_cond || !tp->working_cond)
+      goto error;
+
    /* Create the requested number of thread and detach them. */
    for (i = 0; i < num; i++)
    {
-      thread = sthread_create(tpool_worker, tp);
+      if (!(thread = sthread_create(tpool_worker, tp)))
+         break;
+      slock_lock(tp->work_mutex);
+      tp->thread_cnt++;
+      slock_unlock(tp->work_mutex);
       sthread_detach(thread);
    }
 
+   /* A pool without threads would never do its work */
+   if (!tp->thread_cnt)
+      goto error;
+
    return tp;
+
+error:
+   if (tp->work_mutex)
+      slock_free(tp->work_mutex);
+   if (tp->work_cond)
+      scond_free(tp->work_cond);
+   if (tp->working_cond)
+      scond_free(tp->working_cond);
+   free(tp);
+   return NULL;
 }
 
 void tpool_destroy(tpool_t *tp)
@@ -257,8 +279,11 @@ void tpool_wait(tpool_t *tp)
    {
       /* working_cond is dual use. It signals when we're not stopping but the
        * working_cnt is 0 indicating there isn't any work processing. If we
-       * are stopping it will trigger when there aren't any threads running. */
-      if ((!tp->stop && tp->working_cnt != 0) || (tp->stop && tp->thread_cnt != 0))
+       * are stopping it will trigger when there aren't any threads running.
+       * Work still in the queue counts too, no thread may have woken for it
+       * yet. */
+      if (     (!tp->stop && (tp->working_cnt != 0 || tp->work_first))
+            || ( tp->stop && tp->thread_cnt != 0))
          scond_wait(tp->working_cond, tp->work_mutex);
       else
          break;
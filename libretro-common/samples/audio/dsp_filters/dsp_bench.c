@@ -0,0 +1,222 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (dsp_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Reports how long each DSP filter plugin takes per sample,
+ * with its default settings, to see how many can be stacked
+ * on a given box.
+ *
+ * Every plugin is fed the same noise, a chunk at a time, at
+ * 48 kHz. Times are the best of a few runs.
+ *
+ *    dsp_bench [seconds of audio per run] [plugin...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <features/features_cpu.h>
+#include <libretro_dspfilter.h>
+
+#define BENCH_RATE   48000.0f
+#define BENCH_CHUNK  1024
+#define BENCH_RUNS   5
+
+extern const struct dspfilter_implementation *
+chorus_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+delta_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+echo_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+eq_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+iir_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+panning_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+phaser_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+reverb_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+tremolo_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+vibrato_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+extern const struct dspfilter_implementation *
+wahwah_dspfilter_get_implementation(dspfilter_simd_mask_t mask);
+
+static const dspfilter_get_implementation_t plugs[] = {
+   chorus_dspfilter_get_implementation,
+   delta_dspfilter_get_implementation,
+   echo_dspfilter_get_implementation,
+   eq_dspfilter_get_implementation,
+   iir_dspfilter_get_implementation,
+   panning_dspfilter_get_implementation,
+   phaser_dspfilter_get_implementation,
+   reverb_dspfilter_get_implementation,
+   tremolo_dspfilter_get_implementation,
+   vibrato_dspfilter_get_implementation,
+   wahwah_dspfilter_get_implementation,
+};
+
+/* No .dsp file, every plugin gets its defaults */
+static int bench_get_float(void *userdata, const char *key,
+      float *value, float default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_int(void *userdata, const char *key,
+      int *value, int default_value)
+{
+   *value = default_value;
+   return 0;
+}
+
+static int bench_get_float_array(void *userdata, const char *key,
+      float **values, unsigned *out_num_values,
+      const float *default_values, unsigned num_default_values)
+{
+   *values         = (float*)malloc(num_default_values * sizeof(float));
+   *out_num_values = *values ? num_default_values : 0;
+   if (*values)
+      memcpy(*values, default_values, num_default_values * sizeof(float));
+   return 0;
+}
+
+static int bench_get_int_array(void *userdata, const char *key,
+      int **values, unsigned *out_num_values,
+      const int *default_values, unsigned num_default_values)
+{
+   *values         = (int*)malloc(num_default_values * sizeof(int));
+   *out_num_values = *values ? num_default_values : 0;
+   if (*values)
+      memcpy(*values, default_values, num_default_values * sizeof(int));
+   return 0;
+}
+
+static int bench_get_string(void *userdata, const char *key,
+      char **output, const char *default_output)
+{
+   *output = default_output ? strdup(default_output) : NULL;
+   return 0;
+}
+
+static const struct dspfilter_config bench_config = {
+   bench_get_float,
+   bench_get_int,
+   bench_get_float_array,
+   bench_get_int_array,
+   bench_get_string,
+   free,
+};
+
+static float noise[BENCH_CHUNK * 2];
+static float work[BENCH_CHUNK * 2];
+
+/* Returns the best time in nanoseconds per sample */
+static double bench_plug(const struct dspfilter_implementation *impl,
+      double seconds)
+{
+   unsigned run;
+   struct dspfilter_info info;
+   double best  = 0.0;
+   size_t calls = (size_t)(seconds * BENCH_RATE / BENCH_CHUNK);
+   void *handle;
+
+   info.input_rate = BENCH_RATE;
+   if (!(handle = impl->init(&info, &bench_config, NULL)))
+      return 0.0;
+   if (!calls)
+      calls = 1;
+
+   for (run = 0; run < BENCH_RUNS; run++)
+   {
+      size_t i;
+      double ns;
+      retro_time_t start = cpu_features_get_time_usec();
+
+      for (i = 0; i < calls; i++)
+      {
+         struct dspfilter_input  in;
+         struct dspfilter_output out;
+
+         /* The plugins work in place, refill what they overwrote.
+          * Output starts out as the input, like in the frontend */
+         memcpy(work, noise, sizeof(work));
+         in.samples  = work;
+         in.frames   = BENCH_CHUNK;
+         out.samples = work;
+         out.frames  = BENCH_CHUNK;
+         impl->process(handle, &out, &in);
+      }
+
+      ns = (double)(cpu_features_get_time_usec() - start) * 1000.0
+         / ((double)calls * BENCH_CHUNK * 2);
+      if (!run || ns < best)
+         best = ns;
+   }
+
+   impl->free(handle);
+   return best;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   int j;
+   double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+
+   if (seconds <= 0.0)
+   {
+      fprintf(stderr, "Usage: %s [seconds of audio per run] [plugin...]\n",
+            argv[0]);
+      return 1;
+   }
+
+   for (i = 0; i < BENCH_CHUNK * 2; i++)
+      noise[i] = (float)((rand() & 0xffff) - 0x8000) / 0x10000;
+
+   printf("%-12s %10s %10s\n", "plugin", "ns/sample", "realtime");
+
+   for (i = 0; i < sizeof(plugs) / sizeof(plugs[0]); i++)
+   {
+      double ns;
+      const struct dspfilter_implementation *impl = plugs[i](
+            (dspfilter_simd_mask_t)cpu_features_get());
+      bool wanted = argc <= 2;
+
+      for (j = 2; j < argc; j++)
+         if (!strcmp(argv[j], impl->short_ident))
+            wanted = true;
+
+      if (!wanted)
+         continue;
+
+      ns = bench_plug(impl, seconds);
+      printf("%-12s %10.2f %9.0fx\n", impl->short_ident, ns,
+            ns > 0.0 ? 1e9 / (ns * BENCH_RATE * 2.0) : 0.0);
+   }
+
+   return 0;
+}
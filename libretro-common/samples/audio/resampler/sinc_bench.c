@@ -0,0 +1,293 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (sinc_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Compares the interpolating and the fixed ratio paths of the
+ * sinc resampler, for common input rates and the Kaiser qualities.
+ *
+ * Speed is measured with one frame's worth of input per call and
+ * the ratio wandering by up to 0.5%, like rate control does.
+ * Accuracy is the SNR of a resampled sine at the requested ratio,
+ * against a least squares fit of the expected output sine. It's
+ * fed a frame's worth per call too, so a fixed ratio path snapped
+ * to a nearby fraction pays for the step it carries between calls.
+ *
+ *    sinc_bench [seconds of audio per run]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <features/features_cpu.h>
+
+/* The bench needs to pick the path, which isn't exposed */
+#include "../../../audio/resampler/drivers/sinc_resampler.c"
+
+#define BENCH_CHUNK_FRAMES 2048
+#define BENCH_SNR_FRAMES   (BENCH_CHUNK_FRAMES * 16)
+#define BENCH_RUNS         16
+
+struct bench_rates
+{
+   double in;
+   double out;
+};
+
+static const struct bench_rates rates[] = {
+   { 32040.0, 48000.0 }, /* SNES */
+   { 31987.33, 48000.0 }, /* SNES, skewed to a 60 Hz display */
+   { 44100.0, 48000.0 },
+   { 44144.14, 48000.0 }, /* 59.94 fps core, skewed to 60 Hz */
+   { 48000.0, 44100.0 },
+   { 32000.0, 48000.0 },
+};
+
+static const struct
+{
+   const char *name;
+   enum resampler_quality quality;
+} qualities[] = {
+   { "normal",  RESAMPLER_QUALITY_NORMAL  },
+   { "higher",  RESAMPLER_QUALITY_HIGHER  },
+   { "highest", RESAMPLER_QUALITY_HIGHEST },
+};
+
+static void bench_noise(float *input)
+{
+   size_t i;
+   for (i = 0; i < BENCH_CHUNK_FRAMES * 2; i++)
+      input[i] = (float)((rand() & 0xffff) - 0x8000) / 0x8000;
+}
+
+static void *bench_new(double ratio, enum resampler_quality quality,
+      bool fixed_ratio, resampler_process_t *process)
+{
+   void *re = resampler_sinc_init(ratio, quality,
+         (resampler_simd_mask_t)cpu_features_get(), fixed_ratio);
+   /* The process function is global, grab it for this instance */
+   *process = sinc_resampler.process;
+   return re;
+}
+
+/* Returns the audio seconds resampled per second,
+ * the best of a few runs to ride out scheduling noise */
+static double bench_speed(const struct bench_rates *r,
+      enum resampler_quality quality, bool fixed_ratio, double seconds,
+      const float *input, float *output)
+{
+   unsigned i, run;
+   resampler_process_t process;
+   double ratio       = r->out / r->in;
+   double best        = 0.0;
+   unsigned chunk     = (unsigned)(r->in / 60.0);
+   unsigned calls     = (unsigned)(seconds * 60.0 / BENCH_RUNS);
+   void *re           = bench_new(ratio, quality, fixed_ratio, &process);
+
+   if (!re)
+      return 0.0;
+   if (!calls)
+      calls = 1;
+
+   for (run = 0; run < BENCH_RUNS; run++)
+   {
+      double speed;
+      retro_time_t start = cpu_features_get_time_usec();
+
+      for (i = 0; i < calls; i++)
+      {
+         struct resampler_data data;
+
+         data.data_in      = input;
+         data.data_out     = output;
+         data.input_frames = chunk;
+         data.ratio        = ratio * (1.0 + 0.005 * sin(i * 0.05));
+         process(re, &data);
+      }
+
+      speed = calls / 60.0 * 1000000.0
+         / (double)(cpu_features_get_time_usec() - start);
+      if (speed > best)
+         best = speed;
+   }
+
+   resampler_sinc_free(re);
+   return best;
+}
+
+/* SNR in dB of a sine at @freq Hz, resampled by @ratio */
+static double bench_snr(const struct bench_rates *r, double ratio,
+      enum resampler_quality quality, bool fixed_ratio, double freq,
+      float *input, float *output)
+{
+   unsigned i;
+   resampler_process_t process;
+   double m[3][3]     = {{0}};
+   double v[3]        = {0};
+   double coef[3];
+   double sig         = 0.0;
+   double err         = 0.0;
+   double w_in        = 2.0 * M_PI * freq / r->in;
+   double w_out       = w_in / ratio;
+   unsigned chunk     = (unsigned)(r->in / 60.0);
+   unsigned calls     = BENCH_SNR_FRAMES / chunk;
+   size_t total       = 0;
+   size_t skip        = 0;
+   void *re           = bench_new(ratio, quality, fixed_ratio, &process);
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re;
+
+   if (!re)
+      return 0.0;
+
+   skip  = (size_t)(resamp->taps * (ratio > 1.0 ? ratio : 1.0)) * 2;
+
+   for (i = 0; i < calls; i++)
+   {
+      size_t j;
+      struct resampler_data data;
+
+      for (j = 0; j < chunk; j++)
+      {
+         double t          = (double)i * chunk + j;
+         input[j * 2 + 0]  = (float)(0.5 * sin(w_in * t));
+         input[j * 2 + 1]  = input[j * 2 + 0];
+      }
+
+      data.data_in      = input;
+      data.data_out     = output + total * 2;
+      data.input_frames = chunk;
+      data.ratio        = ratio;
+      process(re, &data);
+      total            += data.output_frames;
+   }
+
+   /* Fit a * sin + b * cos + c, solving the normal equations */
+   for (i = skip; i < total; i++)
+   {
+      unsigned a, b;
+      double basis[3];
+      basis[0] = sin(w_out * i);
+      basis[1] = cos(w_out * i);
+      basis[2] = 1.0;
+      for (a = 0; a < 3; a++)
+      {
+         for (b = 0; b < 3; b++)
+            m[a][b] += basis[a] * basis[b];
+         v[a] += basis[a] * output[i * 2];
+      }
+   }
+
+   {
+      double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                 - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                 + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+      unsigned c;
+      for (c = 0; c < 3; c++)
+      {
+         double mc[3][3];
+         unsigned a;
+         for (a = 0; a < 3; a++)
+         {
+            mc[a][0] = m[a][0];
+            mc[a][1] = m[a][1];
+            mc[a][2] = m[a][2];
+            mc[a][c] = v[a];
+         }
+         coef[c] = (mc[0][0] * (mc[1][1] * mc[2][2] - mc[1][2] * mc[2][1])
+                  - mc[0][1] * (mc[1][0] * mc[2][2] - mc[1][2] * mc[2][0])
+                  + mc[0][2] * (mc[1][0] * mc[2][1] - mc[1][1] * mc[2][0]))
+                  / det;
+      }
+   }
+
+   for (i = skip; i < total; i++)
+   {
+      double fit = coef[0] * sin(w_out * i) + coef[1] * cos(w_out * i)
+         + coef[2];
+      double d   = output[i * 2] - fit;
+      sig       += fit * fit;
+      err       += d * d;
+   }
+
+   resampler_sinc_free(re);
+   return 10.0 * log10(sig / (err > 0.0 ? err : 1e-30));
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i, j;
+   double seconds = argc > 1 ? atof(argv[1]) : 4.0;
+   float *input   = (float*)calloc(BENCH_CHUNK_FRAMES * 2, sizeof(float));
+   /* Room for 16 chunks upsampled 2x, and then some */
+   float *output  = (float*)calloc(BENCH_CHUNK_FRAMES * 2 * 16 * 4,
+         sizeof(float));
+   int failed     = 0;
+
+   if (!input || !output || seconds <= 0.0)
+   {
+      fprintf(stderr, "Usage: %s [seconds of audio per run]\n", argv[0]);
+      return 1;
+   }
+
+   bench_noise(input);
+
+   printf("%-20s %-8s %6s %10s %10s %7s %8s %8s\n",
+         "rates", "quality", "phases",
+         "interp", "fixed", "speedup", "interp", "fixed");
+
+   for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+   {
+      for (j = 0; j < sizeof(qualities) / sizeof(qualities[0]); j++)
+      {
+         char name[32];
+         double speed_i, speed_f, snr_i, snr_f;
+         const struct bench_rates *r = &rates[i];
+         enum resampler_quality q    = qualities[j].quality;
+         double freq                 = 0.3 * r->in;
+         unsigned phases             = sinc_fixed_ratio_phases(r->out / r->in);
+
+         if (!phases)
+            phases                   = sinc_snapped_ratio_phases(r->out / r->in);
+
+         speed_i = bench_speed(r, q, false, seconds, input, output);
+         speed_f = bench_speed(r, q, true,  seconds, input, output);
+         snr_i   = bench_snr(r, r->out / r->in, q, false, freq,
+               input, output);
+         snr_f   = bench_snr(r, r->out / r->in, q, true,  freq,
+               input, output);
+
+         bench_noise(input);
+
+         snprintf(name, sizeof(name), "%.0f -> %.0f", r->in, r->out);
+         printf("%-20s %-8s %6u %8.0fx %8.0fx %6.2fx %5.1f dB %5.1f dB\n",
+               name, qualities[j].name, phases,
+               speed_i, speed_f, speed_f / speed_i, snr_i, snr_f);
+
+         /* The fixed path must not be less accurate */
+         if (snr_f < snr_i - 1.0)
+            failed = 1;
+      }
+   }
+
+   free(input);
+   free(output);
+   return failed;
+}
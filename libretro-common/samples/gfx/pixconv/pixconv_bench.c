@@ -0,0 +1,177 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (pixconv_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Times the converters in pixconv.c on one thread, then split
+ * between a thread pool and the calling thread with
+ * conv_parallel(), and checks that both give the same output.
+ * conv_parallel() stays on one thread below
+ * CONV_THREADS_MIN_PIXELS, so the default size is 4K.
+ *
+ *    pixconv_bench [width] [height] [threads] [milliseconds]
+ *
+ * 'make' builds the default SIMD kernels (SSE2 on x86_64),
+ * 'make clean && make AVX2=1' the AVX2 ones. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <boolean.h>
+#include <features/features_cpu.h>
+#include <gfx/scaler/pixconv.h>
+#include <rthreads/tpool.h>
+
+struct bench_conv
+{
+   const char *name;
+   conv_func_t conv;
+   unsigned in_bpp;
+   unsigned out_bpp;
+};
+
+static const struct bench_conv convs[] = {
+   { "rgb565_argb8888",   conv_rgb565_argb8888,   2, 4 },
+   { "0rgb1555_argb8888", conv_0rgb1555_argb8888, 2, 4 },
+   { "yuyv_argb8888",     conv_yuyv_argb8888,     2, 4 },
+   { "argb8888_abgr8888", conv_argb8888_abgr8888, 4, 4 },
+   { "rgb565_0rgb1555",   conv_rgb565_0rgb1555,   2, 2 },
+   { "0rgb1555_rgb565",   conv_0rgb1555_rgb565,   2, 2 },
+   { "rgb565_bgr24",      conv_rgb565_bgr24,      2, 3 },
+   { "argb8888_bgr24",    conv_argb8888_bgr24,    4, 3 },
+   { "argb8888_0rgb1555", conv_argb8888_0rgb1555, 4, 2 },
+   { "copy",              conv_copy,              4, 4 },
+};
+
+/* Returns the input megapixels per second */
+static double bench_run(const struct bench_conv *c,
+      void *output, const void *input,
+      int width, int height, tpool_t *pool, unsigned threads,
+      unsigned msec)
+{
+   unsigned runs       = 0;
+   retro_time_t start  = cpu_features_get_time_usec();
+   retro_time_t now    = start;
+
+   do
+   {
+      conv_parallel(c->conv, output, input, width, height,
+            width * c->out_bpp, width * c->in_bpp, pool, threads);
+      runs++;
+      now = cpu_features_get_time_usec();
+   } while (now - start < (retro_time_t)msec * 1000);
+
+   return (double)width * height * runs / (double)(now - start);
+}
+
+static const char *simd_name(void)
+{
+#if defined(__AVX2__)
+   return "AVX2";
+#elif defined(__SSE2__)
+   return "SSE2";
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+   return "NEON";
+#else
+   return "C";
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   int width        = argc > 1 ? atoi(argv[1]) : 3840;
+   int height       = argc > 2 ? atoi(argv[2]) : 2160;
+   unsigned threads = argc > 3 ? (unsigned)atoi(argv[3])
+      : cpu_features_get_core_amount();
+   unsigned msec    = argc > 4 ? (unsigned)atoi(argv[4]) : 500;
+   size_t pixels    = (size_t)width * height;
+   uint8_t *input   = NULL;
+   uint8_t *out1    = NULL;
+   uint8_t *outn    = NULL;
+   tpool_t *pool    = NULL;
+   int failed       = 0;
+
+   if (width < 2 || height < 1 || !threads)
+   {
+      fprintf(stderr,
+            "Usage: %s [width] [height] [threads] [milliseconds]\n", argv[0]);
+      return 1;
+   }
+
+   /* YUYV works on pairs of pixels */
+   width &= ~1;
+   pixels = (size_t)width * height;
+
+   input  = (uint8_t*)malloc(pixels * 4);
+   out1   = (uint8_t*)malloc(pixels * 4);
+   outn   = (uint8_t*)malloc(pixels * 4);
+
+   /* The calling thread converts a strip as well */
+   if (threads > 1)
+      pool = tpool_create(threads - 1);
+
+   if (!input || !out1 || !outn || (threads > 1 && !pool))
+   {
+      fprintf(stderr, "Out of memory.\n");
+      return 1;
+   }
+
+   srand(1);
+   for (i = 0; i < pixels * 4; i++)
+      input[i] = (uint8_t)rand();
+
+   printf("%dx%d, %s kernels, %u thread(s)\n\n",
+         width, height, simd_name(), threads);
+   printf("%-20s %12s %12s %8s\n",
+         "converter", "1 thread", "threaded", "speedup");
+
+   for (i = 0; i < sizeof(convs) / sizeof(convs[0]); i++)
+   {
+      const struct bench_conv *c = &convs[i];
+      size_t out_size            = pixels * c->out_bpp;
+      double single, multi;
+      bool same;
+
+      memset(out1, 0, out_size);
+      memset(outn, 0xff, out_size);
+
+      single = bench_run(c, out1, input, width, height, NULL, 1, msec);
+      multi  = bench_run(c, outn, input, width, height,
+            pool, threads, msec);
+      same   = !memcmp(out1, outn, out_size);
+
+      printf("%-20s %7.1f Mp/s %7.1f Mp/s %7.2fx%s\n", c->name,
+            single, multi, multi / single, same ? "" : "  MISMATCH");
+
+      if (!same)
+         failed = 1;
+   }
+
+   if (pool)
+      tpool_destroy(pool);
+   free(input);
+   free(out1);
+   free(outn);
+
+   return failed;
+}
@@ -302,8 +302,11 @@ int64_t intfstream_seek(
          break;
 #endif
       case INTFSTREAM_RZIP:
-         /* Unsupported */
+#if defined(HAVE_ZLIB)
+         return rzipstream_seek(intf->rzip.fp, offset, whence);
+#else
          break;
+#endif
    }
 
    return -1;
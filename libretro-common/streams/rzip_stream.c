@@ -28,6 +28,11 @@
 
 #include <streams/rzip_stream.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
+
 /* Current RZIP file format version */
 #define RZIP_VERSION 1
 
@@ -44,6 +49,34 @@
 #define RZIP_HEADER_SIZE 20
 #define RZIP_CHUNK_HEADER_SIZE 4
 
+/* Maximum number of chunks (de)compressed
+ * in parallel */
+#define RZIP_MAX_JOBS 8
+
+/* Chunks are independent zlib streams, so
+ * several of them can be (de)compressed at once.
+ * Each job owns a transform stream and the buffer
+ * that holds its compressed data; the uncompressed
+ * side lives in the stream's in_buf (writing) or
+ * out_buf (reading), one chunk per job */
+struct rzip_job
+{
+   struct rzipstream *stream;
+#ifdef HAVE_THREADS
+   sthread_t *thread;
+#endif
+   void *trans_stream;
+   uint8_t *buf;
+   const uint8_t *in;
+   uint8_t *out;
+   uint32_t buf_size;
+   uint32_t in_size;
+   uint32_t out_size;
+   uint32_t written;
+   unsigned index;
+   bool ok;
+};
+
 /* Holds all metadata for an RZIP file stream */
 struct rzipstream
 {
@@ -51,6 +84,12 @@ struct rzipstream
    /* virtual_ptr: Used to track how much
     * uncompressed data has been read */
    uint64_t virtual_ptr;
+   /* out_buf_start: Uncompressed offset of the
+    * data currently held in the output buffer */
+   uint64_t out_buf_start;
+   /* chunk_offsets: File offset of each chunk,
+    * built on first seek */
+   uint64_t *chunk_offsets;
    RFILE* file;
    const struct trans_stream_backend *deflate_backend;
    void *deflate_stream;
@@ -64,10 +103,285 @@ struct rzipstream
    uint32_t out_buf_ptr;
    uint32_t out_buf_occupancy;
    uint32_t chunk_size;
+   /* num_chunks/chunk_index: Total number of chunks
+    * in the file, and the next one to be read */
+   uint64_t num_chunks;
+   uint64_t chunk_index;
+   struct rzip_job *jobs;
+   /* num_jobs: Number of chunks handled per batch
+    * (1 == serial mode) */
+   unsigned num_jobs;
+#ifdef HAVE_THREADS
+   slock_t *job_lock;
+   scond_t *job_cond;
+   scond_t *done_cond;
+   unsigned job_gen;
+   unsigned jobs_active;
+   unsigned jobs_pending;
+   bool job_quit;
+   bool workers_started;
+   bool workers_failed;
+#endif
    bool is_compressed;
    bool is_writing;
 };
 
+/* Parallel Processing */
+
+#ifdef HAVE_THREADS
+/* Returns the number of chunks worth
+ * (de)compressing at once */
+static unsigned rzipstream_get_num_jobs(void)
+{
+   unsigned cores = cpu_features_get_core_amount();
+   if (cores > RZIP_MAX_JOBS)
+      return RZIP_MAX_JOBS;
+   return (cores > 0) ? cores : 1;
+}
+#endif
+
+/* Compresses or decompresses a single chunk */
+static void rzipstream_run_job(struct rzip_job *job)
+{
+   uint32_t trans_read;
+   uint32_t trans_written;
+   rzipstream_t *stream = job->stream;
+   const struct trans_stream_backend *backend = stream->is_writing
+         ? stream->deflate_backend
+         : stream->inflate_backend;
+
+   job->written = 0;
+   job->ok      = false;
+
+   backend->set_in(job->trans_stream, job->in, job->in_size);
+   backend->set_out(job->trans_stream, job->out, job->out_size);
+
+   if (!backend->trans(job->trans_stream, true,
+         &trans_read, &trans_written, NULL))
+      return;
+
+   /* Error checking */
+   if (trans_read != job->in_size)
+      return;
+
+   if ((trans_written == 0) ||
+       (trans_written > job->out_size))
+      return;
+
+   job->written = trans_written;
+   job->ok      = true;
+}
+
+#ifdef HAVE_THREADS
+static void rzipstream_worker(void *data)
+{
+   struct rzip_job *job = (struct rzip_job*)data;
+   rzipstream_t *stream = job->stream;
+   /* Workers are started before the first batch
+    * is dispatched, while job_gen is still zero */
+   unsigned gen         = 0;
+
+   slock_lock(stream->job_lock);
+   for (;;)
+   {
+      while (!stream->job_quit && (stream->job_gen == gen))
+         scond_wait(stream->job_cond, stream->job_lock);
+
+      if (stream->job_quit)
+         break;
+
+      gen = stream->job_gen;
+
+      if (job->index < stream->jobs_active)
+      {
+         slock_unlock(stream->job_lock);
+         rzipstream_run_job(job);
+         slock_lock(stream->job_lock);
+
+         if (--stream->jobs_pending == 0)
+            scond_signal(stream->done_cond);
+      }
+   }
+   slock_unlock(stream->job_lock);
+}
+
+static void rzipstream_stop_workers(rzipstream_t *stream)
+{
+   unsigned i;
+
+   if (stream->job_lock)
+   {
+      slock_lock(stream->job_lock);
+      stream->job_quit = true;
+      if (stream->job_cond)
+         scond_broadcast(stream->job_cond);
+      slock_unlock(stream->job_lock);
+   }
+
+   for (i = 1; i < stream->num_jobs; i++)
+   {
+      if (!stream->jobs[i].thread)
+         continue;
+      sthread_join(stream->jobs[i].thread);
+      stream->jobs[i].thread = NULL;
+   }
+
+   if (stream->job_cond)
+      scond_free(stream->job_cond);
+   if (stream->done_cond)
+      scond_free(stream->done_cond);
+   if (stream->job_lock)
+      slock_free(stream->job_lock);
+
+   stream->job_cond        = NULL;
+   stream->done_cond       = NULL;
+   stream->job_lock        = NULL;
+   stream->workers_started = false;
+}
+
+/* Job 0 always runs on the calling thread;
+ * the others each get a worker thread.
+ * If threads can't be created, every job
+ * simply runs on the calling thread */
+static bool rzipstream_start_workers(rzipstream_t *stream)
+{
+   unsigned i;
+
+   if (stream->workers_started)
+      return true;
+   if (stream->workers_failed)
+      return false;
+
+   stream->job_quit     = false;
+   stream->job_gen      = 0;
+   stream->jobs_active  = 0;
+   stream->jobs_pending = 0;
+
+   if (   !(stream->job_lock  = slock_new())
+       || !(stream->job_cond  = scond_new())
+       || !(stream->done_cond = scond_new()))
+      goto error;
+
+   for (i = 1; i < stream->num_jobs; i++)
+      if (!(stream->jobs[i].thread = sthread_create(
+            rzipstream_worker, &stream->jobs[i])))
+         goto error;
+
+   stream->workers_started = true;
+   return true;
+
+error:
+   rzipstream_stop_workers(stream);
+   stream->workers_failed  = true;
+   return false;
+}
+#endif
+
+/* Allocates the per-job transform streams
+ * and compressed data buffers */
+static bool rzipstream_init_jobs(rzipstream_t *stream)
+{
+   unsigned i;
+   const struct trans_stream_backend *backend = stream->is_writing
+         ? stream->deflate_backend
+         : stream->inflate_backend;
+
+   if (stream->jobs)
+      return true;
+
+   if (!(stream->jobs = (struct rzip_job*)calloc(
+         stream->num_jobs, sizeof(*stream->jobs))))
+      return false;
+
+   for (i = 0; i < stream->num_jobs; i++)
+   {
+      struct rzip_job *job = &stream->jobs[i];
+
+      job->stream          = stream;
+      job->index           = i;
+
+      if (!(job->trans_stream = backend->stream_new()))
+         return false;
+
+      if (stream->is_writing)
+      {
+         if (!backend->define(job->trans_stream,
+               "level", RZIP_COMPRESSION_LEVEL))
+            return false;
+
+         /* Same size as the serial output buffer */
+         job->buf_size = stream->out_buf_size;
+         if (!(job->buf = (uint8_t *)malloc(job->buf_size)))
+            return false;
+      }
+   }
+
+   return true;
+}
+
+static void rzipstream_free_jobs(rzipstream_t *stream)
+{
+   unsigned i;
+   const struct trans_stream_backend *backend = stream->is_writing
+         ? stream->deflate_backend
+         : stream->inflate_backend;
+
+   if (!stream->jobs)
+      return;
+
+#ifdef HAVE_THREADS
+   rzipstream_stop_workers(stream);
+#endif
+
+   for (i = 0; i < stream->num_jobs; i++)
+   {
+      struct rzip_job *job = &stream->jobs[i];
+      if (job->trans_stream && backend)
+         backend->stream_free(job->trans_stream);
+      if (job->buf)
+         free(job->buf);
+   }
+
+   free(stream->jobs);
+   stream->jobs = NULL;
+}
+
+/* Runs the first 'num' jobs, in parallel
+ * where possible. Returns false if any of
+ * them failed */
+static bool rzipstream_run_jobs(rzipstream_t *stream, unsigned num)
+{
+   unsigned i;
+
+#ifdef HAVE_THREADS
+   if ((num > 1) && rzipstream_start_workers(stream))
+   {
+      slock_lock(stream->job_lock);
+      stream->jobs_active  = num;
+      stream->jobs_pending = num - 1;
+      stream->job_gen++;
+      scond_broadcast(stream->job_cond);
+      slock_unlock(stream->job_lock);
+
+      rzipstream_run_job(&stream->jobs[0]);
+
+      slock_lock(stream->job_lock);
+      while (stream->jobs_pending > 0)
+         scond_wait(stream->done_cond, stream->job_lock);
+      slock_unlock(stream->job_lock);
+   }
+   else
+#endif
+      for (i = 0; i < num; i++)
+         rzipstream_run_job(&stream->jobs[i]);
+
+   for (i = 0; i < num; i++)
+      if (!stream->jobs[i].ok)
+         return false;
+
+   return true;
+}
+
 /* Header Functions */
 
 /* Reads header information from RZIP file
@@ -213,6 +527,12 @@ static bool rzipstream_init_stream(
    stream->out_buf_size      = 0;
    stream->out_buf_ptr       = 0;
    stream->out_buf_occupancy = 0;
+   stream->out_buf_start     = 0;
+   stream->chunk_offsets     = NULL;
+   stream->num_chunks        = 0;
+   stream->chunk_index       = 0;
+   stream->jobs              = NULL;
+   stream->num_jobs          = 1;
 
    /* Check whether this is a read or write stream */
    stream->is_writing = is_writing;
@@ -280,6 +600,13 @@ static bool rzipstream_init_stream(
       if (   (stream->in_buf_size  == 0)
           || (stream->out_buf_size == 0))
          return false;
+
+#ifdef HAVE_THREADS
+      /* Input buffer only grows to hold several
+       * chunks once more than one has been written,
+       * so small files are handled as before */
+      stream->num_jobs = rzipstream_get_num_jobs();
+#endif
    }
    /* When reading, don't need an inflate transform
     * stream (or buffers) if source file is uncompressed */
@@ -309,6 +636,23 @@ static bool rzipstream_init_stream(
       if (   (stream->in_buf_size  == 0)
           || (stream->out_buf_size == 0))
          return false;
+
+      stream->num_chunks   = (stream->size + stream->chunk_size - 1) /
+            stream->chunk_size;
+
+#ifdef HAVE_THREADS
+      /* Output buffer holds one decompressed
+       * chunk per job */
+      stream->num_jobs     = rzipstream_get_num_jobs();
+      if (stream->num_jobs > stream->num_chunks)
+         stream->num_jobs  = (unsigned)stream->num_chunks;
+      if ((uint64_t)stream->chunk_size * RZIP_MAX_JOBS >
+            (uint64_t)UINT32_MAX - (stream->chunk_size >> 2))
+         stream->num_jobs  = 1;
+      if (stream->num_jobs > 1)
+         stream->out_buf_size = stream->chunk_size * stream->num_jobs +
+               (stream->chunk_size >> 2);
+#endif
    }
 
    /* Allocate buffers */
@@ -336,6 +680,14 @@ static int rzipstream_free_stream(rzipstream_t *stream)
    if (!stream)
       return -1;
 
+   /* Free parallel jobs (these share the
+    * stream's transform backends) */
+   rzipstream_free_jobs(stream);
+
+   if (stream->chunk_offsets)
+      free(stream->chunk_offsets);
+   stream->chunk_offsets   = NULL;
+
    /* Free transform streams */
    if (stream->deflate_stream && stream->deflate_backend)
       stream->deflate_backend->stream_free(stream->deflate_stream);
@@ -416,6 +768,19 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
    stream->out_buf_size    = 0;
    stream->out_buf_ptr     = 0;
    stream->out_buf_occupancy = 0;
+   stream->out_buf_start   = 0;
+   stream->chunk_offsets   = NULL;
+   stream->num_chunks      = 0;
+   stream->chunk_index     = 0;
+   stream->jobs            = NULL;
+   stream->num_jobs        = 1;
+#ifdef HAVE_THREADS
+   stream->job_lock        = NULL;
+   stream->job_cond        = NULL;
+   stream->done_cond       = NULL;
+   stream->workers_started = false;
+   stream->workers_failed  = false;
+#endif
 
    /* Initialise stream */
    if (!rzipstream_init_stream(
@@ -431,34 +796,117 @@ rzipstream_t* rzipstream_open(const char *path, unsigned mode)
 
 /* File Read */
 
+/* Reads the size of the next compressed chunk
+ * from the RZIP file. Returns 0 on error */
+static uint32_t rzipstream_read_chunk_header(rzipstream_t *stream)
+{
+   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE] = {0};
+
+   /* Attempt to read chunk header bytes */
+   if (filestream_read(
+         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
+         RZIP_CHUNK_HEADER_SIZE)
+      return 0;
+
+   /* Get size of next compressed chunk */
+   return ((uint32_t)chunk_header_bytes[3] << 24) |
+          ((uint32_t)chunk_header_bytes[2] << 16) |
+          ((uint32_t)chunk_header_bytes[1] <<  8) |
+           (uint32_t)chunk_header_bytes[0];
+}
+
+/* Reads the next 'num' chunks of data from the
+ * RZIP file and decompresses them in parallel
+ * into the output buffer */
+static bool rzipstream_read_chunks(rzipstream_t *stream, unsigned num)
+{
+   unsigned i;
+
+   if (!rzipstream_init_jobs(stream))
+      return false;
+
+   /* File access is sequential... */
+   for (i = 0; i < num; i++)
+   {
+      struct rzip_job *job           = &stream->jobs[i];
+      uint32_t compressed_chunk_size = rzipstream_read_chunk_header(stream);
+
+      if (compressed_chunk_size == 0)
+         return false;
+
+      /* Resize compressed data buffer, if required */
+      if (compressed_chunk_size > job->buf_size)
+      {
+         free(job->buf);
+         job->buf_size = 0;
+         if (!(job->buf = (uint8_t *)malloc(compressed_chunk_size)))
+            return false;
+         job->buf_size = compressed_chunk_size;
+      }
+
+      if (filestream_read(
+            stream->file, job->buf, compressed_chunk_size) !=
+            compressed_chunk_size)
+         return false;
+
+      job->in       = job->buf;
+      job->in_size  = compressed_chunk_size;
+      job->out      = stream->out_buf + (size_t)i * stream->chunk_size;
+      /* Last chunk may use the spare space at the
+       * end of the output buffer, as in serial mode */
+      job->out_size = (i == num - 1)
+            ? stream->out_buf_size - i * stream->chunk_size
+            : stream->chunk_size;
+   }
+
+   /* ...decompression is not */
+   if (!rzipstream_run_jobs(stream, num))
+      return false;
+
+   /* Chunks must be contiguous: all but the
+    * last must be full */
+   for (i = 0; i < num - 1; i++)
+      if (stream->jobs[i].written != stream->chunk_size)
+         return false;
+
+   stream->out_buf_occupancy = (num - 1) * stream->chunk_size +
+         stream->jobs[num - 1].written;
+   stream->out_buf_ptr       = 0;
+
+   return true;
+}
+
 /* Reads and decompresses the next chunk of data
- * in the RZIP file */
+ * in the RZIP file (or the next several, when
+ * running in parallel mode) */
 static bool rzipstream_read_chunk(rzipstream_t *stream)
 {
-   unsigned i;
-   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
    uint32_t compressed_chunk_size;
    uint32_t inflate_read;
    uint32_t inflate_written;
+   uint64_t num;
 
    if (!stream || !stream->inflate_backend || !stream->inflate_stream)
       return false;
 
-   for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
-      chunk_header_bytes[i] = 0;
+   stream->out_buf_start = stream->chunk_index * stream->chunk_size;
 
-   /* Attempt to read chunk header bytes */
-   if (filestream_read(
-         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
-         RZIP_CHUNK_HEADER_SIZE)
-      return false;
+   num = (stream->chunk_index < stream->num_chunks)
+         ? stream->num_chunks - stream->chunk_index
+         : 1;
+   if (num > stream->num_jobs)
+      num = stream->num_jobs;
+
+   if (num > 1)
+   {
+      if (!rzipstream_read_chunks(stream, (unsigned)num))
+         return false;
+      stream->chunk_index += num;
+      return true;
+   }
 
    /* Get size of next compressed chunk */
-   compressed_chunk_size = ((uint32_t)chunk_header_bytes[3] << 24) |
-                           ((uint32_t)chunk_header_bytes[2] << 16) |
-                           ((uint32_t)chunk_header_bytes[1] <<  8) |
-                            (uint32_t)chunk_header_bytes[0];
-   if (compressed_chunk_size == 0)
+   if ((compressed_chunk_size = rzipstream_read_chunk_header(stream)) == 0)
       return false;
 
    /* Resize input buffer, if required */
@@ -514,6 +962,7 @@ static bool rzipstream_read_chunk(rzipstream_t *stream)
     * and reset pointer */
    stream->out_buf_occupancy = inflate_written;
    stream->out_buf_ptr       = 0;
+   stream->chunk_index++;
 
    return true;
 }
@@ -716,20 +1165,80 @@ error:
 
 /* File Write */
 
+/* Writes one compressed chunk, preceded by its
+ * size, to the RZIP file */
+static bool rzipstream_write_chunk_data(rzipstream_t *stream,
+      const uint8_t *data, uint32_t deflate_written)
+{
+   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
+
+   /* Write compressed chunk size to file */
+   chunk_header_bytes[3] = (deflate_written >> 24) & 0xFF;
+   chunk_header_bytes[2] = (deflate_written >> 16) & 0xFF;
+   chunk_header_bytes[1] = (deflate_written >>  8) & 0xFF;
+   chunk_header_bytes[0] =  deflate_written        & 0xFF;
+
+   if (filestream_write(
+         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
+         RZIP_CHUNK_HEADER_SIZE)
+      return false;
+
+   /* Write compressed data to file */
+   return (filestream_write(
+         stream->file, data, deflate_written) == deflate_written);
+}
+
+/* Compresses the several chunks of data currently
+ * cached in parallel, and writes them in order */
+static bool rzipstream_write_chunks(rzipstream_t *stream)
+{
+   unsigned i;
+   unsigned num = (stream->in_buf_ptr + stream->chunk_size - 1) /
+         stream->chunk_size;
+
+   if (!rzipstream_init_jobs(stream))
+      return false;
+
+   for (i = 0; i < num; i++)
+   {
+      struct rzip_job *job = &stream->jobs[i];
+      uint32_t offset      = i * stream->chunk_size;
+
+      job->in       = stream->in_buf + offset;
+      job->in_size  = stream->in_buf_ptr - offset;
+      if (job->in_size > stream->chunk_size)
+         job->in_size = stream->chunk_size;
+      job->out      = job->buf;
+      job->out_size = job->buf_size;
+   }
+
+   if (!rzipstream_run_jobs(stream, num))
+      return false;
+
+   for (i = 0; i < num; i++)
+      if (!rzipstream_write_chunk_data(stream,
+            stream->jobs[i].buf, stream->jobs[i].written))
+         return false;
+
+   /* Reset input buffer pointer */
+   stream->in_buf_ptr = 0;
+
+   return true;
+}
+
 /* Compresses currently cached data and writes it
- * as the next RZIP file chunk */
+ * as the next RZIP file chunk (or chunks, when
+ * running in parallel mode) */
 static bool rzipstream_write_chunk(rzipstream_t *stream)
 {
-   unsigned i;
-   uint8_t chunk_header_bytes[RZIP_CHUNK_HEADER_SIZE];
    uint32_t deflate_read;
    uint32_t deflate_written;
 
    if (!stream || !stream->deflate_backend || !stream->deflate_stream)
       return false;
 
-   for (i = 0; i < RZIP_CHUNK_HEADER_SIZE; i++)
-      chunk_header_bytes[i] = 0;
+   if (stream->in_buf_ptr > stream->chunk_size)
+      return rzipstream_write_chunks(stream);
 
    /* Compress data currently held in input buffer */
    stream->deflate_backend->set_in(
@@ -757,20 +1266,8 @@ static bool rzipstream_write_chunk(rzipstream_t *stream)
        (deflate_written > stream->out_buf_size))
       return false;
 
-   /* Write compressed chunk size to file */
-   chunk_header_bytes[3] = (deflate_written >> 24) & 0xFF;
-   chunk_header_bytes[2] = (deflate_written >> 16) & 0xFF;
-   chunk_header_bytes[1] = (deflate_written >>  8) & 0xFF;
-   chunk_header_bytes[0] =  deflate_written        & 0xFF;
-
-   if (filestream_write(
-         stream->file, chunk_header_bytes, sizeof(chunk_header_bytes)) !=
-         RZIP_CHUNK_HEADER_SIZE)
-      return false;
-
-   /* Write compressed data to file */
-   if (filestream_write(
-         stream->file, stream->out_buf, deflate_written) != deflate_written)
+   if (!rzipstream_write_chunk_data(stream,
+         stream->out_buf, deflate_written))
       return false;
 
    /* Reset input buffer pointer */
@@ -797,8 +1294,28 @@ int64_t rzipstream_write(rzipstream_t *stream, const void *data, int64_t len)
 
       /* If input buffer is full, compress and write to disk */
       if (stream->in_buf_ptr >= stream->in_buf_size)
-         if (!rzipstream_write_chunk(stream))
-            return -1;
+      {
+         /* Once there is more than one chunk of data,
+          * switch to caching one chunk per job */
+         uint32_t batch_size = stream->chunk_size * stream->num_jobs;
+
+         if (stream->in_buf_size < batch_size)
+         {
+            uint8_t *in_buf = (uint8_t *)realloc(stream->in_buf, batch_size);
+
+            if (in_buf)
+            {
+               stream->in_buf      = in_buf;
+               stream->in_buf_size = batch_size;
+            }
+            else
+               stream->num_jobs    = 1;
+         }
+
+         if (stream->in_buf_ptr >= stream->in_buf_size)
+            if (!rzipstream_write_chunk(stream))
+               return -1;
+      }
 
       /* Get amount of data to cache during this loop
        * > i.e. minimum of space remaining in input buffer
@@ -956,8 +1473,8 @@ void rzipstream_rewind(rzipstream_t *stream)
    {
       /* Check whether first file chunk is currently
        * buffered in memory */
-      if ((stream->virtual_ptr < stream->chunk_size) &&
-          (stream->out_buf_ptr < stream->out_buf_occupancy))
+      if ((stream->out_buf_start == 0) &&
+          (stream->out_buf_occupancy > 0))
       {
          /* It is: No file access is therefore required
           * > Just reset pointers */
@@ -975,6 +1492,7 @@ void rzipstream_rewind(rzipstream_t *stream)
             return;
 
          /* Read chunk */
+         stream->chunk_index = 0;
          if (!rzipstream_read_chunk(stream))
             return;
 
@@ -985,6 +1503,146 @@ void rzipstream_rewind(rzipstream_t *stream)
    }
 }
 
+/* Records the file offset of every chunk, so that
+ * any chunk can be read without inflating the ones
+ * before it */
+static bool rzipstream_build_chunk_index(rzipstream_t *stream)
+{
+   uint64_t i;
+   int64_t chunk_offset = RZIP_HEADER_SIZE;
+   int64_t file_offset  = filestream_tell(stream->file);
+
+   if (file_offset < 0)
+      return false;
+
+   if ((uint64_t)(size_t)stream->num_chunks != stream->num_chunks)
+      return false;
+
+   if (!(stream->chunk_offsets = (uint64_t*)malloc(
+         (size_t)stream->num_chunks * sizeof(uint64_t))))
+      return false;
+
+   for (i = 0; i < stream->num_chunks; i++)
+   {
+      uint32_t compressed_chunk_size;
+
+      stream->chunk_offsets[i] = (uint64_t)chunk_offset;
+
+      if (filestream_seek(stream->file, chunk_offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+         goto error;
+
+      if ((compressed_chunk_size = rzipstream_read_chunk_header(stream)) == 0)
+         goto error;
+
+      chunk_offset += RZIP_CHUNK_HEADER_SIZE + compressed_chunk_size;
+   }
+
+   if (filestream_seek(stream->file, file_offset,
+         RETRO_VFS_SEEK_POSITION_START) < 0)
+      goto error;
+
+   return true;
+
+error:
+   free(stream->chunk_offsets);
+   stream->chunk_offsets = NULL;
+   filestream_seek(stream->file, file_offset,
+         RETRO_VFS_SEEK_POSITION_START);
+   return false;
+}
+
+/* Sets the position of the *uncompressed* data
+ * in an RZIP file open for reading. 'whence' is
+ * one of SEEK_SET, SEEK_CUR or SEEK_END.
+ * Returns 0 on success, or -1 in the event
+ * of an error */
+int64_t rzipstream_seek(rzipstream_t *stream, int64_t offset, int whence)
+{
+   int64_t position;
+   uint64_t chunk;
+
+   if (!stream || stream->is_writing)
+      return -1;
+
+   /* If we are reading uncompressed data, simply
+    * 'pass on' the direct file access request */
+   if (!stream->is_compressed)
+   {
+      int seek_position = RETRO_VFS_SEEK_POSITION_START;
+
+      if (whence == SEEK_CUR)
+         seek_position  = RETRO_VFS_SEEK_POSITION_CURRENT;
+      else if (whence == SEEK_END)
+         seek_position  = RETRO_VFS_SEEK_POSITION_END;
+
+      return (filestream_seek(stream->file, offset, seek_position) < 0)
+            ? -1 : 0;
+   }
+
+   switch (whence)
+   {
+      case SEEK_SET:
+         position = offset;
+         break;
+      case SEEK_CUR:
+         position = (int64_t)stream->virtual_ptr + offset;
+         break;
+      case SEEK_END:
+         position = (int64_t)stream->size + offset;
+         break;
+      default:
+         return -1;
+   }
+
+   if ((position < 0) || ((uint64_t)position > stream->size))
+      return -1;
+
+   /* Check whether the target is already
+    * buffered in memory */
+   if (   ((uint64_t)position >= stream->out_buf_start)
+       && ((uint64_t)position <  stream->out_buf_start +
+             stream->out_buf_occupancy))
+   {
+      stream->out_buf_ptr = (uint32_t)(position - stream->out_buf_start);
+      stream->virtual_ptr = (uint64_t)position;
+      return 0;
+   }
+
+   /* Seeking to the end of the file requires
+    * no data; the next read will return nothing */
+   if ((uint64_t)position == stream->size)
+   {
+      stream->out_buf_ptr = stream->out_buf_occupancy;
+      stream->virtual_ptr = stream->size;
+      return 0;
+   }
+
+   if (!stream->chunk_offsets && !rzipstream_build_chunk_index(stream))
+      return -1;
+
+   /* Read the chunk holding the target, and
+    * skip to the requested offset within it */
+   chunk = (uint64_t)position / stream->chunk_size;
+
+   if (filestream_seek(stream->file, (int64_t)stream->chunk_offsets[chunk],
+         RETRO_VFS_SEEK_POSITION_START) < 0)
+      return -1;
+
+   stream->chunk_index = chunk;
+   if (!rzipstream_read_chunk(stream))
+      return -1;
+
+   if ((uint64_t)position - stream->out_buf_start >=
+         stream->out_buf_occupancy)
+      return -1;
+
+   stream->out_buf_ptr = (uint32_t)(position - stream->out_buf_start);
+   stream->virtual_ptr = (uint64_t)position;
+
+   return 0;
+}
+
 /* File Status */
 
 /* Returns total size (in bytes) of the *uncompressed*
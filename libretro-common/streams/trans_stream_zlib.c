@@ -31,6 +31,8 @@ struct zlib_trans_stream
 {
    z_stream z;
    int ex; /* window_bits or level */
+   int window_bits; /* deflate only */
+   bool sync_flush; /* deflate only */
    bool inited;
 };
 
@@ -42,6 +44,8 @@ static void *zlib_deflate_stream_new(void)
       return NULL;
    ret->inited      = false;
    ret->ex          = 9;
+   ret->window_bits = MAX_WBITS;
+   ret->sync_flush  = false;
 
    ret->z.next_in   = NULL;
    ret->z.avail_in  = 0;
@@ -122,6 +126,22 @@ static bool zlib_deflate_define(void *data, const char *prop, uint32_t val)
          z->ex = (int) val;
       return true;
    }
+   /* Negative for a raw deflate stream, without zlib header
+    * and checksum */
+   else if (string_is_equal(prop, "window_bits"))
+   {
+      if (z)
+         z->window_bits = (int) val;
+      return true;
+   }
+   /* Flushing ends the data on a byte boundary but leaves the
+    * stream open, so more data can be appended to it later */
+   else if (string_is_equal(prop, "sync_flush"))
+   {
+      if (z)
+         z->sync_flush = (val != 0);
+      return true;
+   }
    return false;
 }
 
@@ -149,7 +169,8 @@ static void zlib_deflate_set_in(void *data, const uint8_t *in, uint32_t in_size)
 
    if (!z->inited)
    {
-      deflateInit(&z->z, z->ex);
+      deflateInit2(&z->z, z->ex, Z_DEFLATED, z->window_bits,
+            8, Z_DEFAULT_STRATEGY);
       z->inited = true;
    }
 }
@@ -195,13 +216,17 @@ static bool zlib_deflate_trans(
 
    if (!zt->inited)
    {
-      deflateInit(z, zt->ex);
+      deflateInit2(z, zt->ex, Z_DEFLATED, zt->window_bits,
+            8, Z_DEFAULT_STRATEGY);
       zt->inited = true;
    }
 
    pre_avail_in  = z->avail_in;
    pre_avail_out = z->avail_out;
-   zret          = deflate(z, flush ? Z_FINISH : Z_NO_FLUSH);
+   if (flush)
+      zret       = deflate(z, zt->sync_flush ? Z_SYNC_FLUSH : Z_FINISH);
+   else
+      zret       = deflate(z, Z_NO_FLUSH);
 
    if (zret == Z_OK)
    {
@@ -0,0 +1,173 @@
+/* Copyright  (C) 2010-2026 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (test_buffer_pool.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <check.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <buffer_pool.h>
+
+#define SUITE_NAME "Buffer Pool"
+
+#define STATE_SIZE 4096
+
+/* A long-lived state, like the save to RAM or undo buffers */
+struct kept_state
+{
+   void *data;
+   size_t size;
+};
+
+/* Same hand-over as content_state_pool_put() in task_save.c */
+static void keep_state(buffer_pool_t *pool, void *data,
+      struct kept_state *keep)
+{
+   if (!keep->data)
+      buffer_pool_take(pool, data);
+   else if (!buffer_pool_put(pool, data, keep->data, keep->size))
+      free(keep->data);
+   keep->data = data;
+   keep->size = STATE_SIZE;
+}
+
+static void *save_state(buffer_pool_t *pool, unsigned char value)
+{
+   void *data = buffer_pool_get(pool, STATE_SIZE);
+   ck_assert_ptr_nonnull(data);
+   memset(data, value, STATE_SIZE);
+   return data;
+}
+
+static void check_state(const struct kept_state *keep, unsigned char value)
+{
+   size_t i;
+   const unsigned char *p = (const unsigned char*)keep->data;
+
+   for (i = 0; i < keep->size; i++)
+      ck_assert_int_eq(p[i], value);
+}
+
+START_TEST (test_buffer_pool_get_put)
+{
+   void *a, *b;
+   buffer_pool_t pool;
+
+   memset(&pool, 0, sizeof(pool));
+   buffer_pool_init(&pool, 2);
+
+   a = buffer_pool_get(&pool, STATE_SIZE);
+   ck_assert_ptr_nonnull(a);
+   ck_assert(buffer_pool_put(&pool, a, NULL, 0));
+
+   /* Handed back, so it is reused */
+   b = buffer_pool_get(&pool, STATE_SIZE);
+   ck_assert_ptr_eq(a, b);
+   ck_assert(buffer_pool_put(&pool, b, NULL, 0));
+
+   buffer_pool_deinit(&pool);
+}
+END_TEST
+
+START_TEST (test_buffer_pool_take)
+{
+   void *a, *b;
+   buffer_pool_t pool;
+
+   memset(&pool, 0, sizeof(pool));
+   buffer_pool_init(&pool, 1);
+
+   a = buffer_pool_get(&pool, STATE_SIZE);
+   ck_assert(buffer_pool_take(&pool, a));
+   ck_assert(!buffer_pool_take(&pool, a));
+   ck_assert(!buffer_pool_put(&pool, a, NULL, 0));
+
+   b = buffer_pool_get(&pool, STATE_SIZE);
+   ck_assert_ptr_ne(a, b);
+   ck_assert(buffer_pool_put(&pool, b, NULL, 0));
+
+   free(a);
+   buffer_pool_deinit(&pool);
+}
+END_TEST
+
+START_TEST (test_buffer_pool_save_to_ram_twice)
+{
+   void *other;
+   struct kept_state ram;
+   buffer_pool_t pool;
+
+   memset(&pool, 0, sizeof(pool));
+   memset(&ram, 0, sizeof(ram));
+   buffer_pool_init(&pool, 2);
+
+   /* First save to RAM: nothing kept yet */
+   keep_state(&pool, save_state(&pool, 1), &ram);
+   check_state(&ram, 1);
+
+   /* Another state passing through the pool
+    * must not land in the kept one */
+   other = save_state(&pool, 0xff);
+   ck_assert_ptr_ne(other, ram.data);
+   check_state(&ram, 1);
+   ck_assert(buffer_pool_put(&pool, other, NULL, 0));
+
+   /* Second save to RAM swaps the old one into the pool */
+   keep_state(&pool, save_state(&pool, 2), &ram);
+   check_state(&ram, 2);
+   other = save_state(&pool, 0xff);
+   ck_assert_ptr_ne(other, ram.data);
+   check_state(&ram, 2);
+   ck_assert(buffer_pool_put(&pool, other, NULL, 0));
+
+   /* Resetting the backups frees the kept state,
+    * then the pool's idle buffers */
+   free(ram.data);
+   ram.data = NULL;
+   buffer_pool_trim(&pool);
+
+   buffer_pool_deinit(&pool);
+}
+END_TEST
+
+Suite *create_suite(void)
+{
+   Suite *s = suite_create(SUITE_NAME);
+
+   TCase *tc_core = tcase_create("Core");
+   tcase_add_test(tc_core, test_buffer_pool_get_put);
+   tcase_add_test(tc_core, test_buffer_pool_take);
+   tcase_add_test(tc_core, test_buffer_pool_save_to_ram_twice);
+   suite_add_tcase(s, tc_core);
+
+   return s;
+}
+
+int main(void)
+{
+	int num_fail;
+	Suite *s = create_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_NORMAL);
+	num_fail = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (num_fail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -86,7 +86,7 @@ static void menu_action_setting_audio_mixer_stream_name(
    if (offset >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return;
 
-   strlcpy(s, audio_driver_mixer_get_stream_name(offset), len);
+   audio_driver_mixer_get_stream_name(offset, s, len);
 }
 
 static void menu_action_setting_audio_mixer_stream_volume(
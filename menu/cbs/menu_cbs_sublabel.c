@@ -543,6 +543,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_volume,                  MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_mixer_volume,            MENU_ENUM_SUBLABEL_AUDIO_MIXER_VOLUME)
 #endif
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_sync,                    MENU_ENUM_SUBLABEL_AUDIO_SYNC)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_audio_threaded_processing,     MENU_ENUM_SUBLABEL_AUDIO_THREADED_PROCESSING)
 #if defined(GEKKO)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_input_mouse_scale,             MENU_ENUM_SUBLABEL_INPUT_MOUSE_SCALE)
 #endif
@@ -730,6 +731,7 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_slowmotion_ratio,              MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_run_ahead_unsupported,         MENU_ENUM_SUBLABEL_RUN_AHEAD_UNSUPPORTED)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_run_ahead_enabled,             MENU_ENUM_SUBLABEL_RUN_AHEAD_ENABLED)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_run_ahead_secondary_instance,  MENU_ENUM_SUBLABEL_RUN_AHEAD_SECONDARY_INSTANCE)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_run_ahead_speculative_instances, MENU_ENUM_SUBLABEL_RUN_AHEAD_SPECULATIVE_INSTANCES)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_run_ahead_hide_warnings,       MENU_ENUM_SUBLABEL_RUN_AHEAD_HIDE_WARNINGS)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_run_ahead_frames,              MENU_ENUM_SUBLABEL_RUN_AHEAD_FRAMES)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_preempt_unsupported,           MENU_ENUM_SUBLABEL_PREEMPT_UNSUPPORTED)
@@ -777,6 +779,9 @@ DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheat_file_load_append,        MENU_
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_cheat_file_save_as,            MENU_ENUM_SUBLABEL_CHEAT_FILE_SAVE_AS)
 #endif
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_rewind_granularity,            MENU_ENUM_SUBLABEL_REWIND_GRANULARITY)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_rewind_async,                  MENU_ENUM_SUBLABEL_REWIND_ASYNC)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_rewind_keyframe_interval,      MENU_ENUM_SUBLABEL_REWIND_KEYFRAME_INTERVAL)
+DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_rewind_compression_level,      MENU_ENUM_SUBLABEL_REWIND_COMPRESSION_LEVEL)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_rewind_buffer_size,            MENU_ENUM_SUBLABEL_REWIND_BUFFER_SIZE)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_rewind_buffer_size_step,       MENU_ENUM_SUBLABEL_REWIND_BUFFER_SIZE_STEP)
 DEFAULT_SUBLABEL_MACRO(action_bind_sublabel_libretro_log_level,            MENU_ENUM_SUBLABEL_LIBRETRO_LOG_LEVEL)
@@ -1560,12 +1565,11 @@ static int action_bind_sublabel_audio_mixer_stream(
    size_t _len;
    char msg[64];
    unsigned              offset = (type - MENU_SETTINGS_AUDIO_MIXER_STREAM_BEGIN);
-   audio_mixer_stream_t *stream = audio_driver_mixer_get_stream(offset);
 
-   if (!stream)
+   if (offset >= AUDIO_MIXER_MAX_SYSTEM_STREAMS)
       return -1;
 
-   switch (stream->state)
+   switch (audio_driver_mixer_get_stream_state(offset))
    {
       case AUDIO_STREAM_STATE_NONE:
          strlcpy(msg,
@@ -1597,7 +1601,7 @@ static int action_bind_sublabel_audio_mixer_stream(
    _len = strlcpy(s, msg, len);
    snprintf(s + _len, len - _len, " | %s: %.2f dB",
          msg_hash_to_str(MENU_ENUM_LABEL_VALUE_MIXER_ACTION_VOLUME),
-         stream->volume);
+         audio_driver_mixer_get_stream_volume(offset));
    return 0;
 }
 #endif
@@ -3944,6 +3948,15 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_rewind_buffer_size_step);
             break;
+         case MENU_ENUM_LABEL_REWIND_ASYNC:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_rewind_async);
+            break;
+         case MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_rewind_keyframe_interval);
+            break;
+         case MENU_ENUM_LABEL_REWIND_COMPRESSION_LEVEL:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_rewind_compression_level);
+            break;
          case MENU_ENUM_LABEL_CHEAT_IDX:
 #ifdef HAVE_CHEATS
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_cheat_idx);
@@ -4076,6 +4089,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_secondary_instance);
             break;
+         case MENU_ENUM_LABEL_RUN_AHEAD_SPECULATIVE_INSTANCES:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_speculative_instances);
+            break;
          case MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_run_ahead_hide_warnings);
             break;
@@ -4518,6 +4534,9 @@ int menu_cbs_init_bind_sublabel(menu_file_list_cbs_t *cbs,
          case MENU_ENUM_LABEL_AUDIO_SYNC:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_sync);
             break;
+         case MENU_ENUM_LABEL_AUDIO_THREADED_PROCESSING:
+            BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_threaded_processing);
+            break;
          case MENU_ENUM_LABEL_AUDIO_VOLUME:
             BIND_ACTION_SUBLABEL(cbs, action_bind_sublabel_audio_volume);
             break;
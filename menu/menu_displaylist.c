@@ -7312,6 +7312,9 @@ unsigned menu_displaylist_build_list(
          {
             menu_displaylist_build_info_selective_t build_list[] = {
                {MENU_ENUM_LABEL_AUDIO_SYNC,                      PARSE_ONLY_BOOL,     true  },
+#ifdef HAVE_THREADS
+               {MENU_ENUM_LABEL_AUDIO_THREADED_PROCESSING,       PARSE_ONLY_BOOL,     true  },
+#endif
                {MENU_ENUM_LABEL_AUDIO_MAX_TIMING_SKEW,           PARSE_ONLY_FLOAT,    true  },
                {MENU_ENUM_LABEL_AUDIO_RATE_CONTROL_DELTA,        PARSE_ONLY_FLOAT,    true  },
             };
@@ -9909,6 +9912,7 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_RUN_AHEAD_ENABLED,                     PARSE_ONLY_BOOL, false },
                {MENU_ENUM_LABEL_RUN_AHEAD_FRAMES,                      PARSE_ONLY_UINT, false },
                {MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE,          PARSE_ONLY_BOOL, false },
+               {MENU_ENUM_LABEL_RUN_AHEAD_SPECULATIVE_INSTANCES,       PARSE_ONLY_UINT, false },
                {MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS,               PARSE_ONLY_BOOL, false },
                {MENU_ENUM_LABEL_PREEMPT_ENABLE,                        PARSE_ONLY_BOOL, false },
                {MENU_ENUM_LABEL_PREEMPT_FRAMES,                        PARSE_ONLY_UINT, false },
@@ -9971,6 +9975,7 @@ unsigned menu_displaylist_build_list(
                         break;
                      case MENU_ENUM_LABEL_RUN_AHEAD_FRAMES:
                      case MENU_ENUM_LABEL_RUN_AHEAD_SECONDARY_INSTANCE:
+                     case MENU_ENUM_LABEL_RUN_AHEAD_SPECULATIVE_INSTANCES:
                      case MENU_ENUM_LABEL_RUN_AHEAD_HIDE_WARNINGS:
                         if (runahead_enabled)
                            build_list[i].checked = true;
@@ -10966,6 +10971,11 @@ unsigned menu_displaylist_build_list(
                {MENU_ENUM_LABEL_REWIND_GRANULARITY,      PARSE_ONLY_UINT, false},
                {MENU_ENUM_LABEL_REWIND_BUFFER_SIZE,      PARSE_ONLY_SIZE, false},
                {MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP, PARSE_ONLY_UINT, false},
+               {MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL,PARSE_ONLY_UINT, false},
+               {MENU_ENUM_LABEL_REWIND_COMPRESSION_LEVEL,PARSE_ONLY_UINT, false},
+#ifdef HAVE_THREADS
+               {MENU_ENUM_LABEL_REWIND_ASYNC,            PARSE_ONLY_BOOL, false},
+#endif
             };
 
             for (i = 0; i < ARRAY_SIZE(build_list); i++)
@@ -10975,6 +10985,9 @@ unsigned menu_displaylist_build_list(
                   case MENU_ENUM_LABEL_REWIND_GRANULARITY:
                   case MENU_ENUM_LABEL_REWIND_BUFFER_SIZE:
                   case MENU_ENUM_LABEL_REWIND_BUFFER_SIZE_STEP:
+                  case MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL:
+                  case MENU_ENUM_LABEL_REWIND_COMPRESSION_LEVEL:
+                  case MENU_ENUM_LABEL_REWIND_ASYNC:
                      if (rewind_enable)
                         build_list[i].checked = true;
                      break;
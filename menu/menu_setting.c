@@ -11744,6 +11744,56 @@ static bool setting_append_list(
             (*list)[list_info->index - 1].offset_by     = 1;
             menu_settings_list_current_add_range(list, list_info, 1, 100, 1, true, true);
 
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.rewind_keyframe_interval,
+                  MENU_ENUM_LABEL_REWIND_KEYFRAME_INTERVAL,
+                  MENU_ENUM_LABEL_VALUE_REWIND_KEYFRAME_INTERVAL,
+                  DEFAULT_REWIND_KEYFRAME_INTERVAL,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].action_ok     = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 3600, 1, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
+            MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_REWIND_REINIT);
+
+            CONFIG_UINT(
+                  list, list_info,
+                  &settings->uints.rewind_compression_level,
+                  MENU_ENUM_LABEL_REWIND_COMPRESSION_LEVEL,
+                  MENU_ENUM_LABEL_VALUE_REWIND_COMPRESSION_LEVEL,
+                  DEFAULT_REWIND_COMPRESSION_LEVEL,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler);
+            (*list)[list_info->index - 1].action_ok     = &setting_action_ok_uint;
+            menu_settings_list_current_add_range(list, list_info, 0, 9, 1, true, true);
+            SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
+            MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_REWIND_REINIT);
+
+#ifdef HAVE_THREADS
+            CONFIG_BOOL(
+                  list, list_info,
+                  &settings->bools.rewind_async,
+                  MENU_ENUM_LABEL_REWIND_ASYNC,
+                  MENU_ENUM_LABEL_VALUE_REWIND_ASYNC,
+                  DEFAULT_REWIND_ASYNC,
+                  MENU_ENUM_LABEL_VALUE_OFF,
+                  MENU_ENUM_LABEL_VALUE_ON,
+                  &group_info,
+                  &subgroup_info,
+                  parent_group,
+                  general_write_handler,
+                  general_read_handler,
+                  SD_FLAG_CMD_APPLY_AUTO);
+            MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_REWIND_REINIT);
+#endif
+
          END_SUB_GROUP(list, list_info, parent_group);
          END_GROUP(list, list_info, parent_group);
          break;
@@ -14160,6 +14210,25 @@ static bool setting_append_list(
          MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_AUDIO_REINIT);
          SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_LAKKA_ADVANCED);
 
+#ifdef HAVE_THREADS
+         CONFIG_BOOL(
+               list, list_info,
+               &settings->bools.audio_threaded_processing,
+               MENU_ENUM_LABEL_AUDIO_THREADED_PROCESSING,
+               MENU_ENUM_LABEL_VALUE_AUDIO_THREADED_PROCESSING,
+               DEFAULT_AUDIO_THREADED_PROCESSING,
+               MENU_ENUM_LABEL_VALUE_OFF,
+               MENU_ENUM_LABEL_VALUE_ON,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler,
+               SD_FLAG_ADVANCED
+               );
+         MENU_SETTINGS_LIST_CURRENT_ADD_CMD(list, list_info, CMD_EVENT_AUDIO_REINIT);
+#endif
+
          CONFIG_UINT(
                list, list_info,
                &settings->uints.audio_latency,
@@ -15937,6 +16006,23 @@ static bool setting_append_list(
                SD_FLAG_NONE
                );
          (*list)[list_info->index - 1].change_handler = runahead_change_handler;
+
+#ifdef HAVE_THREADS
+         CONFIG_UINT(
+               list, list_info,
+               &settings->uints.run_ahead_speculative_instances,
+               MENU_ENUM_LABEL_RUN_AHEAD_SPECULATIVE_INSTANCES,
+               MENU_ENUM_LABEL_VALUE_RUN_AHEAD_SPECULATIVE_INSTANCES,
+               DEFAULT_RUN_AHEAD_SPECULATIVE_INSTANCES,
+               &group_info,
+               &subgroup_info,
+               parent_group,
+               general_write_handler,
+               general_read_handler);
+         (*list)[list_info->index - 1].action_ok = &setting_action_ok_uint;
+         menu_settings_list_current_add_range(list, list_info, 0, MAX_RUNAHEAD_SPECULATIVE, 1, true, true);
+         SETTINGS_DATA_LIST_CURRENT_ADD_FLAGS(list, list_info, SD_FLAG_ADVANCED);
+#endif
 #endif
 
          CONFIG_BOOL(
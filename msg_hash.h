@@ -2238,6 +2238,7 @@ enum msg_hash_enums
    MENU_LABEL(AUDIO_FASTFORWARD_MUTE),
    MENU_LABEL(AUDIO_FASTFORWARD_SPEEDUP),
    MENU_LABEL(AUDIO_SYNC),
+   MENU_LABEL(AUDIO_THREADED_PROCESSING),
    MENU_LBL_H(AUDIO_VOLUME),
    MENU_LABEL(AUDIO_MIXER_VOLUME),
    MENU_LBL_H(AUDIO_RATE_CONTROL_DELTA),
@@ -2323,6 +2324,9 @@ enum msg_hash_enums
    MENU_LABEL(REWIND_GRANULARITY),
    MENU_LABEL(REWIND_BUFFER_SIZE),
    MENU_LABEL(REWIND_BUFFER_SIZE_STEP),
+   MENU_LABEL(REWIND_ASYNC),
+   MENU_LABEL(REWIND_KEYFRAME_INTERVAL),
+   MENU_LABEL(REWIND_COMPRESSION_LEVEL),
    /* TODO/FIXME: INPUT_META_REWIND is incorrectly defined;
     * the LABEL/SUBLABEL enums should be entered 'manually',
     * like all the other hotkeys. Moreover, the resultant
@@ -2723,6 +2727,7 @@ enum msg_hash_enums
    MENU_LABEL(RUN_AHEAD_UNSUPPORTED),
    MENU_LABEL(RUN_AHEAD_ENABLED),
    MENU_LABEL(RUN_AHEAD_SECONDARY_INSTANCE),
+   MENU_LABEL(RUN_AHEAD_SPECULATIVE_INSTANCES),
    MENU_LABEL(RUN_AHEAD_HIDE_WARNINGS),
    MENU_LABEL(RUN_AHEAD_FRAMES),
    MENU_LABEL(PREEMPT_UNSUPPORTED),
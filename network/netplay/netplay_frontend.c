@@ -7108,6 +7108,8 @@ static void netplay_free(netplay_t *netplay)
 {
    size_t i;
 
+   core_state_cache_release();
+
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
@@ -7194,6 +7196,8 @@ static netplay_t *netplay_new(const char *server, const char *mitm,
    if (!netplay)
       return NULL;
 
+   core_state_cache_acquire();
+
    netplay->is_server        = !server;
    netplay->check_frames     = check_frames;
    netplay->cbs              = *cb;
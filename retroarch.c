@@ -1581,9 +1581,13 @@ void driver_set_nonblock_state(void)
    }
 
    if (audio_driver_active && audio_st->context_audio_data)
+   {
+      AUDIO_DRIVER_WRITE_LOCK(audio_st);
       audio_st->current_audio->set_nonblock_state(
             audio_st->context_audio_data,
             audio_sync ? enable : true);
+      AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+   }
 
    audio_st->chunk_size = enable
       ? audio_st->chunk_nonblock_size
@@ -1669,9 +1673,13 @@ void drivers_init(
       if (     audio_st->current_audio
             && audio_st->current_audio->device_list_new
             && audio_st->context_audio_data)
+      {
+         AUDIO_DRIVER_WRITE_LOCK(audio_st);
          audio_st->devices_list = (struct string_list*)
             audio_st->current_audio->device_list_new(
                   audio_st->context_audio_data);
+         AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+      }
    }
 
 #ifdef HAVE_MICROPHONE
@@ -3802,6 +3810,16 @@ bool command_event(enum event_command cmd, void *data)
          {
             bool rewind_enable        = settings->bools.rewind_enable;
             size_t rewind_buf_size    = settings->sizes.rewind_buffer_size;
+            bool rewind_async         = settings->bools.rewind_async;
+            unsigned rewind_keyframes = settings->uints.rewind_keyframe_interval;
+            unsigned rewind_level     = settings->uints.rewind_compression_level;
+#ifdef HAVE_RUNAHEAD
+            /* Share states with run-ahead/preemptive frames */
+            bool rewind_special       = settings->bools.run_ahead_enabled
+                  || settings->bools.preemptive_frames_enable;
+#else
+            bool rewind_special       = false;
+#endif
             bool core_type_is_dummy   = runloop_st->current_core_type == CORE_TYPE_DUMMY;
 
             if (core_type_is_dummy)
@@ -3824,7 +3842,8 @@ bool command_event(enum event_command cmd, void *data)
 #endif
                {
                   state_manager_event_init(&runloop_st->rewind_st,
-                        (unsigned)rewind_buf_size);
+                        (unsigned)rewind_buf_size, rewind_async,
+                        rewind_keyframes, rewind_level, rewind_special);
                }
             }
          }
@@ -5700,6 +5719,10 @@ void main_exit(void *args)
    retroarch_ctl(RARCH_CTL_STATE_FREE,  NULL);
    global_free(p_rarch);
    task_queue_deinit();
+   content_state_pool_deinit();
+#ifdef HAVE_SCREENSHOTS
+   screenshot_pool_deinit();
+#endif
 
    ui_companion_driver_deinit();
    retroarch_config_deinit();
@@ -23,12 +23,20 @@
 #endif
 
 #include <encodings/utf.h>
+#include <file/file_path.h>
 #include <string/stdstring.h>
 #include <streams/file_stream.h>
 #include <time/rtime.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
+#ifdef HAVE_CHEATS
+#include "cheat_manager.h"
+#endif
 #include "content.h"
 #include "core.h"
+#include "core_option_manager.h"
 #include "dynamic.h"
 #include "driver.h"
 #include "audio/audio_driver.h"
@@ -37,34 +45,46 @@
 #include "runloop.h"
 #include "verbosity.h"
 
-static int16_t input_state_get_last(unsigned port,
-      unsigned device, unsigned index, unsigned id)
+static input_list_element *input_list_find(const my_list *list,
+      unsigned port, unsigned device, unsigned index)
 {
-   runloop_state_t      *runloop_st = runloop_state_get_ptr();
-
-   if (runloop_st->input_state_list)
+   if (list)
    {
       int i;
       /* find list item */
-      for (i = 0; i < runloop_st->input_state_list->size; i++)
+      for (i = 0; i < list->size; i++)
       {
-         input_list_element *element =
-            (input_list_element*)runloop_st->input_state_list->data[i];
+         input_list_element *element = (input_list_element*)list->data[i];
 
          if (     (element->port   == port)
                && (element->device == device)
                && (element->index  == index))
-         {
-            if (id < element->state_size)
-               return element->state[id];
-            break;
-         }
+            return element;
       }
    }
 
+   return NULL;
+}
+
+static int16_t input_list_get_last(const my_list *list,
+      unsigned port, unsigned device, unsigned index, unsigned id)
+{
+   input_list_element *element = input_list_find(list,
+         port, device, index);
+
+   if (element && id < element->state_size)
+      return element->state[id];
    return 0;
 }
 
+static int16_t input_state_get_last(unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   runloop_state_t      *runloop_st = runloop_state_get_ptr();
+   return input_list_get_last(runloop_st->input_state_list,
+         port, device, index, id);
+}
+
 static void free_retro_ctx_load_content_info(struct
       retro_ctx_load_content_info *dest)
 {
@@ -177,28 +197,114 @@ static void strcat_alloc(char **dst, const char *s)
    strcpy_literal(src + len1, s);
 }
 
+static void runahead_core_instance_destroy(struct retro_core_t *core,
+      dylib_t *lib_handle, char **library_path)
+{
+   if (*lib_handle)
+   {
+      /* unload game from core */
+      if (core->retro_unload_game)
+         core->retro_unload_game();
+
+      /* deinit */
+      if (core->retro_deinit)
+         core->retro_deinit();
+
+      dylib_close(*lib_handle);
+      *lib_handle = NULL;
+   }
+   memset(core, 0, sizeof(struct retro_core_t));
+
+   if (*library_path)
+   {
+      filestream_delete(*library_path);
+      free(*library_path);
+   }
+   *library_path = NULL;
+}
+
+#ifdef HAVE_THREADS
+/* RUNAHEAD - SPECULATIVE INSTANCES
+ *
+ * Each instance is another private copy of the core, loaded, run
+ * and unloaded by one worker thread, so that cores keeping state
+ * per thread (libco, thread-local storage) never see it move.
+ * After every frame, all of them are loaded with the main core's
+ * state and run ahead by 'runahead_count' frames, each with the
+ * last input plus one recently changed input toggled. When the next
+ * frame's input turns out to match one of those guesses, the state
+ * that instance ended up in is loaded into the secondary core
+ * instead of replaying the frames on the main thread. */
+struct runahead_spec_input
+{
+   unsigned port;
+   unsigned device;
+   unsigned index;
+   unsigned id;
+   int bit;          /* Bit of RETRO_DEVICE_ID_JOYPAD_MASK, or -1 */
+};
+
+struct runahead_spec_branch
+{
+   struct retro_core_t core;           /* uint64_t alignment */
+   runahead_spec_t *spec;
+   char *library_path;
+   my_list *input_state_list;
+   void *result;                       /* State after the guess */
+   dylib_t lib_handle;
+   sthread_t *thread;
+   uintptr_t thread_id;
+   unsigned frames;
+   bool armed;
+   bool pending;
+   bool loading;
+   bool exclusive;   /* Main thread waits while this one loads/unloads */
+   bool ready;
+   bool created;
+   bool quit;
+   bool ok;
+};
+
+struct runahead_spec
+{
+   struct runahead_spec_branch
+      branches[MAX_RUNAHEAD_SPECULATIVE];  /* uint64_t alignment */
+   uint64_t serial;
+   struct runahead_spec_input recent[MAX_RUNAHEAD_SPECULATIVE];
+   /* Core option values when the instances were created;
+    * changing an option recreates the instances */
+   struct string_list *option_keys;
+   struct string_list *option_vals;
+   void *state;
+   size_t state_size;
+   slock_t *lock;
+   scond_t *cond;
+   unsigned count;
+   unsigned requested;
+   unsigned num_recent;
+   bool active;
+};
+
+static void runahead_speculation_destroy(runloop_state_t *runloop_st);
+#endif
+
 void runahead_secondary_core_destroy(void *data)
 {
    runloop_state_t *runloop_st      = (runloop_state_t*)data;
+
+#ifdef HAVE_THREADS
+   /* Speculative instances only make sense
+    * alongside the secondary one */
+   runahead_speculation_destroy(runloop_st);
+#endif
+
    if (!runloop_st->secondary_lib_handle)
       return;
 
-   /* unload game from core */
-   if (runloop_st->secondary_core.retro_unload_game)
-      runloop_st->secondary_core.retro_unload_game();
+   runahead_core_instance_destroy(&runloop_st->secondary_core,
+         &runloop_st->secondary_lib_handle,
+         &runloop_st->secondary_library_path);
    runloop_st->core_poll_type_override = POLL_TYPE_OVERRIDE_DONTCARE;
-
-   /* deinit */
-   if (runloop_st->secondary_core.retro_deinit)
-      runloop_st->secondary_core.retro_deinit();
-   memset(&runloop_st->secondary_core, 0, sizeof(struct retro_core_t));
-
-   dylib_close(runloop_st->secondary_lib_handle);
-   runloop_st->secondary_lib_handle = NULL;
-   filestream_delete(runloop_st->secondary_library_path);
-   if (runloop_st->secondary_library_path)
-      free(runloop_st->secondary_library_path);
-   runloop_st->secondary_library_path = NULL;
 }
 
 static char *get_tmpdir_alloc(const char *override_dir)
@@ -294,8 +400,9 @@ static bool write_file_with_random_name(char **temp_dll_path,
    /* Try up to 30 'random' filenames before giving up */
    for (i = 0; i < 30; i++)
    {
-      int number_value = _number_value * 214013 + 2531011;
-      int number       = (number_value >> 14) % 100000;
+      int number;
+      _number_value    = _number_value * 214013 + 2531011;
+      number           = (_number_value >> 14) % 100000;
 
       snprintf(number_buf, sizeof(number_buf), "%05d", number);
 
@@ -309,6 +416,11 @@ static bool write_file_with_random_name(char **temp_dll_path,
       strcat_alloc(temp_dll_path, number_buf);
       strcat_alloc(temp_dll_path, ext);
 
+      /* Several copies can be made within the same second,
+       * never overwrite one that may already be loaded */
+      if (path_is_valid(*temp_dll_path))
+         continue;
+
       if (filestream_write_file(*temp_dll_path, data, dataSize))
       {
          okay = true;
@@ -361,7 +473,9 @@ static char *copy_core_to_temp_file(
    strcat_alloc(&tmp_dll_path, PATH_DEFAULT_SLASH());
    strcat_alloc(&tmp_dll_path, core_base_name);
 
-   if (!filestream_write_file(tmp_dll_path, dll_file_data, dll_file_size))
+   /* Another instance may already be loaded from there */
+   if (     path_is_valid(tmp_dll_path)
+         || !filestream_write_file(tmp_dll_path, dll_file_data, dll_file_size))
    {
       /* try other file names */
       if (!write_file_with_random_name(&tmp_dll_path,
@@ -410,6 +524,82 @@ static bool runloop_environment_secondary_core_hook(
    return result;
 }
 
+#ifdef HAVE_THREADS
+/* Environment callback of the speculative instances,
+ * only ever called from their own threads */
+static bool runahead_speculation_environment(unsigned cmd, void *data)
+{
+   unsigned i;
+   runloop_state_t *runloop_st        = runloop_state_get_ptr();
+   runahead_spec_t *spec              = runloop_st->runahead_spec;
+   uintptr_t thread_id                = sthread_get_current_thread_id();
+   struct runahead_spec_branch
+      *branch                         = NULL;
+
+   for (i = 0; i < MAX_RUNAHEAD_SPECULATIVE; i++)
+   {
+      if (spec->branches[i].thread_id == thread_id)
+      {
+         branch = &spec->branches[i];
+         break;
+      }
+   }
+
+   /* While the main thread waits for the instance to be loaded
+    * or unloaded, it may use the frontend as the secondary does */
+   if (branch && branch->exclusive)
+      return runloop_environment_secondary_core_hook(cmd, data);
+
+   /* Otherwise it only gets the read-only
+    * queries a core may make while running */
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT:
+         if (data)
+            *(int*)data = (branch && branch->loading)
+               ? RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_BINARY
+               : RETRO_SAVESTATE_CONTEXT_NORMAL;
+         return true;
+      case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+         if (data)
+            *(int*)data = (branch && branch->loading) ? (4 | 8) : 8;
+         return true;
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         if (data)
+            *(bool*)data = false;
+         return true;
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+         {
+            size_t j;
+            struct retro_variable *var  = (struct retro_variable*)data;
+
+            if (!var)
+               return true;
+
+            var->value = NULL;
+
+            for (j = 0; spec->option_keys
+                  && j < spec->option_keys->size; j++)
+            {
+               if (string_is_equal(var->key,
+                        spec->option_keys->elems[j].data))
+               {
+                  var->value = spec->option_vals->elems[j].data;
+                  break;
+               }
+            }
+            return (var->value != NULL);
+         }
+      case RETRO_ENVIRONMENT_GET_INPUT_BITMASKS:
+         return true;
+      default:
+         break;
+   }
+
+   return false;
+}
+#endif
+
 void runahead_clear_controller_port_map(void *data)
 {
    int port;
@@ -418,13 +608,15 @@ void runahead_clear_controller_port_map(void *data)
       runloop_st->port_map[port] = -1;
 }
 
-static bool secondary_core_create(runloop_state_t *runloop_st,
-      settings_t *settings)
+/* Loads a private copy of the current core
+ * and content, for use as an extra instance */
+static bool runahead_core_instance_create(runloop_state_t *runloop_st,
+      settings_t *settings, struct retro_core_t *core,
+      dylib_t *lib_handle, char **library_path,
+      retro_environment_t environ_cb)
 {
    const enum rarch_core_type
       last_core_type             = runloop_st->last_core_type;
-   rarch_system_info_t *sys_info = &runloop_st->system;
-   unsigned num_active_users     = settings->uints.input_max_users;
    uint8_t flags                 = content_get_flags();
 
    if (     (last_core_type != CORE_TYPE_PLAIN)
@@ -432,34 +624,32 @@ static bool secondary_core_create(runloop_state_t *runloop_st,
          || ( runloop_st->load_content_info->special))
       return false;
 
-   if (runloop_st->secondary_library_path)
-      free(runloop_st->secondary_library_path);
-   runloop_st->secondary_library_path = NULL;
-   runloop_st->secondary_library_path = copy_core_to_temp_file(
+   if (*library_path)
+      free(*library_path);
+   *library_path = NULL;
+   *library_path = copy_core_to_temp_file(
 		   path_get(RARCH_PATH_CORE),
 		   settings->paths.directory_libretro);
 
-   if (!runloop_st->secondary_library_path)
+   if (!*library_path)
       return false;
 
    /* Load Core */
    if (!runloop_init_libretro_symbols(runloop_st,
-            CORE_TYPE_PLAIN, &runloop_st->secondary_core,
-            runloop_st->secondary_library_path,
-            &runloop_st->secondary_lib_handle))
+            CORE_TYPE_PLAIN, core,
+            *library_path,
+            lib_handle))
       return false;
 
-   runloop_st->secondary_core.flags |= RETRO_CORE_FLAG_SYMBOLS_INITED;
-   runloop_st->secondary_core.retro_set_environment(
-         runloop_environment_secondary_core_hook);
-   runloop_st->flags                |= RUNLOOP_FLAG_HAS_VARIABLE_UPDATE;
+   core->flags |= RETRO_CORE_FLAG_SYMBOLS_INITED;
+   core->retro_set_environment(environ_cb);
 
-   runloop_st->secondary_core.retro_init();
+   core->retro_init();
 
    if (flags & CONTENT_ST_FLAG_IS_INITED)
-      runloop_st->secondary_core.flags |=  RETRO_CORE_FLAG_INITED;
+      core->flags |=  RETRO_CORE_FLAG_INITED;
    else
-      runloop_st->secondary_core.flags &= ~RETRO_CORE_FLAG_INITED;
+      core->flags &= ~RETRO_CORE_FLAG_INITED;
 
    /* Load Content */
    /* disabled due to crashes */
@@ -470,30 +660,31 @@ static bool secondary_core_create(runloop_state_t *runloop_st,
    if ( (   runloop_st->load_content_info->content->size > 0)
          && runloop_st->load_content_info->content->elems[0].data)
    {
-      if (!runloop_st->secondary_core.retro_load_game(
+      if (!core->retro_load_game(
                runloop_st->load_content_info->info))
       {
-         runloop_st->secondary_core.flags &= ~RETRO_CORE_FLAG_GAME_LOADED;
-         goto error;
+         core->flags &= ~RETRO_CORE_FLAG_GAME_LOADED;
+         return false;
       }
-      runloop_st->secondary_core.flags    |=  RETRO_CORE_FLAG_GAME_LOADED;
+      core->flags    |=  RETRO_CORE_FLAG_GAME_LOADED;
    }
    else if (flags & CONTENT_ST_FLAG_CORE_DOES_NOT_NEED_CONTENT)
    {
-      if (!runloop_st->secondary_core.retro_load_game(NULL))
+      if (!core->retro_load_game(NULL))
       {
-         runloop_st->secondary_core.flags &= ~RETRO_CORE_FLAG_GAME_LOADED;
-         goto error;
+         core->flags &= ~RETRO_CORE_FLAG_GAME_LOADED;
+         return false;
       }
-      runloop_st->secondary_core.flags    |=  RETRO_CORE_FLAG_GAME_LOADED;
+      core->flags    |=  RETRO_CORE_FLAG_GAME_LOADED;
    }
    else
-      runloop_st->secondary_core.flags    &= ~RETRO_CORE_FLAG_GAME_LOADED;
+      core->flags    &= ~RETRO_CORE_FLAG_GAME_LOADED;
 
-   if (!(runloop_st->secondary_core.flags & RETRO_CORE_FLAG_INITED))
-      goto error;
+   return (core->flags & RETRO_CORE_FLAG_INITED) ? true : false;
+}
 
-   core_set_default_callbacks(&runloop_st->secondary_callbacks);
+static void runahead_secondary_core_attach(runloop_state_t *runloop_st)
+{
    runloop_st->secondary_core.retro_set_video_refresh(
          runloop_st->secondary_callbacks.frame_cb);
    runloop_st->secondary_core.retro_set_audio_sample(
@@ -504,6 +695,25 @@ static bool secondary_core_create(runloop_state_t *runloop_st,
          runloop_st->secondary_callbacks.state_cb);
    runloop_st->secondary_core.retro_set_input_poll(
          runloop_st->secondary_callbacks.poll_cb);
+}
+
+static bool secondary_core_create(runloop_state_t *runloop_st,
+      settings_t *settings)
+{
+   rarch_system_info_t *sys_info = &runloop_st->system;
+   unsigned num_active_users     = settings->uints.input_max_users;
+
+   runloop_st->flags            |= RUNLOOP_FLAG_HAS_VARIABLE_UPDATE;
+
+   if (!runahead_core_instance_create(runloop_st, settings,
+            &runloop_st->secondary_core,
+            &runloop_st->secondary_lib_handle,
+            &runloop_st->secondary_library_path,
+            runloop_environment_secondary_core_hook))
+      goto error;
+
+   core_set_default_callbacks(&runloop_st->secondary_callbacks);
+   runahead_secondary_core_attach(runloop_st);
 
    if (sys_info)
    {
@@ -608,6 +818,10 @@ void runahead_remember_controller_port_device(void *data,
    if (     runloop_st->secondary_lib_handle
          && runloop_st->secondary_core.retro_set_controller_port_device)
       runloop_st->secondary_core.retro_set_controller_port_device((unsigned)port, (unsigned)device);
+#ifdef HAVE_THREADS
+   /* Recreated with the new device on the next frame */
+   runahead_speculation_destroy(runloop_st);
+#endif
 }
 
 #else
@@ -767,22 +981,22 @@ static void input_list_element_destructor(void* element_ptr)
 }
 
 static void runahead_input_state_set_last(
-      runloop_state_t *runloop_st,
+      my_list **list_p,
       unsigned port, unsigned device,
       unsigned index, unsigned id, int16_t value)
 {
    unsigned i;
    input_list_element *element = NULL;
 
-   if (!runloop_st->input_state_list)
-      mylist_create(&runloop_st->input_state_list, 16,
+   if (!*list_p)
+      mylist_create(list_p, 16,
             input_list_element_constructor,
             input_list_element_destructor);
 
    /* Find list item */
-   for (i = 0; i < (unsigned)runloop_st->input_state_list->size; i++)
+   for (i = 0; i < (unsigned)(*list_p)->size; i++)
    {
-      element = (input_list_element*)runloop_st->input_state_list->data[i];
+      element = (input_list_element*)(*list_p)->data[i];
       if (  (element->port   == port)   &&
             (element->device == device) &&
             (element->index  == index)
@@ -796,9 +1010,9 @@ static void runahead_input_state_set_last(
    }
 
    element               = NULL;
-   if (runloop_st->input_state_list)
+   if (*list_p)
       element            = (input_list_element*)
-         mylist_add_element(runloop_st->input_state_list);
+         mylist_add_element(*list_p);
    if (element)
    {
       element->port         = port;
@@ -810,6 +1024,563 @@ static void runahead_input_state_set_last(
    }
 }
 
+#if (defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)) && defined(HAVE_THREADS)
+static void runahead_speculation_note_input(runahead_spec_t *spec,
+      unsigned port, unsigned device, unsigned index,
+      unsigned id, int16_t changed)
+{
+   int bit = -1;
+
+   if (id == RETRO_DEVICE_ID_JOYPAD_MASK)
+   {
+      /* Lowest changed button only */
+      for (bit = 0; bit < 16; bit++)
+         if (changed & (1 << bit))
+            break;
+   }
+   else if (id > RETRO_DEVICE_ID_JOYPAD_R3)
+      return;
+
+   /* Move to the front of the list */
+   {
+      unsigned i;
+      unsigned last = (spec->num_recent < MAX_RUNAHEAD_SPECULATIVE)
+         ? spec->num_recent
+         : MAX_RUNAHEAD_SPECULATIVE - 1;
+
+      for (i = 0; i < spec->num_recent; i++)
+      {
+         struct runahead_spec_input *in = &spec->recent[i];
+         if (     in->port   == port
+               && in->device == device
+               && in->index  == index
+               && in->id     == id
+               && in->bit    == bit)
+         {
+            last = i;
+            break;
+         }
+      }
+
+      if (last == spec->num_recent)
+         spec->num_recent++;
+
+      memmove(&spec->recent[1], &spec->recent[0],
+            last * sizeof(spec->recent[0]));
+      spec->recent[0].port   = port;
+      spec->recent[0].device = device;
+      spec->recent[0].index  = index;
+      spec->recent[0].id     = id;
+      spec->recent[0].bit    = bit;
+   }
+}
+
+static int16_t runahead_speculation_input_state(unsigned slot,
+      unsigned port, unsigned device, unsigned index, unsigned id)
+{
+   runloop_state_t *runloop_st = runloop_state_get_ptr();
+   return input_list_get_last(
+         runloop_st->runahead_spec->branches[slot].input_state_list,
+         port, device, index, id);
+}
+
+#define RUNAHEAD_SPECULATION_INPUT_STATE(slot) \
+static int16_t runahead_speculation_input_state_##slot(unsigned port, \
+      unsigned device, unsigned index, unsigned id) \
+{ \
+   return runahead_speculation_input_state(slot, port, device, index, id); \
+}
+
+RUNAHEAD_SPECULATION_INPUT_STATE(0)
+RUNAHEAD_SPECULATION_INPUT_STATE(1)
+RUNAHEAD_SPECULATION_INPUT_STATE(2)
+
+static const retro_input_state_t
+runahead_speculation_input_state_cbs[MAX_RUNAHEAD_SPECULATIVE] = {
+   runahead_speculation_input_state_0,
+   runahead_speculation_input_state_1,
+   runahead_speculation_input_state_2
+};
+
+static void runahead_speculation_video_null(const void *data,
+      unsigned width, unsigned height, size_t pitch) { }
+static void runahead_speculation_audio_null(int16_t left, int16_t right) { }
+static size_t runahead_speculation_audio_batch_null(
+      const int16_t *data, size_t frames) { return frames; }
+
+static void runahead_speculation_attach(struct retro_core_t *core,
+      unsigned slot)
+{
+   core->retro_set_video_refresh(runahead_speculation_video_null);
+   core->retro_set_audio_sample(runahead_speculation_audio_null);
+   core->retro_set_audio_sample_batch(
+         runahead_speculation_audio_batch_null);
+   core->retro_set_input_state(
+         runahead_speculation_input_state_cbs[slot]);
+   core->retro_set_input_poll(secondary_core_input_poll_null);
+}
+
+#ifdef HAVE_CHEATS
+static void runahead_speculation_apply_cheats(struct retro_core_t *core)
+{
+   unsigned i, idx           = 0;
+   cheat_manager_t *cheat_st = &cheat_manager_state;
+
+   if (     !cheat_st->cheats
+         || !core->retro_cheat_reset
+         || !core->retro_cheat_set)
+      return;
+
+   core->retro_cheat_reset();
+
+   for (i = 0; i < cheat_st->size; i++)
+   {
+      if (     cheat_st->cheats[i].state
+            && cheat_st->cheats[i].handler == CHEAT_HANDLER_TYPE_EMU
+            && !string_is_empty(cheat_st->cheats[i].code))
+         core->retro_cheat_set(idx++, true, cheat_st->cheats[i].code);
+   }
+}
+#endif
+
+/* Loads the instance, on the thread that will run it */
+static bool runahead_speculation_branch_create(runloop_state_t *runloop_st,
+      struct runahead_spec_branch *branch, unsigned slot)
+{
+   ssize_t port;
+   settings_t *settings           = config_get_ptr();
+   rarch_system_info_t *sys_info  = &runloop_st->system;
+   unsigned num_active_users      = settings->uints.input_max_users;
+
+   if (!runahead_core_instance_create(runloop_st, settings,
+            &branch->core, &branch->lib_handle,
+            &branch->library_path,
+            runahead_speculation_environment))
+      return false;
+
+   runahead_speculation_attach(&branch->core, slot);
+
+   for (port = 0; port < MAX_USERS; port++)
+   {
+      if (port < sys_info->ports.size)
+      {
+         unsigned device = (port < num_active_users)
+               ? input_config_get_device((unsigned)port)
+               : RETRO_DEVICE_NONE;
+         branch->core.retro_set_controller_port_device(
+               (unsigned)port, device);
+      }
+   }
+
+#ifdef HAVE_CHEATS
+   runahead_speculation_apply_cheats(&branch->core);
+#endif
+
+   return true;
+}
+
+static void runahead_speculation_thread(void *data)
+{
+   struct runahead_spec_branch *branch = (struct runahead_spec_branch*)data;
+   runahead_spec_t *spec               = branch->spec;
+   runloop_state_t *runloop_st         = runloop_state_get_ptr();
+   bool created;
+
+   branch->thread_id   = sthread_get_current_thread_id();
+   branch->exclusive   = true;
+   created             = runahead_speculation_branch_create(runloop_st,
+         branch, (unsigned)(branch - spec->branches));
+   branch->exclusive   = false;
+
+   slock_lock(spec->lock);
+   branch->created     = created;
+   branch->ready       = true;
+   scond_broadcast(spec->cond);
+
+   while (created)
+   {
+      unsigned i;
+      bool ok;
+
+      while (!branch->pending && !branch->quit)
+         scond_wait(spec->cond, spec->lock);
+      if (branch->quit)
+         break;
+      slock_unlock(spec->lock);
+
+      branch->loading = true;
+      ok              = branch->core.retro_unserialize(
+            spec->state, spec->state_size);
+      branch->loading = false;
+
+      for (i = 0; ok && i < branch->frames; i++)
+         branch->core.retro_run();
+
+      /* Kept for the secondary core, in case this was the right guess */
+      branch->loading = true;
+      ok              = ok && branch->core.retro_serialize(
+            branch->result, spec->state_size);
+      branch->loading = false;
+
+      slock_lock(spec->lock);
+      branch->ok      = ok;
+      branch->pending = false;
+      scond_broadcast(spec->cond);
+   }
+
+   while (!branch->quit)
+      scond_wait(spec->cond, spec->lock);
+   slock_unlock(spec->lock);
+
+   branch->exclusive   = true;
+   runahead_core_instance_destroy(&branch->core,
+         &branch->lib_handle, &branch->library_path);
+   branch->exclusive   = false;
+}
+
+static void runahead_speculation_wait(runahead_spec_t *spec)
+{
+   unsigned i;
+
+   slock_lock(spec->lock);
+   for (i = 0; i < spec->count; i++)
+      while (spec->branches[i].pending)
+         scond_wait(spec->cond, spec->lock);
+   slock_unlock(spec->lock);
+}
+
+/* Has the thread of one instance unload it, and waits for it */
+static void runahead_speculation_branch_destroy(runahead_spec_t *spec,
+      struct runahead_spec_branch *branch)
+{
+   slock_lock(spec->lock);
+   branch->quit = true;
+   scond_broadcast(spec->cond);
+   slock_unlock(spec->lock);
+
+   sthread_join(branch->thread);
+   branch->thread = NULL;
+}
+
+static void runahead_speculation_destroy(runloop_state_t *runloop_st)
+{
+   unsigned i;
+   runahead_spec_t *spec = runloop_st->runahead_spec;
+
+   if (!spec)
+      return;
+
+   /* One at a time, since each of them may
+    * use the frontend while unloading */
+   for (i = 0; i < spec->count; i++)
+      runahead_speculation_branch_destroy(spec, &spec->branches[i]);
+
+   runloop_st->runahead_spec = NULL;
+
+   for (i = 0; i < spec->count; i++)
+   {
+      struct runahead_spec_branch *branch = &spec->branches[i];
+      mylist_destroy(&branch->input_state_list);
+      free(branch->result);
+   }
+
+   string_list_free(spec->option_keys);
+   string_list_free(spec->option_vals);
+   if (spec->cond)
+      scond_free(spec->cond);
+   if (spec->lock)
+      slock_free(spec->lock);
+   free(spec->state);
+   free(spec);
+}
+
+/* Copies the values of the core options, so the instances
+ * can read them without racing the main thread */
+static bool runahead_speculation_snapshot_options(runahead_spec_t *spec,
+      core_option_manager_t *opts)
+{
+   size_t i;
+   union string_list_elem_attr attr;
+
+   attr.i = 0;
+
+   if (     !(spec->option_keys = string_list_new())
+         || !(spec->option_vals = string_list_new()))
+      return false;
+
+   for (i = 0; opts && i < opts->size; i++)
+   {
+      const char *val = core_option_manager_get_val(opts, i);
+
+      if (     string_is_empty(opts->opts[i].key)
+            || !val)
+         continue;
+
+      if (     !string_list_append(spec->option_keys,
+               opts->opts[i].key, attr)
+            || !string_list_append(spec->option_vals, val, attr))
+         return false;
+   }
+
+   return true;
+}
+
+static runahead_spec_t *runahead_speculation_create(
+      runloop_state_t *runloop_st, unsigned instances)
+{
+   unsigned i;
+   video_driver_state_t *video_st = video_state_get_ptr();
+   runahead_spec_t *spec          = (runahead_spec_t*)
+      calloc(1, sizeof(*spec));
+
+   if (!spec)
+      return NULL;
+
+   /* Even if no instance can be created, keep this around
+    * so that creation isn't retried on every frame */
+   spec->requested                = instances;
+   runloop_st->runahead_spec      = spec;
+
+   /* Worker threads can't render into the main context */
+   if (video_st->hw_render.context_type != RETRO_HW_CONTEXT_NONE)
+   {
+      RARCH_WARN("[Run-Ahead]: Speculative instances are not supported by hardware rendered cores.\n");
+      return spec;
+   }
+
+   if (     !(spec->lock  = slock_new())
+         || !(spec->cond  = scond_new())
+         || !(spec->state = malloc(runloop_st->runahead_save_state_size))
+         || !runahead_speculation_snapshot_options(spec,
+            runloop_st->core_options))
+      return spec;
+   spec->state_size               = runloop_st->runahead_save_state_size;
+
+   if (instances > MAX_RUNAHEAD_SPECULATIVE)
+      instances                   = MAX_RUNAHEAD_SPECULATIVE;
+
+   for (i = 0; i < instances; i++)
+   {
+      bool created;
+      struct runahead_spec_branch *branch = &spec->branches[i];
+
+      branch->spec   = spec;
+      if (!(branch->result = malloc(spec->state_size)))
+         break;
+
+      created        = false;
+      if ((branch->thread = sthread_create(
+                  runahead_speculation_thread, branch)))
+      {
+         /* The thread loads the instance itself, which
+          * may use the frontend as the secondary one does */
+         slock_lock(spec->lock);
+         while (!branch->ready)
+            scond_wait(spec->cond, spec->lock);
+         created     = branch->created;
+         slock_unlock(spec->lock);
+
+         if (!created)
+            runahead_speculation_branch_destroy(spec, branch);
+      }
+
+      if (!created)
+      {
+         free(branch->result);
+         branch->result = NULL;
+         break;
+      }
+      spec->count++;
+   }
+
+   RARCH_LOG("[Run-Ahead]: Created %u speculative instance(s).\n",
+         spec->count);
+
+   return spec;
+}
+
+/* Whether the two lists hold the same value for every input */
+static bool runahead_speculation_input_covers(const my_list *a,
+      const my_list *b)
+{
+   int i;
+
+   if (!a)
+      return true;
+
+   for (i = 0; i < a->size; i++)
+   {
+      unsigned id;
+      input_list_element *x = (input_list_element*)a->data[i];
+      input_list_element *y = input_list_find(b,
+            x->port, x->device, x->index);
+
+      for (id = 0; id < x->state_size; id++)
+      {
+         int16_t other = (y && id < y->state_size) ? y->state[id] : 0;
+         if (x->state[id] != other)
+            return false;
+      }
+   }
+
+   return true;
+}
+
+static void runahead_speculation_predict(runloop_state_t *runloop_st,
+      struct runahead_spec_branch *branch,
+      const struct runahead_spec_input *in)
+{
+   int i;
+   int16_t value;
+   const my_list *src = runloop_st->input_state_list;
+
+   if (!branch->input_state_list)
+      mylist_create(&branch->input_state_list, 16,
+            input_list_element_constructor,
+            input_list_element_destructor);
+
+   mylist_resize(branch->input_state_list, src ? src->size : 0, true);
+
+   for (i = 0; src && i < src->size; i++)
+   {
+      input_list_element *s = (input_list_element*)src->data[i];
+      input_list_element *d = (input_list_element*)
+         branch->input_state_list->data[i];
+
+      input_list_element_realloc(d, s->state_size);
+      d->port   = s->port;
+      d->device = s->device;
+      d->index  = s->index;
+      memcpy(d->state, s->state, s->state_size * sizeof(int16_t));
+      memset(&d->state[s->state_size], 0,
+            (d->state_size - s->state_size) * sizeof(int16_t));
+   }
+
+   value = input_list_get_last(branch->input_state_list,
+         in->port, in->device, in->index, in->id);
+   if (in->bit >= 0)
+      value ^= (1 << in->bit);
+   else
+      value  = !value;
+   runahead_input_state_set_last(&branch->input_state_list,
+         in->port, in->device, in->index, in->id, value);
+}
+
+/* Starts running ahead of the main core's current state
+ * with each guess of what the next input will be */
+static void runahead_speculation_start(runloop_state_t *runloop_st,
+      unsigned instances, int frames)
+{
+   unsigned i;
+   bool busy                     = false;
+   retro_ctx_serialize_info_t serial_info;
+   runahead_spec_t *spec         = runloop_st->runahead_spec;
+
+   if (spec && spec->requested != instances)
+   {
+      runahead_speculation_destroy(runloop_st);
+      spec                       = NULL;
+   }
+
+   if (!spec && !(spec = runahead_speculation_create(
+               runloop_st, instances)))
+      return;
+
+   spec->active                  = false;
+
+   if (!spec->count || !spec->num_recent)
+      return;
+
+   /* Guesses from an earlier frame still running;
+    * sit this one out rather than stall */
+   slock_lock(spec->lock);
+   for (i = 0; i < spec->count; i++)
+      busy                      |= spec->branches[i].pending;
+   slock_unlock(spec->lock);
+
+   if (busy)
+      return;
+
+   serial_info.data_const        = spec->state;
+   serial_info.data              = spec->state;
+   serial_info.size              = spec->state_size;
+   if (!core_serialize_special(&serial_info))
+      return;
+
+   for (i = 0; i < spec->count; i++)
+   {
+      struct runahead_spec_branch *branch = &spec->branches[i];
+
+      branch->armed              = (i < spec->num_recent);
+      branch->ok                 = false;
+      if (!branch->armed)
+         continue;
+
+      runahead_speculation_predict(runloop_st, branch, &spec->recent[i]);
+      branch->frames             = (unsigned)frames;
+   }
+
+   slock_lock(spec->lock);
+   for (i = 0; i < spec->count; i++)
+      spec->branches[i].pending  = spec->branches[i].armed;
+   scond_broadcast(spec->cond);
+   slock_unlock(spec->lock);
+
+   spec->serial                  = runloop_st->core_state_serial;
+   spec->active                  = true;
+}
+
+/* Called after the main core has run one frame past the state
+ * the instances started from. If one of them guessed its input,
+ * its state is loaded into the secondary core, which is then
+ * already 'runahead_count' frames ahead. */
+static bool runahead_speculation_commit(runloop_state_t *runloop_st)
+{
+   unsigned i;
+   runahead_spec_t *spec = runloop_st->runahead_spec;
+
+   if (!spec || !spec->active)
+      return false;
+
+   spec->active          = false;
+
+   if (runloop_st->core_state_serial != spec->serial + 1)
+      return false;
+
+   runahead_speculation_wait(spec);
+
+   for (i = 0; i < spec->count; i++)
+   {
+      bool ok;
+      struct runahead_spec_branch *branch = &spec->branches[i];
+
+      if (     !branch->armed
+            || !branch->ok
+            || !runahead_speculation_input_covers(
+               runloop_st->input_state_list, branch->input_state_list)
+            || !runahead_speculation_input_covers(
+               branch->input_state_list, runloop_st->input_state_list))
+         continue;
+
+      /* The secondary core stays on this thread,
+       * and takes over where the instance got to */
+      branch->armed      = false;
+      runloop_st->flags |=  RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE;
+      ok                 = runloop_st->secondary_core.retro_unserialize(
+            branch->result, spec->state_size);
+      runloop_st->flags &= ~RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE;
+      return ok;
+   }
+
+   return false;
+}
+
+void runahead_speculation_deinit(void *data)
+{
+   runahead_speculation_destroy((runloop_state_t*)data);
+}
+#endif
+
 static int16_t runahead_input_state_with_logging(unsigned port,
       unsigned device, unsigned index, unsigned id)
 {
@@ -823,10 +1594,19 @@ static int16_t runahead_input_state_with_logging(unsigned port,
       int16_t last_input            =
          input_state_get_last(port, device, index, id);
       if (result != last_input)
+      {
          runloop_st->flags         |= RUNLOOP_FLAG_INPUT_IS_DIRTY;
+#if (defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)) && defined(HAVE_THREADS)
+         if (     runloop_st->runahead_spec
+               && (device & RETRO_DEVICE_MASK) == RETRO_DEVICE_JOYPAD)
+            runahead_speculation_note_input(runloop_st->runahead_spec,
+                  port, device, index, id, result ^ last_input);
+#endif
+      }
       /*arbitrary limit of up to 65536 elements in state array*/
       if (id < 65536)
-         runahead_input_state_set_last(runloop_st, port, device, index, id, result);
+         runahead_input_state_set_last(&runloop_st->input_state_list,
+               port, device, index, id, result);
       return result;
    }
    return 0;
@@ -942,10 +1722,20 @@ static void runahead_save_state_list_init(
    runloop_st->runahead_save_state_size  = save_state_size;
    runloop_st->flags                    |= RUNLOOP_FLAG_RUNAHEAD_SAVE_STATE_SIZE_KNOWN;
 
+   if (!runloop_st->runahead_save_state_list)
+      core_state_cache_acquire();
    mylist_create(&runloop_st->runahead_save_state_list, 16,
          runahead_save_state_alloc, runahead_save_state_free);
 }
 
+static void runahead_save_state_list_deinit(runloop_state_t *runloop_st)
+{
+   if (!runloop_st->runahead_save_state_list)
+      return;
+   mylist_destroy(&runloop_st->runahead_save_state_list);
+   core_state_cache_release();
+}
+
 /* Hooks - Hooks to cleanup, and add dirty input hooks */
 static void runahead_remove_hooks(runloop_state_t *runloop_st)
 {
@@ -967,7 +1757,7 @@ static void runahead_remove_hooks(runloop_state_t *runloop_st)
 
 static void runahead_destroy(runloop_state_t *runloop_st)
 {
-   mylist_destroy(&runloop_st->runahead_save_state_list);
+   runahead_save_state_list_deinit(runloop_st);
    runahead_remove_hooks(runloop_st);
    runahead_clear_variables(runloop_st);
 }
@@ -1017,7 +1807,7 @@ static void runahead_add_hooks(runloop_state_t *runloop_st)
 static void runahead_error(runloop_state_t *runloop_st)
 {
    runloop_st->flags &= ~RUNLOOP_FLAG_RUNAHEAD_AVAILABLE;
-   mylist_destroy(&runloop_st->runahead_save_state_list);
+   runahead_save_state_list_deinit(runloop_st);
    runahead_remove_hooks(runloop_st);
    runloop_st->runahead_save_state_size       = 0;
    runloop_st->flags                         |= RUNLOOP_FLAG_RUNAHEAD_SAVE_STATE_SIZE_KNOWN;
@@ -1116,6 +1906,7 @@ static void runahead_core_run_use_last_input(runloop_state_t *runloop_st)
    runloop_st->current_core.retro_set_input_poll(cbs->poll_cb);
    runloop_st->current_core.retro_set_input_state(cbs->state_cb);
 
+   core_state_invalidate();
    runloop_st->current_core.retro_run();
 
    cbs->poll_cb                           = old_poll_function;
@@ -1128,7 +1919,8 @@ static void runahead_core_run_use_last_input(runloop_state_t *runloop_st)
 void runahead_run(void *data,
       int runahead_count,
       bool runahead_hide_warnings,
-      bool use_secondary)
+      bool use_secondary,
+      unsigned speculative_instances)
 {
    runloop_state_t *runloop_st = (runloop_state_t*)data;
    int frame_number        = 0;
@@ -1250,6 +2042,9 @@ void runahead_run(void *data,
    else
    {
 #if HAVE_DYNAMIC
+#ifdef HAVE_THREADS
+      bool had_variable_update = (runloop_st->flags & RUNLOOP_FLAG_HAS_VARIABLE_UPDATE) ? true : false;
+#endif
       if (!secondary_core_ensure_exists(runloop_st, config_get_ptr()))
       {
          const char *runahead_failed_str =
@@ -1269,6 +2064,18 @@ void runahead_run(void *data,
       else
          video_st->flags &= ~VIDEO_FLAG_ACTIVE;
 
+#ifdef HAVE_THREADS
+      /* Speculative instances never see core option
+       * changes, start over with fresh ones */
+      if (     !had_variable_update
+            && (runloop_st->flags & RUNLOOP_FLAG_HAS_VARIABLE_UPDATE))
+         runahead_speculation_destroy(runloop_st);
+      else if ( (runloop_st->flags & RUNLOOP_FLAG_INPUT_IS_DIRTY)
+            && !(runloop_st->flags & RUNLOOP_FLAG_RUNAHEAD_FORCE_INPUT_DIRTY)
+            && runahead_speculation_commit(runloop_st))
+         runloop_st->flags &= ~RUNLOOP_FLAG_INPUT_IS_DIRTY;
+#endif
+
       if (     (runloop_st->flags & RUNLOOP_FLAG_INPUT_IS_DIRTY)
             || (runloop_st->flags & RUNLOOP_FLAG_RUNAHEAD_FORCE_INPUT_DIRTY))
       {
@@ -1317,6 +2124,14 @@ void runahead_run(void *data,
          runloop_st->flags              &= ~RUNLOOP_FLAG_RUNAHEAD_SECONDARY_CORE_AVAILABLE;
       audio_st->flags                   &= ~(AUDIO_FLAG_SUSPENDED
                                          | AUDIO_FLAG_HARD_DISABLE);
+
+#ifdef HAVE_THREADS
+      if (speculative_instances > 0)
+         runahead_speculation_start(runloop_st,
+               speculative_instances, runahead_count);
+      else
+         runahead_speculation_destroy(runloop_st);
+#endif
 #endif
    }
    runloop_st->flags &= ~RUNLOOP_FLAG_RUNAHEAD_FORCE_INPUT_DIRTY;
@@ -1370,6 +2185,8 @@ static const char* preempt_allocate(runloop_state_t *runloop_st,
    if (!(runloop_st->preempt_data = preempt))
       return msg_hash_to_str(MSG_PREEMPT_FAILED_TO_ALLOCATE);
 
+   core_state_cache_acquire();
+
    info_size = core_serialize_size_special();
    if (!info_size)
       return msg_hash_to_str(MSG_PREEMPT_CORE_DOES_NOT_SUPPORT_SAVESTATES);
@@ -1408,6 +2225,7 @@ void preempt_deinit(void *data)
 
    free(preempt);
    runloop_st->preempt_data = NULL;
+   core_state_cache_release();
 
    /* Undo overrides */
    runloop_st->flags |= (RUNLOOP_FLAG_RUNAHEAD_AVAILABLE
@@ -1453,7 +2271,10 @@ bool preempt_init(void *data)
    /* Run at least one frame before attempting
     * retro_serialize_size or retro_serialize */
    if (video_state_get_ptr()->frame_count == 0)
+   {
+      core_state_invalidate();
       runloop_st->current_core.retro_run();
+   }
 
    /* Allocate - same 'frames' setting as runahead */
    if ((failed_str = preempt_allocate(runloop_st,
@@ -1621,6 +2442,7 @@ void preempt_run(preempt_t *preempt, void *data)
 {
    runloop_state_t     *runloop_st   = (runloop_state_t*)data;
    struct retro_core_t *current_core = &runloop_st->current_core;
+   retro_ctx_serialize_info_t serial_info;
    const char *failed_str            = NULL;
    settings_t *settings              = config_get_ptr();
    audio_driver_state_t *audio_st    = audio_state_get_ptr();
@@ -1638,6 +2460,7 @@ void preempt_run(preempt_t *preempt, void *data)
       audio_st->flags |=  AUDIO_FLAG_SUSPENDED;
       video_st->flags &= ~VIDEO_FLAG_ACTIVE;
 
+      core_state_invalidate();
       if (!current_core->retro_unserialize(
             preempt->buffer[preempt->start_ptr], preempt->state_size))
       {
@@ -1665,9 +2488,11 @@ void preempt_run(preempt_t *preempt, void *data)
       video_st->flags |=  VIDEO_FLAG_ACTIVE;
    }
 
-   /* Save current state and set start_ptr to oldest state */
-   if (!current_core->retro_serialize(
-         preempt->buffer[preempt->start_ptr], preempt->state_size))
+   /* Save current state and set start_ptr to oldest state.
+    * Without replayed frames, rewind may already have taken it. */
+   serial_info.data = preempt->buffer[preempt->start_ptr];
+   serial_info.size = preempt->state_size;
+   if (!core_serialize_special(&serial_info))
    {
       failed_str = msg_hash_to_str(MSG_PREEMPT_FAILED_TO_SAVE_STATE);
       goto error;
@@ -1677,6 +2502,7 @@ void preempt_run(preempt_t *preempt, void *data)
          | RUNLOOP_FLAG_INPUT_IS_DIRTY);
 
    /* Run normal frame */
+   core_state_invalidate();
    current_core->retro_run();
    preempt->frame_count++;
    return;
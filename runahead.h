@@ -25,6 +25,7 @@
 #include "core.h"
 
 #define MAX_RUNAHEAD_FRAMES 12
+#define MAX_RUNAHEAD_SPECULATIVE 3
 
 typedef void *(*constructor_t)(void);
 typedef void  (*destructor_t )(void*);
@@ -68,11 +69,14 @@ RETRO_BEGIN_DECLS
 
 typedef bool(*runahead_load_state_function)(const void*, size_t);
 
+typedef struct runahead_spec runahead_spec_t;
+
 void runahead_run(
       void *data,
       int runahead_count,
       bool runahead_hide_warnings,
-      bool use_secondary);
+      bool use_secondary,
+      unsigned speculative_instances);
 
 void runahead_clear_variables(void *data);
 
@@ -86,6 +90,10 @@ void runahead_set_load_content_info(
 
 void runahead_secondary_core_destroy(void *data);
 
+/* Drops the speculative instances, e.g. because the
+ * cheats they were created with changed */
+void runahead_speculation_deinit(void *data);
+
 bool preempt_init(void *data);
 void preempt_deinit(void *data);
 
@@ -191,6 +191,7 @@
 #include "msg_hash.h"
 #include "paths.h"
 #include "file_path_special.h"
+#include "frame_trace.h"
 #include "ui/ui_companion_driver.h"
 #include "verbosity.h"
 
@@ -339,6 +340,15 @@ bool state_manager_frame_is_reversed(void)
 #endif
 }
 
+bool state_manager_uses_special_states(void)
+{
+#ifdef HAVE_REWIND
+   return (runloop_state.rewind_st.flags & STATE_MGR_REWIND_ST_FLAG_SPECIAL_STATES) > 0;
+#else
+   return false;
+#endif
+}
+
 content_state_t *content_state_get_ptr(void)
 {
    return &runloop_state.content_st;
@@ -6921,10 +6931,9 @@ int runloop_iterate(void)
             && audio_st->context_audio_data
             && audio_st->buffer_size)
       {
-         size_t audio_buf_avail;
+         size_t audio_buf_avail = audio_driver_write_avail();
 
-         if ((audio_buf_avail = audio_st->current_audio->write_avail(
-               audio_st->context_audio_data)) > audio_st->buffer_size)
+         if (audio_buf_avail > audio_st->buffer_size)
             audio_buf_avail = audio_st->buffer_size;
 
          audio_buf_occupancy = (unsigned)(100 - (audio_buf_avail * 100) /
@@ -7096,11 +7105,13 @@ int runloop_iterate(void)
    }
 
    {
+      retro_time_t trace_start          = frame_trace_begin_frame();
 #ifdef HAVE_RUNAHEAD
       bool run_ahead_enabled            = settings->bools.run_ahead_enabled;
       unsigned run_ahead_num_frames     = settings->uints.run_ahead_frames;
       bool run_ahead_hide_warnings      = settings->bools.run_ahead_hide_warnings;
       bool run_ahead_secondary_instance = settings->bools.run_ahead_secondary_instance;
+      unsigned run_ahead_speculative    = settings->uints.run_ahead_speculative_instances;
       /* Run Ahead Feature replaces the call to core_run in this loop */
       bool want_runahead                = run_ahead_enabled
             && (run_ahead_num_frames > 0)
@@ -7111,16 +7122,25 @@ int runloop_iterate(void)
 #endif
 
       if (want_runahead)
+      {
          runahead_run(
                runloop_st,
                run_ahead_num_frames,
                run_ahead_hide_warnings,
-               run_ahead_secondary_instance);
+               run_ahead_secondary_instance,
+               run_ahead_speculative);
+         frame_trace_add(FRAME_TRACE_RUN_AHEAD, trace_start);
+      }
       else if (runloop_st->preempt_data)
+      {
          preempt_run(runloop_st->preempt_data, runloop_st);
+         frame_trace_add(FRAME_TRACE_RUN_AHEAD, trace_start);
+      }
       else
 #endif
          core_run();
+
+      frame_trace_add(FRAME_TRACE_FRAME, trace_start);
    }
 
    /* Increment runtime tick counter after each call to
@@ -7181,7 +7201,11 @@ int runloop_iterate(void)
    /* Frame delay */
    if (     !(input_st->flags & INP_FLAG_NONBLOCKING)
          || (runloop_st->flags & RUNLOOP_FLAG_FASTMOTION))
+   {
+      retro_time_t trace_start = cpu_features_get_time_usec();
       video_frame_delay(video_st, settings, core_paused);
+      frame_trace_add(FRAME_TRACE_FRAME_DELAY, trace_start);
+   }
 
 end:
    if (vrr_runloop_enable)
@@ -7194,8 +7218,12 @@ end:
             /* Nonblocking audio */
             if (    (audio_st->flags & AUDIO_FLAG_ACTIVE)
                  && (audio_st->context_audio_data))
+            {
+               AUDIO_DRIVER_WRITE_LOCK(audio_st);
                audio_st->current_audio->set_nonblock_state(
                      audio_st->context_audio_data, true);
+               AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+            }
             audio_st->chunk_size =
                audio_st->chunk_nonblock_size;
          }
@@ -7207,9 +7235,13 @@ end:
             /* Blocking audio */
             if (     (audio_st->flags & AUDIO_FLAG_ACTIVE)
                   && (audio_st->context_audio_data))
+            {
+               AUDIO_DRIVER_WRITE_LOCK(audio_st);
                audio_st->current_audio->set_nonblock_state(
                      audio_st->context_audio_data,
                      audio_sync ? false : true);
+               AUDIO_DRIVER_WRITE_UNLOCK(audio_st);
+            }
 
             audio_st->chunk_size = audio_st->chunk_block_size;
             runloop_st->fastforward_after_frames = 0;
@@ -7544,6 +7576,7 @@ bool core_set_cheat(retro_ctx_cheat_info_t *info)
    }
 #endif
 
+   runloop_st->core_state_serial++;
    runloop_st->current_core.retro_cheat_set(info->index, info->enabled, info->code);
 
 #if defined(HAVE_RUNAHEAD) && (defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB))
@@ -7554,6 +7587,9 @@ bool core_set_cheat(retro_ctx_cheat_info_t *info)
          && (runloop_st->secondary_core.retro_cheat_set))
       runloop_st->secondary_core.retro_cheat_set(
             info->index, info->enabled, info->code);
+#ifdef HAVE_THREADS
+   runahead_speculation_deinit(runloop_st);
+#endif
 #endif
 
    return true;
@@ -7584,6 +7620,7 @@ bool core_reset_cheat(void)
    }
 #endif
 
+   runloop_st->core_state_serial++;
    runloop_st->current_core.retro_cheat_reset();
 
 #if defined(HAVE_RUNAHEAD) && (defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB))
@@ -7593,6 +7630,9 @@ bool core_reset_cheat(void)
        && (secondary_core_ensure_exists(runloop_st, settings))
        && (runloop_st->secondary_core.retro_cheat_reset))
       runloop_st->secondary_core.retro_cheat_reset();
+#ifdef HAVE_THREADS
+   runahead_speculation_deinit(runloop_st);
+#endif
 #endif
 
    return true;
@@ -7629,6 +7669,7 @@ bool core_set_controller_port_device(retro_ctx_controller_info_t *pad)
 #endif
 #endif
 
+   runloop_st->core_state_serial++;
    runloop_st->current_core.retro_set_controller_port_device(pad->port, pad->device);
    return true;
 }
@@ -7650,6 +7691,7 @@ bool core_load_game(retro_ctx_load_content_info_t *load_info)
    runloop_state_t *runloop_st    = &runloop_state;
 
    video_st->frame_cache_data     = NULL;
+   runloop_st->core_state_serial++;
 
 #ifdef HAVE_RUNAHEAD
    runahead_set_load_content_info(runloop_st, load_info);
@@ -7692,9 +7734,80 @@ bool core_get_system_info(struct retro_system_info *sysinfo)
    return true;
 }
 
+void core_state_invalidate(void)
+{
+   runloop_state.core_state_serial++;
+}
+
+void core_state_cache_acquire(void)
+{
+   runloop_state.core_state_cache.users++;
+}
+
+void core_state_cache_release(void)
+{
+   core_state_cache_t *cache = &runloop_state.core_state_cache;
+
+   if (!cache->users || --cache->users)
+      return;
+
+   free(cache->data);
+   cache->data     = NULL;
+   cache->size     = 0;
+   cache->capacity = 0;
+   cache->valid    = false;
+}
+
+bool core_state_cache_shared(void)
+{
+   return runloop_state.core_state_cache.users >= 2;
+}
+
+static void core_state_cache_store(runloop_state_t *runloop_st,
+      const void *data, size_t size)
+{
+   core_state_cache_t *cache = &runloop_st->core_state_cache;
+
+   if (cache->users < 2 || !data)
+      return;
+
+   if (size > cache->capacity)
+   {
+      uint8_t *tmp = (uint8_t*)realloc(cache->data, size);
+      if (!tmp)
+      {
+         cache->valid = false;
+         return;
+      }
+      cache->data     = tmp;
+      cache->capacity = size;
+   }
+
+   memcpy(cache->data, data, size);
+   cache->size   = size;
+   cache->serial = runloop_st->core_state_serial;
+   cache->valid  = true;
+}
+
+static bool core_state_cache_fetch(runloop_state_t *runloop_st,
+      void *data, size_t size)
+{
+   core_state_cache_t *cache = &runloop_st->core_state_cache;
+
+   if (     cache->users < 2
+         || !cache->valid
+         ||  cache->serial != runloop_st->core_state_serial
+         ||  cache->size   != size)
+      return false;
+
+   memcpy(data, cache->data, size);
+   return true;
+}
+
 bool core_unserialize(retro_ctx_serialize_info_t *info)
 {
    runloop_state_t *runloop_st  = &runloop_state;
+   runloop_st->core_state_serial++;
    if (!info || !runloop_st->current_core.retro_unserialize(info->data_const, info->size))
       return false;
 
@@ -7716,10 +7829,15 @@ bool core_unserialize_special(retro_ctx_serialize_info_t *info)
    if (!info)
       return false;
 
+   runloop_st->core_state_serial++;
    runloop_st->flags |=  RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE;
    ret = runloop_st->current_core.retro_unserialize(info->data_const, info->size);
    runloop_st->flags &= ~RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE;
 
+   /* The core now holds exactly this state */
+   if (ret)
+      core_state_cache_store(runloop_st, info->data_const, info->size);
+
 #ifdef HAVE_NETWORKING
    if (ret)
       netplay_driver_ctl(RARCH_NETPLAY_CTL_LOAD_SAVESTATE, info);
@@ -7744,11 +7862,17 @@ bool core_serialize_special(retro_ctx_serialize_info_t *info)
    if (!info)
       return false;
 
+   if (core_state_cache_fetch(runloop_st, info->data, info->size))
+      return true;
+
    runloop_st->flags |=  RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE;
    ret                = runloop_st->current_core.retro_serialize(
                         info->data, info->size);
    runloop_st->flags &= ~RUNLOOP_FLAG_REQUEST_SPECIAL_SAVESTATE;
 
+   if (ret)
+      core_state_cache_store(runloop_st, info->data, info->size);
+
    return ret;
 }
 
@@ -7780,6 +7904,7 @@ void core_reset(void)
    runloop_state_t *runloop_st    = &runloop_state;
    video_driver_state_t *video_st = video_state_get_ptr();
    video_st->frame_cache_data     = NULL;
+   runloop_st->core_state_serial++;
    runloop_st->current_core.retro_reset();
 }
 
@@ -7795,6 +7920,7 @@ void core_run(void)
       : current_core->poll_type;
    bool early_polling          = new_poll_type == POLL_TYPE_EARLY;
    bool late_polling           = new_poll_type == POLL_TYPE_LATE;
+   retro_time_t trace_start;
 #ifdef HAVE_NETWORKING
    bool netplay_preframe       = netplay_driver_ctl(
          RARCH_NETPLAY_CTL_PRE_FRAME, NULL);
@@ -7814,7 +7940,10 @@ void core_run(void)
    else if (late_polling)
       current_core->flags &= ~RETRO_CORE_FLAG_INPUT_POLLED;
 
+   runloop_st->core_state_serial++;
+   trace_start                 = cpu_features_get_time_usec();
    current_core->retro_run();
+   frame_trace_add(FRAME_TRACE_CORE_RUN, trace_start);
 
    if (      late_polling
          && (!(current_core->flags & RETRO_CORE_FLAG_INPUT_POLLED)))
@@ -161,6 +161,16 @@ typedef struct core_options_callbacks
    retro_core_options_update_display_callback_t update_display;
 } core_options_callbacks_t;
 
+typedef struct core_state_cache
+{
+   uint8_t *data;
+   size_t size;
+   size_t capacity;
+   uint64_t serial;  /* runloop core_state_serial the data matches */
+   unsigned users;
+   bool valid;
+} core_state_cache_t;
+
 struct runloop
 {
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
@@ -173,6 +183,9 @@ struct runloop
    retro_usec_t frame_time_last;                /* int64_t alignment */
 
    struct retro_core_t        current_core;     /* uint64_t alignment */
+   /* Bumped every time the core state may have changed */
+   uint64_t core_state_serial;                  /* uint64_t alignment */
+   core_state_cache_t core_state_cache;         /* uint64_t alignment */
 #if defined(HAVE_RUNAHEAD)
    uint64_t runahead_last_frame_count;          /* uint64_t alignment */
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
@@ -206,6 +219,9 @@ struct runloop
       retro_unserialize_callback_original;               /* ptr alignment */
 #if defined(HAVE_DYNAMIC) || defined(HAVE_DYLIB)
    struct retro_callbacks secondary_callbacks;           /* ptr alignment */
+#ifdef HAVE_THREADS
+   runahead_spec_t *runahead_spec;                       /* ptr alignment */
+#endif
 #endif
 #endif
 #ifdef HAVE_THREADS
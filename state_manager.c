@@ -15,19 +15,17 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef __STDC_LIMIT_MACROS
-#define __STDC_LIMIT_MACROS
-#endif
-
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <retro_inline.h>
+#include <retro_miscellaneous.h>
 #include <compat/strl.h>
-#include <compat/intrinsics.h>
+#include <features/features_cpu.h>
 
 #include "state_manager.h"
+#include "state_manager_raw.h"
 #include "msg_hash.h"
 #include "core.h"
 #include "core_info.h"
@@ -44,302 +42,6 @@
 /* Keep it off unless you're chasing a core bug, it slows things down. */
 #define STRICT_BUF_SIZE 0
 
-#ifndef UINT16_MAX
-#define UINT16_MAX 0xffff
-#endif
-
-#ifndef UINT32_MAX
-#define UINT32_MAX 0xffffffffu
-#endif
-
-#if defined(__x86_64__) || defined(__i386__) || defined(__i486__) || defined(__i686__) || defined(_M_IX86) || defined(_M_AMD64) || defined(_M_X64)
-#define CPU_X86
-#endif
-
-/* Other arches SIGBUS (usually) on unaligned accesses. */
-#ifndef CPU_X86
-#define NO_UNALIGNED_MEM
-#endif
-
-#if __SSE2__
-#include <emmintrin.h>
-#endif
-
-/* Format per frame (pseudocode): */
-#if 0
-size nextstart;
-repeat {
-   uint16 numchanged; /* everything is counted in units of uint16 */
-   if (numchanged)
-   {
-      uint16 numunchanged; /* skip these before handling numchanged */
-      uint16[numchanged] changeddata;
-   }
-   else
-   {
-      uint32 numunchanged;
-      if (!numunchanged)
-         break;
-   }
-}
-size thisstart;
-#endif
-
-/* There's no equivalent in libc, you'd think so ...
- * std::mismatch exists, but it's not optimized at all. */
-static size_t find_change(const uint16_t *a, const uint16_t *b)
-{
-#if __SSE2__
-   const __m128i *a128 = (const __m128i*)a;
-   const __m128i *b128 = (const __m128i*)b;
-
-   for (;;)
-   {
-      __m128i v0    = _mm_loadu_si128(a128);
-      __m128i v1    = _mm_loadu_si128(b128);
-      __m128i c     = _mm_cmpeq_epi8(v0, v1);
-      uint32_t mask = _mm_movemask_epi8(c);
-
-      if (mask != 0xffff) /* Something has changed, figure out where. */
-      {
-         /* calculate the real offset to the differing byte */
-         size_t ret = (((uint8_t*)a128 - (uint8_t*)a) |
-               (compat_ctz(~mask)));
-
-         /* and convert that to the uint16_t offset */
-         return (ret >> 1);
-      }
-
-      a128++;
-      b128++;
-   }
-#else
-   const uint16_t *a_org = a;
-#ifdef NO_UNALIGNED_MEM
-   while (((uintptr_t)a & (sizeof(size_t) - 1)) && *a == *b)
-   {
-      a++;
-      b++;
-   }
-   if (*a == *b)
-#endif
-   {
-      const size_t *a_big = (const size_t*)a;
-      const size_t *b_big = (const size_t*)b;
-
-      while (*a_big == *b_big)
-      {
-         a_big++;
-         b_big++;
-      }
-      a = (const uint16_t*)a_big;
-      b = (const uint16_t*)b_big;
-
-      while (*a == *b)
-      {
-         a++;
-         b++;
-      }
-   }
-   return a - a_org;
-#endif
-}
-
-static size_t find_same(const uint16_t *a, const uint16_t *b)
-{
-   const uint16_t *a_org = a;
-#ifdef NO_UNALIGNED_MEM
-   if (((uintptr_t)a & (sizeof(uint32_t) - 1)) && *a != *b)
-   {
-      a++;
-      b++;
-   }
-   if (*a != *b)
-#endif
-   {
-      /* With this, it's random whether two consecutive identical
-       * words are caught.
-       *
-       * Luckily, compression rate is the same for both cases, and
-       * three is always caught.
-       *
-       * (We prefer to miss two-word blocks, anyways; fewer iterations
-       * of the outer loop, as well as in the decompressor.) */
-      const uint32_t *a_big = (const uint32_t*)a;
-      const uint32_t *b_big = (const uint32_t*)b;
-
-      while (*a_big != *b_big)
-      {
-         a_big++;
-         b_big++;
-      }
-      a = (const uint16_t*)a_big;
-      b = (const uint16_t*)b_big;
-
-      if (a != a_org && a[-1] == b[-1])
-      {
-         a--;
-         b--;
-      }
-   }
-   return a - a_org;
-}
-
-/* Returns the maximum compressed size of a savestate.
- * It is very likely to compress to far less. */
-static size_t state_manager_raw_maxsize(size_t uncomp)
-{
-   /* bytes covered by a compressed block */
-   const int maxcblkcover = UINT16_MAX * sizeof(uint16_t);
-   /* uncompressed size, rounded to 16 bits */
-   size_t uncomp16        = (uncomp + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
-   /* number of blocks */
-   size_t maxcblks        = (uncomp + maxcblkcover - 1) / maxcblkcover;
-   return uncomp16 + maxcblks * sizeof(uint16_t) * 2 /* two u16 overhead per block */ + sizeof(uint16_t) *
-      3; /* three u16 to end it */
-}
-
-/*
- * See state_manager_raw_compress for information about this.
- * When you're done with it, send it to free().
- */
-static void *state_manager_raw_alloc(size_t len, uint16_t uniq)
-{
-   size_t  len16 = (len + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
-   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 16, 1);
-
-   if (!ret)
-      return NULL;
-
-   /* Force in a different byte at the end, so we don't need to check
-    * bounds in the innermost loop (it's expensive).
-    *
-    * There is also a large amount of data that's the same, to stop
-    * the other scan.
-    *
-    * There is also some padding at the end. This is so we don't
-    * read outside the buffer end if we're reading in large blocks;
-    *
-    * It doesn't make any difference to us, but sacrificing 16 bytes to get
-    * Valgrind happy is worth it. */
-   ret[len16/sizeof(uint16_t) + 3] = uniq;
-
-   return ret;
-}
-
-/*
- * Takes two savestates and creates a patch that turns 'src' into 'dst'.
- * Both 'src' and 'dst' must be returned from state_manager_raw_alloc(),
- * with the same 'len', and different 'uniq'.
- *
- * 'patch' must be size 'state_manager_raw_maxsize(len)' or more.
- * Returns the number of bytes actually written to 'patch'.
- */
-static size_t state_manager_raw_compress(const void *src,
-      const void *dst, size_t len, void *patch)
-{
-   const uint16_t  *old16 = (const uint16_t*)src;
-   const uint16_t  *new16 = (const uint16_t*)dst;
-   uint16_t *compressed16 = (uint16_t*)patch;
-   size_t          num16s = (len + sizeof(uint16_t) - 1)
-      / sizeof(uint16_t);
-
-   while (num16s)
-   {
-      size_t i, changed;
-      size_t skip = find_change(old16, new16);
-
-      if (skip >= num16s)
-         break;
-
-      old16  += skip;
-      new16  += skip;
-      num16s -= skip;
-
-      if (skip > UINT16_MAX)
-      {
-         /* This will make it scan the entire thing again,
-          * but it only hits on 8GB unchanged data anyways,
-          * and if you're doing that, you've got bigger problems. */
-         if (skip > UINT32_MAX)
-            skip         = UINT32_MAX;
-
-         *compressed16++ = 0;
-         *compressed16++ = skip;
-         *compressed16++ = skip >> 16;
-         continue;
-      }
-
-      changed         = find_same(old16, new16);
-      if (changed > UINT16_MAX)
-         changed = UINT16_MAX;
-
-      *compressed16++ = changed;
-      *compressed16++ = skip;
-
-      for (i = 0; i < changed; i++)
-         compressed16[i] = old16[i];
-
-      old16        += changed;
-      new16        += changed;
-      num16s       -= changed;
-      compressed16 += changed;
-   }
-
-   compressed16[0]  = 0;
-   compressed16[1]  = 0;
-   compressed16[2]  = 0;
-
-   return (uint8_t*)(compressed16 + 3) - (uint8_t*)patch;
-}
-
-/*
- * Takes 'patch' from a previous call to 'state_manager_raw_compress'
- * and applies it to 'data' ('src' from that call),
- * yielding 'dst' in that call.
- *
- * If the given arguments do not match a previous call to
- * state_manager_raw_compress(), anything at all can happen.
- */
-static void state_manager_raw_decompress(const void *patch,
-      size_t patchlen, void *data, size_t datalen)
-{
-   uint16_t         *out16 = (uint16_t*)data;
-   const uint16_t *patch16 = (const uint16_t*)patch;
-
-   for (;;)
-   {
-      uint16_t numchanged  = *(patch16++);
-
-      if (numchanged)
-      {
-         uint16_t i;
-
-         out16       += *patch16++;
-
-         /* We could do memcpy, but it seems that memcpy has a
-          * constant-per-call overhead that actually shows up.
-          *
-          * Our average size in here seems to be 8 or something.
-          * Therefore, we do something with lower overhead. */
-         for (i = 0; i < numchanged; i++)
-            out16[i]  = patch16[i];
-
-         patch16     += numchanged;
-         out16       += numchanged;
-      }
-      else
-      {
-         uint32_t numunchanged = patch16[0] | (patch16[1] << 16);
-
-         if (!numunchanged)
-            break;
-         patch16 += 2;
-         out16   += numunchanged;
-      }
-   }
-}
-
 /* The start offsets point to 'nextstart' of any given compressed frame.
  * Each uint16 is stored native endian; anything that claims any other
  * endianness refers to the endianness of this specific item.
@@ -375,17 +77,61 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+/* Blocks until the compression worker (if any) has
+ * finished the job handed to it by state_manager_push_do(). */
+static void state_manager_wait(state_manager_t *state)
+{
+#ifdef HAVE_THREADS
+   if (!state->thread)
+      return;
+
+   slock_lock(state->lock);
+   while (state->busy)
+      scond_wait(state->cond, state->lock);
+   slock_unlock(state->lock);
+#endif
+}
+
 static void state_manager_free(state_manager_t *state)
 {
    if (!state)
       return;
 
+#ifdef HAVE_THREADS
+   if (state->thread)
+   {
+      state_manager_wait(state);
+
+      slock_lock(state->lock);
+      state->quit = true;
+      scond_signal(state->cond);
+      slock_unlock(state->lock);
+
+      sthread_join(state->thread);
+   }
+   if (state->cond)
+      scond_free(state->cond);
+   if (state->lock)
+      slock_free(state->lock);
+   state->thread     = NULL;
+   state->cond       = NULL;
+   state->lock       = NULL;
+#endif
+
    if (state->data)
       free(state->data);
    if (state->thisblock)
       free(state->thisblock);
    if (state->nextblock)
       free(state->nextblock);
+   if (state->keyframes)
+      free(state->keyframes);
+   if (state->scratch)
+      free(state->scratch);
+   if (state->pack_stream)
+      state->pack_backend->stream_free(state->pack_stream);
+   if (state->unpack_stream)
+      state->pack_backend->reverse->stream_free(state->unpack_stream);
 #if STRICT_BUF_SIZE
    if (state->debugblock)
       free(state->debugblock);
@@ -394,10 +140,167 @@ static void state_manager_free(state_manager_t *state)
    state->data       = NULL;
    state->thisblock  = NULL;
    state->nextblock  = NULL;
+   state->keyframes  = NULL;
+   state->scratch    = NULL;
+   state->pack_stream   = NULL;
+   state->unpack_stream = NULL;
 }
 
+static INLINE struct state_manager_keyframe *state_manager_keyframe_at(
+      state_manager_t *state, size_t idx)
+{
+   return &state->keyframes[
+      (state->keyframes_first + idx) % state->keyframes_cap];
+}
+
+/* Drops keyframes that are no longer inside
+ * [tail_serial, head_serial). */
+static void state_manager_keyframes_prune(state_manager_t *state)
+{
+   while (state->keyframes_count
+         && state_manager_keyframe_at(state, 0)->serial
+         < state->tail_serial)
+   {
+      state->keyframes_first = (state->keyframes_first + 1)
+         % state->keyframes_cap;
+      state->keyframes_count--;
+   }
+
+   while (state->keyframes_count
+         && state_manager_keyframe_at(state,
+            state->keyframes_count - 1)->serial >= state->head_serial)
+      state->keyframes_count--;
+}
+
+static bool state_manager_keyframes_grow(state_manager_t *state)
+{
+   size_t i;
+   size_t cap                          = state->keyframes_cap * 2;
+   struct state_manager_keyframe *keys = (struct state_manager_keyframe*)
+      malloc(cap * sizeof(*keys));
+
+   if (!keys)
+      return false;
+
+   for (i = 0; i < state->keyframes_count; i++)
+      keys[i] = *state_manager_keyframe_at(state, i);
+
+   free(state->keyframes);
+   state->keyframes       = keys;
+   state->keyframes_cap   = cap;
+   state->keyframes_first = 0;
+   return true;
+}
+
+/* Drops whatever a failed pack left in the stream,
+ * so the next entry starts from a clean state. */
+static void state_manager_pack_reset(state_manager_t *state)
+{
+   state->pack_backend->stream_free(state->pack_stream);
+   state->pack_stream = state->pack_backend->stream_new();
+   if (state->pack_stream && state->pack_backend->define)
+      state->pack_backend->define(state->pack_stream,
+            "level", state->pack_level);
+}
+
+/* Writes 'len' bytes from 'in' to 'out', through the second
+ * stage if enabled. Returns the number of bytes written. */
+static size_t state_manager_pack(state_manager_t *state,
+      const uint8_t *in, size_t len, uint8_t *out)
+{
+   uint32_t rd, wn;
+   enum trans_stream_error err;
+   uint32_t packed = 0;
+
+   if (!state->pack_backend)
+   {
+      memcpy(out, in, len);
+      return len;
+   }
+
+   if (state->pack_stream)
+   {
+      state->pack_backend->set_in(state->pack_stream, in, (uint32_t)len);
+      state->pack_backend->set_out(state->pack_stream,
+            out + sizeof(uint32_t), (uint32_t)len);
+
+      if (     state->pack_backend->trans(state->pack_stream,
+               true, &rd, &wn, &err)
+            && err == TRANS_STREAM_ERROR_NONE
+            && wn < len)
+         packed = wn;
+      else
+         state_manager_pack_reset(state);
+   }
+
+   memcpy(out, &packed, sizeof(packed));
+   if (packed)
+      return sizeof(uint32_t) + packed;
+
+   memcpy(out + sizeof(uint32_t), in, len);
+   return sizeof(uint32_t) + len;
+}
+
+/* Reverses state_manager_pack(). Returns where the unpacked
+ * entry is; either inside 'in', or 'out' if it had to be
+ * inflated. */
+static const uint8_t *state_manager_unpack(state_manager_t *state,
+      const uint8_t *in, uint8_t *out, size_t out_size)
+{
+   uint32_t rd, wn, packed;
+   const struct trans_stream_backend *backend;
+
+   if (!state->pack_backend)
+      return in;
+
+   memcpy(&packed, in, sizeof(packed));
+   if (!packed)
+      return in + sizeof(uint32_t);
+
+   backend = state->pack_backend->reverse;
+   backend->set_in(state->unpack_stream, in + sizeof(uint32_t), packed);
+   backend->set_out(state->unpack_stream, out, (uint32_t)out_size);
+   backend->trans(state->unpack_stream, true, &rd, &wn, NULL);
+   return out;
+}
+
+static void state_manager_push_compress(state_manager_t *state,
+      const uint8_t *oldb, const uint8_t *newb);
+
+#ifdef HAVE_THREADS
+static void state_manager_thread(void *data)
+{
+   state_manager_t *state = (state_manager_t*)data;
+
+   slock_lock(state->lock);
+
+   for (;;)
+   {
+      while (!state->busy && !state->quit)
+         scond_wait(state->cond, state->lock);
+
+      if (state->quit)
+         break;
+
+      slock_unlock(state->lock);
+
+      /* state_manager_push_do() already swapped the blocks,
+       * so the older state now lives in 'nextblock'. */
+      state_manager_push_compress(state,
+            state->nextblock, state->thisblock);
+
+      slock_lock(state->lock);
+      state->busy = false;
+      scond_signal(state->cond);
+   }
+
+   slock_unlock(state->lock);
+}
+#endif
+
 static state_manager_t *state_manager_new(
-      size_t state_size, size_t buffer_size)
+      size_t state_size, size_t buffer_size, bool async,
+      unsigned keyframe_interval, unsigned compression_level)
 {
    size_t max_comp_size, block_size;
    uint8_t *next_block    = NULL;
@@ -408,9 +311,15 @@ static state_manager_t *state_manager_new(
    if (!state)
       return NULL;
 
+   state_manager_raw_init_simd(cpu_features_get());
+   RARCH_LOG("[Rewind]: Using \"%s\" delta scanner.\n",
+         state_manager_raw_simd_ident());
+
    block_size         = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
    /* the compressed data is surrounded by pointers to the other side */
    max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
+   if (compression_level)
+      max_comp_size  += sizeof(uint32_t);
    state_data         = (uint8_t*)malloc(buffer_size);
 
    if (!state_data)
@@ -432,11 +341,63 @@ static state_manager_t *state_manager_new(
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
 
+   /* Unpacked keyframes take at least a full block, so this
+    * many can never be live at once; packed ones may be
+    * smaller, in which case the index grows on demand. */
+   if (keyframe_interval)
+   {
+      state->keyframes_cap     = buffer_size / block_size + 2;
+      state->keyframes         = (struct state_manager_keyframe*)
+         malloc(state->keyframes_cap * sizeof(*state->keyframes));
+      if (!state->keyframes)
+         goto error;
+      state->keyframe_interval = keyframe_interval;
+   }
+
+   if (compression_level)
+   {
+      const struct trans_stream_backend *backend =
+         trans_stream_get_zlib_deflate_backend();
+
+      if (backend)
+      {
+         state->pack_backend  = backend;
+         state->pack_level    = compression_level;
+         state->scratch_size  = state_manager_raw_maxsize(state_size);
+         state->scratch       = (uint8_t*)malloc(state->scratch_size);
+         state->unpack_stream = backend->reverse->stream_new();
+         state_manager_pack_reset(state);
+
+         if (     !state->scratch
+               || !state->pack_stream
+               || !state->unpack_stream)
+            goto error;
+      }
+      else
+         RARCH_WARN("[Rewind]: Compression unavailable in this build.\n");
+   }
+
 #if STRICT_BUF_SIZE
    state->debugsize   = state_size;
    state->debugblock  = (uint8_t*)malloc(state_size);
 #endif
 
+#ifdef HAVE_THREADS
+   if (async)
+   {
+      state->lock     = slock_new();
+      state->cond     = scond_new();
+
+      if (state->lock && state->cond)
+         state->thread = sthread_create(state_manager_thread, state);
+
+      /* Not fatal, just compress on the main thread instead */
+      if (!state->thread)
+         RARCH_WARN("[Rewind]: Failed to start compression thread.\n");
+   }
+#endif
+   state->async       = async;
+
    return state;
 
 error:
@@ -456,6 +417,8 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
 
    *data                        = NULL;
 
+   state_manager_wait(state);
+
    if (state->thisblock_valid)
    {
       state->thisblock_valid    = false;
@@ -472,20 +435,105 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
    state->head                  = state->data + start;
    compressed                   = state->data + start + sizeof(size_t);
    out                          = state->thisblock;
+   state->head_serial--;
 
-   state_manager_raw_decompress(compressed,
-         state->maxcompsize, out, state->blocksize);
+   if (     state->keyframes_count
+         && state_manager_keyframe_at(state, state->keyframes_count - 1)
+         ->serial == state->head_serial)
+   {
+      compressed                = state_manager_unpack(state,
+            compressed, out, state->blocksize);
+      if (compressed != out)
+         memcpy(out, compressed, state->blocksize);
+      state->keyframes_count--;
+   }
+   else
+      state_manager_raw_decompress(state_manager_unpack(state,
+               compressed, state->scratch, state->scratch_size),
+            state->maxcompsize, out, state->blocksize);
 
    state->entries--;
    return true;
 }
 
+/* Same as calling state_manager_pop() 'count' times,
+ * but starts from the closest keyframe at or after the
+ * target instead of replaying every patch from the head. */
+static bool state_manager_seek_entries(state_manager_t *state,
+      unsigned count, const void **data)
+{
+   size_t i;
+   uint64_t serial, target;
+   uint8_t *pos         = NULL;
+
+   *data                = NULL;
+
+   state_manager_wait(state);
+
+   *data                = state->thisblock;
+
+   if (state->thisblock_valid)
+   {
+      state->thisblock_valid = false;
+      state->entries--;
+      if (--count == 0)
+         return true;
+   }
+
+   if (state->head == state->tail)
+      return false;
+
+   if (count > state->head_serial - state->tail_serial)
+      count             = (unsigned)(state->head_serial - state->tail_serial);
+
+   target               = state->head_serial - count;
+   /* 'thisblock' holds the state at head_serial */
+   pos                  = state->head;
+   serial               = state->head_serial;
+
+   for (i = 0; i < state->keyframes_count; i++)
+   {
+      struct state_manager_keyframe *key =
+         state_manager_keyframe_at(state, i);
+
+      if (key->serial >= target)
+      {
+         const uint8_t *keydata;
+         pos            = state->data + key->offset;
+         serial         = key->serial;
+         keydata        = state_manager_unpack(state,
+               pos + sizeof(size_t), state->thisblock, state->blocksize);
+         if (keydata != state->thisblock)
+            memcpy(state->thisblock, keydata, state->blocksize);
+         break;
+      }
+   }
+
+   while (serial > target)
+   {
+      pos               = state->data
+         + read_size_t(pos - sizeof(size_t));
+      state_manager_raw_decompress(state_manager_unpack(state,
+               pos + sizeof(size_t), state->scratch, state->scratch_size),
+            state->maxcompsize, state->thisblock, state->blocksize);
+      serial--;
+   }
+
+   state->head          = pos;
+   state->head_serial   = target;
+   state->entries      -= count;
+   state_manager_keyframes_prune(state);
+   return true;
+}
+
 static void state_manager_push_where(state_manager_t *state, void **data)
 {
    /* We need to ensure we have an uncompressed copy of the last
     * pushed state, or we could end up applying a 'patch' to wrong
     * savestate, and that'd blow up rather quickly. */
 
+   state_manager_wait(state);
+
    if (!state->thisblock_valid)
    {
       const void *ignored;
@@ -502,9 +550,93 @@ static void state_manager_push_where(state_manager_t *state, void **data)
 #endif
 }
 
+/* Appends the patch turning 'newb' back into 'oldb' at the head
+ * of the buffer, dropping the oldest entries to make room.
+ * Runs on the compression thread in async mode. */
+static void state_manager_push_compress(state_manager_t *state,
+      const uint8_t *oldb, const uint8_t *newb)
+{
+   uint8_t *compressed;
+   size_t headpos, tailpos, remaining;
+
+recheckcapacity:;
+   headpos   = state->head - state->data;
+   tailpos   = state->tail - state->data;
+   remaining = (tailpos + state->capacity -
+         sizeof(size_t) - headpos - 1) % state->capacity + 1;
+
+   if (remaining <= state->maxcompsize)
+   {
+      state->tail = state->data + read_size_t(state->tail);
+      state->tail_serial++;
+      state->entries--;
+      goto recheckcapacity;
+   }
+
+   state_manager_keyframes_prune(state);
+
+   compressed        = state->head + sizeof(size_t);
+
+   if (     state->keyframe_interval
+         && (!state->keyframes_count
+            || state->head_serial - state_manager_keyframe_at(state,
+               state->keyframes_count - 1)->serial
+            >= state->keyframe_interval)
+         && (  state->keyframes_count < state->keyframes_cap
+            || state_manager_keyframes_grow(state)))
+   {
+      struct state_manager_keyframe *key = state_manager_keyframe_at(
+            state, state->keyframes_count++);
+      key->serial    = state->head_serial;
+      key->offset    = state->head - state->data;
+
+      compressed    += state_manager_pack(state, oldb,
+            state->blocksize, compressed);
+   }
+   else if (state->pack_backend)
+      compressed    += state_manager_pack(state, state->scratch,
+            state_manager_raw_compress(oldb, newb,
+               state->blocksize, state->scratch), compressed);
+   else
+      compressed    += state_manager_raw_compress(oldb, newb,
+            state->blocksize, compressed);
+
+   if (compressed - state->data + state->maxcompsize > state->capacity)
+   {
+      compressed     = state->data;
+      if (state->tail == state->data + sizeof(size_t))
+      {
+         state->tail = state->data + read_size_t(state->tail);
+         state->tail_serial++;
+      }
+   }
+   write_size_t(compressed, state->head-state->data);
+   compressed       += sizeof(size_t);
+   write_size_t(state->head, compressed-state->data);
+   state->head       = compressed;
+   state->head_serial++;
+}
+
+static void state_manager_push_record(state_manager_t *state,
+      retro_time_t start)
+{
+   static const retro_time_t limits[] = {
+      100, 250, 500, 1000, 2000, 4000, 8000 };
+   retro_time_t elapsed = cpu_features_get_time_usec() - start;
+   unsigned bucket      = 0;
+
+   while (bucket < ARRAY_SIZE(limits) && elapsed >= limits[bucket])
+      bucket++;
+
+   state->push_histogram[bucket]++;
+}
+
 static void state_manager_push_do(state_manager_t *state)
 {
-   uint8_t *swap = NULL;
+   uint8_t *swap      = NULL;
+   retro_time_t start = cpu_features_get_time_usec();
+
+   state_manager_wait(state);
 
 #if STRICT_BUF_SIZE
    memcpy(state->nextblock, state->debugblock, state->debugsize);
@@ -512,44 +644,33 @@ static void state_manager_push_do(state_manager_t *state)
 
    if (state->thisblock_valid)
    {
-      const uint8_t *oldb, *newb;
-      uint8_t *compressed;
-      size_t headpos, tailpos, remaining;
       if (state->capacity < sizeof(size_t) + state->maxcompsize) {
          RARCH_ERR("State capacity insufficient\n");
          return;
       }
 
-recheckcapacity:;
-      headpos   = state->head - state->data;
-      tailpos   = state->tail - state->data;
-      remaining = (tailpos + state->capacity -
-            sizeof(size_t) - headpos - 1) % state->capacity + 1;
-
-      if (remaining <= state->maxcompsize)
+#ifdef HAVE_THREADS
+      if (state->thread)
       {
-         state->tail = state->data + read_size_t(state->tail);
-         state->entries--;
-         goto recheckcapacity;
-      }
-
-      oldb              = state->thisblock;
-      newb              = state->nextblock;
-      compressed        = state->head + sizeof(size_t);
+         swap                = state->thisblock;
+         state->thisblock    = state->nextblock;
+         state->nextblock    = swap;
+         state->entries++;
 
-      compressed       += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
+         /* Hand the pair over; the core gets to run the next
+          * frame while the worker produces the patch. */
+         slock_lock(state->lock);
+         state->busy         = true;
+         scond_signal(state->cond);
+         slock_unlock(state->lock);
 
-      if (compressed - state->data + state->maxcompsize > state->capacity)
-      {
-         compressed     = state->data;
-         if (state->tail == state->data + sizeof(size_t))
-            state->tail = state->data + read_size_t(state->tail);
+         state_manager_push_record(state, start);
+         return;
       }
-      write_size_t(compressed, state->head-state->data);
-      compressed       += sizeof(size_t);
-      write_size_t(state->head, compressed-state->data);
-      state->head       = compressed;
+#endif
+
+      state_manager_push_compress(state,
+            state->thisblock, state->nextblock);
    }
    else
       state->thisblock_valid = true;
@@ -559,6 +680,8 @@ recheckcapacity:;
    state->nextblock          = swap;
 
    state->entries++;
+
+   state_manager_push_record(state, start);
 }
 
 #if 0
@@ -581,7 +704,10 @@ static void state_manager_capacity(state_manager_t *state,
 
 void state_manager_event_init(
       struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size)
+      unsigned rewind_buffer_size, bool rewind_async,
+      unsigned rewind_keyframe_interval,
+      unsigned rewind_compression_level,
+      bool rewind_special_states)
 {
    core_info_t *core_info = NULL;
    void *state            = NULL;
@@ -596,6 +722,7 @@ void state_manager_event_init(
                                    STATE_MGR_REWIND_ST_FLAG_FRAME_IS_REVERSED
                                  | STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_CHECKED
                                  | STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_PRESSED
+                                 | STATE_MGR_REWIND_ST_FLAG_SPECIAL_STATES
                                     );
 
    /* We cannot initialise the rewind buffer
@@ -620,6 +747,9 @@ void state_manager_event_init(
       return;
    }
 
+   if (rewind_special_states)
+      rewind_st->flags |= STATE_MGR_REWIND_ST_FLAG_SPECIAL_STATES;
+
    rewind_st->size = content_get_serialized_size_rewind();
 
    if (!rewind_st->size)
@@ -634,10 +764,13 @@ void state_manager_event_init(
          (unsigned)(rewind_buffer_size / 1000000));
 
    rewind_st->state = state_manager_new(rewind_st->size,
-         rewind_buffer_size);
+         rewind_buffer_size, rewind_async, rewind_keyframe_interval,
+         rewind_compression_level);
 
    if (!rewind_st->state)
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
+   else
+      core_state_cache_acquire();
 
    state_manager_push_where(rewind_st->state, &state);
 
@@ -662,8 +795,17 @@ void state_manager_event_deinit(
 
    if (rewind_st->state)
    {
+      const unsigned *hist = rewind_st->state->push_histogram;
+      RARCH_LOG("[Rewind]: Push cost (%s): <0.1ms: %u, <0.25ms: %u, "
+            "<0.5ms: %u, <1ms: %u, <2ms: %u, <4ms: %u, <8ms: %u, "
+            ">=8ms: %u.\n",
+            rewind_st->state->async ? "async" : "sync",
+            hist[0], hist[1], hist[2], hist[3],
+            hist[4], hist[5], hist[6], hist[7]);
+
       state_manager_free(rewind_st->state);
       free(rewind_st->state);
+      core_state_cache_release();
    }
 
    rewind_st->state              = NULL;
@@ -673,6 +815,7 @@ void state_manager_event_deinit(
                                  | STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_CHECKED
                                  | STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_PRESSED
                                  | STATE_MGR_REWIND_ST_FLAG_INIT_ATTEMPTED
+                                 | STATE_MGR_REWIND_ST_FLAG_SPECIAL_STATES
                                     );
 
    /* Restore regular (non-rewind) core audio
@@ -687,6 +830,21 @@ void state_manager_event_deinit(
    }
 }
 
+bool state_manager_seek(struct state_manager_rewind_state *rewind_st,
+      unsigned entries)
+{
+   const void *buf = NULL;
+
+   if (!rewind_st || !rewind_st->state || !entries)
+      return false;
+
+   if (!state_manager_seek_entries(rewind_st->state, entries, &buf))
+      return false;
+
+   content_deserialize_state_rewind(buf, rewind_st->size);
+   return true;
+}
+
 /**
  * check_rewind:
  * @pressed              : was rewind key pressed or held?
@@ -763,7 +921,7 @@ bool state_manager_check_rewind(
          *time                  = is_paused ? 1 : 30;
          ret                    = true;
 
-         content_deserialize_state(buf, rewind_st->size);
+         content_deserialize_state_rewind(buf, rewind_st->size);
 
 #ifdef HAVE_BSV_MOVIE
          bsv_movie_frame_rewind();
@@ -771,7 +929,7 @@ bool state_manager_check_rewind(
       }
       else
       {
-         content_deserialize_state(buf, rewind_st->size);
+         content_deserialize_state_rewind(buf, rewind_st->size);
 
 #ifdef HAVE_NETWORKING
          /* Tell netplay we're done */
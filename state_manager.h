@@ -24,6 +24,12 @@
 #include <boolean.h>
 #include <retro_common_api.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#include <streams/trans_stream.h>
+
 #include "dynamic.h"
 
 RETRO_BEGIN_DECLS
@@ -33,7 +39,20 @@ enum state_manager_rewind_st_flags
    STATE_MGR_REWIND_ST_FLAG_FRAME_IS_REVERSED     = (1 << 0),
    STATE_MGR_REWIND_ST_FLAG_INIT_ATTEMPTED        = (1 << 1),
    STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_CHECKED    = (1 << 2),
-   STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_PRESSED    = (1 << 3)
+   STATE_MGR_REWIND_ST_FLAG_HOTKEY_WAS_PRESSED    = (1 << 3),
+   /* Take and load states in the same-instance context
+    * run-ahead uses, so they can share the core state cache */
+   STATE_MGR_REWIND_ST_FLAG_SPECIAL_STATES        = (1 << 4)
+};
+
+/* A full, uncompressed savestate stored in the buffer
+ * in place of a patch, so that seeking back doesn't need
+ * to replay every patch since the newest state. */
+struct state_manager_keyframe
+{
+   uint64_t serial;
+   /* Start of the entry, relative to state_manager::data */
+   size_t offset;
 };
 
 struct state_manager
@@ -59,8 +78,49 @@ struct state_manager
     * (yes, the math is a bit ugly). */
    size_t maxcompsize;
 
+   /* Ring of keyframes, oldest first. Only holds entries
+    * between tail_serial and head_serial. */
+   struct state_manager_keyframe *keyframes;
+   size_t keyframes_cap;
+   size_t keyframes_first;
+   size_t keyframes_count;
+   /* Serial of the next entry written at 'head', and of
+    * the oldest entry still in the buffer. */
+   uint64_t head_serial;
+   uint64_t tail_serial;
+   unsigned keyframe_interval;
+
+   /* Optional second stage run over every entry. When enabled,
+    * entries start with a uint32 holding the packed size, or 0
+    * if packing didn't help and the entry is stored as is. */
+   const struct trans_stream_backend *pack_backend;
+   void *pack_stream;
+   void *unpack_stream;
+   /* Holds an entry between the two stages */
+   uint8_t *scratch;
+   size_t scratch_size;
+   unsigned pack_level;
+
+#ifdef HAVE_THREADS
+   /* Worker thread compressing the previous block against
+    * the newest one while the core runs the next frames.
+    * Only created in async mode. Whenever 'busy' is set, the
+    * worker owns the buffer and every field above; the main
+    * thread must call state_manager_wait() before touching them. */
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool busy;
+   bool quit;
+#endif
+
+   /* Main thread cost of state_manager_push_do(),
+    * bucketed by duration; logged on deinit. */
+   unsigned push_histogram[8];
+
    unsigned entries;
    bool thisblock_valid;
+   bool async;
 };
 
 typedef struct state_manager state_manager_t;
@@ -75,12 +135,30 @@ struct state_manager_rewind_state
 
 bool state_manager_frame_is_reversed(void);
 
+bool state_manager_uses_special_states(void);
+
 void state_manager_event_deinit(
       struct state_manager_rewind_state *rewind_st,
       struct retro_core_t *current_core);
 
 void state_manager_event_init(struct state_manager_rewind_state *rewind_st,
-      unsigned rewind_buffer_size);
+      unsigned rewind_buffer_size, bool rewind_async,
+      unsigned rewind_keyframe_interval,
+      unsigned rewind_compression_level,
+      bool rewind_special_states);
+
+/**
+ * state_manager_seek:
+ * @entries              : number of rewind steps to go back.
+ *
+ * Restores the state from @entries rewind steps ago and
+ * discards everything newer. Only the patches between the
+ * target and the closest keyframe after it are decompressed.
+ *
+ * Returns: true if a state was restored.
+ **/
+bool state_manager_seek(struct state_manager_rewind_state *rewind_st,
+      unsigned entries);
 
 /**
  * check_rewind:
@@ -0,0 +1,593 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2014-2017 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <retro_inline.h>
+#include <compat/intrinsics.h>
+#include <features/features_cpu.h>
+
+#include "state_manager_raw.h"
+
+#ifndef UINT16_MAX
+#define UINT16_MAX 0xffff
+#endif
+
+#ifndef UINT32_MAX
+#define UINT32_MAX 0xffffffffu
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__i486__) || defined(__i686__) || defined(_M_IX86) || defined(_M_AMD64) || defined(_M_X64)
+#define CPU_X86
+#endif
+
+/* Other arches SIGBUS (usually) on unaligned accesses. */
+#ifndef CPU_X86
+#define NO_UNALIGNED_MEM
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* The AVX2 scanner is picked at runtime, so build it even when
+ * the compiler doesn't target AVX2 for the rest of the file */
+#if defined(__AVX2__)
+#define HAVE_SCAN_AVX2
+#define SCAN_AVX2_TARGET
+#elif defined(CPU_X86) && defined(__SSE2__) && (defined(__clang__) \
+      ? __clang_major__ >= 4 \
+      : (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define HAVE_SCAN_AVX2
+#define SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(CPU_X86) && defined(_MSC_VER) && _MSC_VER >= 1800
+#define HAVE_SCAN_AVX2
+#define SCAN_AVX2_TARGET
+#endif
+
+#ifdef HAVE_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
+#include <arm_neon.h>
+#endif
+
+/* Format per frame (pseudocode): */
+#if 0
+size nextstart;
+repeat {
+   uint16 numchanged; /* everything is counted in units of uint16 */
+   if (numchanged)
+   {
+      uint16 numunchanged; /* skip these before handling numchanged */
+      uint16[numchanged] changeddata;
+   }
+   else
+   {
+      uint32 numunchanged;
+      if (!numunchanged)
+         break;
+   }
+}
+size thisstart;
+#endif
+
+typedef size_t (*state_manager_raw_scan_t)(const uint16_t *a,
+      const uint16_t *b);
+
+/* There's no equivalent in libc, you'd think so ...
+ * std::mismatch exists, but it's not optimized at all. */
+static size_t find_change_c(const uint16_t *a, const uint16_t *b)
+{
+   const uint16_t *a_org = a;
+#ifdef NO_UNALIGNED_MEM
+   while (((uintptr_t)a & (sizeof(size_t) - 1)) && *a == *b)
+   {
+      a++;
+      b++;
+   }
+   if (*a == *b)
+#endif
+   {
+      const size_t *a_big = (const size_t*)a;
+      const size_t *b_big = (const size_t*)b;
+
+      while (*a_big == *b_big)
+      {
+         a_big++;
+         b_big++;
+      }
+      a = (const uint16_t*)a_big;
+      b = (const uint16_t*)b_big;
+
+      while (*a == *b)
+      {
+         a++;
+         b++;
+      }
+   }
+   return a - a_org;
+}
+
+static size_t find_same_c(const uint16_t *a, const uint16_t *b)
+{
+   const uint16_t *a_org = a;
+#ifdef NO_UNALIGNED_MEM
+   if (((uintptr_t)a & (sizeof(uint32_t) - 1)) && *a != *b)
+   {
+      a++;
+      b++;
+   }
+   if (*a != *b)
+#endif
+   {
+      /* With this, it's random whether two consecutive identical
+       * words are caught.
+       *
+       * Luckily, compression rate is the same for both cases, and
+       * three is always caught.
+       *
+       * (We prefer to miss two-word blocks, anyways; fewer iterations
+       * of the outer loop, as well as in the decompressor.) */
+      const uint32_t *a_big = (const uint32_t*)a;
+      const uint32_t *b_big = (const uint32_t*)b;
+
+      while (*a_big != *b_big)
+      {
+         a_big++;
+         b_big++;
+      }
+      a = (const uint16_t*)a_big;
+      b = (const uint16_t*)b_big;
+
+      if (a != a_org && a[-1] == b[-1])
+      {
+         a--;
+         b--;
+      }
+   }
+   return a - a_org;
+}
+
+/* The vector scanners below rely on the padding added by
+ * state_manager_raw_alloc() to never read past the buffer;
+ * they check whole vectors and only then locate the exact
+ * uint16 (find_change) or uint32 (find_same) inside it.
+ *
+ * find_same compares uint32s relative to 'a', like the
+ * scalar version, so all implementations produce the
+ * same patch. */
+
+#if defined(__SSE2__)
+static size_t find_change_sse2(const uint16_t *a, const uint16_t *b)
+{
+   const __m128i *a128 = (const __m128i*)a;
+   const __m128i *b128 = (const __m128i*)b;
+
+   for (;;)
+   {
+      __m128i v0    = _mm_loadu_si128(a128);
+      __m128i v1    = _mm_loadu_si128(b128);
+      __m128i c     = _mm_cmpeq_epi8(v0, v1);
+      uint32_t mask = _mm_movemask_epi8(c);
+
+      if (mask != 0xffff) /* Something has changed, figure out where. */
+      {
+         /* calculate the real offset to the differing byte */
+         size_t ret = (((uint8_t*)a128 - (uint8_t*)a) |
+               (compat_ctz(~mask)));
+
+         /* and convert that to the uint16_t offset */
+         return (ret >> 1);
+      }
+
+      a128++;
+      b128++;
+   }
+}
+
+static size_t find_same_sse2(const uint16_t *a, const uint16_t *b)
+{
+   const uint8_t *a8 = (const uint8_t*)a;
+   const uint8_t *b8 = (const uint8_t*)b;
+   size_t off        = 0;
+
+   for (;;)
+   {
+      __m128i c     = _mm_cmpeq_epi32(
+            _mm_loadu_si128((const __m128i*)(a8 + off)),
+            _mm_loadu_si128((const __m128i*)(b8 + off)));
+      uint32_t mask = _mm_movemask_epi8(c);
+
+      if (mask)
+      {
+         off       += compat_ctz(mask);
+         break;
+      }
+
+      off          += 16;
+   }
+
+   off >>= 1;
+   if (off && a[off - 1] == b[off - 1])
+      off--;
+   return off;
+}
+#endif
+
+#ifdef HAVE_SCAN_AVX2
+SCAN_AVX2_TARGET
+static size_t find_change_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const uint8_t *a8 = (const uint8_t*)a;
+   const uint8_t *b8 = (const uint8_t*)b;
+   size_t off        = 0;
+
+   for (;;)
+   {
+      __m256i c0    = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i*)(a8 + off)),
+            _mm256_loadu_si256((const __m256i*)(b8 + off)));
+      __m256i c1    = _mm256_cmpeq_epi8(
+            _mm256_loadu_si256((const __m256i*)(a8 + off + 32)),
+            _mm256_loadu_si256((const __m256i*)(b8 + off + 32)));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(c0, c1));
+
+      if (mask != 0xffffffff)
+      {
+         mask       = (uint32_t)_mm256_movemask_epi8(c0);
+         if (mask == 0xffffffff)
+         {
+            mask    = (uint32_t)_mm256_movemask_epi8(c1);
+            off    += 32;
+         }
+         return (off + compat_ctz(~mask)) >> 1;
+      }
+
+      off          += 64;
+   }
+}
+
+SCAN_AVX2_TARGET
+static size_t find_same_avx2(const uint16_t *a, const uint16_t *b)
+{
+   const uint8_t *a8 = (const uint8_t*)a;
+   const uint8_t *b8 = (const uint8_t*)b;
+   size_t off        = 0;
+
+   for (;;)
+   {
+      __m256i c0    = _mm256_cmpeq_epi32(
+            _mm256_loadu_si256((const __m256i*)(a8 + off)),
+            _mm256_loadu_si256((const __m256i*)(b8 + off)));
+      __m256i c1    = _mm256_cmpeq_epi32(
+            _mm256_loadu_si256((const __m256i*)(a8 + off + 32)),
+            _mm256_loadu_si256((const __m256i*)(b8 + off + 32)));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(c0, c1));
+
+      if (mask)
+      {
+         mask       = (uint32_t)_mm256_movemask_epi8(c0);
+         if (!mask)
+         {
+            mask    = (uint32_t)_mm256_movemask_epi8(c1);
+            off    += 32;
+         }
+         off       += compat_ctz(mask);
+         break;
+      }
+
+      off          += 64;
+   }
+
+   off >>= 1;
+   if (off && a[off - 1] == b[off - 1])
+      off--;
+   return off;
+}
+#endif
+
+#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
+/* Narrows a byte compare result to 4 bits per byte. */
+static INLINE uint64_t neon_movemask(uint8x16_t v)
+{
+   uint8x8_t n = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+   return vget_lane_u64(vreinterpret_u64_u8(n), 0);
+}
+
+static INLINE unsigned neon_ctz64(uint64_t x)
+{
+   uint32_t lo = (uint32_t)x;
+   if (lo)
+      return compat_ctz(lo);
+   return 32 + compat_ctz((uint32_t)(x >> 32));
+}
+
+static size_t find_change_neon(const uint16_t *a, const uint16_t *b)
+{
+   const uint8_t *a8 = (const uint8_t*)a;
+   const uint8_t *b8 = (const uint8_t*)b;
+   size_t off        = 0;
+
+   for (;;)
+   {
+      uint8x16_t c0 = vceqq_u8(vld1q_u8(a8 + off),      vld1q_u8(b8 + off));
+      uint8x16_t c1 = vceqq_u8(vld1q_u8(a8 + off + 16), vld1q_u8(b8 + off + 16));
+      uint64_t mask = neon_movemask(vandq_u8(c0, c1));
+
+      if (mask != UINT64_C(0xffffffffffffffff))
+      {
+         mask       = neon_movemask(c0);
+         if (mask == UINT64_C(0xffffffffffffffff))
+         {
+            mask    = neon_movemask(c1);
+            off    += 16;
+         }
+         return (off + (neon_ctz64(~mask) >> 2)) >> 1;
+      }
+
+      off          += 32;
+   }
+}
+
+static size_t find_same_neon(const uint16_t *a, const uint16_t *b)
+{
+   const uint8_t *a8 = (const uint8_t*)a;
+   const uint8_t *b8 = (const uint8_t*)b;
+   size_t off        = 0;
+
+   for (;;)
+   {
+      uint32x4_t c0 = vceqq_u32(
+            vreinterpretq_u32_u8(vld1q_u8(a8 + off)),
+            vreinterpretq_u32_u8(vld1q_u8(b8 + off)));
+      uint32x4_t c1 = vceqq_u32(
+            vreinterpretq_u32_u8(vld1q_u8(a8 + off + 16)),
+            vreinterpretq_u32_u8(vld1q_u8(b8 + off + 16)));
+      uint64_t mask = neon_movemask(vreinterpretq_u8_u32(
+               vorrq_u32(c0, c1)));
+
+      if (mask)
+      {
+         mask       = neon_movemask(vreinterpretq_u8_u32(c0));
+         if (!mask)
+         {
+            mask    = neon_movemask(vreinterpretq_u8_u32(c1));
+            off    += 16;
+         }
+         off       += neon_ctz64(mask) >> 2;
+         break;
+      }
+
+      off          += 32;
+   }
+
+   off >>= 1;
+   if (off && a[off - 1] == b[off - 1])
+      off--;
+   return off;
+}
+#endif
+
+static state_manager_raw_scan_t find_change = find_change_c;
+static state_manager_raw_scan_t find_same   = find_same_c;
+static const char *find_ident               = "c";
+
+void state_manager_raw_init_simd(uint64_t mask)
+{
+   find_change = find_change_c;
+   find_same   = find_same_c;
+   find_ident  = "c";
+
+#ifdef HAVE_SCAN_AVX2
+   if (mask & RETRO_SIMD_AVX2)
+   {
+      find_change = find_change_avx2;
+      find_same   = find_same_avx2;
+      find_ident  = "avx2";
+      return;
+   }
+#endif
+#if defined(__SSE2__)
+   if (mask & RETRO_SIMD_SSE2)
+   {
+      find_change = find_change_sse2;
+      find_same   = find_same_sse2;
+      find_ident  = "sse2";
+      return;
+   }
+#endif
+#if (defined(__ARM_NEON__) || defined(HAVE_NEON))
+   if (mask & RETRO_SIMD_NEON)
+   {
+      find_change = find_change_neon;
+      find_same   = find_same_neon;
+      find_ident  = "neon";
+      return;
+   }
+#endif
+}
+
+const char *state_manager_raw_simd_ident(void)
+{
+   return find_ident;
+}
+
+/* Returns the maximum compressed size of a savestate.
+ * It is very likely to compress to far less. */
+size_t state_manager_raw_maxsize(size_t uncomp)
+{
+   /* bytes covered by a compressed block */
+   const int maxcblkcover = UINT16_MAX * sizeof(uint16_t);
+   /* uncompressed size, rounded to 16 bits */
+   size_t uncomp16        = (uncomp + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
+   /* number of blocks */
+   size_t maxcblks        = (uncomp + maxcblkcover - 1) / maxcblkcover;
+   return uncomp16 + maxcblks * sizeof(uint16_t) * 2 /* two u16 overhead per block */ + sizeof(uint16_t) *
+      3; /* three u16 to end it */
+}
+
+/*
+ * See state_manager_raw_compress for information about this.
+ * When you're done with it, send it to free().
+ */
+void *state_manager_raw_alloc(size_t len, uint16_t uniq)
+{
+   size_t  len16 = (len + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
+   uint16_t *ret = (uint16_t*)calloc(len16 + sizeof(uint16_t) * 4 + 64, 1);
+
+   if (!ret)
+      return NULL;
+
+   /* Force in a different byte at the end, so we don't need to check
+    * bounds in the innermost loop (it's expensive).
+    *
+    * There is also a large amount of data that's the same, to stop
+    * the other scan.
+    *
+    * There is also some padding at the end. This is so we don't
+    * read outside the buffer end if we're reading in large blocks;
+    * the widest scanner reads 64 bytes at a time.
+    *
+    * It doesn't make any difference to us, but sacrificing 64 bytes to get
+    * Valgrind happy is worth it. */
+   ret[len16/sizeof(uint16_t) + 3] = uniq;
+
+   return ret;
+}
+
+/*
+ * Takes two savestates and creates a patch that turns 'src' into 'dst'.
+ * Both 'src' and 'dst' must be returned from state_manager_raw_alloc(),
+ * with the same 'len', and different 'uniq'.
+ *
+ * 'patch' must be size 'state_manager_raw_maxsize(len)' or more.
+ * Returns the number of bytes actually written to 'patch'.
+ */
+size_t state_manager_raw_compress(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   const uint16_t  *old16 = (const uint16_t*)src;
+   const uint16_t  *new16 = (const uint16_t*)dst;
+   uint16_t *compressed16 = (uint16_t*)patch;
+   size_t          num16s = (len + sizeof(uint16_t) - 1)
+      / sizeof(uint16_t);
+
+   while (num16s)
+   {
+      size_t i, changed;
+      size_t skip = find_change(old16, new16);
+
+      if (skip >= num16s)
+         break;
+
+      old16  += skip;
+      new16  += skip;
+      num16s -= skip;
+
+      if (skip > UINT16_MAX)
+      {
+         /* This will make it scan the entire thing again,
+          * but it only hits on 8GB unchanged data anyways,
+          * and if you're doing that, you've got bigger problems. */
+         if (skip > UINT32_MAX)
+            skip         = UINT32_MAX;
+
+         *compressed16++ = 0;
+         *compressed16++ = skip;
+         *compressed16++ = skip >> 16;
+         continue;
+      }
+
+      changed         = find_same(old16, new16);
+      if (changed > UINT16_MAX)
+         changed = UINT16_MAX;
+
+      *compressed16++ = changed;
+      *compressed16++ = skip;
+
+      for (i = 0; i < changed; i++)
+         compressed16[i] = old16[i];
+
+      old16        += changed;
+      new16        += changed;
+      num16s       -= changed;
+      compressed16 += changed;
+   }
+
+   compressed16[0]  = 0;
+   compressed16[1]  = 0;
+   compressed16[2]  = 0;
+
+   return (uint8_t*)(compressed16 + 3) - (uint8_t*)patch;
+}
+
+/*
+ * Takes 'patch' from a previous call to 'state_manager_raw_compress'
+ * and applies it to 'data' ('src' from that call),
+ * yielding 'dst' in that call.
+ *
+ * If the given arguments do not match a previous call to
+ * state_manager_raw_compress(), anything at all can happen.
+ */
+void state_manager_raw_decompress(const void *patch,
+      size_t patchlen, void *data, size_t datalen)
+{
+   uint16_t         *out16 = (uint16_t*)data;
+   const uint16_t *patch16 = (const uint16_t*)patch;
+
+   for (;;)
+   {
+      uint16_t numchanged  = *(patch16++);
+
+      if (numchanged)
+      {
+         uint16_t i;
+
+         out16       += *patch16++;
+
+         /* We could do memcpy, but it seems that memcpy has a
+          * constant-per-call overhead that actually shows up.
+          *
+          * Our average size in here seems to be 8 or something.
+          * Therefore, we do something with lower overhead. */
+         for (i = 0; i < numchanged; i++)
+            out16[i]  = patch16[i];
+
+         patch16     += numchanged;
+         out16       += numchanged;
+      }
+      else
+      {
+         uint32_t numunchanged = patch16[0] | (patch16[1] << 16);
+
+         if (!numunchanged)
+            break;
+         patch16 += 2;
+         out16   += numunchanged;
+      }
+   }
+}
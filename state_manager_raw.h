@@ -0,0 +1,76 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2014-2017 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STATE_MANAGER_RAW_H
+#define __STATE_MANAGER_RAW_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/**
+ * state_manager_raw_init_simd:
+ * @mask                 : RETRO_SIMD_* flags the scanners may use,
+ *                         normally cpu_features_get().
+ *
+ * Picks the fastest compiled-in find_change/find_same
+ * implementation allowed by @mask.
+ **/
+void state_manager_raw_init_simd(uint64_t mask);
+
+/* Name of the implementation picked by
+ * state_manager_raw_init_simd(), for logging. */
+const char *state_manager_raw_simd_ident(void);
+
+/* Returns the maximum compressed size of a savestate.
+ * It is very likely to compress to far less. */
+size_t state_manager_raw_maxsize(size_t uncomp);
+
+/*
+ * See state_manager_raw_compress for information about this.
+ * When you're done with it, send it to free().
+ */
+void *state_manager_raw_alloc(size_t len, uint16_t uniq);
+
+/*
+ * Takes two savestates and creates a patch that turns 'src' into 'dst'.
+ * Both 'src' and 'dst' must be returned from state_manager_raw_alloc(),
+ * with the same 'len', and different 'uniq'.
+ *
+ * 'patch' must be size 'state_manager_raw_maxsize(len)' or more.
+ * Returns the number of bytes actually written to 'patch'.
+ */
+size_t state_manager_raw_compress(const void *src,
+      const void *dst, size_t len, void *patch);
+
+/*
+ * Takes 'patch' from a previous call to 'state_manager_raw_compress'
+ * and applies it to 'data' ('src' from that call),
+ * yielding 'dst' in that call.
+ *
+ * If the given arguments do not match a previous call to
+ * state_manager_raw_compress(), anything at all can happen.
+ */
+void state_manager_raw_decompress(const void *patch,
+      size_t patchlen, void *data, size_t datalen);
+
+RETRO_END_DECLS
+
+#endif
@@ -24,6 +24,7 @@
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
 #include <streams/rzip_stream.h>
+#include <buffer_pool.h>
 #include <rthreads/rthreads.h>
 #include <file/file_path.h>
 #include <retro_miscellaneous.h>
@@ -65,6 +66,14 @@
 #define RASTATE_REPLAY_BLOCK "RPLY"
 #define RASTATE_END_BLOCK "END "
 
+/* Serialized states handed to save tasks come from a small pool
+ * of buffers that are kept around between saves, so slot hotkeys
+ * and periodic autosaves don't allocate and fault in a fresh
+ * state-sized buffer on the main thread every time. One buffer
+ * is being written by the (blocking) save task while the next
+ * save is taken into the other. */
+#define SAVE_STATE_POOL_SIZE 2
+
 struct save_state_buf
 {
    void* data;
@@ -127,6 +136,9 @@ static struct ram_save_state_buf ram_buf;
 
 static bool save_state_in_background       = false;
 
+/* Buffers are released from the task thread */
+static buffer_pool_t save_state_pool;
+
 typedef struct rastate_size_info
 {
    size_t total_size;
@@ -140,6 +152,72 @@ typedef struct rastate_size_info
 } rastate_size_info_t;
 
 
+/* Must be called from the main thread before the pool is used */
+static void content_state_pool_init(void)
+{
+   buffer_pool_init(&save_state_pool, SAVE_STATE_POOL_SIZE);
+}
+
+/**
+ * content_state_pool_get:
+ * @len : size the buffer must hold.
+ *
+ * Takes a zeroed buffer of at least @len bytes from the pool,
+ * or allocates one if every pooled buffer is busy.
+ *
+ * Returns: the buffer, to be handed back with
+ * content_state_pool_put(); NULL on allocation failure.
+ **/
+static void *content_state_pool_get(size_t len)
+{
+   void *data = buffer_pool_get(&save_state_pool, len);
+
+   /* Ensure buffer is initialised to zero
+    * > Prevents inconsistent compressed state file
+    *   sizes when core requests a larger buffer
+    *   than it needs (and leaves the excess
+    *   as uninitialised garbage) */
+   if (data)
+      memset(data, 0, len);
+   return data;
+}
+
+/**
+ * content_state_pool_put:
+ * @data : buffer from content_state_pool_get(), or any
+ *         other malloc()'d state buffer.
+ * @keep : if non-NULL, receives @data's storage instead of
+ *         the pool; the pool takes over keep->data in exchange,
+ *         or just forgets @data if there is none yet.
+ *
+ * Returns @data to the pool. Passing @keep moves a finished
+ * state into a long-lived buffer without copying it.
+ **/
+static void content_state_pool_put(void *data, struct save_state_buf *keep)
+{
+   if (!data)
+      return;
+
+   if (keep)
+   {
+      /* Either way the pool must no longer hand
+       * out @data, now that @keep holds it */
+      if (!keep->data)
+         buffer_pool_take(&save_state_pool, data);
+      else if (!buffer_pool_put(&save_state_pool, data,
+               keep->data, keep->size))
+         free(keep->data);
+      keep->data = data;
+   }
+   else if (!buffer_pool_put(&save_state_pool, data, NULL, 0))
+      free(data);
+}
+
+void content_state_pool_deinit(void)
+{
+   buffer_pool_deinit(&save_state_pool);
+}
+
 /**
  * undo_load_state:
  * Revert to the state before a state was loaded.
@@ -318,7 +396,7 @@ static void task_save_handler_finished(retro_task_t *task,
       if (     (state->flags & SAVE_TASK_FLAG_UNDO_SAVE)
             && (state->data == undo_save_buf.data))
          undo_save_buf.data = NULL;
-      free(state->data);
+      content_state_pool_put(state->data, NULL);
       state->data = NULL;
    }
 
@@ -328,9 +406,22 @@ static void task_save_handler_finished(retro_task_t *task,
 /* Align to 8-byte boundary */
 #define CONTENT_ALIGN_SIZE(size) ((((size) + 7) & ~7))
 
+/* Rewind may take its states in the same-instance context
+ * run-ahead uses, so the two share one serialization per frame. */
+static bool content_rewind_special_states(bool rewind)
+{
+#ifdef HAVE_REWIND
+   return rewind && state_manager_uses_special_states();
+#else
+   return false;
+#endif
+}
+
 static size_t content_get_rastate_size(rastate_size_info_t* size, bool rewind)
 {
-   size_t info_size = core_serialize_size();
+   size_t info_size = content_rewind_special_states(rewind)
+      ? core_serialize_size_special()
+      : core_serialize_size();
    if (!info_size)
       return 0;
    size->coremem_size = info_size;
@@ -416,7 +507,12 @@ static bool content_write_serialized_state(void* buffer,
    /* important - pass the unaligned size to the core. some fail if it isn't exactly what they're expecting. */
    serial_info.size = size->coremem_size;
    serial_info.data = (void*)output;
-   if (!core_serialize(&serial_info))
+   if (content_rewind_special_states(rewind))
+   {
+      if (!core_serialize_special(&serial_info))
+         return false;
+   }
+   else if (!core_serialize(&serial_info))
       return false;
 
    output += CONTENT_ALIGN_SIZE(size->coremem_size);
@@ -453,17 +549,12 @@ static void *content_get_serialized_data(size_t* serial_size)
    if ((len = content_get_rastate_size(&size, false)) == 0)
       return NULL;
 
-   /* Ensure buffer is initialised to zero
-    * > Prevents inconsistent compressed state file
-    *   sizes when core requests a larger buffer
-    *   than it needs (and leaves the excess
-    *   as uninitialised garbage) */
-   if (!(data = calloc(len, 1)))
+   if (!(data = content_state_pool_get(len)))
       return NULL;
 
    if (!content_write_serialized_state(data, &size, false))
    {
-      free(data);
+      content_state_pool_put(data, NULL);
       return NULL;
    }
 
@@ -818,7 +909,8 @@ end:
    task_load_handler_finished(task, state);
 }
 
-static bool content_load_rastate1(unsigned char* input, size_t size)
+static bool content_load_rastate1(unsigned char* input, size_t size,
+      bool rewind)
 {
    unsigned char *stop = input + size;
    bool seen_core      = false;
@@ -867,7 +959,15 @@ static bool content_load_rastate1(unsigned char* input, size_t size)
             }
          }
 #endif
-         if (!core_unserialize(&serial_info))
+         if (content_rewind_special_states(rewind))
+         {
+            if (!core_unserialize_special(&serial_info))
+               return false;
+#ifdef HAVE_RUNAHEAD
+            command_event(CMD_EVENT_PREEMPT_RESET_BUFFER, NULL);
+#endif
+         }
+         else if (!core_unserialize(&serial_info))
             return false;
 
          seen_core = true;
@@ -956,7 +1056,7 @@ bool content_deserialize_state(
       switch (input[7]) /* version */
       {
          case 1:
-            if (content_load_rastate1(input, serialized_size))
+            if (content_load_rastate1(input, serialized_size, false))
                break;
             /* fall-through intentional */
          default:
@@ -967,6 +1067,19 @@ bool content_deserialize_state(
    return true;
 }
 
+bool content_deserialize_state_rewind(
+      const void* serialized_data, size_t serialized_size)
+{
+   unsigned char* input = (unsigned char*)serialized_data;
+
+   /* Rewind always writes the current RASTATE format */
+   if (     memcmp(serialized_data, "RASTATE", 7) != 0
+         || input[7] != RASTATE_VERSION)
+      return content_deserialize_state(serialized_data, serialized_size);
+
+   return content_load_rastate1(input, serialized_size, true);
+}
+
 /**
  * content_load_state_cb:
  * @path      : path that state will be loaded from.
@@ -1009,19 +1122,13 @@ static void content_load_state_cb(retro_task_t *task,
    {
       /* If we were previously backing up a file, let go of it first */
       if (undo_save_buf.data)
-      {
          free(undo_save_buf.data);
-         undo_save_buf.data = NULL;
-      }
-
-      if (!(undo_save_buf.data = malloc(size)))
-         goto error;
 
-      memcpy(undo_save_buf.data, buf, size);
+      /* Keep the buffer the file was read into */
+      undo_save_buf.data = buf;
       undo_save_buf.size = size;
       strlcpy(undo_save_buf.path, load_data->path, sizeof(undo_save_buf.path));
 
-      free(buf);
       free(load_data);
       return;
    }
@@ -1192,8 +1299,7 @@ static void task_push_save_state(const char *path, void *data, size_t size, bool
    if (!task_queue_push(task))
    {
       /* Another blocking task is already active. */
-      if (data)
-         free(data);
+      content_state_pool_put(data, NULL);
       if (task->title)
          task_free_title(task);
       free(task);
@@ -1203,8 +1309,7 @@ static void task_push_save_state(const char *path, void *data, size_t size, bool
    return;
 
 error:
-   if (data)
-      free(data);
+   content_state_pool_put(data, NULL);
    if (state)
       free(state);
    if (task)
@@ -1298,8 +1403,7 @@ static void task_push_load_and_save_state(const char *path, void *data,
    if (!task_queue_push(task))
    {
       /* Another blocking task is already active. */
-      if (data)
-         free(data);
+      content_state_pool_put(data, NULL);
       if (task->title)
          task_free_title(task);
       free(task);
@@ -1335,6 +1439,8 @@ bool content_auto_save_state(const char *path)
    if (serial_size == 0)
       return false;
 
+   content_state_pool_init();
+
    serial_data = content_get_serialized_data(&serial_size);
    if (!serial_data)
       return false;
@@ -1349,20 +1455,20 @@ bool content_auto_save_state(const char *path)
 
    if (!file)
    {
-      free(serial_data);
+      content_state_pool_put(serial_data, NULL);
       return false;
    }
 
    if (serial_size != (size_t)intfstream_write(file, serial_data, serial_size))
    {
       intfstream_close(file);
-      free(serial_data);
+      content_state_pool_put(serial_data, NULL);
       free(file);
       return false;
    }
 
    intfstream_close(file);
-   free(serial_data);
+   content_state_pool_put(serial_data, NULL);
    free(file);
 
 #ifdef HAVE_SCREENSHOTS
@@ -1406,6 +1512,8 @@ bool content_save_state(const char *path, bool save_to_disk)
    if (serial_size == 0)
       return false;
 
+   content_state_pool_init();
+
    if (!save_state_in_background)
    {
       if (!(data = content_get_serialized_data(&serial_size)))
@@ -1453,21 +1561,9 @@ bool content_save_state(const char *path, bool save_to_disk)
       /* save_to_disk is false, which means we are saving the state
       in undo_load_buf to allow content_undo_load_state() to restore it */
 
-      /* If we were holding onto an old state already, clean it up first */
-      if (undo_load_buf.data)
-      {
-         free(undo_load_buf.data);
-         undo_load_buf.data = NULL;
-      }
-
-      if (!(undo_load_buf.data = malloc(serial_size)))
-      {
-         free(data);
-         return false;
-      }
-
-      memcpy(undo_load_buf.data, data, serial_size);
-      free(data);
+      /* Swap the new state in; the old one's storage goes
+       * back to the pool */
+      content_state_pool_put(data, &undo_load_buf);
       undo_load_buf.size = serial_size;
       strlcpy(undo_load_buf.path, path, sizeof(undo_load_buf.path));
    }
@@ -1640,6 +1736,8 @@ void content_reset_savestate_backups(void)
    ram_buf.state_buf.path[0] = '\0';
    ram_buf.state_buf.size    = 0;
    ram_buf.to_write_file     = false;
+
+   buffer_pool_trim(&save_state_pool);
 }
 
 bool content_undo_load_buf_is_empty(void)
@@ -1727,6 +1825,8 @@ bool content_save_state_to_ram(void)
    if (serial_size == 0)
       return false;
 
+   content_state_pool_init();
+
    if (!save_state_in_background)
    {
       if (!(data = content_get_serialized_data(&serial_size)))
@@ -1752,21 +1852,9 @@ bool content_save_state_to_ram(void)
       }
    }
 
-   /* If we were holding onto an old state already, clean it up first */
-   if (ram_buf.state_buf.data)
-   {
-      free(ram_buf.state_buf.data);
-      ram_buf.state_buf.data = NULL;
-   }
-
-   if (!(ram_buf.state_buf.data = malloc(serial_size)))
-   {
-      free(data);
-      return false;
-   }
-
-   memcpy(ram_buf.state_buf.data, data, serial_size);
-   free(data);
+   /* Swap the new state in; the old one's storage goes
+    * back to the pool */
+   content_state_pool_put(data, &ram_buf.state_buf);
    ram_buf.state_buf.size = serial_size;
    ram_buf.to_write_file  = true;
 
@@ -30,6 +30,7 @@
 #include <compat/strl.h>
 #include <string/stdstring.h>
 #include <gfx/video_frame.h>
+#include <buffer_pool.h>
 
 #ifdef HAVE_RBMP
 #include <formats/rbmp.h>
@@ -57,6 +58,65 @@
 
 #include "tasks_internal.h"
 
+/* Number of software frame copies kept around for the next
+ * screenshot; more are allocated while a burst is queued. */
+#define SCREENSHOT_POOL_SIZE 2
+
+/* Buffers are released from the task thread */
+static buffer_pool_t screenshot_pool;
+
+/**
+ * screenshot_pool_get:
+ * @len : size the buffer must hold.
+ *
+ * Takes a buffer of at least @len bytes from the pool,
+ * or allocates one if every pooled buffer is busy.
+ * Must be called from the main thread.
+ *
+ * Returns: the buffer, to be handed back with
+ * screenshot_pool_put(); NULL on allocation failure.
+ **/
+static void *screenshot_pool_get(size_t len)
+{
+   buffer_pool_init(&screenshot_pool, SCREENSHOT_POOL_SIZE);
+   return buffer_pool_get(&screenshot_pool, len);
+}
+
+/* Returns @data to the pool, or frees it if it
+ * didn't come from there. */
+static void screenshot_pool_put(void *data)
+{
+   if (!buffer_pool_put(&screenshot_pool, data, NULL, 0))
+      free(data);
+}
+
+void screenshot_pool_deinit(void)
+{
+   buffer_pool_deinit(&screenshot_pool);
+}
+
+/* Dated names only change once a second, so screenshots
+ * taken in a burst get numbered instead of overwriting
+ * each other while they wait in the task queue. */
+static void screenshot_number_dated_name(char *shotname, size_t len)
+{
+   static char last_name[NAME_MAX_LENGTH];
+   static unsigned count = 0;
+   size_t _len           = strlen(shotname);
+   size_t ext_len        = STRLEN_CONST("." IMG_EXT);
+
+   if (!string_is_equal(shotname, last_name))
+   {
+      strlcpy(last_name, shotname, sizeof(last_name));
+      count = 0;
+      return;
+   }
+
+   if (_len > ext_len)
+      snprintf(shotname + _len - ext_len, len - (_len - ext_len),
+            "-%u." IMG_EXT, ++count + 1);
+}
+
 static bool screenshot_dump_direct(screenshot_task_state_t *state)
 {
    struct scaler_ctx *scaler     = (struct scaler_ctx*)&state->scaler;
@@ -174,7 +234,7 @@ task_finished:
       task_free_title(task);
 
    if (state && state->userbuf)
-      free(state->userbuf);
+      screenshot_pool_put(state->userbuf);
 
 #if defined(HAVE_GFX_WIDGETS)
    /* If display widgets are enabled, state is freed
@@ -326,6 +386,8 @@ static bool screenshot_dump(
 
             fill_str_dated_filename(state->shotname, screenshot_name,
                   IMG_EXT, sizeof(state->shotname));
+            screenshot_number_dated_name(state->shotname,
+                  sizeof(state->shotname));
          }
          else
          {
@@ -365,7 +427,10 @@ static bool screenshot_dump(
    {
       retro_task_t *task = task_init();
 
-      task->type         = TASK_TYPE_BLOCKING;
+      /* The task owns its copy of the frame, so a burst of
+       * screenshots can queue up. Savestate thumbnails still
+       * wait their turn with the other savestate tasks. */
+      task->type         = savestate ? TASK_TYPE_BLOCKING : TASK_TYPE_NONE;
       task->state        = state;
       task->handler      = task_screenshot_handler;
       task->mute         = savestate;
@@ -463,10 +528,37 @@ static bool take_screenshot_raw(
    unsigned width         = video_st->frame_cache_width;
    unsigned height        = video_st->frame_cache_height;
    size_t pitch           = video_st->frame_cache_pitch;
+
+   if (!data || data == RETRO_HW_FRAME_BUFFER_VALID || !width || !height)
+      return false;
+
+   /* The frame cache points into the core's framebuffer, which
+    * the next frame overwrites; give the task its own copy.
+    * This is a plain copy of the rows, so taking screenshots
+    * never waits on conversion or encoding. */
+   if (use_thread && !userbuf)
+   {
+      unsigned y;
+      size_t row_size = width * ((pixel_format_type
+               == RETRO_PIXEL_FORMAT_XRGB8888) ? 4 : 2);
+      uint8_t *copy   = (uint8_t*)screenshot_pool_get(row_size * height);
+
+      if (!copy)
+         return false;
+
+      for (y = 0; y < height; y++)
+         memcpy(copy + y * row_size,
+               (const uint8_t*)data + y * pitch, row_size);
+
+      data    = copy;
+      pitch   = row_size;
+      userbuf = copy;
+   }
+
    /* Negative pitch is needed as screenshot takes bottom-up,
     * but we use top-down.
     */
-   return screenshot_dump(screenshot_dir,
+   if (!screenshot_dump(screenshot_dir,
             name_base,
             (const uint8_t*)data + (height - 1) * pitch,
             width,
@@ -478,7 +570,14 @@ static bool take_screenshot_raw(
             runloop_flags,
             fullpath,
             use_thread,
-            pixel_format_type);
+            pixel_format_type))
+   {
+      if (userbuf == data)
+         screenshot_pool_put(userbuf);
+      return false;
+   }
+
+   return true;
 }
 
 static bool take_screenshot_choice(
@@ -268,6 +268,10 @@ bool take_screenshot(
       const char *path, bool silence,
       bool has_valid_framebuffer, bool fullpath, bool use_thread);
 
+/* Frees the screenshot buffer pool; no
+ * screenshot task may be running. */
+void screenshot_pool_deinit(void);
+
 bool event_load_save_files(bool is_sram_load_disabled);
 
 bool event_save_files(bool sram_used);
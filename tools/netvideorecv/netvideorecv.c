@@ -0,0 +1,283 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Receives the delta stream of the network video driver with
+ * video_network_delta enabled (see gfx/drivers/network_gfx.c for the format),
+ * rebuilds every frame and optionally writes them out as raw video. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <zlib.h>
+
+#include "compat/getopt.h"
+#include "net/net_compat.h"
+#include "net/net_socket.h"
+
+#define NETWORK_VIDEO_DELTA_MAGIC   0x524E5644 /* "RNVD" */
+#define NETWORK_VIDEO_DELTA_VERSION 1
+#define NETWORK_VIDEO_FLAG_ZLIB     (1 << 0)
+
+static void usage(void)
+{
+   fprintf(stderr,
+      "Use: netvideorecv [options]\n"
+      "Options:\n"
+      "    -P|--port <port>:     Port to listen on. Defaults to 4953.\n"
+      "    -o|--output <file>:   Append every frame to a file as raw 32-bit\n"
+      "                          pixels.\n"
+      "    -v|--verbose:         Print a line per frame.\n"
+      "\n");
+}
+
+static int accept_connection(uint16_t port)
+{
+   int fd;
+   int conn;
+   struct addrinfo *addr = NULL;
+
+   fd = socket_init((void**)&addr, port, NULL, SOCKET_TYPE_STREAM, AF_INET);
+   if (fd < 0 || !addr || !socket_bind(fd, addr) || listen(fd, 1) < 0)
+   {
+      perror("listen");
+      exit(1);
+   }
+   freeaddrinfo_retro(addr);
+
+   fprintf(stderr, "Waiting for RetroArch on port %u...\n", (unsigned)port);
+
+   conn = accept(fd, NULL, NULL);
+   socket_close(fd);
+
+   if (conn < 0)
+   {
+      perror("accept");
+      exit(1);
+   }
+
+   return conn;
+}
+
+/* Applies one inflated payload to the frame */
+static bool apply_tiles(uint32_t *frame, unsigned width, unsigned height,
+      unsigned tile_size, unsigned tiles, const uint8_t *in, size_t size)
+{
+   unsigned i;
+   const uint8_t *end = in + size;
+
+   for (i = 0; i < tiles; i++)
+   {
+      unsigned x, y, tw, th;
+      unsigned x0, y0;
+      uint16_t pos[2];
+
+      if (end - in < (ptrdiff_t)sizeof(pos))
+         return false;
+      memcpy(pos, in, sizeof(pos));
+      in += sizeof(pos);
+
+      x0  = ntohs(pos[0]) * tile_size;
+      y0  = ntohs(pos[1]) * tile_size;
+      if (x0 >= width || y0 >= height)
+         return false;
+
+      tw  = (width  - x0 < tile_size) ? width  - x0 : tile_size;
+      th  = (height - y0 < tile_size) ? height - y0 : tile_size;
+      if ((size_t)(end - in) < (size_t)tw * th * sizeof(uint32_t))
+         return false;
+
+      for (y = 0; y < th; y++)
+      {
+         uint32_t *dst = frame + (size_t)(y0 + y) * width + x0;
+         for (x = 0; x < tw; x++)
+         {
+            uint32_t delta;
+            memcpy(&delta, in, sizeof(delta));
+            in     += sizeof(delta);
+            dst[x] ^= delta;
+         }
+      }
+   }
+
+   return in == end;
+}
+
+int main(int argc, char *argv[])
+{
+   int fd;
+   uint32_t header[7];
+   uint16_t port            = 4953;
+   const char *output_name  = NULL;
+   FILE *output             = NULL;
+   bool verbose             = false;
+   uint32_t *frame          = NULL;
+   uint8_t *payload         = NULL;
+   uint8_t *inflated        = NULL;
+   size_t payload_cap       = 0;
+   size_t inflated_cap      = 0;
+   unsigned width           = 0;
+   unsigned height          = 0;
+   unsigned long frames     = 0;
+   unsigned long long wire  = 0;
+   unsigned long long raw   = 0;
+
+   const struct option opt[] = {
+      {"port",       1, NULL, 'P'},
+      {"output",     1, NULL, 'o'},
+      {"verbose",    0, NULL, 'v'},
+      {NULL,         0, NULL, 0}
+   };
+
+   for (;;)
+   {
+      int c = getopt_long(argc, argv, "P:o:v", opt, NULL);
+      if (c == -1)
+         break;
+
+      switch (c)
+      {
+         case 'P':
+            port = (uint16_t)atoi(optarg);
+            break;
+
+         case 'o':
+            output_name = optarg;
+            break;
+
+         case 'v':
+            verbose = true;
+            break;
+
+         default:
+            usage();
+            return 1;
+      }
+   }
+
+   if (output_name && !(output = fopen(output_name, "wb")))
+   {
+      perror(output_name);
+      return 1;
+   }
+
+   if (!network_init())
+      return 1;
+
+   fd = accept_connection(port);
+
+   if (     !socket_receive_all_blocking(fd, header, 2 * sizeof(uint32_t))
+         || ntohl(header[0]) != NETWORK_VIDEO_DELTA_MAGIC
+         || ntohl(header[1]) != NETWORK_VIDEO_DELTA_VERSION)
+   {
+      fprintf(stderr, "Not a version %d delta stream.\n",
+            NETWORK_VIDEO_DELTA_VERSION);
+      return 1;
+   }
+
+   while (socket_receive_all_blocking(fd, header, sizeof(header)))
+   {
+      unsigned i;
+      unsigned new_width  = ntohl(header[0]);
+      unsigned new_height = ntohl(header[1]);
+      unsigned format     = ntohl(header[2]);
+      unsigned tile_size  = ntohl(header[3]);
+      unsigned tiles      = ntohl(header[4]);
+      uint32_t flags      = ntohl(header[5]);
+      size_t size         = ntohl(header[6]);
+      size_t tile_bytes   = 2 * sizeof(uint16_t)
+         + (size_t)tile_size * tile_size * sizeof(uint32_t);
+      const uint8_t *data = NULL;
+
+      if (!tile_size)
+         break;
+
+      if (new_width != width || new_height != height)
+      {
+         width  = new_width;
+         height = new_height;
+         free(frame);
+         if (!(frame = (uint32_t*)calloc((size_t)width * height,
+                     sizeof(uint32_t))))
+            break;
+      }
+
+      if (size > payload_cap)
+      {
+         payload_cap = size;
+         if (!(payload = (uint8_t*)realloc(payload, payload_cap)))
+            break;
+      }
+
+      if (!socket_receive_all_blocking(fd, payload, size))
+         break;
+
+      data = payload;
+
+      if (flags & NETWORK_VIDEO_FLAG_ZLIB)
+      {
+         uLongf out_size = (uLongf)(tiles * tile_bytes);
+
+         if (out_size > inflated_cap)
+         {
+            inflated_cap = out_size;
+            if (!(inflated = (uint8_t*)realloc(inflated, inflated_cap)))
+               break;
+         }
+
+         if (uncompress(inflated, &out_size, payload, (uLong)size) != Z_OK)
+         {
+            fprintf(stderr, "Frame %lu: bad zlib payload.\n", frames);
+            break;
+         }
+
+         data = inflated;
+         size = out_size;
+      }
+
+      if (!apply_tiles(frame, width, height, tile_size, tiles, data, size))
+      {
+         fprintf(stderr, "Frame %lu: bad tile data.\n", frames);
+         break;
+      }
+
+      wire += sizeof(header) + ntohl(header[6]);
+      raw  += (unsigned long long)width * height * sizeof(uint32_t);
+
+      if (verbose)
+         printf("frame %lu: %ux%u format %u, %u tiles, %u bytes%s\n",
+               frames, width, height, format, tiles,
+               (unsigned)ntohl(header[6]),
+               (flags & NETWORK_VIDEO_FLAG_ZLIB) ? " (zlib)" : "");
+
+      if (output)
+         for (i = 0; i < height; i++)
+            fwrite(frame + (size_t)i * width, sizeof(uint32_t), width, output);
+
+      frames++;
+   }
+
+   fprintf(stderr, "%lu frames, %llu bytes received, %llu bytes raw (%.1f%%).\n",
+         frames, wire, raw, raw ? 100.0 * wire / raw : 0.0);
+
+   if (output)
+      fclose(output);
+   socket_close(fd);
+   free(frame);
+   free(payload);
+   free(inflated);
+
+   return 0;
+}
@@ -0,0 +1,231 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2017 - Daniel De Matteis
+ *  Copyright (C) 2014-2017 - Alfred Agrell
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+
+#include <features/features_cpu.h>
+
+#include "state_manager_raw.h"
+
+/* Runs at least this long per measurement */
+#define BENCH_MIN_USEC 200000
+
+static const uint64_t bench_masks[] = {
+   0,
+   RETRO_SIMD_SSE2,
+   RETRO_SIMD_SSE2 | RETRO_SIMD_AVX2,
+   RETRO_SIMD_NEON
+};
+
+static uint32_t bench_rand_state = 0x12345678;
+
+static uint32_t bench_rand(void)
+{
+   bench_rand_state = bench_rand_state * 1664525 + 1013904223;
+   return bench_rand_state >> 8;
+}
+
+/* Returns false if a patch didn't turn 'dst' back into 'src' */
+static bool bench_run(const char *name,
+      const uint8_t *src, const uint8_t *dst, size_t len)
+{
+   size_t i;
+   bool ok         = true;
+   uint64_t cpu    = cpu_features_get();
+   size_t maxsize  = state_manager_raw_maxsize(len);
+   uint8_t *patch  = (uint8_t*)malloc(maxsize);
+   uint8_t *a      = (uint8_t*)state_manager_raw_alloc(len, 0);
+   uint8_t *b      = (uint8_t*)state_manager_raw_alloc(len, 1);
+   const char *ran = "";
+
+   if (!patch || !a || !b)
+   {
+      fprintf(stderr, "%s: out of memory.\n", name);
+      ok = false;
+      goto end;
+   }
+
+   memcpy(a, src, len);
+   memcpy(b, dst, len);
+
+   for (i = 0; i < sizeof(bench_masks) / sizeof(bench_masks[0]); i++)
+   {
+      size_t patchlen = 0;
+      unsigned iters  = 0;
+      double comp_usec, decomp_usec;
+      retro_time_t start, elapsed;
+
+      /* Skip masks the CPU can't run, and duplicates
+       * of what an earlier mask already selected */
+      if ((bench_masks[i] & cpu) != bench_masks[i])
+         continue;
+      state_manager_raw_init_simd(bench_masks[i]);
+      if (i && !strcmp(ran, state_manager_raw_simd_ident()))
+         continue;
+      ran             = state_manager_raw_simd_ident();
+
+      start           = cpu_features_get_time_usec();
+      do
+      {
+         patchlen     = state_manager_raw_compress(a, b, len, patch);
+         iters++;
+      } while ((elapsed = cpu_features_get_time_usec() - start)
+            < BENCH_MIN_USEC);
+      comp_usec       = (double)elapsed / iters;
+
+      iters           = 0;
+      start           = cpu_features_get_time_usec();
+      do
+      {
+         /* Applying the patch to 'b' yields 'a'; it doesn't
+          * touch the unchanged parts, so this can repeat */
+         state_manager_raw_decompress(patch, patchlen, b, len);
+         iters++;
+      } while ((elapsed = cpu_features_get_time_usec() - start)
+            < BENCH_MIN_USEC);
+      decomp_usec     = (double)elapsed / iters;
+
+      if (memcmp(a, b, len))
+      {
+         fprintf(stderr, "%s: %s patch doesn't round-trip.\n",
+               name, ran);
+         ok = false;
+      }
+      memcpy(b, dst, len);
+
+      printf("%-28s %-5s %10u bytes -> %10u  compress %7.2f GB/s"
+            "  decompress %7.2f GB/s\n",
+            name, ran, (unsigned)len, (unsigned)patchlen,
+            len / comp_usec   / 1000.0,
+            len / decomp_usec / 1000.0);
+   }
+
+end:
+   free(patch);
+   free(a);
+   free(b);
+   return ok;
+}
+
+static bool bench_synthetic(size_t len, unsigned change_ppm,
+      unsigned run)
+{
+   char name[64];
+   size_t i;
+   bool ok      = false;
+   uint8_t *src = (uint8_t*)malloc(len);
+   uint8_t *dst = (uint8_t*)malloc(len);
+
+   if (!src || !dst)
+      goto end;
+
+   for (i = 0; i < len; i++)
+      src[i] = (uint8_t)bench_rand();
+   memcpy(dst, src, len);
+
+   /* Changes come in runs of 'run' bytes, like
+    * a core touching variables or small buffers */
+   for (i = 0; i < len; i += run)
+      if (bench_rand() % 1000000 < change_ppm)
+      {
+         size_t j;
+         for (j = i; j < i + run && j < len; j++)
+            dst[j] ^= (uint8_t)(bench_rand() | 1);
+      }
+
+   snprintf(name, sizeof(name), "synthetic %.2f%% x%u",
+         change_ppm / 10000.0, run);
+   ok = bench_run(name, src, dst, len);
+
+end:
+   free(src);
+   free(dst);
+   return ok;
+}
+
+static uint8_t *bench_load(const char *path, size_t *len)
+{
+   long size;
+   uint8_t *buf = NULL;
+   FILE *file   = fopen(path, "rb");
+
+   if (!file)
+      return NULL;
+
+   fseek(file, 0, SEEK_END);
+   size         = ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   if (size > 0 && (buf = (uint8_t*)malloc(size)))
+   {
+      if (fread(buf, 1, size, file) != (size_t)size)
+      {
+         free(buf);
+         buf    = NULL;
+      }
+      *len      = size;
+   }
+
+   fclose(file);
+   return buf;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   static const size_t sizes[]      = { 256 << 10, 4 << 20, 16 << 20 };
+   static const unsigned changes[]  = { 100, 1000, 10000, 100000 };
+   uint8_t *prev                    = NULL;
+   size_t prev_len                  = 0;
+   int ret                          = 0;
+   size_t s, c;
+
+   for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+      for (c = 0; c < sizeof(changes) / sizeof(changes[0]); c++)
+         if (!bench_synthetic(sizes[s], changes[c], 16))
+            ret = 1;
+
+   for (i = 1; i < argc; i++)
+   {
+      size_t len   = 0;
+      uint8_t *cur = bench_load(argv[i], &len);
+
+      if (!cur)
+      {
+         fprintf(stderr, "Failed to read \"%s\".\n", argv[i]);
+         continue;
+      }
+
+      if (prev && prev_len == len)
+      {
+         if (!bench_run(argv[i], prev, cur, len))
+            ret = 1;
+      }
+      else if (prev)
+         fprintf(stderr, "Skipping \"%s\": size differs.\n", argv[i]);
+
+      free(prev);
+      prev         = cur;
+      prev_len     = len;
+   }
+
+   free(prev);
+   return ret;
+}